@@ -0,0 +1,38 @@
+#version 120
+
+// Expands the segments of a BillboardLine into camera-facing quads.
+// gl_Vertex is the end of the segment this vertex belongs to, uv0.xyz
+// the other end and uv0.w the side of the quad, relative to the
+// direction towards the other end.  size.x is the line width.
+
+uniform mat4 worldview_matrix;
+uniform mat4 projection_matrix;
+uniform vec4 size;
+
+attribute vec4 uv0;
+
+#ifdef WITH_DEPTH
+varying float depth;
+#endif
+
+void main()
+{
+  vec4 pos = worldview_matrix * gl_Vertex;
+  vec3 other = ( worldview_matrix * vec4( uv0.xyz, 1.0 ) ).xyz;
+
+  // widen perpendicular to the segment and to the line of sight
+  vec3 side = cross( other - pos.xyz, pos.xyz );
+  float len = length( side );
+  if( len > 0.0 )
+  {
+    side /= len;
+  }
+  pos.xyz += side * ( uv0.w * 0.5 * size.x );
+
+  gl_Position = projection_matrix * pos;
+  gl_FrontColor = gl_Color;
+
+#ifdef WITH_DEPTH
+  depth = -pos.z;
+#endif
+}
@@ -0,0 +1,47 @@
+#version 120
+
+// glsl150/include/colormap150.vert is a copy of this for glsl150
+// programs.  Keep the two in sync.
+
+// Maps a value stored in the rgb bytes of a vertex color by
+// rviz::PointCloud::encodeColorMapValue() to a color.
+//
+// colormap.x and colormap.y scale and offset the stored value
+// to [0..1], colormap.z selects the map:
+// 1: rainbow, 2: inverted rainbow, 3: min to max color.
+
+uniform vec4 colormap;
+uniform vec4 colormap_min_color;
+uniform vec4 colormap_max_color;
+
+vec3 rainbow( float value )
+{
+  float h = clamp( value, 0.0, 1.0 ) * 5.0 + 1.0;
+  float i = floor( h );
+  float f = h - i;
+  if( mod( i, 2.0 ) < 0.5 ) f = 1.0 - f; // if i is even
+  float n = 1.0 - f;
+
+  if( i <= 1.0 ) return vec3( n, 0.0, 1.0 );
+  if( i == 2.0 ) return vec3( 0.0, n, 1.0 );
+  if( i == 3.0 ) return vec3( 0.0, 1.0, n );
+  if( i == 4.0 ) return vec3( n, 1.0, 0.0 );
+  return vec3( 1.0, n, 0.0 );
+}
+
+vec4 colormapColor( vec4 encoded )
+{
+  vec3 bytes = floor( encoded.rgb * 255.0 + 0.5 );
+  float value = dot( bytes, vec3( 65536.0, 256.0, 1.0 )) / 16777215.0;
+  float t = value * colormap.x + colormap.y;
+
+  if( colormap.z > 2.5 )
+  {
+    return vec4( mix( colormap_min_color.rgb, colormap_max_color.rgb, clamp( t, 0.0, 1.0 )), encoded.a );
+  }
+  if( colormap.z < 1.5 )
+  {
+    t = 1.0 - t;
+  }
+  return vec4( rainbow( t ), encoded.a );
+}
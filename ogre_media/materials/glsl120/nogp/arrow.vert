@@ -0,0 +1,52 @@
+#version 120
+
+// Computes the position of an arrow vertex from the vertex of a unit
+// arrow, rotated by the arrow's orientation quaternion.
+// Used in case that geometry shaders are not supported.
+//
+// gl_MultiTexCoord0: orientation quaternion (x, y, z, w)
+// gl_MultiTexCoord1: vertex of the unit arrow; w selects the shaft (0) or the head (1)
+// gl_MultiTexCoord2: face normal of the unit arrow, zero for lines
+//
+// size.x: shaft length
+// size.y: shaft radius (half width)
+// size.z: head length
+// size.w: head radius (half width at the base)
+
+uniform mat4 worldviewproj_matrix;
+uniform mat4 worldview_matrix;
+uniform vec4 size;
+
+vec3 rotate( vec4 q, vec3 v )
+{
+  return v + 2.0 * cross( q.xyz, cross( q.xyz, v ) + q.w * v );
+}
+
+void main()
+{
+  // An unset orientation is all zeros; draw it along x like identity.
+  vec4 o = gl_MultiTexCoord0;
+  vec4 q = dot( o, o ) < 1e-12 ? vec4( 0.0, 0.0, 0.0, 1.0 ) : normalize( o );
+  vec4 v = gl_MultiTexCoord1;
+
+  vec3 local;
+  if( v.w < 0.5 )
+  {
+    local = vec3( v.x * size.x, v.yz * size.y );
+  }
+  else
+  {
+    local = vec3( size.x + v.x * size.z, v.yz * size.w );
+  }
+
+  vec4 pos = vec4( gl_Vertex.xyz + rotate( q, local ), 1.0 );
+  gl_Position = worldviewproj_matrix * pos;
+
+  float lightness = 1.0;
+  vec3 normal = gl_MultiTexCoord2.xyz;
+  if( dot( normal, normal ) > 0.0 )
+  {
+    lightness = 0.5 + 0.5 * abs( (worldview_matrix * vec4( rotate( q, normal ), 0.0 )).z );
+  }
+  gl_FrontColor = vec4( gl_Color.rgb * lightness, gl_Color.a );
+}
@@ -10,6 +10,11 @@ uniform vec4 size;
 uniform vec4 normal;
 uniform vec4 up;
 
+#ifdef WITH_COLORMAP
+  //include:
+  vec4 colormapColor( vec4 encoded );
+#endif
+
 #ifdef WITH_DEPTH
 //include:
 void passDepth( vec4 pos );
@@ -27,7 +32,11 @@ void main()
   
   gl_Position = worldviewproj_matrix * pos;
   gl_TexCoord[0] = gl_MultiTexCoord0 + vec4(0.5,0.5,0.0,0.0);
+#ifdef WITH_COLORMAP
+  gl_FrontColor = colormapColor( gl_Color );
+#else
   gl_FrontColor = gl_Color;
+#endif
 
 #ifdef WITH_DEPTH
   passDepth( pos );
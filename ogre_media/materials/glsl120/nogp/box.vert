@@ -8,6 +8,11 @@ uniform vec4 camera_pos;
 uniform vec4 size;
 uniform vec4 auto_size;
 
+#ifdef WITH_COLORMAP
+  //include:
+  vec4 colormapColor( vec4 encoded );
+#endif
+
 #ifdef WITH_DEPTH
   //include:
   void passDepth( vec4 pos );
@@ -23,7 +28,11 @@ void main()
   vec4 pos = gl_Vertex - s;
   gl_Position = worldviewproj_matrix * pos;
   gl_TexCoord[0] = gl_MultiTexCoord0;
+#ifdef WITH_COLORMAP
+  gl_FrontColor = colormapColor( gl_Color );
+#else
   gl_FrontColor = gl_Color;
+#endif
 
 #ifdef WITH_DEPTH
   passDepth( pos );
@@ -7,6 +7,11 @@
 uniform mat4 worldviewproj_matrix;
 uniform vec4 size;
 
+#ifdef WITH_COLORMAP
+  //include:
+  vec4 colormapColor( vec4 encoded );
+#endif
+
 #ifdef WITH_DEPTH
   //include:
   void passDepth( vec4 pos );
@@ -15,7 +20,11 @@ uniform vec4 size;
 void main()
 {
   gl_Position = worldviewproj_matrix * gl_Vertex;
+#ifdef WITH_COLORMAP
+  gl_FrontColor = colormapColor( gl_Color );
+#else
   gl_FrontColor = gl_Color;
+#endif
   gl_PointSize = size.x;
 
 #ifdef WITH_DEPTH
@@ -0,0 +1,13 @@
+#version 120
+
+// Modulates the vertex color with the glyph coverage from the font texture.
+
+uniform sampler2D font_texture;
+
+varying vec2 UV;
+
+void main()
+{
+  vec4 glyph = texture2D( font_texture, UV );
+  gl_FragColor = gl_Color * glyph;
+}
@@ -0,0 +1,27 @@
+#version 120
+
+// Billboarded text for TextCloud.  gl_Vertex is the anchor of the
+// label; the glyph corner offset (uv1) is added in view space so every
+// label faces the camera.
+
+uniform mat4 worldview_matrix;
+uniform mat4 projection_matrix;
+
+attribute vec4 uv0;
+attribute vec4 uv1;
+
+varying vec2 UV;
+
+void main()
+{
+  vec4 view_pos = worldview_matrix * gl_Vertex;
+  view_pos.xy += uv1.xy;
+  gl_Position = projection_matrix * view_pos;
+  UV = uv0.xy;
+
+#ifdef WITH_PICK
+  gl_FrontColor = vec4( gl_SecondaryColor.rgb, 1.0 );
+#else
+  gl_FrontColor = gl_Color;
+#endif
+}
@@ -0,0 +1,16 @@
+#version 120
+
+// Writes the per-label pick color wherever a glyph covers the pixel.
+
+uniform sampler2D font_texture;
+
+varying vec2 UV;
+
+void main()
+{
+  if( texture2D( font_texture, UV ).a < 0.5 )
+  {
+    discard;
+  }
+  gl_FragColor = gl_Color;
+}
@@ -3,6 +3,11 @@
 // this merely passes over position and color, 
 // as needed by box.geom
 
+#ifdef WITH_COLORMAP
+  //include: rviz/glsl150/include/colormap.vert
+  vec4 colormapColor( vec4 encoded );
+#endif
+
 out gl_PerVertex {
 	vec4 gl_Position;
 	vec4 gl_FrontColor;
@@ -10,5 +15,9 @@ out gl_PerVertex {
 
 void main() {
     gl_Position = gl_Vertex;
+#ifdef WITH_COLORMAP
+    gl_FrontColor = colormapColor( gl_Color );
+#else
     gl_FrontColor = gl_Color;
+#endif
 }
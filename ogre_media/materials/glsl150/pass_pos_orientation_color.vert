@@ -0,0 +1,17 @@
+#version 150 compatibility
+
+// Passes over position, color and an orientation
+// quaternion (in texture coords 0), as needed by arrow.geom
+
+out gl_PerVertex {
+	vec4 gl_Position;
+	vec4 gl_FrontColor;
+};
+
+out vec4 orientation;
+
+void main() {
+    gl_Position = gl_Vertex;
+    gl_FrontColor = gl_Color;
+    orientation = gl_MultiTexCoord0;
+}
@@ -45,9 +45,11 @@
 #include <QCheckBox>
 #include <QComboBox>
 #include <QHeaderView>
+#include <QSet>
 
 #include "add_display_dialog.h"
 #include "rviz/load_resource.h"
+#include "rviz/topic_cache.h"
 
 #include "display_factory.h"
 
@@ -56,12 +58,6 @@ namespace rviz
 
 // Utilities for grouping topics together
 
-struct LexicalTopicInfo {
-  bool operator()(const ros::master::TopicInfo &a, const ros::master::TopicInfo &b) {
-    return a.name < b.name;
-  }
-};
-
 /**
  * Return true if one topic is a subtopic of the other.
  *
@@ -117,9 +113,8 @@ void getPluginGroups( const QMap<QString, QString> &datatype_plugins,
                       QList<PluginGroup> *groups,
                       QList<ros::master::TopicInfo> *unvisualizable )
 {
-  ros::master::V_TopicInfo all_topics;
-  ros::master::getTopics( all_topics );
-  std::sort( all_topics.begin(), all_topics.end(), LexicalTopicInfo() );
+  // Already sorted by name.
+  ros::master::V_TopicInfo all_topics = TopicCache::get()->getTopics();
   ros::master::V_TopicInfo::iterator topic_it;
 
   for ( topic_it = all_topics.begin(); topic_it != all_topics.end(); ++topic_it )
@@ -429,6 +424,7 @@ void DisplayTypeTree::fillTree( Factory *factory )
 }
 
 TopicDisplayWidget::TopicDisplayWidget()
+  : factory_( NULL )
 {
   tree_ = new QTreeWidget;
   tree_->setHeaderHidden( true );
@@ -463,7 +459,7 @@ void TopicDisplayWidget::onCurrentItemChanged( QTreeWidgetItem* curr )
 {
   // If plugin is selected, populate selection data.  Otherwise, clear data.
   SelectionData sd;
-  if ( curr->data( 1, Qt::UserRole ).isValid() )
+  if ( curr && curr->data( 1, Qt::UserRole ).isValid() )
   {
     QTreeWidgetItem *parent = curr->parent();
     sd.whats_this = curr->whatsThis( 0 );
@@ -508,7 +504,38 @@ void TopicDisplayWidget::stateChanged( int state )
 
 void TopicDisplayWidget::fill( DisplayFactory *factory )
 {
+  factory_ = factory;
   findPlugins( factory );
+  fillTopics();
+
+  connect( TopicCache::get(), SIGNAL( topicsChanged() ), this, SLOT( fillTopics() ));
+}
+
+QString TopicDisplayWidget::itemKey( QTreeWidgetItem* item ) const
+{
+  QString key;
+  for( ; item; item = item->parent() )
+  {
+    key = item->text( 0 ) + "\n" + key;
+  }
+  return key;
+}
+
+void TopicDisplayWidget::fillTopics()
+{
+  DisplayFactory *factory = factory_;
+
+  QString current_key = tree_->currentItem() ? itemKey( tree_->currentItem() ) : QString();
+  QSet<QString> expanded_keys;
+  for( QTreeWidgetItemIterator it( tree_ ); *it; ++it )
+  {
+    if( (*it)->isExpanded() )
+    {
+      expanded_keys.insert( itemKey( *it ));
+    }
+  }
+  tree_->blockSignals( true );
+  tree_->clear();
 
   QList<PluginGroup> groups;
   QList<ros::master::TopicInfo> unvisualizable;
@@ -561,6 +588,31 @@ void TopicDisplayWidget::fill( DisplayFactory *factory )
 
   // Hide unvisualizable topics if necessary
   stateChanged( enable_hidden_box_->isChecked() );
+
+  QTreeWidgetItem *current = NULL;
+  for( QTreeWidgetItemIterator it( tree_ ); *it; ++it )
+  {
+    QString key = itemKey( *it );
+    if( expanded_keys.contains( key ))
+    {
+      (*it)->setExpanded( true );
+    }
+    if( key == current_key )
+    {
+      current = *it;
+    }
+  }
+  if( current )
+  {
+    tree_->setCurrentItem( current );
+  }
+  tree_->blockSignals( false );
+
+  // The selection data refers to items which are gone now.
+  if( !current_key.isEmpty() )
+  {
+    onCurrentItemChanged( current );
+  }
 }
 
 void TopicDisplayWidget::findPlugins( DisplayFactory *factory )
@@ -181,6 +181,10 @@ private Q_SLOTS:
   void onCurrentItemChanged( QTreeWidgetItem *curr );
   void onComboBoxClicked( QTreeWidgetItem *curr );
 
+  /** Rebuild the tree from the topic cache, keeping the current and
+   * expanded items.  Called again whenever the topic list changes. */
+  void fillTopics();
+
 private:
   void findPlugins( DisplayFactory* );
 
@@ -191,6 +195,10 @@ private:
    */
   QTreeWidgetItem* insertItem ( const QString &topic, bool disabled );
 
+  /** Return @a item's topic path and display name, to find it again after fillTopics(). */
+  QString itemKey( QTreeWidgetItem* item ) const;
+
+  DisplayFactory *factory_;
   QTreeWidget *tree_;
   QCheckBox *enable_hidden_box_;
 
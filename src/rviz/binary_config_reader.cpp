@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QFile>
+
+#include "rviz/binary_config_writer.h"
+
+#include "rviz/binary_config_reader.h"
+
+namespace rviz
+{
+
+/** Read the quint32 @a offset bytes ahead in @a in without consuming
+ * anything.  Sets ReadPastEnd and returns false at the end of the data. */
+static bool peekUInt32( QDataStream& in, int offset, quint32& value )
+{
+  QByteArray head = in.device()->peek( offset + 4 );
+  if( head.size() < offset + 4 )
+  {
+    in.setStatus( QDataStream::ReadPastEnd );
+    return false;
+  }
+  QDataStream head_in( head );
+  head_in.setByteOrder( in.byteOrder() );
+  head_in.skipRawData( offset );
+  head_in >> value;
+  return true;
+}
+
+/** Check that the QString @a offset bytes ahead in @a in fits into the
+ * rest of the data, so a corrupt length cannot make QDataStream
+ * allocate it up front.  Sets ReadCorruptData and returns false if not. */
+static bool checkStringLength( QDataStream& in, int offset )
+{
+  quint32 length;
+  if( !peekUInt32( in, offset, length ))
+  {
+    return false;
+  }
+  // 0xffffffff marks a null string, which has no data.
+  if( length != 0xffffffff && length > in.device()->bytesAvailable() - offset - 4 )
+  {
+    in.setStatus( QDataStream::ReadCorruptData );
+    return false;
+  }
+  return true;
+}
+
+BinaryConfigReader::BinaryConfigReader()
+  : error_( false )
+{}
+
+void BinaryConfigReader::readFile( Config& config, const QString& filename )
+{
+  error_ = false;
+  message_ = "";
+
+  QFile file( filename );
+  if( !file.open( QIODevice::ReadOnly ))
+  {
+    error_ = true;
+    message_ = "Failed to open " + filename + ".";
+    return;
+  }
+
+  // Decode straight from the mapping.  fromRawData() does not copy,
+  // and the mapping lives as long as file.
+  QByteArray data;
+  uchar* mapped = file.map( 0, file.size() );
+  if( mapped )
+  {
+    data = QByteArray::fromRawData( (const char*) mapped, file.size() );
+  }
+  else
+  {
+    data = file.readAll();
+  }
+
+  QDataStream in( data );
+  in.setVersion( QDataStream::Qt_4_6 );
+  quint32 magic = 0;
+  quint32 version = 0;
+  in >> magic >> version;
+  if( magic != BinaryConfigWriter::MAGIC )
+  {
+    error_ = true;
+    message_ = filename + " is not a binary rviz config.";
+    return;
+  }
+  if( version != BinaryConfigWriter::VERSION )
+  {
+    error_ = true;
+    message_ = filename + " has binary config version " + QString::number( version ) +
+      ", expected " + QString::number( BinaryConfigWriter::VERSION ) + ".";
+    return;
+  }
+
+  readConfigNode( config, in, 0 );
+  if( in.status() != QDataStream::Ok )
+  {
+    error_ = true;
+    message_ = filename + " is truncated or corrupt.";
+  }
+}
+
+bool BinaryConfigReader::error()
+{
+  return error_;
+}
+
+QString BinaryConfigReader::errorMessage()
+{
+  return message_;
+}
+
+void BinaryConfigReader::readConfigNode( Config& config, QDataStream& in, int depth )
+{
+  if( depth > MAX_DEPTH )
+  {
+    in.setStatus( QDataStream::ReadCorruptData );
+    return;
+  }
+
+  quint8 type;
+  in >> type;
+  if( in.status() != QDataStream::Ok )
+  {
+    return;
+  }
+
+  switch( type )
+  {
+  case Config::List:
+  {
+    quint32 num_children;
+    in >> num_children;
+    config.setType( Config::List );
+    // The status check ends the loop at the end of a truncated file,
+    // whatever count it claims.
+    for( quint32 i = 0; i < num_children && in.status() == QDataStream::Ok; i++ )
+    {
+      Config child = config.listAppendNew();
+      readConfigNode( child, in, depth + 1 );
+    }
+    break;
+  }
+  case Config::Map:
+  {
+    quint32 num_children;
+    in >> num_children;
+    config.setType( Config::Map );
+    for( quint32 i = 0; i < num_children && in.status() == QDataStream::Ok; i++ )
+    {
+      if( !checkStringLength( in, 0 ))
+      {
+        break;
+      }
+      QString key;
+      in >> key;
+      Config child = config.mapMakeChild( key );
+      readConfigNode( child, in, depth + 1 );
+    }
+    break;
+  }
+  case Config::Value:
+  {
+    // A QVariant is stored as its quint32 type and a quint8 null flag,
+    // followed by the data.
+    quint32 value_type;
+    if( !peekUInt32( in, 0, value_type ) ||
+        ( value_type == QVariant::String && !checkStringLength( in, 5 )))
+    {
+      break;
+    }
+    QVariant value;
+    in >> value;
+    config.setValue( value );
+    break;
+  }
+  case Config::Empty:
+    config.setType( Config::Empty );
+    break;
+  default:
+    in.setStatus( QDataStream::ReadCorruptData );
+    break;
+  }
+}
+
+} // end namespace rviz
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RVIZ_BINARY_CONFIG_READER_H
+#define RVIZ_BINARY_CONFIG_READER_H
+
+#include "rviz/config.h"
+
+class QDataStream;
+
+namespace rviz
+{
+
+/** @brief Reads a Config tree written by BinaryConfigWriter. */
+class BinaryConfigReader
+{
+public:
+  /** @brief Constructor.  Object begins in a no-error state. */
+  BinaryConfigReader();
+
+  /** @brief Read config data from a file.
+   *
+   * The file is memory-mapped where possible and decoded in place.
+   * Files from a different format version are rejected with an
+   * error, as are strings longer than the rest of the file and
+   * nesting deeper than MAX_DEPTH, which a truncated or corrupt file
+   * would otherwise turn into huge allocations or a stack overflow.
+   * This potentially changes the return values of error() and
+   * errorMessage(). */
+  void readFile( Config& config, const QString& filename );
+
+  /** @brief Return true if the latest readFile() call had an error. */
+  bool error();
+
+  /** @brief Return an error message if the latest read call had an
+   * error, or the empty string if not. */
+  QString errorMessage();
+
+  /** @brief Deepest nesting of lists and maps accepted by readFile(). */
+  static const int MAX_DEPTH = 64;
+
+private:
+  void readConfigNode( Config& config, QDataStream& in, int depth );
+
+  QString message_;
+  bool error_;
+};
+
+} // end namespace rviz
+
+#endif // RVIZ_BINARY_CONFIG_READER_H
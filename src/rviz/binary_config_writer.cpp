@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include <QDataStream>
+#include <QFile>
+
+#include "rviz/binary_config_writer.h"
+
+namespace rviz
+{
+
+BinaryConfigWriter::BinaryConfigWriter()
+  : error_( false )
+{}
+
+void BinaryConfigWriter::writeFile( const Config& config, const QString& filename )
+{
+  error_ = false;
+  message_ = "";
+
+  QString temp_filename = filename + ".tmp";
+  QFile file( temp_filename );
+  if( !file.open( QIODevice::WriteOnly | QIODevice::Truncate ))
+  {
+    error_ = true;
+    message_ = "Failed to open " + temp_filename + " for writing.";
+    return;
+  }
+
+  QDataStream out( &file );
+  out.setVersion( QDataStream::Qt_4_6 );
+  out << MAGIC << VERSION;
+  writeConfigNode( config, out );
+  // Get the data onto the disk before the rename makes it the real
+  // file, so a crash cannot leave an empty or partial file behind.
+  bool synced = file.flush() && fsync( file.handle() ) == 0;
+  file.close();
+
+  if( out.status() != QDataStream::Ok || file.error() != QFile::NoError || !synced )
+  {
+    error_ = true;
+    message_ = "Failed to write " + temp_filename + ".";
+    QFile::remove( temp_filename );
+    return;
+  }
+
+  // rename() replaces the old file atomically, QFile::rename() would refuse.
+  if( rename( qPrintable( temp_filename ), qPrintable( filename )) != 0 )
+  {
+    error_ = true;
+    message_ = "Failed to rename " + temp_filename + " to " + filename + ".";
+    QFile::remove( temp_filename );
+  }
+}
+
+bool BinaryConfigWriter::error()
+{
+  return error_;
+}
+
+QString BinaryConfigWriter::errorMessage()
+{
+  return message_;
+}
+
+void BinaryConfigWriter::writeConfigNode( const Config& config, QDataStream& out )
+{
+  Config::Type type = config.getType();
+  if( type == Config::Invalid )
+  {
+    type = Config::Empty;
+  }
+  out << quint8( type );
+
+  switch( type )
+  {
+  case Config::List:
+  {
+    int num_children = config.listLength();
+    out << quint32( num_children );
+    for( int i = 0; i < num_children; i++ )
+    {
+      writeConfigNode( config.listChildAt( i ), out );
+    }
+    break;
+  }
+  case Config::Map:
+  {
+    int num_children = 0;
+    Config::MapIterator count_iter = config.mapIterator();
+    for( ; count_iter.isValid(); count_iter.advance() )
+    {
+      num_children++;
+    }
+    out << quint32( num_children );
+    Config::MapIterator iter = config.mapIterator();
+    for( ; iter.isValid(); iter.advance() )
+    {
+      out << iter.currentKey();
+      writeConfigNode( iter.currentChild(), out );
+    }
+    break;
+  }
+  case Config::Value:
+    out << config.getValue();
+    break;
+  default:
+    break;
+  }
+}
+
+} // end namespace rviz
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RVIZ_BINARY_CONFIG_WRITER_H
+#define RVIZ_BINARY_CONFIG_WRITER_H
+
+#include "rviz/config.h"
+
+class QDataStream;
+
+namespace rviz
+{
+
+/**
+ * \brief Writes a Config tree in rviz's compact binary snapshot format.
+ *
+ * Meant for autosave snapshots, which are written often and read back
+ * by BinaryConfigReader only; YAML stays the format for config files
+ * people edit.  The file starts with a magic number and a format
+ * version, followed by the nodes depth first: a type byte, then for a
+ * map its size and key/child pairs, for a list its size and children,
+ * and for a value the QVariant.
+ */
+class BinaryConfigWriter
+{
+public:
+  /** @brief Constructor.  Writer starts in a non-error state. */
+  BinaryConfigWriter();
+
+  /** @brief Write config data to a file.
+   *
+   * The data goes to a temporary file first, which is synced to disk
+   * and then replaces @a filename, so a crash while writing leaves the
+   * previous file intact.  This potentially changes the return values of error()
+   * and errorMessage(). */
+  void writeFile( const Config& config, const QString& filename );
+
+  /** @brief Return true if the latest write operation had an error. */
+  bool error();
+
+  /** @brief Return an error message if the latest write call had an
+   * error, or the empty string if there was no error. */
+  QString errorMessage();
+
+  static const quint32 MAGIC = 0x52564346; ///< "RVCF"
+  static const quint32 VERSION = 1;
+
+private:
+  void writeConfigNode( const Config& config, QDataStream& out );
+
+  QString message_;
+  bool error_;
+};
+
+} // end namespace rviz
+
+#endif // RVIZ_BINARY_CONFIG_WRITER_H
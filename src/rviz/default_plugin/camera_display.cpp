@@ -340,6 +340,7 @@ void CameraDisplay::update( float wall_dt, float ros_dt )
       caminfo_ok_ = updateCamera();
       force_render_ = false;
     }
+    setQueueStatus( texture_.getMailbox().getQueuedCount(), texture_.getMailbox().getDroppedCount() );
   }
   catch( UnsupportedImageEncoding& e )
   {
@@ -36,6 +36,8 @@
 #include <OGRE/OgreRenderTargetListener.h>
 
 #ifndef Q_MOC_RUN
+# include <boost/thread/mutex.hpp>
+
 # include <sensor_msgs/CameraInfo.h>
 
 # include <message_filters/subscriber.h>
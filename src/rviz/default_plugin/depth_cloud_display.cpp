@@ -38,6 +38,7 @@
 #include "rviz/properties/bool_property.h"
 #include "rviz/properties/int_property.h"
 #include "rviz/frame_manager.h"
+#include "rviz/topic_cache.h"
 
 #include <tf/transform_listener.h>
 
@@ -100,6 +101,7 @@ DepthCloudDisplay::DepthCloudDisplay()
   depth_transport_property_ = new EnumProperty("Depth Map Transport Hint", "raw", "Preferred method of sending images.", this, SLOT( updateTopic() ));
 
   connect(depth_transport_property_, SIGNAL( requestOptions( EnumProperty* )), this,  SLOT( fillTransportOptionList( EnumProperty* )));
+  connect(TopicCache::get(), SIGNAL( topicsChanged() ), depth_transport_property_, SLOT( refreshOptions() ));
 
   depth_transport_property_->setStdString("raw");
 
@@ -119,6 +121,7 @@ DepthCloudDisplay::DepthCloudDisplay()
 
 
   connect(color_transport_property_, SIGNAL( requestOptions( EnumProperty* )), this, SLOT( fillTransportOptionList( EnumProperty* )));
+  connect(TopicCache::get(), SIGNAL( topicsChanged() ), color_transport_property_, SLOT( refreshOptions() ));
 
   color_transport_property_->setStdString("raw");
 
@@ -571,8 +574,7 @@ void DepthCloudDisplay::fillTransportOptionList(EnumProperty* property)
   choices.push_back("raw");
 
   // Loop over all current ROS topic names
-  ros::master::V_TopicInfo topics;
-  ros::master::getTopics(topics);
+  ros::master::V_TopicInfo topics = TopicCache::get()->getTopics();
   ros::master::V_TopicInfo::iterator it = topics.begin();
   ros::master::V_TopicInfo::iterator end = topics.end();
   for (; it != end; ++it)
@@ -190,6 +190,7 @@ void ImageDisplay::update( float wall_dt, float ros_dt )
   try
   {
     texture_.update();
+    setQueueStatus( texture_.getMailbox().getQueuedCount(), texture_.getMailbox().getDroppedCount() );
 
     //make sure the aspect ratio of the image is preserved
     float win_width = render_panel_->width();
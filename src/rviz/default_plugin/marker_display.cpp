@@ -29,6 +29,8 @@
 
 #include <sstream>
 
+#include <OGRE/OgreAxisAlignedBox.h>
+
 #include <tf/transform_listener.h>
 
 #include "rviz/default_plugin/markers/arrow_marker.h"
@@ -44,6 +46,8 @@
 #include "rviz/ogre_helpers/arrow.h"
 #include "rviz/ogre_helpers/billboard_line.h"
 #include "rviz/ogre_helpers/shape.h"
+#include "rviz/ogre_helpers/text_cloud.h"
+#include "rviz/properties/float_property.h"
 #include "rviz/properties/int_property.h"
 #include "rviz/properties/property.h"
 #include "rviz/properties/ros_topic_property.h"
@@ -59,6 +63,8 @@ namespace rviz
 
 MarkerDisplay::MarkerDisplay()
   : Display()
+  , message_queue_( MessageMailbox<visualization_msgs::Marker::ConstPtr>::DropOldest )
+  , text_cloud_( NULL )
 {
   marker_topic_property_ = new RosTopicProperty( "Marker Topic", "visualization_marker",
                                                  QString::fromStdString( ros::message_traits::datatype<visualization_msgs::Marker>() ),
@@ -73,11 +79,20 @@ MarkerDisplay::MarkerDisplay()
                                           this, SLOT( updateQueueSize() ));
   queue_size_property_->setMin( 0 );
 
+  mesh_lod_bias_property_ = new FloatProperty( "Mesh LOD Bias", 1,
+                                               "Scales the screen size at which large mesh markers switch to simplified versions."
+                                               "  Lower values simplify sooner, higher values keep full detail longer.",
+                                               this, SLOT( updateMeshLodBias() ));
+  mesh_lod_bias_property_->setMin( 0.01 );
+
   namespaces_category_ = new Property( "Namespaces", QVariant(), "", this );
 }
 
 void MarkerDisplay::onInitialize()
 {
+  text_cloud_ = new TextCloud();
+  scene_node_->attachObject( text_cloud_ );
+
   tf_filter_ = new tf::MessageFilter<visualization_msgs::Marker>( *context_->getTFClient(),
                                                                   fixed_frame_.toStdString(),
                                                                   queue_size_property_->getInt(),
@@ -97,11 +112,13 @@ MarkerDisplay::~MarkerDisplay()
     clearMarkers();
 
     delete tf_filter_;
+    delete text_cloud_;
   }
 }
 
 void MarkerDisplay::clearMarkers()
 {
+  message_queue_.clear();
   markers_.clear();
   markers_with_expiration_.clear();
   frame_locked_markers_.clear();
@@ -128,6 +145,23 @@ void MarkerDisplay::updateQueueSize()
   tf_filter_->setQueueSize( (uint32_t) queue_size_property_->getInt() );
 }
 
+float MarkerDisplay::getMeshLodBias() const
+{
+  return mesh_lod_bias_property_->getFloat();
+}
+
+void MarkerDisplay::updateMeshLodBias()
+{
+  float bias = getMeshLodBias();
+  M_IDToMarker::iterator it = markers_.begin();
+  M_IDToMarker::iterator end = markers_.end();
+  for( ; it != end; ++it )
+  {
+    it->second->setMeshLodBias( bias );
+  }
+  context_->queueRender();
+}
+
 void MarkerDisplay::updateTopic()
 {
   unsubscribe();
@@ -233,9 +267,7 @@ void MarkerDisplay::incomingMarkerArray(const visualization_msgs::MarkerArray::C
 
 void MarkerDisplay::incomingMarker( const visualization_msgs::Marker::ConstPtr& marker )
 {
-  boost::mutex::scoped_lock lock(queue_mutex_);
-
-  message_queue_.push_back(marker);
+  message_queue_.push(marker);
 }
 
 void MarkerDisplay::failedMarker(const visualization_msgs::Marker::ConstPtr& marker, tf::FilterFailureReason reason)
@@ -395,25 +427,17 @@ void MarkerDisplay::processDelete( const visualization_msgs::Marker::ConstPtr& m
 
 void MarkerDisplay::update(float wall_dt, float ros_dt)
 {
-  V_MarkerMessage local_queue;
-
-  {
-    boost::mutex::scoped_lock lock(queue_mutex_);
-
-    local_queue.swap( message_queue_ );
-  }
-
-  if ( !local_queue.empty() )
+  // Only process what was queued when we started, so a fast
+  // publisher can not keep us here, and leave what does not fit into
+  // our update time for the next update.
+  uint32_t queued = message_queue_.getQueuedCount();
+  visualization_msgs::Marker::ConstPtr marker;
+  for ( uint32_t i = 0; i < queued && ( i == 0 || hasUpdateTimeLeft() ) && message_queue_.pop( &marker ); i++ )
   {
-    V_MarkerMessage::iterator message_it = local_queue.begin();
-    V_MarkerMessage::iterator message_end = local_queue.end();
-    for ( ; message_it != message_end; ++message_it )
-    {
-      visualization_msgs::Marker::ConstPtr& marker = *message_it;
-
-      processMessage( marker );
-    }
+    processMessage( marker );
   }
+  marker.reset();
+  setQueueStatus( message_queue_.getQueuedCount(), message_queue_.getDroppedCount() );
 
   {
     S_MarkerBase::iterator it = markers_with_expiration_.begin();
@@ -424,6 +448,7 @@ void MarkerDisplay::update(float wall_dt, float ros_dt)
       if (marker->expired())
       {
         ++it;
+        context_->queueRender( marker->getWorldBounds() );
         deleteMarker(marker->getID());
       }
       else
@@ -33,7 +33,6 @@
 #include <map>
 #include <set>
 
-#include <boost/thread/mutex.hpp>
 #include <boost/shared_ptr.hpp>
 
 #ifndef Q_MOC_RUN
@@ -45,17 +44,20 @@
 #include <visualization_msgs/MarkerArray.h>
 
 #include "rviz/display.h"
+#include "rviz/message_mailbox.h"
 #include "rviz/properties/bool_property.h"
 #include "rviz/selection/forwards.h"
 
 namespace rviz
 {
+class FloatProperty;
 class IntProperty;
 class MarkerBase;
 class MarkerNamespace;
 class MarkerSelectionHandler;
 class Object;
 class RosTopicProperty;
+class TextCloud;
 
 typedef boost::shared_ptr<MarkerSelectionHandler> MarkerSelectionHandlerPtr;
 typedef boost::shared_ptr<MarkerBase> MarkerBasePtr;
@@ -86,6 +88,12 @@ public:
   void setMarkerStatus(MarkerID id, StatusLevel level, const std::string& text);
   void deleteMarkerStatus(MarkerID id);
 
+  /** @brief The text batch shared by all text markers of this display. */
+  TextCloud* getTextCloud() { return text_cloud_; }
+
+  /** @brief LOD bias for the entities of mesh markers, from the "Mesh LOD Bias" property. */
+  float getMeshLodBias() const;
+
 protected:
   virtual void onEnable();
   virtual void onDisable();
@@ -105,9 +113,11 @@ protected:
 
   RosTopicProperty* marker_topic_property_;
   IntProperty* queue_size_property_;
+  FloatProperty* mesh_lod_bias_property_;
 
 private Q_SLOTS:
   void updateQueueSize();
+  void updateMeshLodBias();
   void updateTopic();
 
 private:
@@ -147,14 +157,14 @@ private:
   M_IDToMarker markers_;                                ///< Map of marker id to the marker info structure
   S_MarkerBase markers_with_expiration_;
   S_MarkerBase frame_locked_markers_;
-  typedef std::vector<visualization_msgs::Marker::ConstPtr> V_MarkerMessage;
-  V_MarkerMessage message_queue_;                       ///< Marker message queue.  Messages are added to this as they are received, and then processed
-                                                        ///< in our update() function
-  boost::mutex queue_mutex_;
+  MessageMailbox<visualization_msgs::Marker::ConstPtr> message_queue_; ///< Marker message queue.  Messages are added to this as they are received, and then processed
+                                                                       ///< in our update() function
 
   message_filters::Subscriber<visualization_msgs::Marker> sub_;
   tf::MessageFilter<visualization_msgs::Marker>* tf_filter_;
 
+  TextCloud* text_cloud_;
+
   typedef QHash<QString, MarkerNamespace*> M_Namespace;
   M_Namespace namespaces_;
 
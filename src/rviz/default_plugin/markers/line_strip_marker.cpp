@@ -82,35 +82,28 @@ void LineStripMarker::onNewMessage(const MarkerConstPtr& old_message, const Mark
 
   bool has_per_point_color = new_message->colors.size() == new_message->points.size();
 
-  size_t i = 0;
-  std::vector<geometry_msgs::Point>::const_iterator it = new_message->points.begin();
-  std::vector<geometry_msgs::Point>::const_iterator end = new_message->points.end();
-  for ( ; it != end; ++it, ++i )
+  size_t num_points = new_message->points.size();
+  std::vector<Ogre::Vector3> points( num_points );
+  std::vector<Ogre::ColourValue> colors;
+  for ( size_t i = 0; i < num_points; ++i )
   {
-    const geometry_msgs::Point& p = *it;
-
-    Ogre::Vector3 v( p.x, p.y, p.z );
+    const geometry_msgs::Point& p = new_message->points[i];
+    points[i] = Ogre::Vector3( p.x, p.y, p.z );
+  }
 
-    Ogre::ColourValue c;
-    if (has_per_point_color)
+  if (has_per_point_color)
+  {
+    colors.resize( num_points );
+    for ( size_t i = 0; i < num_points; ++i )
     {
       const std_msgs::ColorRGBA& color = new_message->colors[i];
-      c.r = color.r;
-      c.g = color.g;
-      c.b = color.b;
-      c.a = color.a;
+      colors[i] = Ogre::ColourValue( color.r, color.g, color.b, color.a );
     }
-    else
-    {
-      c.r = new_message->color.r;
-      c.g = new_message->color.g;
-      c.b = new_message->color.b;
-      c.a = new_message->color.a;
-    }
-
-    lines_->addPoint( v, c );
   }
 
+  // Without per-point colors the points take the color set above.
+  lines_->addPoints( &points.front(), has_per_point_color ? &colors.front() : NULL, num_points );
+
   handler_.reset( new MarkerSelectionHandler( this, MarkerID( new_message->ns, new_message->id ), context_ ));
   handler_->addTrackedObjects( lines_->getSceneNode() );
 }
@@ -136,6 +136,12 @@ const Ogre::Quaternion& MarkerBase::getOrientation()
   return scene_node_->getOrientation();
 }
 
+Ogre::AxisAlignedBox MarkerBase::getWorldBounds()
+{
+  // Kept up to date by the scene graph, including child nodes.
+  return scene_node_->_getWorldAABB();
+}
+
 void MarkerBase::extractMaterials( Ogre::Entity *entity, S_MaterialPtr &materials )
 {
   uint32_t num_sub_entities = entity->getNumSubEntities();
@@ -41,6 +41,7 @@
 
 namespace Ogre
 {
+class AxisAlignedBox;
 class SceneNode;
 class Vector3;
 class Quaternion;
@@ -83,7 +84,7 @@ public:
   }
 
   /** @brief Associate an InteractiveObject with this MarkerBase. */
-  void setInteractiveObject( InteractiveObjectWPtr object );
+  virtual void setInteractiveObject( InteractiveObjectWPtr object );
 
   virtual void setPosition( const Ogre::Vector3& position );
   virtual void setOrientation( const Ogre::Quaternion& orientation );
@@ -92,6 +93,12 @@ public:
 
   virtual S_MaterialPtr getMaterials() { return S_MaterialPtr(); }
 
+  /** @brief Return the world-space bounds of everything this marker drew in the last frame. */
+  Ogre::AxisAlignedBox getWorldBounds();
+
+  /** @brief Scale the screen size at which meshes switch to simplified LOD levels.  Only mesh markers have any. */
+  virtual void setMeshLodBias( float bias ) {}
+
 protected:
   bool transform(const MarkerConstPtr& message, Ogre::Vector3& pos, Ogre::Quaternion& orient, Ogre::Vector3& scale);
   virtual void onNewMessage(const MarkerConstPtr& old_message, const MarkerConstPtr& new_message) = 0;
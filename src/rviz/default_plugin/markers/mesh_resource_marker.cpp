@@ -35,6 +35,7 @@
 
 #include "rviz/display_context.h"
 #include "rviz/mesh_loader.h"
+#include "rviz/ogre_helpers/material_cache.h"
 #include "marker_display.h"
 
 #include <OGRE/OgreSceneNode.h>
@@ -50,6 +51,7 @@ namespace rviz
 MeshResourceMarker::MeshResourceMarker(MarkerDisplay* owner, DisplayContext* context, Ogre::SceneNode* parent_node)
 : MarkerBase(owner, context, parent_node)
 , entity_(0)
+, private_materials_(false)
 {
 }
 
@@ -67,18 +69,13 @@ void MeshResourceMarker::reset()
     entity_ = 0;
   }
 
-  // destroy all the materials we've created
-  S_MaterialPtr::iterator it;
-  for ( it = materials_.begin(); it!=materials_.end(); it++ )
+  // give back all the materials we've acquired
+  for ( size_t i = 0; i < materials_.size(); i++ )
   {
-    Ogre::MaterialPtr material = *it;
-    if (!material.isNull())
-    {
-      material->unload();
-      Ogre::MaterialManager::getSingleton().remove(material->getName());
-    }
+    releaseMaterial( materials_[ i ]);
   }
   materials_.clear();
+  base_materials_.clear();
 }
 
 void MeshResourceMarker::onNewMessage(const MarkerConstPtr& old_message, const MarkerConstPtr& new_message)
@@ -120,51 +117,31 @@ void MeshResourceMarker::onNewMessage(const MarkerConstPtr& old_message, const M
     scene_node_->attachObject(entity_);
     need_color = true;
 
-    // create a default material for any sub-entities which don't have their own.
-    ss << "Material";
-    Ogre::MaterialPtr default_material = Ogre::MaterialManager::getSingleton().create( ss.str(), ROS_PACKAGE_NAME );
-    default_material->setReceiveShadows(false);
-    default_material->getTechnique(0)->setLightingEnabled(true);
-    default_material->getTechnique(0)->setAmbient( 0.5, 0.5, 0.5 );
-    materials_.insert( default_material );
-
-    if ( new_message->mesh_use_embedded_materials )
+    if ( owner_ )
     {
-      // make clones of all embedded materials so selection works correctly
-      S_MaterialPtr materials = getMaterials();
+      entity_->setMeshLodBias( owner_->getMeshLodBias() );
+    }
 
-      S_MaterialPtr::iterator it;
-      for ( it = materials.begin(); it!=materials.end(); it++ )
+    // Embedded materials are kept as the base of the colored material
+    // for their sub-entity.  BaseWhiteNoLighting is the default material
+    // Ogre uses when it sees a mesh with no material; those sub-entities
+    // get a plain material colored with new_message->color.  Selection
+    // colors are set per renderable, so markers with the same mesh and
+    // color share their materials through the cache, except for the
+    // markers of interactive controls, which modify their materials.
+    for (uint32_t i = 0; i < entity_->getNumSubEntities(); ++i)
+    {
+      std::string mat_name = entity_->getSubEntity(i)->getMaterialName();
+      if( new_message->mesh_use_embedded_materials && mat_name != "BaseWhiteNoLighting" )
       {
-        if( (*it)->getName() != "BaseWhiteNoLighting" )
-        {
-          Ogre::MaterialPtr new_material = (*it)->clone( id + (*it)->getName() );
-          materials_.insert( new_material );
-        }
+        base_materials_.push_back( mat_name );
       }
-
-      // make sub-entities use cloned materials
-      for (uint32_t i = 0; i < entity_->getNumSubEntities(); ++i)
+      else
       {
-        std::string mat_name = entity_->getSubEntity(i)->getMaterialName();
-        if( mat_name != "BaseWhiteNoLighting" )
-        {
-          entity_->getSubEntity(i)->setMaterialName( id + mat_name );
-        }
-        else
-        {
-          // BaseWhiteNoLighting is the default material Ogre uses
-          // when it sees a mesh with no material.  Here we replace
-          // that with our default_material which gets colored with
-          // new_message->color.
-          entity_->getSubEntity(i)->setMaterial( default_material );
-        }
+        base_materials_.push_back( "" );
       }
     }
-    else
-    {
-      entity_->setMaterial( default_material );
-    }
+    materials_.resize( base_materials_.size() );
 
     handler_.reset( new MarkerSelectionHandler( this, MarkerID( new_message->ns, new_message->id ), context_ ));
     handler_->addTrackedObject( entity_ );
@@ -192,30 +169,19 @@ void MeshResourceMarker::onNewMessage(const MarkerConstPtr& old_message, const M
       r = 1; g = 1; b = 1; a = 1;
     }
 
-    Ogre::SceneBlendType blending;
-    bool depth_write;
-
-    if ( a < 0.9998 )
-    {
-      blending = Ogre::SBT_TRANSPARENT_ALPHA;
-      depth_write = false;
-    }
-    else
-    {
-      blending = Ogre::SBT_REPLACE;
-      depth_write = true;
-    }
+    MaterialCache::Key key;
+    key.ambient = Ogre::ColourValue( r*0.5, g*0.5, b*0.5 );
+    key.diffuse = Ogre::ColourValue( r, g, b, a );
+    key.lighting = true;
 
-    S_MaterialPtr::iterator it;
-    for( it = materials_.begin(); it != materials_.end(); it++ )
+    for( size_t i = 0; i < materials_.size(); i++ )
     {
-      Ogre::Technique* technique = (*it)->getTechnique( 0 );
-
-      technique->setAmbient( r*0.5, g*0.5, b*0.5 );
-      technique->setDiffuse( r, g, b, a );
-      technique->setSceneBlending( blending );
-      technique->setDepthWriteEnabled( depth_write );
-      technique->setLightingEnabled( true );
+      // Acquire before releasing, so an unchanged key keeps its material.
+      key.base_material = base_materials_[ i ];
+      Ogre::MaterialPtr material = acquireMaterial( key );
+      entity_->getSubEntity( i )->setMaterial( material );
+      releaseMaterial( materials_[ i ]);
+      materials_[ i ] = material;
     }
   }
 
@@ -230,6 +196,71 @@ void MeshResourceMarker::onNewMessage(const MarkerConstPtr& old_message, const M
   scene_node_->setScale(scale);
 }
 
+void MeshResourceMarker::setInteractiveObject( InteractiveObjectWPtr object )
+{
+  MarkerBase::setInteractiveObject( object );
+
+  if( private_materials_ )
+  {
+    return;
+  }
+  private_materials_ = true;
+
+  for( size_t i = 0; i < materials_.size(); i++ )
+  {
+    if( !materials_[ i ].isNull() )
+    {
+      materials_[ i ] = makePrivate( materials_[ i ] );
+      entity_->getSubEntity( i )->setMaterial( materials_[ i ] );
+    }
+  }
+}
+
+Ogre::MaterialPtr MeshResourceMarker::acquireMaterial( const MaterialCache::Key& key )
+{
+  Ogre::MaterialPtr material = MaterialCache::get()->acquire( key );
+  if( private_materials_ )
+  {
+    material = makePrivate( material );
+  }
+  return material;
+}
+
+void MeshResourceMarker::releaseMaterial( const Ogre::MaterialPtr& material )
+{
+  if( material.isNull() )
+  {
+    return;
+  }
+  if( private_materials_ )
+  {
+    material->unload();
+    Ogre::MaterialManager::getSingleton().remove( material->getName() );
+  }
+  else
+  {
+    MaterialCache::get()->release( material );
+  }
+}
+
+Ogre::MaterialPtr MeshResourceMarker::makePrivate( const Ogre::MaterialPtr& material )
+{
+  static uint32_t count = 0;
+  std::stringstream ss;
+  ss << material->getName() << "Private" << count++;
+  Ogre::MaterialPtr copy = material->clone( ss.str() );
+  MaterialCache::get()->release( material );
+  return copy;
+}
+
+void MeshResourceMarker::setMeshLodBias( float bias )
+{
+  if( entity_ )
+  {
+    entity_->setMeshLodBias( bias );
+  }
+}
+
 S_MaterialPtr MeshResourceMarker::getMaterials()
 {
   S_MaterialPtr materials;
@@ -31,9 +31,11 @@
 #define RVIZ_MESH_RESOURCE_MARKER_H
 
 #include "marker_base.h"
+#include "rviz/ogre_helpers/material_cache.h"
 
 #include <OGRE/OgreMaterial.h>
 
+#include <string>
 #include <vector>
 
 namespace Ogre
@@ -53,13 +55,30 @@ public:
 
   virtual S_MaterialPtr getMaterials();
 
+  virtual void setMeshLodBias( float bias );
+
+  /** @brief Also switches the marker to private copies of its
+   * materials, as interactive controls add highlight passes to them. */
+  virtual void setInteractiveObject( InteractiveObjectWPtr object );
+
 protected:
   virtual void onNewMessage(const MarkerConstPtr& old_message, const MarkerConstPtr& new_message);
 
   void reset();
 
+  /** @brief Acquire the material for @a key, copied if the marker uses private materials. */
+  Ogre::MaterialPtr acquireMaterial( const MaterialCache::Key& key );
+
+  /** @brief Give back a material obtained from acquireMaterial(). */
+  void releaseMaterial( const Ogre::MaterialPtr& material );
+
+  /** @brief Return a private copy of the cached @a material, and release it. */
+  Ogre::MaterialPtr makePrivate( const Ogre::MaterialPtr& material );
+
   Ogre::Entity* entity_;
-  S_MaterialPtr materials_;
+  std::vector<std::string> base_materials_; ///< Per sub-entity embedded material, or empty for a plain one.
+  std::vector<Ogre::MaterialPtr> materials_; ///< Per sub-entity material from MaterialCache, or a private copy of it.
+  bool private_materials_;
 
   //! Scaling factor to convert units. Currently relevant for Collada only.
   float unit_rescale_;
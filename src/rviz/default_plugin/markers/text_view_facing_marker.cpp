@@ -32,9 +32,11 @@
 
 #include <ros/assert.h>
 
+#include "rviz/default_plugin/marker_display.h"
 #include "rviz/default_plugin/markers/marker_selection_handler.h"
 #include "rviz/display_context.h"
 #include "rviz/ogre_helpers/movable_text.h"
+#include "rviz/ogre_helpers/text_cloud.h"
 #include "rviz/selection/selection_manager.h"
 
 #include "rviz/default_plugin/markers/text_view_facing_marker.h"
@@ -45,26 +47,45 @@ namespace rviz
 TextViewFacingMarker::TextViewFacingMarker(MarkerDisplay* owner, DisplayContext* context, Ogre::SceneNode* parent_node)
 : MarkerBase(owner, context, parent_node)
 , text_(0)
+, cloud_(0)
+, label_(0)
 {
 }
 
 TextViewFacingMarker::~TextViewFacingMarker()
 {
   delete text_;
+  if (cloud_)
+  {
+    cloud_->destroyLabel(label_);
+  }
 }
 
 void TextViewFacingMarker::onNewMessage(const MarkerConstPtr& old_message, const MarkerConstPtr& new_message)
 {
   ROS_ASSERT(new_message->type == visualization_msgs::Marker::TEXT_VIEW_FACING);
 
-  if (!text_)
+  if (!text_ && !cloud_)
   {
-    text_ = new MovableText(new_message->text);
-    text_->setTextAlignment(MovableText::H_CENTER, MovableText::V_CENTER);
-    scene_node_->attachObject(text_);
-
     handler_.reset( new MarkerSelectionHandler(this, MarkerID(new_message->ns, new_message->id ), context_ ));
-    handler_->addTrackedObject( text_ );
+
+    if (owner_)
+    {
+      // All text markers of a MarkerDisplay are drawn in one batch.
+      // The label carries the pick color itself, since it has no
+      // MovableObject of its own to track.
+      cloud_ = owner_->getTextCloud();
+      label_ = cloud_->createLabel();
+      cloud_->setAlignment(label_, TextCloud::H_CENTER, TextCloud::V_CENTER);
+      cloud_->setPickColor(label_, SelectionManager::handleToColor(handler_->getHandle()));
+    }
+    else
+    {
+      text_ = new MovableText(new_message->text);
+      text_->setTextAlignment(MovableText::H_CENTER, MovableText::V_CENTER);
+      scene_node_->attachObject(text_);
+      handler_->addTrackedObject( text_ );
+    }
   }
 
   Ogre::Vector3 pos, scale;
@@ -72,15 +93,36 @@ void TextViewFacingMarker::onNewMessage(const MarkerConstPtr& old_message, const
   transform(new_message, pos, orient, scale);
 
   setPosition(pos);
-  text_->setCharacterHeight(new_message->scale.z);
-  text_->setColor(Ogre::ColourValue(new_message->color.r, new_message->color.g, new_message->color.b, new_message->color.a));
-  text_->setCaption(new_message->text);
+  Ogre::ColourValue color(new_message->color.r, new_message->color.g, new_message->color.b, new_message->color.a);
+  if (cloud_)
+  {
+    cloud_->setCharacterHeight(label_, new_message->scale.z);
+    cloud_->setColor(label_, color);
+    cloud_->setCaption(label_, new_message->text);
+  }
+  else
+  {
+    text_->setCharacterHeight(new_message->scale.z);
+    text_->setColor(color);
+    text_->setCaption(new_message->text);
+  }
+}
+
+void TextViewFacingMarker::setPosition( const Ogre::Vector3& position )
+{
+  MarkerBase::setPosition(position);
+  if (cloud_)
+  {
+    cloud_->setPosition(label_, position);
+  }
 }
 
 S_MaterialPtr TextViewFacingMarker::getMaterials()
 {
   S_MaterialPtr materials;
-  if ( text_->getMaterial().get() )
+  // The material of the shared TextCloud must not be handed out for
+  // per-marker changes like highlighting.
+  if ( text_ && text_->getMaterial().get() )
   {
   materials.insert( text_->getMaterial() );
   }
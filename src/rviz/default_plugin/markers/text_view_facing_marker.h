@@ -40,6 +40,7 @@ class SceneNode;
 namespace rviz
 {
 class MovableText;
+class TextCloud;
 }
 
 namespace rviz
@@ -51,6 +52,7 @@ public:
   TextViewFacingMarker(MarkerDisplay* owner, DisplayContext* context, Ogre::SceneNode* parent_node);
   ~TextViewFacingMarker();
 
+  virtual void setPosition( const Ogre::Vector3& position );
   virtual void setOrientation( const Ogre::Quaternion& orientation ) {}
 
   virtual S_MaterialPtr getMaterials();
@@ -58,8 +60,13 @@ public:
 protected:
   virtual void onNewMessage(const MarkerConstPtr& old_message, const MarkerConstPtr& new_message);
 
+  /// Only used for markers without a MarkerDisplay, like those of interactive markers.
   MovableText* text_;
 
+  /// Shared text batch of the owning MarkerDisplay, and our label in it.
+  TextCloud* cloud_;
+  uint32_t label_;
+
 };
 
 }
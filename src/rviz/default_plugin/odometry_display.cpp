@@ -33,7 +33,6 @@
 #include <tf/transform_listener.h>
 
 #include "rviz/frame_manager.h"
-#include "rviz/ogre_helpers/arrow.h"
 #include "rviz/properties/color_property.h"
 #include "rviz/properties/float_property.h"
 #include "rviz/properties/int_property.h"
@@ -49,6 +48,8 @@ namespace rviz
 OdometryDisplay::OdometryDisplay()
   : Display()
   , messages_received_(0)
+  , arrow_cloud_( NULL )
+  , oldest_arrow_( 0 )
 {
   topic_property_ = new RosTopicProperty( "Topic", "",
                                           QString::fromStdString( ros::message_traits::datatype<nav_msgs::Odometry>() ),
@@ -73,7 +74,7 @@ OdometryDisplay::OdometryDisplay()
 
   keep_property_ = new IntProperty( "Keep", 100,
                                     "Number of arrows to keep before removing the oldest.  0 means keep all of them.",
-                                    this );
+                                    this, SLOT( updateKeep() ));
   keep_property_->setMin( 0 );
 
   length_property_ = new FloatProperty( "Length", 1.0,
@@ -88,6 +89,7 @@ OdometryDisplay::~OdometryDisplay()
     unsubscribe();
     clear();
     delete tf_filter_;
+    delete arrow_cloud_;
   }
 }
 
@@ -99,17 +101,21 @@ void OdometryDisplay::onInitialize()
   tf_filter_->connectInput( sub_ );
   tf_filter_->registerCallback( boost::bind( &OdometryDisplay::incomingMessage, this, _1 ));
   context_->getFrameManager()->registerFilterForTransformStatusCheck( tf_filter_, this );
+
+  arrow_cloud_ = new ArrowCloud();
+  arrow_cloud_->setShape( ArrowCloud::SHAPE_SOLID );
+  scene_node_->attachObject( arrow_cloud_ );
+  updateLength();
 }
 
 void OdometryDisplay::clear()
 {
-  D_Arrow::iterator it = arrows_.begin();
-  D_Arrow::iterator end = arrows_.end();
-  for ( ; it != end; ++it )
+  arrows_.clear();
+  oldest_arrow_ = 0;
+  if( arrow_cloud_ )
   {
-    delete *it;
+    arrow_cloud_->clear();
   }
-  arrows_.clear();
 
   if( last_used_message_ )
   {
@@ -132,32 +138,53 @@ void OdometryDisplay::updateTopic()
 
 void OdometryDisplay::updateColor()
 {
-  QColor color = color_property_->getColor();
-  float red   = color.redF();
-  float green = color.greenF();
-  float blue  = color.blueF();
-
-  D_Arrow::iterator it = arrows_.begin();
-  D_Arrow::iterator end = arrows_.end();
-  for( ; it != end; ++it )
+  Ogre::ColourValue color = color_property_->getOgreColor();
+  for( size_t i = 0; i < arrows_.size(); i++ )
+  {
+    arrows_[ i ].color = color;
+  }
+  if( arrow_cloud_ )
   {
-    Arrow* arrow = *it;
-    arrow->setColor( red, green, blue, 1.0f );
+    arrow_cloud_->setArrows( arrows_.empty() ? 0 : &arrows_.front(), arrows_.size() );
   }
   context_->queueRender();
 }
 
 void OdometryDisplay::updateLength()
 {
+  if( !arrow_cloud_ )
+  {
+    return;
+  }
+
+  // Same proportions as the rviz::Arrow this display used to create per message.
   float length = length_property_->getFloat();
-  D_Arrow::iterator it = arrows_.begin();
-  D_Arrow::iterator end = arrows_.end();
-  Ogre::Vector3 scale( length, length, length );
-  for ( ; it != end; ++it )
+  arrow_cloud_->setDimensions( 0.8f * length, 0.025f * length, 0.2f * length, 0.1f * length );
+  context_->queueRender();
+}
+
+void OdometryDisplay::updateKeep()
+{
+  size_t keep = keep_property_->getInt();
+  if( !arrow_cloud_ || ( keep == arrows_.size() && oldest_arrow_ == 0 ))
   {
-    Arrow* arrow = *it;
-    arrow->setScale( scale );
+    return;
   }
+
+  // Unroll the ring into chronological order, dropping the oldest
+  // arrows which do not fit anymore.
+  std::vector<ArrowCloud::Arrow> arrows;
+  arrows.reserve( arrows_.size() );
+  arrows.insert( arrows.end(), arrows_.begin() + oldest_arrow_, arrows_.end() );
+  arrows.insert( arrows.end(), arrows_.begin(), arrows_.begin() + oldest_arrow_ );
+  if( keep > 0 && arrows.size() > keep )
+  {
+    arrows.erase( arrows.begin(), arrows.end() - keep );
+  }
+
+  arrows_.swap( arrows );
+  oldest_arrow_ = 0;
+  arrow_cloud_->setArrows( arrows_.empty() ? 0 : &arrows_.front(), arrows_.size() );
   context_->queueRender();
 }
 
@@ -229,24 +256,29 @@ void OdometryDisplay::incomingMessage( const nav_msgs::Odometry::ConstPtr& messa
     }
   }
 
-  Arrow* arrow = new Arrow( scene_manager_, scene_node_, 0.8f, 0.05f, 0.2f, 0.2f );
+  ArrowCloud::Arrow arrow;
+  transformArrow( message, &arrow );
+  arrow.color = color_property_->getOgreColor();
 
-  transformArrow( message, arrow );
-
-  QColor color = color_property_->getColor();
-  arrow->setColor( color.redF(), color.greenF(), color.blueF(), 1.0f );
-
-  float length = length_property_->getFloat();
-  Ogre::Vector3 scale( length, length, length );
-  arrow->setScale( scale );
-
-  arrows_.push_back( arrow );
+  size_t keep = keep_property_->getInt();
+  if( keep == 0 || arrows_.size() < keep )
+  {
+    arrows_.push_back( arrow );
+    arrow_cloud_->addArrows( &arrow, 1 );
+  }
+  else
+  {
+    // The ring is full: overwrite the oldest arrow.
+    arrows_[ oldest_arrow_ ] = arrow;
+    arrow_cloud_->setArrow( oldest_arrow_, arrow );
+    oldest_arrow_ = ( oldest_arrow_ + 1 ) % arrows_.size();
+  }
 
   last_used_message_ = message;
   context_->queueRender();
 }
 
-void OdometryDisplay::transformArrow( const nav_msgs::Odometry::ConstPtr& message, Arrow* arrow )
+void OdometryDisplay::transformArrow( const nav_msgs::Odometry::ConstPtr& message, ArrowCloud::Arrow* arrow )
 {
   Ogre::Vector3 position;
   Ogre::Quaternion orientation;
@@ -256,11 +288,8 @@ void OdometryDisplay::transformArrow( const nav_msgs::Odometry::ConstPtr& messag
                qPrintable( getName() ), message->header.frame_id.c_str(), qPrintable( fixed_frame_ ));
   }
 
-  arrow->setPosition( position );
-
-  // Arrow points in -Z direction, so rotate the orientation before display.
-  // TODO: is it safe to change Arrow to point in +X direction?
-  arrow->setOrientation( orientation * Ogre::Quaternion( Ogre::Degree( -90 ), Ogre::Vector3::UNIT_Y ));
+  arrow->position = position;
+  arrow->orientation = orientation;
 }
 
 void OdometryDisplay::fixedFrameChanged()
@@ -269,19 +298,6 @@ void OdometryDisplay::fixedFrameChanged()
   clear();
 }
 
-void OdometryDisplay::update( float wall_dt, float ros_dt )
-{
-  size_t keep = keep_property_->getInt();
-  if( keep > 0 )
-  {
-    while( arrows_.size() > keep )
-    {
-      delete arrows_.front();
-      arrows_.pop_front();
-    }
-  }
-}
-
 void OdometryDisplay::reset()
 {
   Display::reset();
@@ -31,10 +31,9 @@
 #ifndef RVIZ_ODOMETRY_DISPLAY_H_
 #define RVIZ_ODOMETRY_DISPLAY_H_
 
-#include <deque>
+#include <vector>
 
 #include <boost/shared_ptr.hpp>
-#include <boost/thread/mutex.hpp>
 
 #ifndef Q_MOC_RUN
 #include <message_filters/subscriber.h>
@@ -44,11 +43,11 @@
 #include <nav_msgs/Odometry.h>
 
 #include "rviz/display.h"
+#include "rviz/ogre_helpers/arrow_cloud.h"
 
 namespace rviz
 {
 
-class Arrow;
 class ColorProperty;
 class FloatProperty;
 class IntProperty;
@@ -57,6 +56,10 @@ class RosTopicProperty;
 /**
  * \class OdometryDisplay
  * \brief Accumulates and displays the pose from a nav_msgs::Odometry message
+ *
+ * The history is a ring buffer of arrows drawn by a single ArrowCloud.
+ * Once "Keep" arrows are stored, each new arrow overwrites the oldest
+ * one in place.
  */
 class OdometryDisplay: public Display
 {
@@ -68,7 +71,6 @@ public:
   // Overrides from Display
   virtual void onInitialize();
   virtual void fixedFrameChanged();
-  virtual void update( float wall_dt, float ros_dt );
   virtual void reset();
 
   virtual void setTopic( const QString &topic, const QString &datatype );
@@ -82,6 +84,7 @@ private Q_SLOTS:
   void updateColor();
   void updateTopic();
   void updateLength();
+  void updateKeep();
 
 private:
   void subscribe();
@@ -89,10 +92,11 @@ private:
   void clear();
 
   void incomingMessage( const nav_msgs::Odometry::ConstPtr& message );
-  void transformArrow( const nav_msgs::Odometry::ConstPtr& message, Arrow* arrow );
+  void transformArrow( const nav_msgs::Odometry::ConstPtr& message, ArrowCloud::Arrow* arrow );
 
-  typedef std::deque<Arrow*> D_Arrow;
-  D_Arrow arrows_;
+  ArrowCloud* arrow_cloud_;
+  std::vector<ArrowCloud::Arrow> arrows_;  ///< Ring buffer, same order as in arrow_cloud_.
+  uint32_t oldest_arrow_;                  ///< Index of the oldest arrow in arrows_, once it is full.
 
   uint32_t messages_received_;
 
@@ -27,19 +27,24 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <sstream>
+
 #include <boost/bind.hpp>
 
 #include <OGRE/OgreSceneNode.h>
 #include <OGRE/OgreSceneManager.h>
-#include <OGRE/OgreManualObject.h>
-#include <OGRE/OgreBillboardSet.h>
-#include <OGRE/OgreMatrix4.h>
+#include <OGRE/OgreMaterialManager.h>
+#include <OGRE/OgreTechnique.h>
 
 #include <tf/transform_listener.h>
 
 #include "rviz/display_context.h"
 #include "rviz/frame_manager.h"
+#include "rviz/ogre_helpers/arrow_cloud.h"
+#include "rviz/ogre_helpers/billboard_line.h"
+#include "rviz/ogre_helpers/polyline.h"
 #include "rviz/properties/color_property.h"
+#include "rviz/properties/enum_property.h"
 #include "rviz/properties/float_property.h"
 #include "rviz/properties/int_property.h"
 #include "rviz/validate_floats.h"
@@ -51,26 +56,68 @@ namespace rviz
 
 PathDisplay::PathDisplay()
 {
+  style_property_ = new EnumProperty( "Line Style", "Lines",
+                                      "The rendering operation to use to draw the path.",
+                                      this, SLOT( updateStyle() ));
+  style_property_->addOption( "Lines", LINES );
+  style_property_->addOption( "Billboards", BILLBOARDS );
+
+  line_width_property_ = new FloatProperty( "Line Width", 0.03,
+                                            "The width, in meters, of the path when drawn as billboards.",
+                                            style_property_ );
+  line_width_property_->setMin( 0.001 );
+  line_width_property_->hide();
+
   color_property_ = new ColorProperty( "Color", QColor( 25, 255, 0 ),
                                        "Color to draw the path.", this );
 
   alpha_property_ = new FloatProperty( "Alpha", 1.0,
-                                       "Amount of transparency to apply to the path.", this );
+                                       "Amount of transparency to apply to the path.",
+                                       this, SLOT( updateAlpha() ));
+  alpha_property_->setMin( 0.0 );
+  alpha_property_->setMax( 1.0 );
 
   buffer_length_property_ = new IntProperty( "Buffer Length", 1,
                                              "Number of paths to display.",
                                              this, SLOT( updateBufferLength() ));
   buffer_length_property_->setMin( 1 );
+
+  pose_style_property_ = new EnumProperty( "Pose Style", "None",
+                                           "Whether to draw an arrow for the orientation of each pose of the path.",
+                                           this, SLOT( updateStyle() ));
+  pose_style_property_->addOption( "None", POSE_NONE );
+  pose_style_property_->addOption( "Arrows", POSE_ARROWS );
+  pose_style_property_->addOption( "3D Arrows", POSE_ARROWS_3D );
+
+  pose_arrow_length_property_ = new FloatProperty( "Arrow Length", 0.3,
+                                                   "Length of the pose arrows.",
+                                                   pose_style_property_ );
+  pose_arrow_length_property_->setMin( 0.0001 );
+  pose_arrow_length_property_->hide();
 }
 
 PathDisplay::~PathDisplay()
 {
   destroyObjects();
+  if( !line_material_.isNull() )
+  {
+    Ogre::MaterialManager::getSingleton().remove( line_material_->getName() );
+  }
 }
 
 void PathDisplay::onInitialize()
 {
   MFDClass::onInitialize();
+
+  static int count = 0;
+  std::stringstream ss;
+  ss << "PathDisplayMaterial" << count++;
+  line_material_ = Ogre::MaterialManager::getSingleton().getByName( "BaseWhiteNoLighting" );
+  line_material_ = line_material_->clone( ss.str() );
+  line_material_->setReceiveShadows( false );
+  line_material_->getTechnique( 0 )->setLightingEnabled( false );
+
+  updateAlpha();
   updateBufferLength();
 }
 
@@ -82,14 +129,26 @@ void PathDisplay::reset()
 
 void PathDisplay::destroyObjects()
 {
-  for( size_t i = 0; i < manual_objects_.size(); i++ )
+  for( size_t i = 0; i < path_nodes_.size(); i++ )
   {
-    Ogre::ManualObject* manual_object = manual_objects_[ i ];
-    if( manual_object )
-    {
-      manual_object->clear();
-      scene_manager_->destroyManualObject( manual_object );
-    }
+    delete billboard_lines_[ i ];
+    delete polylines_[ i ];
+    delete arrow_clouds_[ i ];
+    scene_manager_->destroySceneNode( path_nodes_[ i ] );
+  }
+  path_nodes_.clear();
+  polylines_.clear();
+  billboard_lines_.clear();
+  arrow_clouds_.clear();
+}
+
+void PathDisplay::clearObjects()
+{
+  for( size_t i = 0; i < path_nodes_.size(); i++ )
+  {
+    polylines_[ i ]->clear();
+    billboard_lines_[ i ]->clear();
+    arrow_clouds_[ i ]->clear();
   }
 }
 
@@ -98,19 +157,65 @@ void PathDisplay::updateBufferLength()
   destroyObjects();
 
   int buffer_length = buffer_length_property_->getInt();
-  QColor color = color_property_->getColor();
 
-  manual_objects_.resize( buffer_length );
-  for( size_t i = 0; i < manual_objects_.size(); i++ )
+  path_nodes_.resize( buffer_length );
+  polylines_.resize( buffer_length );
+  billboard_lines_.resize( buffer_length );
+  arrow_clouds_.resize( buffer_length );
+  for( int i = 0; i < buffer_length; i++ )
   {
-    Ogre::ManualObject* manual_object = scene_manager_->createManualObject();
-    manual_object->setDynamic( true );
-    scene_node_->attachObject( manual_object );
+    Ogre::SceneNode* node = scene_node_->createChildSceneNode();
+
+    Polyline* polyline = new Polyline();
+    polyline->setMaterial( line_material_->getName() );
+    node->attachObject( polyline );
 
-    manual_objects_[ i ] = manual_object;
+    ArrowCloud* arrow_cloud = new ArrowCloud();
+    arrow_cloud->setAlpha( alpha_property_->getFloat() );
+    node->attachObject( arrow_cloud );
+
+    path_nodes_[ i ] = node;
+    polylines_[ i ] = polyline;
+    billboard_lines_[ i ] = new BillboardLine( scene_manager_, node );
+    arrow_clouds_[ i ] = arrow_cloud;
   }
 }
 
+void PathDisplay::updateStyle()
+{
+  line_width_property_->setHidden( style_property_->getOptionInt() != BILLBOARDS );
+  pose_arrow_length_property_->setHidden( pose_style_property_->getOptionInt() == POSE_NONE );
+
+  // The new style takes effect with the next message.
+  clearObjects();
+  context_->queueRender();
+}
+
+void PathDisplay::updateAlpha()
+{
+  float alpha = alpha_property_->getFloat();
+
+  if( !line_material_.isNull() )
+  {
+    if( alpha < 0.9998 )
+    {
+      line_material_->getTechnique( 0 )->setSceneBlending( Ogre::SBT_TRANSPARENT_ALPHA );
+      line_material_->getTechnique( 0 )->setDepthWriteEnabled( false );
+    }
+    else
+    {
+      line_material_->getTechnique( 0 )->setSceneBlending( Ogre::SBT_REPLACE );
+      line_material_->getTechnique( 0 )->setDepthWriteEnabled( true );
+    }
+  }
+
+  for( size_t i = 0; i < arrow_clouds_.size(); i++ )
+  {
+    arrow_clouds_[ i ]->setAlpha( alpha );
+  }
+  context_->queueRender();
+}
+
 bool validateFloats( const nav_msgs::Path& msg )
 {
   bool valid = true;
@@ -120,11 +225,17 @@ bool validateFloats( const nav_msgs::Path& msg )
 
 void PathDisplay::processMessage( const nav_msgs::Path::ConstPtr& msg )
 {
-  Ogre::ManualObject* manual_object = manual_objects_[ messages_received_ % buffer_length_property_->getInt() ];
-  manual_object->clear();
+  size_t slot = messages_received_ % buffer_length_property_->getInt();
+  Ogre::SceneNode* node = path_nodes_[ slot ];
+  Polyline* polyline = polylines_[ slot ];
+  BillboardLine* billboard_line = billboard_lines_[ slot ];
+  ArrowCloud* arrow_cloud = arrow_clouds_[ slot ];
 
   if( !validateFloats( *msg ))
   {
+    polyline->clear();
+    billboard_line->clear();
+    arrow_cloud->clear();
     setStatus( StatusProperty::Error, "Topic", "Message contained invalid floating point values (nans or infs)" );
     return;
   }
@@ -136,27 +247,87 @@ void PathDisplay::processMessage( const nav_msgs::Path::ConstPtr& msg )
     ROS_DEBUG( "Error transforming from frame '%s' to frame '%s'", msg->header.frame_id.c_str(), qPrintable( fixed_frame_ ));
   }
 
-  Ogre::Matrix4 transform( orientation );
-  transform.setTrans( position );
-
-//  scene_node_->setPosition( position );
-//  scene_node_->setOrientation( orientation );
+  // The transform goes onto the slot's node, so the points stay in
+  // the message frame and unchanged prefixes need no upload.
+  node->setPosition( position );
+  node->setOrientation( orientation );
 
   Ogre::ColourValue color = color_property_->getOgreColor();
   color.a = alpha_property_->getFloat();
 
   uint32_t num_points = msg->poses.size();
-  manual_object->estimateVertexCount( num_points );
-  manual_object->begin( "BaseWhiteNoLighting", Ogre::RenderOperation::OT_LINE_STRIP );
-  for( uint32_t i=0; i < num_points; ++i)
+
+  switch( style_property_->getOptionInt() )
+  {
+  case BILLBOARDS:
   {
-    const geometry_msgs::Point& pos = msg->poses[ i ].pose.position;
-    Ogre::Vector3 xpos = transform * Ogre::Vector3( pos.x, pos.y, pos.z );
-    manual_object->position( xpos.x, xpos.y, xpos.z );
-    manual_object->colour( color );
+    polyline->clear();
+    billboard_line->clear();
+    billboard_line->setMaxPointsPerLine( std::max<uint32_t>( num_points, 1 ));
+    billboard_line->setLineWidth( line_width_property_->getFloat() );
+    billboard_line->setColor( color.r, color.g, color.b, color.a );
+    std::vector<Ogre::Vector3> points( num_points );
+    for( uint32_t i = 0; i < num_points; ++i )
+    {
+      const geometry_msgs::Point& pos = msg->poses[ i ].pose.position;
+      points[ i ] = Ogre::Vector3( pos.x, pos.y, pos.z );
+    }
+    if( num_points > 0 )
+    {
+      billboard_line->addPoints( &points.front(), NULL, num_points );
+    }
+    break;
+  }
+  case LINES:
+  default:
+  {
+    billboard_line->clear();
+    std::vector<Ogre::Vector3> points( num_points );
+    for( uint32_t i = 0; i < num_points; ++i )
+    {
+      const geometry_msgs::Point& pos = msg->poses[ i ].pose.position;
+      points[ i ] = Ogre::Vector3( pos.x, pos.y, pos.z );
+    }
+    polyline->setPoints( points, color );
+    break;
+  }
+  }
+
+  int pose_style = pose_style_property_->getOptionInt();
+  if( pose_style == POSE_NONE )
+  {
+    arrow_cloud->clear();
+  }
+  else
+  {
+    float length = pose_arrow_length_property_->getFloat();
+    if( pose_style == POSE_ARROWS_3D )
+    {
+      arrow_cloud->setShape( ArrowCloud::SHAPE_SOLID );
+      arrow_cloud->setDimensions( 0.7 * length, 0.05 * length, 0.3 * length, 0.1 * length );
+    }
+    else
+    {
+      arrow_cloud->setShape( ArrowCloud::SHAPE_LINES );
+      arrow_cloud->setDimensions( 0.75 * length, 0.0, 0.25 * length, 0.2 * length );
+    }
+
+    // The arrow cloud applies the display alpha itself.
+    Ogre::ColourValue arrow_color = color;
+    arrow_color.a = 1.0f;
+    std::vector<ArrowCloud::Arrow> arrows( num_points );
+    for( uint32_t i = 0; i < num_points; ++i )
+    {
+      const geometry_msgs::Pose& pose = msg->poses[ i ].pose;
+      arrows[ i ].position = Ogre::Vector3( pose.position.x, pose.position.y, pose.position.z );
+      arrows[ i ].orientation = Ogre::Quaternion( pose.orientation.w, pose.orientation.x,
+                                                  pose.orientation.y, pose.orientation.z );
+      arrows[ i ].color = arrow_color;
+    }
+    arrow_cloud->setArrows( arrows.empty() ? 0 : &arrows.front(), arrows.size() );
   }
 
-  manual_object->end();
+  context_->queueRender();
 }
 
 } // namespace rviz
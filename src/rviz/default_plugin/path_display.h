@@ -35,21 +35,33 @@
 
 #include "rviz/message_filter_display.h"
 
+#include <OGRE/OgreMaterial.h>
+
 namespace Ogre
 {
-class ManualObject;
+class SceneNode;
 }
 
 namespace rviz
 {
 
+class ArrowCloud;
+class BillboardLine;
 class ColorProperty;
+class EnumProperty;
 class FloatProperty;
 class IntProperty;
+class Polyline;
 
 /**
  * \class PathDisplay
  * \brief Displays a nav_msgs::Path message
+ *
+ * Each of the "Buffer Length" history slots owns a scene node and
+ * persistent renderables.  The path's frame transform is applied to
+ * the slot's scene node, so the points themselves are uploaded in the
+ * message frame, and a path which only grew since the last message in
+ * the same slot only uploads its new tail.
  */
 class PathDisplay: public MessageFilterDisplay<nav_msgs::Path>
 {
@@ -70,15 +82,42 @@ protected:
 
 private Q_SLOTS:
   void updateBufferLength();
+  void updateStyle();
+  void updateAlpha();
 
 private:
+  enum LineStyle
+  {
+    LINES,
+    BILLBOARDS
+  };
+
+  enum PoseStyle
+  {
+    POSE_NONE,
+    POSE_ARROWS,
+    POSE_ARROWS_3D
+  };
+
   void destroyObjects();
 
-  std::vector<Ogre::ManualObject*> manual_objects_;
+  /** @brief Remove the content of all history slots, keeping their buffers. */
+  void clearObjects();
+
+  std::vector<Ogre::SceneNode*> path_nodes_;
+  std::vector<Polyline*> polylines_;
+  std::vector<BillboardLine*> billboard_lines_;
+  std::vector<ArrowCloud*> arrow_clouds_;
+
+  Ogre::MaterialPtr line_material_;
 
+  EnumProperty* style_property_;
+  FloatProperty* line_width_property_;
   ColorProperty* color_property_;
   FloatProperty* alpha_property_;
   IntProperty* buffer_length_property_;
+  EnumProperty* pose_style_property_;
+  FloatProperty* pose_arrow_length_property_;
 };
 
 } // namespace rviz
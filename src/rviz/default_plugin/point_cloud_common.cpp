@@ -33,12 +33,17 @@
 #include <OGRE/OgreSceneNode.h>
 #include <OGRE/OgreWireBoundingBox.h>
 
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+
+#include <ros/callback_queue_interface.h>
 #include <ros/time.h>
 
 #include <tf/transform_listener.h>
 
 #include <pluginlib/class_loader.h>
 
+#include "rviz/default_plugin/point_cloud_layout.h"
 #include "rviz/default_plugin/point_cloud_transformer.h"
 #include "rviz/default_plugin/point_cloud_transformers.h"
 #include "rviz/display.h"
@@ -68,6 +73,24 @@ struct IndexAndMessage
   uint64_t message;
 };
 
+/** Calls a function from a ros::CallbackQueue, on the thread spinning it. */
+class FunctionCallback : public ros::CallbackInterface
+{
+public:
+  FunctionCallback( const boost::function<void()>& function )
+    : function_( function )
+    {}
+
+  virtual CallResult call()
+  {
+    function_();
+    return Success;
+  }
+
+private:
+  boost::function<void()> function_;
+};
+
 uint qHash( IndexAndMessage iam )
 {
   return
@@ -175,7 +198,7 @@ void PointCloudSelectionHandler::createProperties( const Picked& obj, Property*
         property_hash_.insert( hash_key, cat );
 
         // First add the position.
-        VectorProperty* pos_prop = new VectorProperty( "Position", cloud_info_->transformed_points_[index].position, "", cat );
+        VectorProperty* pos_prop = new VectorProperty( "Position", cloud_info_->cloud_->getPointPosition( index ), "", cat );
         pos_prop->setReadOnly( true );
 
         // Then add all other fields as well.
@@ -265,7 +288,7 @@ void PointCloudSelectionHandler::onSelect(const Picked& obj)
 
     sensor_msgs::PointCloud2ConstPtr message = cloud_info_->message_;
 
-    Ogre::Vector3 pos = cloud_info_->transformed_points_[index].position;
+    Ogre::Vector3 pos = cloud_info_->cloud_->getPointPosition( index );
     pos = cloud_info_->scene_node_->convertLocalToWorldPosition( pos );
 
     float size = box_size_ * 0.5f;
@@ -291,6 +314,8 @@ void PointCloudSelectionHandler::onDeselect(const Picked& obj)
 PointCloudCommon::CloudInfo::CloudInfo()
 : manager_(0)
 , scene_node_(0)
+, color_map_min_(0.0f)
+, color_map_max_(0.0f)
 {}
 
 PointCloudCommon::CloudInfo::~CloudInfo()
@@ -309,9 +334,12 @@ void PointCloudCommon::CloudInfo::clear()
 
 PointCloudCommon::PointCloudCommon( Display* display )
 : spinner_(1, &cbqueue_)
+, new_cloud_infos_(MessageMailbox<CloudInfoPtr>::DropOldest)
 , new_xyz_transformer_(false)
 , new_color_transformer_(false)
+, transformer_options_current_(false)
 , needs_retransform_(false)
+, retransform_generation_(0)
 , transformer_class_loader_(NULL)
 , display_( display )
 , auto_size_(false)
@@ -350,6 +378,12 @@ PointCloudCommon::PointCloudCommon( Display* display )
                                             display_, SLOT( queueRender() ));
   decay_time_property_->setMin( 0 );
 
+  compact_positions_property_ = new BoolProperty( "Compact Positions", false,
+                                                  "Store point positions as 16 bit integers on the GPU, relative to the center"
+                                                  " of each vertex buffer.  Saves GPU memory for large or accumulated clouds, at a"
+                                                  " precision of 1/65534 of the extent of each buffer.  Only used with the Points style.",
+                                                  display_, SLOT( updateCompactPositions() ), this );
+
   xyz_transformer_property_ = new EnumProperty( "Position Transformer", "",
                                                 "Set the transformer to use to set the position of the points.",
                                                 display_, SLOT( updateXyzTransformer() ), this );
@@ -408,11 +442,14 @@ void PointCloudCommon::loadTransformers()
     PointCloudTransformerPtr trans( transformer_class_loader_->createUnmanagedInstance( lookup_name ));
     trans->init();
     connect( trans.get(), SIGNAL( needRetransform() ), this, SLOT( causeRetransform() ));
+    connect( trans.get(), SIGNAL( needColorMapUpdate() ), this, SLOT( updateColorMaps() ));
 
     TransformerInfo info;
     info.transformer = trans;
     info.readable_name = name;
     info.lookup_name = lookup_name;
+    info.support = 0;
+    info.score = 0;
 
     info.transformer->createProperties( display_, PointCloudTransformer::Support_XYZ, info.xyz_props );
     setPropertiesHidden( info.xyz_props, true );
@@ -422,6 +459,7 @@ void PointCloudCommon::loadTransformers()
 
     transformers_[ name ] = info;
   }
+  transformer_signature_.clear();
 }
 
 void PointCloudCommon::setAutoSize( bool auto_size )
@@ -443,6 +481,15 @@ void PointCloudCommon::updateAlpha()
   }
 }
 
+void PointCloudCommon::updateCompactPositions()
+{
+  for ( unsigned i=0; i<cloud_infos_.size(); i++ )
+  {
+    cloud_infos_[i]->cloud_->setCompactPositions( compact_positions_property_->getBool() );
+  }
+  context_->queueRender();
+}
+
 void PointCloudCommon::updateSelectable()
 {
   bool selectable = selectable_property_->getBool();
@@ -504,9 +551,14 @@ void PointCloudCommon::updateBillboardSize()
 
 void PointCloudCommon::reset()
 {
-  boost::mutex::scoped_lock lock(new_clouds_mutex_);
   cloud_infos_.clear();
   new_cloud_infos_.clear();
+  new_cloud_infos_.resetCounters();
+  carried_cloud_infos_.clear();
+
+  boost::mutex::scoped_lock lock( retransform_mutex_ );
+  retransform_generation_++;
+  retransformed_cloud_infos_.clear();
 }
 
 void PointCloudCommon::causeRetransform()
@@ -524,6 +576,7 @@ void PointCloudCommon::update(float wall_dt, float ros_dt)
     retransform();
     needs_retransform_ = false;
   }
+  applyRetransformedClouds();
 
   // instead of deleting cloud infos, we just clear them
   // and put them into obsolete_cloud_infos, so active selections
@@ -531,19 +584,32 @@ void PointCloudCommon::update(float wall_dt, float ros_dt)
 
   ros::Time now = ros::Time::now();
 
+  // take the clouds left over from the last update and the ones which
+  // arrived since.  Only process what was queued when we started, so a
+  // fast publisher can not keep us here.
+  new_cloud_infos_.setCapacity( point_decay_time > 0.0 ? 0 : 1 );
+  V_CloudInfo new_cloud_infos;
+  new_cloud_infos.swap( carried_cloud_infos_ );
+  {
+    uint32_t queued = new_cloud_infos_.getQueuedCount();
+    CloudInfoPtr cloud_info;
+    for ( uint32_t i = 0; i < queued && new_cloud_infos_.pop( &cloud_info ); i++ )
+    {
+      new_cloud_infos.push_back( cloud_info );
+    }
+  }
+  display_->setQueueStatus( new_cloud_infos_.getQueuedCount(), new_cloud_infos_.getDroppedCount() );
+
   // if decay time == 0, clear the old cloud when we get a new one
   // otherwise, clear all the outdated ones
+  if ( point_decay_time > 0.0 || !new_cloud_infos.empty() )
   {
-    boost::mutex::scoped_lock lock(new_clouds_mutex_);
-    if ( point_decay_time > 0.0 || !new_cloud_infos_.empty() )
+    while( !cloud_infos_.empty() && now.toSec() - cloud_infos_.front()->receive_time_.toSec() > point_decay_time )
     {
-      while( !cloud_infos_.empty() && now.toSec() - cloud_infos_.front()->receive_time_.toSec() > point_decay_time )
-      {
-        cloud_infos_.front()->clear();
-        obsolete_cloud_infos_.push_back( cloud_infos_.front() );
-        cloud_infos_.pop_front();
-        context_->queueRender();
-      }
+      cloud_infos_.front()->clear();
+      obsolete_cloud_infos_.push_back( cloud_infos_.front() );
+      cloud_infos_.pop_front();
+      context_->queueRender();
     }
   }
 
@@ -559,48 +625,55 @@ void PointCloudCommon::update(float wall_dt, float ros_dt)
     }
   }
 
+  if( !new_cloud_infos.empty() )
   {
-    boost::mutex::scoped_lock lock(new_clouds_mutex_);
-    if( !new_cloud_infos_.empty() )
+    float size;
+    if( mode == PointCloud::RM_POINTS ) {
+      size = point_pixel_size_property_->getFloat();
+    } else {
+      size = point_world_size_property_->getFloat();
+    }
+
+    V_CloudInfo::iterator it = new_cloud_infos.begin();
+    V_CloudInfo::iterator end = new_cloud_infos.end();
+    for (; it != end; ++it)
     {
-      float size;
-      if( mode == PointCloud::RM_POINTS ) {
-        size = point_pixel_size_property_->getFloat();
-      } else {
-        size = point_world_size_property_->getFloat();
-      }
+      CloudInfoPtr cloud_info = *it;
 
-      V_CloudInfo::iterator it = new_cloud_infos_.begin();
-      V_CloudInfo::iterator end = new_cloud_infos_.end();
-      for (; it != end; ++it)
-      {
-        CloudInfoPtr cloud_info = *it;
+      V_CloudInfo::iterator next = it; next++;
+      // ignore point clouds that are too old, but keep at least one
+      if ( next != end && now.toSec() - cloud_info->receive_time_.toSec() > point_decay_time ) {
+        continue;
+      }
 
-        V_CloudInfo::iterator next = it; next++;
-        // ignore point clouds that are too old, but keep at least one
-        if ( next != end && now.toSec() - cloud_info->receive_time_.toSec() > point_decay_time ) {
-          continue;
-        }
+      // Set up the vertex format before adding the points, so they are
+      // only written once.
+      cloud_info->cloud_.reset( new PointCloud() );
+      cloud_info->cloud_->setRenderMode( mode );
+      cloud_info->cloud_->setAlpha( alpha_property_->getFloat() );
+      cloud_info->cloud_->setDimensions( size, size, size );
+      cloud_info->cloud_->setAutoSize(auto_size_);
+      cloud_info->cloud_->setCompactPositions( compact_positions_property_->getBool() );
+      applyColorMap( cloud_info );
+      cloud_info->cloud_->addPoints( &(cloud_info->transformed_points_.front()), cloud_info->transformed_points_.size() );
+      V_PointCloudPoint().swap( cloud_info->transformed_points_ );
 
-        cloud_info->cloud_.reset( new PointCloud() );
-        cloud_info->cloud_->addPoints( &(cloud_info->transformed_points_.front()), cloud_info->transformed_points_.size() );
-        cloud_info->cloud_->setRenderMode( mode );
-        cloud_info->cloud_->setAlpha( alpha_property_->getFloat() );
-        cloud_info->cloud_->setDimensions( size, size, size );
-        cloud_info->cloud_->setAutoSize(auto_size_);
+      cloud_info->manager_ = context_->getSceneManager();
 
-        cloud_info->manager_ = context_->getSceneManager();
+      cloud_info->scene_node_ = scene_node_->createChildSceneNode( cloud_info->position_, cloud_info->orientation_ );
 
-        cloud_info->scene_node_ = scene_node_->createChildSceneNode( cloud_info->position_, cloud_info->orientation_ );
+      cloud_info->scene_node_->attachObject( cloud_info->cloud_.get() );
 
-        cloud_info->scene_node_->attachObject( cloud_info->cloud_.get() );
+      cloud_info->selection_handler_.reset( new PointCloudSelectionHandler( getSelectionBoxSize(), cloud_info.get(), context_ ));
 
-        cloud_info->selection_handler_.reset( new PointCloudSelectionHandler( getSelectionBoxSize(), cloud_info.get(), context_ ));
+      cloud_infos_.push_back(*it);
 
-        cloud_infos_.push_back(*it);
+      // Leave the rest for the next update when our time is up.
+      if( next != end && !display_->hasUpdateTimeLeft() )
+      {
+        carried_cloud_infos_.assign( next, end );
+        break;
       }
-
-      new_cloud_infos_.clear();
     }
   }
 
@@ -639,11 +712,51 @@ void PointCloudCommon::setPropertiesHidden( const QList<Property*>& props, bool
   }
 }
 
+void PointCloudCommon::updateTransformerSupport( const sensor_msgs::PointCloud2ConstPtr& cloud )
+{
+  // What a transformer supports only depends on the fields of the cloud,
+  // so ask each one once per layout rather than once per message.
+  std::string signature = PointCloudLayout::getSignature( *cloud );
+  if( signature == transformer_signature_ )
+  {
+    return;
+  }
+
+  M_TransformerInfo::iterator trans_it = transformers_.begin();
+  M_TransformerInfo::iterator trans_end = transformers_.end();
+  for(;trans_it != trans_end; ++trans_it)
+  {
+    TransformerInfo& info = trans_it->second;
+    info.support = info.transformer->supports( cloud );
+    info.score = info.transformer->score( cloud );
+  }
+
+  transformer_signature_.swap( signature );
+  transformer_options_current_ = false;
+}
+
 void PointCloudCommon::updateTransformers( const sensor_msgs::PointCloud2ConstPtr& cloud )
 {
   std::string xyz_name = xyz_transformer_property_->getStdString();
   std::string color_name = color_transformer_property_->getStdString();
 
+  updateTransformerSupport( cloud );
+
+  if( transformer_options_current_ )
+  {
+    // Same layout as before, so the options are still right.  Only
+    // look further if a transformer has been selected meanwhile which
+    // does not support it, e.g. by loading a config.
+    M_TransformerInfo::iterator xyz_it = transformers_.find( xyz_name );
+    M_TransformerInfo::iterator color_it = transformers_.find( color_name );
+    if( xyz_it != transformers_.end() && ( xyz_it->second.support & PointCloudTransformer::Support_XYZ ) &&
+        color_it != transformers_.end() && ( color_it->second.support & PointCloudTransformer::Support_Color ))
+    {
+      return;
+    }
+  }
+  transformer_options_current_ = true;
+
   xyz_transformer_property_->clearOptions();
   color_transformer_property_->clearOptions();
 
@@ -658,11 +771,11 @@ void PointCloudCommon::updateTransformers( const sensor_msgs::PointCloud2ConstPt
   for(;trans_it != trans_end; ++trans_it)
   {
     const std::string& name = trans_it->first;
-    const PointCloudTransformerPtr& trans = trans_it->second.transformer;
-    uint32_t mask = trans->supports(cloud);
+    const TransformerInfo& info = trans_it->second;
+    uint32_t mask = info.support;
     if (mask & PointCloudTransformer::Support_XYZ)
     {
-      valid_xyz.insert(std::make_pair(trans->score(cloud), name));
+      valid_xyz.insert(std::make_pair(info.score, name));
       if (name == xyz_name)
       {
         cur_xyz_valid = true;
@@ -672,7 +785,7 @@ void PointCloudCommon::updateTransformers( const sensor_msgs::PointCloud2ConstPt
 
     if (mask & PointCloudTransformer::Support_Color)
     {
-      valid_color.insert(std::make_pair(trans->score(cloud), name));
+      valid_color.insert(std::make_pair(info.score, name));
       if (name == color_name)
       {
         cur_color_valid = true;
@@ -710,9 +823,31 @@ void PointCloudCommon::updateTransformers( const sensor_msgs::PointCloud2ConstPt
 
 void PointCloudCommon::updateStatus()
 {
+  size_t num_points = 0;
+  size_t system_bytes = 0;
+  size_t gpu_bytes = 0;
+  for ( unsigned i=0; i<cloud_infos_.size(); i++ )
+  {
+    const CloudInfoPtr& info = cloud_infos_[i];
+    num_points += info->transformed_points_.size();
+    system_bytes += info->transformed_points_.capacity() * sizeof( PointCloud::Point );
+    if( info->cloud_ )
+    {
+      num_points += info->cloud_->getNumPoints();
+      system_bytes += info->cloud_->getSystemMemoryUsage();
+      gpu_bytes += info->cloud_->getGpuMemoryUsage();
+    }
+  }
+
   std::stringstream ss;
-  //ss << "Showing [" << total_point_count_ << "] points from [" << clouds_.size() << "] messages";
-  display_->setStatusStd(StatusProperty::Ok, "Points", ss.str());
+  ss.precision( 1 );
+  ss << std::fixed << "Showing " << num_points << " points from " << cloud_infos_.size() << " messages, using "
+     << system_bytes / ( 1024.0 * 1024.0 ) << " MB system and " << gpu_bytes / ( 1024.0 * 1024.0 ) << " MB GPU memory";
+  if( ss.str() != points_status_ )
+  {
+    points_status_ = ss.str();
+    display_->setStatusStd(StatusProperty::Ok, "Points", points_status_);
+  }
 }
 
 void PointCloudCommon::processMessage(const sensor_msgs::PointCloud2ConstPtr& cloud)
@@ -721,10 +856,18 @@ void PointCloudCommon::processMessage(const sensor_msgs::PointCloud2ConstPtr& cl
   info->message_ = cloud;
   info->receive_time_ = ros::Time::now();
 
+  // Looked up once; retransforms keep the pose the cloud was received with.
+  if (!context_->getFrameManager()->getTransform(cloud->header, info->position_, info->orientation_))
+  {
+    std::stringstream ss;
+    ss << "Failed to transform from frame [" << cloud->header.frame_id << "] to frame [" << context_->getFrameManager()->getFixedFrame() << "]";
+    display_->setStatusStd(StatusProperty::Error, "Message", ss.str());
+    return;
+  }
+
   if (transformCloud(info, true))
   {
-    boost::mutex::scoped_lock lock(new_clouds_mutex_);
-    new_cloud_infos_.push_back(info);
+    new_cloud_infos_.push(info);
     display_->emitTimeSignal( cloud->header.stamp );
   }
 }
@@ -754,13 +897,13 @@ void PointCloudCommon::updateColorTransformer()
 PointCloudTransformerPtr PointCloudCommon::getXYZTransformer( const sensor_msgs::PointCloud2ConstPtr& cloud )
 {
   boost::recursive_mutex::scoped_lock lock( transformers_mutex_);
+  updateTransformerSupport( cloud );
   M_TransformerInfo::iterator it = transformers_.find( xyz_transformer_property_->getStdString() );
   if( it != transformers_.end() )
   {
-    const PointCloudTransformerPtr& trans = it->second.transformer;
-    if( trans->supports( cloud ) & PointCloudTransformer::Support_XYZ )
+    if( it->second.support & PointCloudTransformer::Support_XYZ )
     {
-      return trans;
+      return it->second.transformer;
     }
   }
 
@@ -770,13 +913,13 @@ PointCloudTransformerPtr PointCloudCommon::getXYZTransformer( const sensor_msgs:
 PointCloudTransformerPtr PointCloudCommon::getColorTransformer( const sensor_msgs::PointCloud2ConstPtr& cloud )
 {
   boost::recursive_mutex::scoped_lock lock( transformers_mutex_ );
+  updateTransformerSupport( cloud );
   M_TransformerInfo::iterator it = transformers_.find( color_transformer_property_->getStdString() );
   if( it != transformers_.end() )
   {
-    const PointCloudTransformerPtr& trans = it->second.transformer;
-    if( trans->supports( cloud ) & PointCloudTransformer::Support_Color )
+    if( it->second.support & PointCloudTransformer::Support_Color )
     {
-      return trans;
+      return it->second.transformer;
     }
   }
 
@@ -786,33 +929,133 @@ PointCloudTransformerPtr PointCloudCommon::getColorTransformer( const sensor_msg
 
 void PointCloudCommon::retransform()
 {
-  boost::recursive_mutex::scoped_lock lock(transformers_mutex_);
+  {
+    boost::recursive_mutex::scoped_lock lock(transformers_mutex_);
+
+    // A transformer's settings may change what it supports.
+    transformer_signature_.clear();
+  }
 
-  D_CloudInfo::iterator it = cloud_infos_.begin();
-  D_CloudInfo::iterator end = cloud_infos_.end();
+  // Queue the clouds newest first, since those are the ones people
+  // look at.  The old points stay on screen until each replacement is
+  // ready.
+  boost::mutex::scoped_lock lock(retransform_mutex_);
+  uint32_t generation = ++retransform_generation_;
+  retransformed_cloud_infos_.clear();
+
+  D_CloudInfo::reverse_iterator it = cloud_infos_.rbegin();
+  D_CloudInfo::reverse_iterator end = cloud_infos_.rend();
   for (; it != end; ++it)
   {
-    const CloudInfoPtr& cloud_info = *it;
-    transformCloud(cloud_info, false);
-    cloud_info->cloud_->clear();
-    cloud_info->cloud_->addPoints(&cloud_info->transformed_points_.front(), cloud_info->transformed_points_.size());
+    // Not the CloudInfo itself: its scene node may only be destroyed
+    // on this thread.
+    CloudInfoPtr copy(new CloudInfo);
+    copy->message_ = (*it)->message_;
+    copy->receive_time_ = (*it)->receive_time_;
+    copy->position_ = (*it)->position_;
+    copy->orientation_ = (*it)->orientation_;
+
+    cbqueue_.addCallback(ros::CallbackInterfacePtr(new FunctionCallback(
+        boost::bind(&PointCloudCommon::retransformCloud, this, copy, generation))), (uint64_t)this);
   }
 }
 
-bool PointCloudCommon::transformCloud(const CloudInfoPtr& cloud_info, bool update_transformers)
+void PointCloudCommon::retransformCloud(const CloudInfoPtr& cloud_info, uint32_t generation)
 {
+  {
+    boost::mutex::scoped_lock lock(retransform_mutex_);
+    if (generation != retransform_generation_)
+    {
+      return;
+    }
+  }
 
-  if ( !cloud_info->scene_node_ )
+  if (transformCloud(cloud_info, false))
   {
-    if (!context_->getFrameManager()->getTransform(cloud_info->message_->header, cloud_info->position_, cloud_info->orientation_))
+    boost::mutex::scoped_lock lock(retransform_mutex_);
+    if (generation == retransform_generation_)
     {
-      std::stringstream ss;
-      ss << "Failed to transform from frame [" << cloud_info->message_->header.frame_id << "] to frame [" << context_->getFrameManager()->getFixedFrame() << "]";
-      display_->setStatusStd(StatusProperty::Error, "Message", ss.str());
-      return false;
+      retransformed_cloud_infos_.push_back(cloud_info);
     }
   }
+}
+
+void PointCloudCommon::applyRetransformedClouds()
+{
+  V_CloudInfo retransformed;
+  {
+    boost::mutex::scoped_lock lock(retransform_mutex_);
+    retransformed.swap(retransformed_cloud_infos_);
+  }
+
+  V_CloudInfo::iterator it = retransformed.begin();
+  V_CloudInfo::iterator end = retransformed.end();
+  for (; it != end; ++it)
+  {
+    // Uploading the points is the expensive part, so spread it over
+    // several updates if needed.
+    if (it != retransformed.begin() && !display_->hasUpdateTimeLeft())
+    {
+      boost::mutex::scoped_lock lock(retransform_mutex_);
+      retransformed_cloud_infos_.insert(retransformed_cloud_infos_.begin(), it, end);
+      break;
+    }
+
+    const CloudInfoPtr& replacement = *it;
+    D_CloudInfo::iterator cloud_it = cloud_infos_.begin();
+    for (; cloud_it != cloud_infos_.end(); ++cloud_it)
+    {
+      if ((*cloud_it)->message_ == replacement->message_ && (*cloud_it)->receive_time_ == replacement->receive_time_)
+      {
+        break;
+      }
+    }
+    // It may have decayed meanwhile.
+    if (cloud_it == cloud_infos_.end() || !(*cloud_it)->cloud_)
+    {
+      continue;
+    }
+
+    const CloudInfoPtr& cloud_info = *cloud_it;
+    cloud_info->transformed_points_.swap(replacement->transformed_points_);
+    cloud_info->color_map_transformer_ = replacement->color_map_transformer_;
+    cloud_info->color_map_min_ = replacement->color_map_min_;
+    cloud_info->color_map_max_ = replacement->color_map_max_;
 
+    applyColorMap(cloud_info);
+    cloud_info->cloud_->clear();
+    cloud_info->cloud_->addPoints(&cloud_info->transformed_points_.front(), cloud_info->transformed_points_.size());
+    V_PointCloudPoint().swap( cloud_info->transformed_points_ );
+    context_->queueRender();
+  }
+}
+
+void PointCloudCommon::applyColorMap( const CloudInfoPtr& cloud_info )
+{
+  if( cloud_info->color_map_transformer_ )
+  {
+    cloud_info->color_map_transformer_->applyColorMap( *cloud_info->cloud_, cloud_info->color_map_min_, cloud_info->color_map_max_ );
+  }
+  else
+  {
+    cloud_info->cloud_->setColorMap( PointCloud::ColorMap() );
+  }
+}
+
+void PointCloudCommon::updateColorMaps()
+{
+  // Only shader parameters change, so this is cheap even for a long
+  // decay time.
+  boost::recursive_mutex::scoped_lock lock( transformers_mutex_ );
+  for( D_CloudInfo::iterator it = cloud_infos_.begin(); it != cloud_infos_.end(); ++it )
+  {
+    applyColorMap( *it );
+  }
+  context_->queueRender();
+}
+
+bool PointCloudCommon::transformCloud(const CloudInfoPtr& cloud_info, bool update_transformers)
+{
   Ogre::Matrix4 transform;
   transform.makeTransform( cloud_info->position_, Ogre::Vector3(1,1,1), cloud_info->orientation_ );
 
@@ -850,8 +1093,29 @@ bool PointCloudCommon::transformCloud(const CloudInfoPtr& cloud_info, bool updat
       return false;
     }
 
-    xyz_trans->transform(cloud_info->message_, PointCloudTransformer::Support_XYZ, transform, cloud_points);
-    color_trans->transform(cloud_info->message_, PointCloudTransformer::Support_Color, transform, cloud_points);
+    // Common layouts are decoded in a single pass when positions come
+    // straight from x, y and z.
+    bool fused = false;
+    if( dynamic_cast<XYZPCTransformer*>( xyz_trans.get() ))
+    {
+      PointCloudLayout layout = PointCloudLayout::get( *cloud_info->message_ );
+      fused = layout.specialized && color_trans->transformFused( cloud_info->message_, layout, cloud_points );
+    }
+
+    if( !fused )
+    {
+      xyz_trans->transform(cloud_info->message_, PointCloudTransformer::Support_XYZ, transform, cloud_points);
+      color_trans->transform(cloud_info->message_, PointCloudTransformer::Support_Color, transform, cloud_points);
+    }
+
+    if( color_trans->getColorMapRange( cloud_info->color_map_min_, cloud_info->color_map_max_ ))
+    {
+      cloud_info->color_map_transformer_ = color_trans;
+    }
+    else
+    {
+      cloud_info->color_map_transformer_.reset();
+    }
   }
 
   for (size_t i = 0; i < size; ++i)
@@ -951,14 +1215,13 @@ void PointCloudCommon::fillTransformerOptions( EnumProperty* prop, uint32_t mask
 
   boost::recursive_mutex::scoped_lock tlock(transformers_mutex_);
 
-  const sensor_msgs::PointCloud2ConstPtr& msg = cloud_infos_.front()->message_;
+  updateTransformerSupport( cloud_infos_.front()->message_ );
 
   M_TransformerInfo::iterator it = transformers_.begin();
   M_TransformerInfo::iterator end = transformers_.end();
   for (; it != end; ++it)
   {
-    const PointCloudTransformerPtr& trans = it->second.transformer;
-    if ((trans->supports(msg) & mask) == mask)
+    if ((it->second.support & mask) == mask)
     {
       prop->addOption( QString::fromStdString( it->first ));
     }
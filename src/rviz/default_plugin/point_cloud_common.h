@@ -52,6 +52,7 @@
 # include <sensor_msgs/PointCloud.h>
 # include <sensor_msgs/PointCloud2.h>
 
+# include "rviz/message_mailbox.h"
 # include "rviz/selection/selection_manager.h"
 # include "rviz/default_plugin/point_cloud_transformer.h"
 # include "rviz/properties/color_property.h"
@@ -104,10 +105,19 @@ public:
     boost::shared_ptr<PointCloud> cloud_;
     PointCloudSelectionHandlerPtr selection_handler_;
 
+    /** Output of transformCloud(), only kept until it is added to
+     * cloud_, which stores the points in half the memory.  Read
+     * positions back through PointCloud::getPointPosition(). */
     std::vector<PointCloud::Point> transformed_points_;
 
     Ogre::Quaternion orientation_;
     Ogre::Vector3 position_;
+
+    /** The color transformer, if it left the colors to the shaders,
+     * and the range of its values.  See PointCloudTransformer::getColorMapRange(). */
+    PointCloudTransformerPtr color_map_transformer_;
+    float color_map_min_;
+    float color_map_max_;
 };
 
   typedef boost::shared_ptr<CloudInfo> CloudInfoPtr;
@@ -142,6 +152,7 @@ public:
   EnumProperty* color_transformer_property_;
   EnumProperty* style_property_;
   FloatProperty* decay_time_property_;
+  BoolProperty* compact_positions_property_;
 
   void setAutoSize( bool auto_size );
 
@@ -153,15 +164,18 @@ private Q_SLOTS:
   void updateStyle();
   void updateBillboardSize();
   void updateAlpha();
+  void updateCompactPositions();
   void updateXyzTransformer();
   void updateColorTransformer();
   void setXyzTransformerOptions( EnumProperty* prop );
   void setColorTransformerOptions( EnumProperty* prop );
+  void updateColorMaps();
 
 private:
 
   /**
-   * \brief Transforms the cloud into the correct frame, and sets up our renderable cloud
+   * \brief Transforms the cloud with its position_ and orientation_ into transformed_points_.
+   * Thread-safe, it runs in processMessage() and for retransforms on the thread of spinner_.
    */
   bool transformCloud(const CloudInfoPtr& cloud, bool fully_update_transformers);
 
@@ -171,7 +185,11 @@ private:
   PointCloudTransformerPtr getXYZTransformer(const sensor_msgs::PointCloud2ConstPtr& cloud);
   PointCloudTransformerPtr getColorTransformer(const sensor_msgs::PointCloud2ConstPtr& cloud);
   void updateTransformers( const sensor_msgs::PointCloud2ConstPtr& cloud );
+  void updateTransformerSupport( const sensor_msgs::PointCloud2ConstPtr& cloud );
   void retransform();
+  void retransformCloud( const CloudInfoPtr& cloud_info, uint32_t generation );
+  void applyRetransformedClouds();
+  void applyColorMap( const CloudInfoPtr& cloud_info );
   void onTransformerOptions(V_string& ops, uint32_t mask);
 
   void loadTransformers();
@@ -187,11 +205,19 @@ private:
 
   Ogre::SceneNode* scene_node_;
 
-  V_CloudInfo new_cloud_infos_;
-  boost::mutex new_clouds_mutex_;
+  /** Transformed clouds handed from processMessage() on the spinner
+   * thread to update().  Only the newest is kept when clouds do not
+   * decay. */
+  MessageMailbox<CloudInfoPtr> new_cloud_infos_;
+
+  /** Clouds taken from new_cloud_infos_ which did not fit into the
+   * display's update time, uploaded first by the next update(). */
+  V_CloudInfo carried_cloud_infos_;
 
   L_CloudInfo obsolete_cloud_infos_;
 
+  std::string points_status_;               ///< Last text of the "Points" status
+
   struct TransformerInfo
   {
     PointCloudTransformerPtr transformer;
@@ -200,15 +226,32 @@ private:
 
     std::string readable_name;
     std::string lookup_name;
+
+    uint8_t support;  ///< supports() of the cloud layout in transformer_signature_
+    uint8_t score;    ///< score() of the cloud layout in transformer_signature_
   };
   typedef std::map<std::string, TransformerInfo> M_TransformerInfo;
 
   boost::recursive_mutex transformers_mutex_;
   M_TransformerInfo transformers_;
+
+  /** Field signature (see PointCloudLayout::getSignature()) of the cloud
+   * the transformers were last asked about.  Empty if unknown. */
+  std::string transformer_signature_;
+  /** True if the transformer options and selection have been updated
+   * for the layout in transformer_signature_. */
+  bool transformer_options_current_;
   bool new_xyz_transformer_;
   bool new_color_transformer_;
   bool needs_retransform_;
 
+  /** Retransforms run on the thread of spinner_, one cloud at a time,
+   * into copies of the CloudInfos, which update() then swaps in.  Results
+   * of a retransform started before the current one are dropped. */
+  boost::mutex retransform_mutex_;
+  uint32_t retransform_generation_;
+  V_CloudInfo retransformed_cloud_infos_;
+
   pluginlib::ClassLoader<PointCloudTransformer>* transformer_class_loader_;
 
   Display* display_;
@@ -0,0 +1,323 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <sstream>
+
+#include <boost/thread/mutex.hpp>
+
+#include "rviz/default_plugin/point_cloud_layout.h"
+
+namespace rviz
+{
+
+namespace
+{
+
+const sensor_msgs::PointField* findField( const sensor_msgs::PointCloud2& cloud, const std::string& name )
+{
+  for( size_t i = 0; i < cloud.fields.size(); i++ )
+  {
+    if( cloud.fields[ i ].name == name )
+    {
+      return &cloud.fields[ i ];
+    }
+  }
+  return 0;
+}
+
+bool isFloatAt( const sensor_msgs::PointField* field, uint32_t offset )
+{
+  return field && field->offset == offset && field->datatype == sensor_msgs::PointField::FLOAT32 && field->count <= 1;
+}
+
+PointCloudLayout computeLayout( const sensor_msgs::PointCloud2& cloud )
+{
+  PointCloudLayout layout;
+  layout.point_step = cloud.point_step;
+  layout.specialized = !cloud.is_bigendian &&
+    isFloatAt( findField( cloud, "x" ), 0 ) &&
+    isFloatAt( findField( cloud, "y" ), 4 ) &&
+    isFloatAt( findField( cloud, "z" ), 8 ) &&
+    ( cloud.point_step == 12 || cloud.point_step == 16 || cloud.point_step == 32 || cloud.point_step == 48 );
+
+  const sensor_msgs::PointField* intensity = findField( cloud, "intensity" );
+  layout.intensity_offset = -1;
+  if( intensity && intensity->datatype == sensor_msgs::PointField::FLOAT32 )
+  {
+    layout.intensity_offset = intensity->offset;
+  }
+
+  const sensor_msgs::PointField* rgb = findField( cloud, "rgb" );
+  layout.rgb_offset = -1;
+  if( rgb && ( rgb->datatype == sensor_msgs::PointField::INT32 ||
+               rgb->datatype == sensor_msgs::PointField::UINT32 ||
+               rgb->datatype == sensor_msgs::PointField::FLOAT32 ))
+  {
+    layout.rgb_offset = rgb->offset;
+  }
+
+  return layout;
+}
+
+template<uint32_t Step>
+void decodeXYZKernel( const uint8_t* data, uint32_t num_points, PointCloud::Point* out )
+{
+  for( uint32_t i = 0; i < num_points; ++i )
+  {
+    const float* p = reinterpret_cast<const float*>( data + Step * i );
+    out[ i ].position.x = p[ 0 ];
+    out[ i ].position.y = p[ 1 ];
+    out[ i ].position.z = p[ 2 ];
+  }
+}
+
+template<uint32_t Step, uint32_t IntensityOffset>
+void decodeXYZIntensityKernel( const uint8_t* data, uint32_t num_points, PointCloud::Point* out,
+                               float* intensities, float& min_out, float& max_out )
+{
+  float min_value = std::numeric_limits<float>::max();
+  float max_value = -std::numeric_limits<float>::max();
+  for( uint32_t i = 0; i < num_points; ++i )
+  {
+    const uint8_t* point = data + Step * i;
+    const float* p = reinterpret_cast<const float*>( point );
+    out[ i ].position.x = p[ 0 ];
+    out[ i ].position.y = p[ 1 ];
+    out[ i ].position.z = p[ 2 ];
+
+    float value = *reinterpret_cast<const float*>( point + IntensityOffset );
+    intensities[ i ] = value;
+    min_value = std::min( min_value, value );
+    max_value = std::max( max_value, value );
+  }
+  min_out = min_value;
+  max_out = max_value;
+}
+
+template<uint32_t Step, uint32_t RGBOffset>
+void decodeXYZRGBKernel( const uint8_t* data, uint32_t num_points, PointCloud::Point* out )
+{
+  const float scale = 1.0f / 255.0f;
+  for( uint32_t i = 0; i < num_points; ++i )
+  {
+    const uint8_t* point = data + Step * i;
+    const float* p = reinterpret_cast<const float*>( point );
+    out[ i ].position.x = p[ 0 ];
+    out[ i ].position.y = p[ 1 ];
+    out[ i ].position.z = p[ 2 ];
+
+    uint32_t rgb = *reinterpret_cast<const uint32_t*>( point + RGBOffset );
+    out[ i ].color.r = ((rgb >> 16) & 0xff) * scale;
+    out[ i ].color.g = ((rgb >> 8) & 0xff) * scale;
+    out[ i ].color.b = (rgb & 0xff) * scale;
+    out[ i ].color.a = 1.0f;
+  }
+}
+
+template<typename T>
+void decodeChannelKernel( const uint8_t* data, uint32_t point_step, uint32_t num_points, float* out )
+{
+  for( uint32_t i = 0; i < num_points; ++i )
+  {
+    out[ i ] = static_cast<float>( *reinterpret_cast<const T*>( data + point_step * i ));
+  }
+}
+
+/** Return the number of points of @a cloud if its data holds all of them, 0 otherwise. */
+uint32_t checkedPointCount( const sensor_msgs::PointCloud2& cloud )
+{
+  uint32_t num_points = cloud.width * cloud.height;
+  if( size_t( num_points ) * cloud.point_step > cloud.data.size() )
+  {
+    return 0;
+  }
+  return num_points;
+}
+
+} // end anonymous namespace
+
+std::string PointCloudLayout::getSignature( const sensor_msgs::PointCloud2& cloud )
+{
+  std::ostringstream signature;
+  signature << cloud.point_step << ( cloud.is_bigendian ? 'B' : 'L' );
+  for( size_t i = 0; i < cloud.fields.size(); i++ )
+  {
+    const sensor_msgs::PointField& field = cloud.fields[ i ];
+    signature << ';' << field.name << ':' << field.offset << ':' << int( field.datatype ) << ':' << field.count;
+  }
+  return signature.str();
+}
+
+PointCloudLayout PointCloudLayout::get( const sensor_msgs::PointCloud2& cloud )
+{
+  static boost::mutex mutex;
+  static std::map<std::string, PointCloudLayout> cache;
+
+  const std::string signature = getSignature( cloud );
+
+  boost::mutex::scoped_lock lock( mutex );
+  std::map<std::string, PointCloudLayout>::iterator it = cache.find( signature );
+  if( it != cache.end() )
+  {
+    return it->second;
+  }
+
+  // A handful of layouts is normal; don't let a publisher with
+  // ever-changing fields grow the cache without bound.
+  if( cache.size() >= 64 )
+  {
+    cache.clear();
+  }
+  PointCloudLayout layout = computeLayout( cloud );
+  cache[ signature ] = layout;
+  return layout;
+}
+
+bool decodeXYZ( const sensor_msgs::PointCloud2& cloud, const PointCloudLayout& layout, V_PointCloudPoint& points_out )
+{
+  uint32_t num_points = checkedPointCount( cloud );
+  if( !layout.specialized || num_points == 0 )
+  {
+    return false;
+  }
+
+  const uint8_t* data = &cloud.data.front();
+  PointCloud::Point* out = &points_out.front();
+  switch( layout.point_step )
+  {
+  case 12: decodeXYZKernel<12>( data, num_points, out ); return true;
+  case 16: decodeXYZKernel<16>( data, num_points, out ); return true;
+  case 32: decodeXYZKernel<32>( data, num_points, out ); return true;
+  case 48: decodeXYZKernel<48>( data, num_points, out ); return true;
+  default: return false;
+  }
+}
+
+bool decodeXYZIntensity( const sensor_msgs::PointCloud2& cloud, const PointCloudLayout& layout,
+                         V_PointCloudPoint& points_out, std::vector<float>& intensities_out,
+                         float& min_out, float& max_out )
+{
+  uint32_t num_points = checkedPointCount( cloud );
+  if( !layout.specialized || num_points == 0 )
+  {
+    return false;
+  }
+
+  const uint8_t* data = &cloud.data.front();
+  PointCloud::Point* out = &points_out.front();
+  intensities_out.resize( num_points );
+  float* intensities = &intensities_out.front();
+
+  // Packed xyzi, PCL's PointXYZI and Velodyne, and Ouster.
+  if( layout.point_step == 16 && layout.intensity_offset == 12 )
+  {
+    decodeXYZIntensityKernel<16, 12>( data, num_points, out, intensities, min_out, max_out );
+  }
+  else if( layout.point_step == 32 && layout.intensity_offset == 16 )
+  {
+    decodeXYZIntensityKernel<32, 16>( data, num_points, out, intensities, min_out, max_out );
+  }
+  else if( layout.point_step == 48 && layout.intensity_offset == 16 )
+  {
+    decodeXYZIntensityKernel<48, 16>( data, num_points, out, intensities, min_out, max_out );
+  }
+  else
+  {
+    return false;
+  }
+  return true;
+}
+
+bool decodeXYZRGB( const sensor_msgs::PointCloud2& cloud, const PointCloudLayout& layout, V_PointCloudPoint& points_out )
+{
+  uint32_t num_points = checkedPointCount( cloud );
+  if( !layout.specialized || num_points == 0 )
+  {
+    return false;
+  }
+
+  const uint8_t* data = &cloud.data.front();
+  PointCloud::Point* out = &points_out.front();
+
+  // Packed xyzrgb and PCL's PointXYZRGB.
+  if( layout.point_step == 16 && layout.rgb_offset == 12 )
+  {
+    decodeXYZRGBKernel<16, 12>( data, num_points, out );
+  }
+  else if( layout.point_step == 32 && layout.rgb_offset == 16 )
+  {
+    decodeXYZRGBKernel<32, 16>( data, num_points, out );
+  }
+  else
+  {
+    return false;
+  }
+  return true;
+}
+
+void decodeChannel( const sensor_msgs::PointCloud2& cloud, uint32_t offset, uint8_t datatype, std::vector<float>& values_out )
+{
+  uint32_t num_points = checkedPointCount( cloud );
+  values_out.assign( num_points, 0.0f );
+  if( num_points == 0 )
+  {
+    return;
+  }
+
+  const uint8_t* data = &cloud.data.front() + offset;
+  float* out = &values_out.front();
+  switch( datatype )
+  {
+  case sensor_msgs::PointField::INT8:
+  case sensor_msgs::PointField::UINT8:
+    decodeChannelKernel<uint8_t>( data, cloud.point_step, num_points, out );
+    break;
+  case sensor_msgs::PointField::INT16:
+  case sensor_msgs::PointField::UINT16:
+    decodeChannelKernel<uint16_t>( data, cloud.point_step, num_points, out );
+    break;
+  case sensor_msgs::PointField::INT32:
+  case sensor_msgs::PointField::UINT32:
+    decodeChannelKernel<uint32_t>( data, cloud.point_step, num_points, out );
+    break;
+  case sensor_msgs::PointField::FLOAT32:
+    decodeChannelKernel<float>( data, cloud.point_step, num_points, out );
+    break;
+  case sensor_msgs::PointField::FLOAT64:
+    decodeChannelKernel<double>( data, cloud.point_step, num_points, out );
+    break;
+  default:
+    break;
+  }
+}
+
+} // end namespace rviz
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RVIZ_POINT_CLOUD_LAYOUT_H
+#define RVIZ_POINT_CLOUD_LAYOUT_H
+
+#include <vector>
+#include <string>
+
+#include <sensor_msgs/PointCloud2.h>
+
+#include "rviz/default_plugin/point_cloud_transformer.h"
+
+namespace rviz
+{
+
+/** @brief Field layout of a PointCloud2, for decoding common layouts with specialized loops.
+ *
+ * A layout is specialized if x, y and z are float32 at offsets 0, 4
+ * and 8 and the point step is 12, 16, 32 or 48 bytes.  That covers
+ * packed xyz, PCL's PointXYZ, PointXYZI and PointXYZRGB, and the
+ * Velodyne and Ouster driver clouds with their ring and time fields.
+ * The decode functions below read those with loops whose point step
+ * and field offsets are template parameters, so there is no per-point
+ * type switch or index arithmetic left for the compiler to work around.
+ *
+ * Layouts are cached by a signature of the cloud's fields, so each
+ * layout is only worked out once. */
+struct PointCloudLayout
+{
+  /** @brief Return the layout of @a cloud.  Thread-safe. */
+  static PointCloudLayout get( const sensor_msgs::PointCloud2& cloud );
+
+  /** @brief Return a string which is equal for two clouds exactly when
+   * their point steps, byte orders and fields are. */
+  static std::string getSignature( const sensor_msgs::PointCloud2& cloud );
+
+  bool specialized;          ///< True if x, y and z can be read by a specialized loop.
+  uint32_t point_step;
+  int32_t intensity_offset;  ///< Offset of a float32 "intensity" field, or -1 if there is none.
+  int32_t rgb_offset;        ///< Offset of a packed 32 bit "rgb" field, or -1 if there is none.
+};
+
+/** @brief Decode the positions of all points of @a cloud into @a points_out.
+ * @return false if @a layout has no specialized decoder. */
+bool decodeXYZ( const sensor_msgs::PointCloud2& cloud, const PointCloudLayout& layout, V_PointCloudPoint& points_out );
+
+/** @brief Decode positions and the "intensity" field in one pass.
+ *
+ * @a intensities_out is resized to the number of points, and
+ * @a min_out and @a max_out are set to the intensity bounds.
+ * @return false if @a layout has no specialized decoder for both. */
+bool decodeXYZIntensity( const sensor_msgs::PointCloud2& cloud, const PointCloudLayout& layout,
+                         V_PointCloudPoint& points_out, std::vector<float>& intensities_out,
+                         float& min_out, float& max_out );
+
+/** @brief Decode positions and colors from the packed "rgb" field in one pass.
+ * @return false if @a layout has no specialized decoder for both. */
+bool decodeXYZRGB( const sensor_msgs::PointCloud2& cloud, const PointCloudLayout& layout, V_PointCloudPoint& points_out );
+
+/** @brief Read one field of every point of @a cloud as float into @a values_out.
+ *
+ * The generic counterpart of the decoders above: it works with any
+ * layout, but switches on @a datatype once instead of once per point. */
+void decodeChannel( const sensor_msgs::PointCloud2& cloud, uint32_t offset, uint8_t datatype, std::vector<float>& values_out );
+
+} // namespace rviz
+
+#endif // RVIZ_POINT_CLOUD_LAYOUT_H
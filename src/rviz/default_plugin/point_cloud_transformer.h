@@ -52,6 +52,7 @@ ROS_DECLARE_MESSAGE(PointCloud2);
 namespace rviz
 {
 class Property;
+struct PointCloudLayout;
 
 typedef std::vector<PointCloud::Point> V_PointCloudPoint;
 
@@ -84,6 +85,14 @@ public:
    */
   virtual bool transform(const sensor_msgs::PointCloud2ConstPtr& cloud, uint32_t mask, const Ogre::Matrix4& transform, V_PointCloudPoint& out) = 0;
 
+  /**
+   * \brief Decode position and color together, reading each point only once.  Called on the color transformer when the
+   * position transformer is "XYZ", with the layout of the cloud.  Transformers with a decoder specialized for that layout
+   * (see PointCloudLayout) fill in positions and colors and return true; returning false, as the default does, makes the
+   * caller use transform() for position and color instead.
+   */
+  virtual bool transformFused(const sensor_msgs::PointCloud2ConstPtr& cloud, const PointCloudLayout& layout, V_PointCloudPoint& out) { return false; }
+
   /**
    * \brief "Score" a message for how well supported the message is.  For example, a "flat color" transformer can support any cloud, but will
    * return a score of 0 here since it should not be preferred over others that explicitly support fields in the message.  This allows that
@@ -100,9 +109,25 @@ public:
                                  uint32_t mask,
                                  QList<Property*>& out_props ) {}
 
+  /**
+   * \brief Return true if the last call of transform() or transformFused() wrote values for the
+   * shaders to map to colors (see PointCloud::encodeColorMapValue()) instead of colors.  The values
+   * were normalized from [min_value, max_value], which are returned as well.
+   */
+  virtual bool getColorMapRange( float& min_value, float& max_value ) { return false; }
+
+  /**
+   * \brief Set the colormap of @a cloud, whose points hold values normalized from [min_value, max_value]
+   * as returned by getColorMapRange().
+   */
+  virtual void applyColorMap( PointCloud& cloud, float min_value, float max_value ) {}
+
 Q_SIGNALS:
   /** @brief Subclasses should emit this signal whenever they think the points should be re-transformed. */
   void needRetransform();
+
+  /** @brief Subclasses emit this instead of needRetransform() when only the colormap changed, see applyColorMap(). */
+  void needColorMapUpdate();
 };
 
 } // namespace rviz
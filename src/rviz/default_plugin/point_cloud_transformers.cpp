@@ -38,6 +38,7 @@
 #include "rviz/properties/float_property.h"
 #include "rviz/validate_floats.h"
 
+#include "point_cloud_layout.h"
 #include "point_cloud_transformers.h"
 
 namespace rviz
@@ -61,6 +62,24 @@ static void getRainbowColor(float value, Ogre::ColourValue& color)
   else if (i >= 5) color[0] = 1, color[1] = n, color[2] = 0;
 }
 
+/** Store @a values, normalized from [min_value, max_value], in the colors of @a points_out for PointCloud::ColorMap. */
+static void encodeColorMapValues( const std::vector<float>& values, float min_value, float max_value, V_PointCloudPoint& points_out )
+{
+  float range = max_value - min_value;
+  float scale = range > 0.0f ? 1.0f / range : 0.0f;
+  for( size_t i = 0; i < values.size(); ++i )
+  {
+    PointCloud::encodeColorMapValue(( values[ i ] - min_value ) * scale, points_out[ i ].color );
+  }
+}
+
+IntensityPCTransformer::IntensityPCTransformer()
+: color_mapped_( false )
+, color_map_min_( 0.0f )
+, color_map_max_( 0.0f )
+{
+}
+
 uint8_t IntensityPCTransformer::supports(const sensor_msgs::PointCloud2ConstPtr& cloud)
 {
   updateChannels(cloud);
@@ -77,6 +96,7 @@ bool IntensityPCTransformer::transform( const sensor_msgs::PointCloud2ConstPtr&
                                         const Ogre::Matrix4& transform,
                                         V_PointCloudPoint& points_out )
 {
+  color_mapped_ = false;
   if( !( mask & Support_Color ))
   {
     return false;
@@ -100,28 +120,79 @@ bool IntensityPCTransformer::transform( const sensor_msgs::PointCloud2ConstPtr&
     }
   }
 
-  const uint32_t offset = cloud->fields[index].offset;
-  const uint8_t type = cloud->fields[index].datatype;
-  const uint32_t point_step = cloud->point_step;
-  const uint32_t num_points = cloud->width * cloud->height;
+  // Read the channel once, with the type switch outside the loop.
+  std::vector<float> values;
+  decodeChannel( *cloud, cloud->fields[index].offset, cloud->fields[index].datatype, values );
+  if( values.size() != points_out.size() )
+  {
+    return false;
+  }
 
   float min_intensity = 999999.0f;
   float max_intensity = -999999.0f;
-  if( auto_compute_intensity_bounds_property_->getBool() )
+  if( auto_compute_intensity_bounds_property_->getBool() || gpu_colormap_property_->getBool() )
   {
-    for( uint32_t i = 0; i < num_points; ++i )
+    for( size_t i = 0; i < values.size(); ++i )
     {
-      float val = valueFromCloud<float>(cloud, offset, type, point_step, i);
-      min_intensity = std::min(val, min_intensity);
-      max_intensity = std::max(val, max_intensity);
+      min_intensity = std::min(values[i], min_intensity);
+      max_intensity = std::max(values[i], max_intensity);
     }
+  }
+
+  colorPoints( values, min_intensity, max_intensity, points_out );
+  return true;
+}
+
+bool IntensityPCTransformer::transformFused( const sensor_msgs::PointCloud2ConstPtr& cloud,
+                                             const PointCloudLayout& layout,
+                                             V_PointCloudPoint& points_out )
+{
+  color_mapped_ = false;
+  const std::string& channel = channel_name_property_->getStdString();
+  if( channel != "intensity" || layout.intensity_offset < 0 )
+  {
+    return false;
+  }
+
+  std::vector<float> values;
+  float min_intensity, max_intensity;
+  if( !decodeXYZIntensity( *cloud, layout, points_out, values, min_intensity, max_intensity ))
+  {
+    return false;
+  }
+
+  colorPoints( values, min_intensity, max_intensity, points_out );
+  return true;
+}
 
-    min_intensity = std::max(-999999.0f, min_intensity);
-    max_intensity = std::min(999999.0f, max_intensity);
+void IntensityPCTransformer::colorPoints( const std::vector<float>& values,
+                                          float min_intensity,
+                                          float max_intensity,
+                                          V_PointCloudPoint& points_out )
+{
+  const uint32_t num_points = values.size();
+
+  min_intensity = std::max(-999999.0f, min_intensity);
+  max_intensity = std::min(999999.0f, max_intensity);
+  if( auto_compute_intensity_bounds_property_->getBool() )
+  {
     min_intensity_property_->setFloat( min_intensity );
     max_intensity_property_->setFloat( max_intensity );
   }
-  else
+
+  if( gpu_colormap_property_->getBool() )
+  {
+    // Leave the colors to the shaders, so applyColorMap() can change
+    // them later without touching the points.  The values are stored
+    // relative to the range they actually have.
+    color_mapped_ = true;
+    color_map_min_ = min_intensity;
+    color_map_max_ = max_intensity;
+    encodeColorMapValues( values, min_intensity, max_intensity, points_out );
+    return;
+  }
+
+  if( !auto_compute_intensity_bounds_property_->getBool() )
   {
     min_intensity = min_intensity_property_->getFloat();
     max_intensity = max_intensity_property_->getFloat();
@@ -140,11 +211,11 @@ bool IntensityPCTransformer::transform( const sensor_msgs::PointCloud2ConstPtr&
 
   if( use_rainbow_property_->getBool() )
   {
+    bool invert = invert_rainbow_property_->getBool();
     for (uint32_t i = 0; i < num_points; ++i)
     {
-      float val = valueFromCloud<float>(cloud, offset, type, point_step, i);
-      float value = 1.0 - (val - min_intensity)/diff_intensity;
-      if(invert_rainbow_property_->getBool() ){
+      float value = 1.0 - (values[i] - min_intensity)/diff_intensity;
+      if( invert ){
         value = 1.0 - value;
       }
       getRainbowColor(value, points_out[i].color);
@@ -154,16 +225,53 @@ bool IntensityPCTransformer::transform( const sensor_msgs::PointCloud2ConstPtr&
   {
     for (uint32_t i = 0; i < num_points; ++i)
     {
-      float val = valueFromCloud<float>(cloud, offset, type, point_step, i);
-      float normalized_intensity = ( val - min_intensity ) / diff_intensity;
+      float normalized_intensity = ( values[i] - min_intensity ) / diff_intensity;
       normalized_intensity = std::min(1.0f, std::max(0.0f, normalized_intensity));
       points_out[i].color.r = max_color.r * normalized_intensity + min_color.r * (1.0f - normalized_intensity);
       points_out[i].color.g = max_color.g * normalized_intensity + min_color.g * (1.0f - normalized_intensity);
       points_out[i].color.b = max_color.b * normalized_intensity + min_color.b * (1.0f - normalized_intensity);
     }
   }
+}
 
-  return true;
+bool IntensityPCTransformer::getColorMapRange( float& min_value, float& max_value )
+{
+  min_value = color_map_min_;
+  max_value = color_map_max_;
+  return color_mapped_;
+}
+
+void IntensityPCTransformer::applyColorMap( PointCloud& cloud, float min_value, float max_value )
+{
+  // The same mapping as colorPoints(), from values stored relative to
+  // [min_value, max_value].
+  float min_intensity = min_value;
+  float max_intensity = max_value;
+  if( !auto_compute_intensity_bounds_property_->getBool() )
+  {
+    min_intensity = min_intensity_property_->getFloat();
+    max_intensity = max_intensity_property_->getFloat();
+  }
+  float diff_intensity = max_intensity - min_intensity;
+  if( diff_intensity == 0 )
+  {
+    diff_intensity = 1e20;
+  }
+
+  PointCloud::ColorMap color_map;
+  if( use_rainbow_property_->getBool() )
+  {
+    color_map.mode = invert_rainbow_property_->getBool() ? PointCloud::CM_INVERTED_RAINBOW : PointCloud::CM_RAINBOW;
+  }
+  else
+  {
+    color_map.mode = PointCloud::CM_GRADIENT;
+    color_map.min_color = min_color_property_->getOgreColor();
+    color_map.max_color = max_color_property_->getOgreColor();
+  }
+  color_map.scale = ( max_value - min_value ) / diff_intensity;
+  color_map.offset = ( min_value - min_intensity ) / diff_intensity;
+  cloud.setColorMap( color_map );
 }
 
 void IntensityPCTransformer::createProperties( Property* parent_property, uint32_t mask, QList<Property*>& out_props )
@@ -184,12 +292,12 @@ void IntensityPCTransformer::createProperties( Property* parent_property, uint32
     min_color_property_ = new ColorProperty( "Min Color", Qt::black,
                                              "Color to assign the points with the minimum intensity.  "
                                              "Actual color is interpolated between this and Max Color.",
-                                             parent_property, SIGNAL( needRetransform() ), this );
+                                             parent_property, SLOT( updateColorMap() ), this );
 
     max_color_property_ = new ColorProperty( "Max Color", Qt::white,
                                              "Color to assign the points with the maximum intensity.  "
                                              "Actual color is interpolated between this and Min Color.",
-                                             parent_property, SIGNAL( needRetransform() ), this );
+                                             parent_property, SLOT( updateColorMap() ), this );
 
     auto_compute_intensity_bounds_property_ = new BoolProperty( "Autocompute Intensity Bounds", true,
                                                                 "Whether to automatically compute the intensity min/max values.",
@@ -203,6 +311,11 @@ void IntensityPCTransformer::createProperties( Property* parent_property, uint32
                                                  "Maximum possible intensity value, used to interpolate from Min Color to Max Color for a point.",
                                                  parent_property );
 
+    gpu_colormap_property_ = new BoolProperty( "GPU Colormap", false,
+                                               "Whether to turn intensities into colors on the graphics card.  Changing the colors "
+                                               "or bounds then only updates the shaders instead of transforming all clouds again.",
+                                               parent_property, SIGNAL( needRetransform() ), this );
+
     out_props.push_back( channel_name_property_ );
     out_props.push_back( use_rainbow_property_ );
     out_props.push_back( invert_rainbow_property_ );
@@ -211,6 +324,7 @@ void IntensityPCTransformer::createProperties( Property* parent_property, uint32
     out_props.push_back( auto_compute_intensity_bounds_property_ );
     out_props.push_back( min_intensity_property_ );
     out_props.push_back( max_intensity_property_ );
+    out_props.push_back( gpu_colormap_property_ );
 
     updateUseRainbow();
     updateAutoComputeIntensityBounds();
@@ -249,15 +363,15 @@ void IntensityPCTransformer::updateAutoComputeIntensityBounds()
   max_intensity_property_->setHidden( auto_compute );
   if( auto_compute )
   {
-    disconnect( min_intensity_property_, SIGNAL( changed() ), this, SIGNAL( needRetransform() ));
-    disconnect( max_intensity_property_, SIGNAL( changed() ), this, SIGNAL( needRetransform() ));
+    disconnect( min_intensity_property_, SIGNAL( changed() ), this, SLOT( updateColorMap() ));
+    disconnect( max_intensity_property_, SIGNAL( changed() ), this, SLOT( updateColorMap() ));
   }
   else
   {
-    connect( min_intensity_property_, SIGNAL( changed() ), this, SIGNAL( needRetransform() ));
-    connect( max_intensity_property_, SIGNAL( changed() ), this, SIGNAL( needRetransform() ));
+    connect( min_intensity_property_, SIGNAL( changed() ), this, SLOT( updateColorMap() ));
+    connect( max_intensity_property_, SIGNAL( changed() ), this, SLOT( updateColorMap() ));
   }
-  Q_EMIT needRetransform();
+  updateColorMap();
 }
 
 void IntensityPCTransformer::updateUseRainbow()
@@ -266,7 +380,19 @@ void IntensityPCTransformer::updateUseRainbow()
   invert_rainbow_property_->setHidden( !use_rainbow );
   min_color_property_->setHidden( use_rainbow );
   max_color_property_->setHidden( use_rainbow );
-  Q_EMIT needRetransform();
+  updateColorMap();
+}
+
+void IntensityPCTransformer::updateColorMap()
+{
+  if( gpu_colormap_property_->getBool() )
+  {
+    Q_EMIT needColorMapUpdate();
+  }
+  else
+  {
+    Q_EMIT needRetransform();
+  }
 }
 
 uint8_t XYZPCTransformer::supports(const sensor_msgs::PointCloud2ConstPtr& cloud)
@@ -361,6 +487,11 @@ bool RGB8PCTransformer::transform(const sensor_msgs::PointCloud2ConstPtr& cloud,
   return true;
 }
 
+bool RGB8PCTransformer::transformFused(const sensor_msgs::PointCloud2ConstPtr& cloud, const PointCloudLayout& layout, V_PointCloudPoint& points_out)
+{
+  return decodeXYZRGB(*cloud, layout, points_out);
+}
+
 uint8_t RGBF32PCTransformer::supports(const sensor_msgs::PointCloud2ConstPtr& cloud)
 {
   int32_t ri = findChannelIndex(cloud, "r");
@@ -438,6 +569,24 @@ bool FlatColorPCTransformer::transform( const sensor_msgs::PointCloud2ConstPtr&
   return true;
 }
 
+bool FlatColorPCTransformer::transformFused( const sensor_msgs::PointCloud2ConstPtr& cloud,
+                                             const PointCloudLayout& layout,
+                                             V_PointCloudPoint& points_out )
+{
+  if( !decodeXYZ( *cloud, layout, points_out ))
+  {
+    return false;
+  }
+
+  Ogre::ColourValue color = color_property_->getOgreColor();
+  for( size_t i = 0; i < points_out.size(); ++i )
+  {
+    points_out[i].color = color;
+  }
+
+  return true;
+}
+
 void FlatColorPCTransformer::createProperties( Property* parent_property, uint32_t mask, QList<Property*>& out_props )
 {
   if( mask & Support_Color )
@@ -449,6 +598,13 @@ void FlatColorPCTransformer::createProperties( Property* parent_property, uint32
   }
 }
 
+AxisColorPCTransformer::AxisColorPCTransformer()
+: color_mapped_( false )
+, color_map_min_( 0.0f )
+, color_map_max_( 0.0f )
+{
+}
+
 uint8_t AxisColorPCTransformer::supports(const sensor_msgs::PointCloud2ConstPtr& cloud)
 {
   return Support_Color;
@@ -464,6 +620,7 @@ bool AxisColorPCTransformer::transform( const sensor_msgs::PointCloud2ConstPtr&
                                         const Ogre::Matrix4& transform,
                                         V_PointCloudPoint& points_out )
 {
+  color_mapped_ = false;
   if( !( mask & Support_Color ))
   {
     return false;
@@ -511,7 +668,9 @@ bool AxisColorPCTransformer::transform( const sensor_msgs::PointCloud2ConstPtr&
   }
   float min_value_current = 9999.0f;
   float max_value_current = -9999.0f;
-  if( auto_compute_bounds_property_->getBool() )
+  bool auto_compute = auto_compute_bounds_property_->getBool();
+  bool gpu_colormap = gpu_colormap_property_->getBool();
+  if( auto_compute || gpu_colormap )
   {
     for( uint32_t i = 0; i < num_points; i++ )
     {
@@ -519,10 +678,24 @@ bool AxisColorPCTransformer::transform( const sensor_msgs::PointCloud2ConstPtr&
       min_value_current = std::min( min_value_current, val );
       max_value_current = std::max( max_value_current, val );
     }
+  }
+  if( auto_compute )
+  {
     min_value_property_->setFloat( min_value_current );
     max_value_property_->setFloat( max_value_current );
   }
-  else
+
+  if( gpu_colormap )
+  {
+    // See IntensityPCTransformer::colorPoints().
+    color_mapped_ = true;
+    color_map_min_ = min_value_current;
+    color_map_max_ = max_value_current;
+    encodeColorMapValues( values, min_value_current, max_value_current, points_out );
+    return true;
+  }
+
+  if( !auto_compute )
   {
     min_value_current = min_value_property_->getFloat();
     max_value_current = max_value_property_->getFloat();
@@ -542,6 +715,35 @@ bool AxisColorPCTransformer::transform( const sensor_msgs::PointCloud2ConstPtr&
   return true;
 }
 
+bool AxisColorPCTransformer::getColorMapRange( float& min_value, float& max_value )
+{
+  min_value = color_map_min_;
+  max_value = color_map_max_;
+  return color_mapped_;
+}
+
+void AxisColorPCTransformer::applyColorMap( PointCloud& cloud, float min_value, float max_value )
+{
+  float min_value_current = min_value;
+  float max_value_current = max_value;
+  if( !auto_compute_bounds_property_->getBool() )
+  {
+    min_value_current = min_value_property_->getFloat();
+    max_value_current = max_value_property_->getFloat();
+  }
+  float range = max_value_current - min_value_current;
+  if( range == 0 )
+  {
+    range = 0.001f;
+  }
+
+  PointCloud::ColorMap color_map;
+  color_map.mode = PointCloud::CM_RAINBOW;
+  color_map.scale = ( max_value - min_value ) / range;
+  color_map.offset = ( min_value - min_value_current ) / range;
+  cloud.setColorMap( color_map );
+}
+
 void AxisColorPCTransformer::createProperties( Property* parent_property, uint32_t mask, QList<Property*>& out_props )
 {
   if( mask & Support_Color )
@@ -569,9 +771,15 @@ void AxisColorPCTransformer::createProperties( Property* parent_property, uint32
                                                   "Whether to color the cloud based on its fixed frame position or its local frame position.",
                                                   parent_property, SIGNAL( needRetransform() ), this );
 
+    gpu_colormap_property_ = new BoolProperty( "GPU Colormap", false,
+                                               "Whether to turn values into colors on the graphics card.  Changing the bounds "
+                                               "then only updates the shaders instead of transforming all clouds again.",
+                                               parent_property, SIGNAL( needRetransform() ), this );
+
     out_props.push_back( axis_property_ );
     out_props.push_back( auto_compute_bounds_property_ );
     out_props.push_back( use_fixed_frame_property_ );
+    out_props.push_back( gpu_colormap_property_ );
 
     updateAutoComputeBounds();
   }
@@ -584,16 +792,28 @@ void AxisColorPCTransformer::updateAutoComputeBounds()
   max_value_property_->setHidden( auto_compute );
   if( auto_compute )
   {
-    disconnect( min_value_property_, SIGNAL( changed() ), this, SIGNAL( needRetransform() ));
-    disconnect( max_value_property_, SIGNAL( changed() ), this, SIGNAL( needRetransform() ));
+    disconnect( min_value_property_, SIGNAL( changed() ), this, SLOT( updateColorMap() ));
+    disconnect( max_value_property_, SIGNAL( changed() ), this, SLOT( updateColorMap() ));
   }
   else
   {
-    connect( min_value_property_, SIGNAL( changed() ), this, SIGNAL( needRetransform() ));
-    connect( max_value_property_, SIGNAL( changed() ), this, SIGNAL( needRetransform() ));
+    connect( min_value_property_, SIGNAL( changed() ), this, SLOT( updateColorMap() ));
+    connect( max_value_property_, SIGNAL( changed() ), this, SLOT( updateColorMap() ));
     auto_compute_bounds_property_->expand();
   }
-  Q_EMIT needRetransform();
+  updateColorMap();
+}
+
+void AxisColorPCTransformer::updateColorMap()
+{
+  if( gpu_colormap_property_->getBool() )
+  {
+    Q_EMIT needColorMapUpdate();
+  }
+  else
+  {
+    Q_EMIT needRetransform();
+  }
 }
 
 } // end namespace rviz
@@ -114,20 +114,29 @@ class IntensityPCTransformer : public PointCloudTransformer
 {
 Q_OBJECT
 public:
+  IntensityPCTransformer();
+
   virtual uint8_t supports(const sensor_msgs::PointCloud2ConstPtr& cloud);
   virtual bool transform(const sensor_msgs::PointCloud2ConstPtr& cloud,
                          uint32_t mask,
                          const Ogre::Matrix4& transform,
                          V_PointCloudPoint& points_out);
+  virtual bool transformFused(const sensor_msgs::PointCloud2ConstPtr& cloud, const PointCloudLayout& layout, V_PointCloudPoint& points_out);
   virtual uint8_t score(const sensor_msgs::PointCloud2ConstPtr& cloud);
   virtual void createProperties( Property* parent_property, uint32_t mask, QList<Property*>& out_props );
   void updateChannels(const sensor_msgs::PointCloud2ConstPtr& cloud); 
+  virtual bool getColorMapRange( float& min_value, float& max_value );
+  virtual void applyColorMap( PointCloud& cloud, float min_value, float max_value );
 
 private Q_SLOTS:
   void updateUseRainbow();
   void updateAutoComputeIntensityBounds();
+  void updateColorMap();
 
 private:
+  /** @brief Color @a points_out from intensity @a values.  @a min_value and @a max_value are their bounds, used if they are auto-computed. */
+  void colorPoints( const std::vector<float>& values, float min_value, float max_value, V_PointCloudPoint& points_out );
+
   V_string available_channels_;
 
   ColorProperty* min_color_property_;
@@ -138,6 +147,11 @@ private:
   FloatProperty* min_intensity_property_;
   FloatProperty* max_intensity_property_;
   EditableEnumProperty* channel_name_property_;
+  BoolProperty* gpu_colormap_property_;
+
+  bool color_mapped_;    ///< See getColorMapRange()
+  float color_map_min_;
+  float color_map_max_;
 };
 
 class XYZPCTransformer : public PointCloudTransformer
@@ -156,6 +170,7 @@ Q_OBJECT
 public:
   virtual uint8_t supports(const sensor_msgs::PointCloud2ConstPtr& cloud);
   virtual bool transform(const sensor_msgs::PointCloud2ConstPtr& cloud, uint32_t mask, const Ogre::Matrix4& transform, V_PointCloudPoint& points_out);
+  virtual bool transformFused(const sensor_msgs::PointCloud2ConstPtr& cloud, const PointCloudLayout& layout, V_PointCloudPoint& points_out);
 };
 
 
@@ -176,6 +191,7 @@ Q_OBJECT
 public:
   virtual uint8_t supports(const sensor_msgs::PointCloud2ConstPtr& cloud);
   virtual bool transform(const sensor_msgs::PointCloud2ConstPtr& cloud, uint32_t mask, const Ogre::Matrix4& transform, V_PointCloudPoint& points_out);
+  virtual bool transformFused(const sensor_msgs::PointCloud2ConstPtr& cloud, const PointCloudLayout& layout, V_PointCloudPoint& points_out);
   virtual void createProperties( Property* parent_property, uint32_t mask, QList<Property*>& out_props );
   virtual uint8_t score(const sensor_msgs::PointCloud2ConstPtr& cloud);
 
@@ -187,10 +203,14 @@ class AxisColorPCTransformer : public PointCloudTransformer
 {
 Q_OBJECT
 public:
+  AxisColorPCTransformer();
+
   virtual uint8_t supports(const sensor_msgs::PointCloud2ConstPtr& cloud);
   virtual bool transform(const sensor_msgs::PointCloud2ConstPtr& cloud, uint32_t mask, const Ogre::Matrix4& transform, V_PointCloudPoint& points_out);
   virtual void createProperties( Property* parent_property, uint32_t mask, QList<Property*>& out_props );
   virtual uint8_t score(const sensor_msgs::PointCloud2ConstPtr& cloud);
+  virtual bool getColorMapRange( float& min_value, float& max_value );
+  virtual void applyColorMap( PointCloud& cloud, float min_value, float max_value );
 
   enum Axis
   {
@@ -201,6 +221,7 @@ public:
 
 private Q_SLOTS:
   void updateAutoComputeBounds();
+  void updateColorMap();
 
 private:
   BoolProperty* auto_compute_bounds_property_;
@@ -208,6 +229,11 @@ private:
   FloatProperty* max_value_property_;
   EnumProperty* axis_property_;
   BoolProperty* use_fixed_frame_property_;
+  BoolProperty* gpu_colormap_property_;
+
+  bool color_mapped_;    ///< See getColorMapRange()
+  float color_map_min_;
+  float color_map_max_;
 };
 
 }
@@ -27,13 +27,14 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <OGRE/OgreManualObject.h>
 #include <OGRE/OgreSceneManager.h>
 #include <OGRE/OgreSceneNode.h>
 
 #include "rviz/display_context.h"
 #include "rviz/frame_manager.h"
+#include "rviz/ogre_helpers/arrow_cloud.h"
 #include "rviz/properties/color_property.h"
+#include "rviz/properties/enum_property.h"
 #include "rviz/properties/float_property.h"
 #include "rviz/validate_floats.h"
 
@@ -43,26 +44,67 @@ namespace rviz
 {
 
 PoseArrayDisplay::PoseArrayDisplay()
-  : manual_object_( NULL )
+  : arrow_cloud_( NULL )
 {
+  shape_property_ = new EnumProperty( "Shape", "Arrow (Flat)", "Shape to display the poses as.",
+                                      this, SLOT( updateShape() ));
+  shape_property_->addOption( "Arrow (Flat)", ARROW_FLAT );
+  shape_property_->addOption( "Arrow (3D)", ARROW_3D );
+
   color_property_ = new ColorProperty( "Color", QColor( 255, 25, 0 ), "Color to draw the arrows.", this );
-  length_property_ = new FloatProperty( "Arrow Length", 0.3, "Length of the arrows.", this );
+
+  alpha_property_ = new FloatProperty( "Alpha", 1.0, "Amount of transparency to apply to the arrows.",
+                                       this, SLOT( updateAlpha() ));
+  alpha_property_->setMin( 0.0 );
+  alpha_property_->setMax( 1.0 );
+
+  length_property_ = new FloatProperty( "Arrow Length", 0.3, "Length of the arrows.",
+                                        this, SLOT( updateShape() ));
 }
 
 PoseArrayDisplay::~PoseArrayDisplay()
 {
-  if ( initialized() )
-  {
-    scene_manager_->destroyManualObject( manual_object_ );
-  }
+  delete arrow_cloud_;
 }
 
 void PoseArrayDisplay::onInitialize()
 {
   MFDClass::onInitialize();
-  manual_object_ = scene_manager_->createManualObject();
-  manual_object_->setDynamic( true );
-  scene_node_->attachObject( manual_object_ );
+  arrow_cloud_ = new ArrowCloud();
+  scene_node_->attachObject( arrow_cloud_ );
+  updateShape();
+  updateAlpha();
+}
+
+void PoseArrayDisplay::updateShape()
+{
+  if( !arrow_cloud_ )
+  {
+    return;
+  }
+
+  float length = length_property_->getFloat();
+  if( shape_property_->getOptionInt() == ARROW_3D )
+  {
+    arrow_cloud_->setShape( ArrowCloud::SHAPE_SOLID );
+    arrow_cloud_->setDimensions( 0.7 * length, 0.05 * length, 0.3 * length, 0.1 * length );
+  }
+  else
+  {
+    // Same proportions as the line arrows this display always drew.
+    arrow_cloud_->setShape( ArrowCloud::SHAPE_LINES );
+    arrow_cloud_->setDimensions( 0.75 * length, 0.0, 0.25 * length, 0.2 * length );
+  }
+  context_->queueRender();
+}
+
+void PoseArrayDisplay::updateAlpha()
+{
+  if( arrow_cloud_ )
+  {
+    arrow_cloud_->setAlpha( alpha_property_->getFloat() );
+    context_->queueRender();
+  }
 }
 
 bool validateFloats( const geometry_msgs::PoseArray& msg )
@@ -78,8 +120,6 @@ void PoseArrayDisplay::processMessage( const geometry_msgs::PoseArray::ConstPtr&
     return;
   }
 
-  manual_object_->clear();
-
   Ogre::Vector3 position;
   Ogre::Quaternion orientation;
   if( !context_->getFrameManager()->getTransform( msg->header, position, orientation ))
@@ -90,40 +130,21 @@ void PoseArrayDisplay::processMessage( const geometry_msgs::PoseArray::ConstPtr&
   scene_node_->setPosition( position );
   scene_node_->setOrientation( orientation );
 
-  manual_object_->clear();
-
+  // Only copy the message into the per-arrow layout; rotating the
+  // arrow geometry is left to the shaders.
   Ogre::ColourValue color = color_property_->getOgreColor();
-  float length = length_property_->getFloat();
   size_t num_poses = msg->poses.size();
-  manual_object_->estimateVertexCount( num_poses * 6 );
-  manual_object_->begin( "BaseWhiteNoLighting", Ogre::RenderOperation::OT_LINE_LIST );
+  arrows_.resize( num_poses );
   for( size_t i=0; i < num_poses; ++i )
   {
-    Ogre::Vector3 pos( msg->poses[i].position.x,
-                       msg->poses[i].position.y,
-                       msg->poses[i].position.z );
-    Ogre::Quaternion orient( msg->poses[i].orientation.w,
-                             msg->poses[i].orientation.x,
-                             msg->poses[i].orientation.y,
-                             msg->poses[i].orientation.z );
-    // orient here is not normalized, so the scale of the quaternion
-    // will affect the scale of the arrow.
-
-    Ogre::Vector3 vertices[6];
-    vertices[0] = pos; // back of arrow
-    vertices[1] = pos + orient * Ogre::Vector3( length, 0, 0 ); // tip of arrow
-    vertices[2] = vertices[ 1 ];
-    vertices[3] = pos + orient * Ogre::Vector3( 0.75*length, 0.2*length, 0 );
-    vertices[4] = vertices[ 1 ];
-    vertices[5] = pos + orient * Ogre::Vector3( 0.75*length, -0.2*length, 0 );
-
-    for( int i = 0; i < 6; ++i )
-    {
-      manual_object_->position( vertices[i] );
-      manual_object_->colour( color );
-    }
+    const geometry_msgs::Pose& pose = msg->poses[ i ];
+    ArrowCloud::Arrow& arrow = arrows_[ i ];
+    arrow.position = Ogre::Vector3( pose.position.x, pose.position.y, pose.position.z );
+    arrow.orientation = Ogre::Quaternion( pose.orientation.w, pose.orientation.x,
+                                          pose.orientation.y, pose.orientation.z );
+    arrow.color = color;
   }
-  manual_object_->end();
+  arrow_cloud_->setArrows( arrows_.empty() ? 0 : &arrows_.front(), arrows_.size() );
 
   context_->queueRender();
 }
@@ -131,9 +152,9 @@ void PoseArrayDisplay::processMessage( const geometry_msgs::PoseArray::ConstPtr&
 void PoseArrayDisplay::reset()
 {
   MFDClass::reset();
-  if( manual_object_ )
+  if( arrow_cloud_ )
   {
-    manual_object_->clear();
+    arrow_cloud_->clear();
   }
 }
 
@@ -33,18 +33,18 @@
 #include <geometry_msgs/PoseArray.h>
 
 #include "rviz/message_filter_display.h"
-
-namespace Ogre
-{
-class ManualObject;
-}
+#include "rviz/ogre_helpers/arrow_cloud.h"
 
 namespace rviz
 {
 class ColorProperty;
+class EnumProperty;
 class FloatProperty;
 
-/** @brief Displays a geometry_msgs/PoseArray message as a bunch of line-drawn arrows. */
+/** @brief Displays a geometry_msgs/PoseArray message as a bunch of arrows.
+ *
+ * Positions and orientations are uploaded as per-arrow data to an
+ * ArrowCloud, which builds and rotates the arrow geometry on the GPU. */
 class PoseArrayDisplay: public MessageFilterDisplay<geometry_msgs::PoseArray>
 {
 Q_OBJECT
@@ -57,10 +57,24 @@ protected:
   virtual void reset();
   virtual void processMessage( const geometry_msgs::PoseArray::ConstPtr& msg );
 
+private Q_SLOTS:
+  void updateShape();
+  void updateAlpha();
+
 private:
-  Ogre::ManualObject* manual_object_;
+  enum Shape
+  {
+    ARROW_FLAT,
+    ARROW_3D
+  };
+
+  ArrowCloud* arrow_cloud_;
+  /// Scratch buffer, kept to avoid reallocating for every message.
+  std::vector<ArrowCloud::Arrow> arrows_;
 
+  EnumProperty* shape_property_;
   ColorProperty* color_property_;
+  FloatProperty* alpha_property_;
   FloatProperty* length_property_;
 };
 
@@ -35,10 +35,13 @@
 #include <tf/transform_listener.h>
 
 #include "rviz/display_context.h"
+#include "rviz/robot/joint_state_link_updater.h"
 #include "rviz/robot/robot.h"
 #include "rviz/robot/tf_link_updater.h"
+#include "rviz/properties/bool_property.h"
 #include "rviz/properties/float_property.h"
 #include "rviz/properties/property.h"
+#include "rviz/properties/ros_topic_property.h"
 #include "rviz/properties/string_property.h"
 
 #include "robot_model_display.h"
@@ -58,6 +61,7 @@ RobotModelDisplay::RobotModelDisplay()
   : Display()
   , has_new_transforms_( false )
   , time_since_last_transform_( 0.0f )
+  , joint_state_updater_( NULL )
 {
   visual_enabled_property_ = new Property( "Visual Enabled", true,
                                            "Whether to display the visual representation of the robot.",
@@ -79,6 +83,12 @@ RobotModelDisplay::RobotModelDisplay()
   alpha_property_->setMin( 0.0 );
   alpha_property_->setMax( 1.0 );
 
+  mesh_lod_bias_property_ = new FloatProperty( "Mesh LOD Bias", 1,
+                                               "Scales the screen size at which large meshes switch to simplified versions."
+                                               "  Lower values simplify sooner, higher values keep full detail longer.",
+                                               this, SLOT( updateMeshLodBias() ));
+  mesh_lod_bias_property_->setMin( 0.01 );
+
   robot_description_property_ = new StringProperty( "Robot Description", "robot_description",
                                                     "Name of the parameter to search for to load the robot description.",
                                                     this, SLOT( updateRobotDescription() ));
@@ -87,12 +97,24 @@ RobotModelDisplay::RobotModelDisplay()
                                             "Robot Model normally assumes the link name is the same as the tf frame name. "
                                             " This option allows you to set a prefix.  Mainly useful for multi-robot situations.",
                                             this, SLOT( updateTfPrefix() ));
+
+  use_joint_states_property_ = new BoolProperty( "Use Joint States", false,
+                                                 "Compute the link poses from joint states and the URDF instead of looking"
+                                                 " up every link in tf.  Only the root link is taken from tf.",
+                                                 this, SLOT( updateJointStateSource() ));
+
+  joint_state_topic_property_ = new RosTopicProperty( "Joint State Topic", "joint_states",
+                                                      QString::fromStdString( ros::message_traits::datatype<sensor_msgs::JointState>() ),
+                                                      "sensor_msgs::JointState topic to subscribe to.",
+                                                      use_joint_states_property_, SLOT( updateJointStateSource() ), this );
 }
 
 RobotModelDisplay::~RobotModelDisplay()
 {
   if ( initialized() )
   {
+    unsubscribeJointStates();
+    delete joint_state_updater_;
     delete robot_;
   }
 }
@@ -104,6 +126,7 @@ void RobotModelDisplay::onInitialize()
   updateVisualVisible();
   updateCollisionVisible();
   updateAlpha();
+  updateMeshLodBias();
 }
 
 void RobotModelDisplay::updateAlpha()
@@ -112,6 +135,12 @@ void RobotModelDisplay::updateAlpha()
   context_->queueRender();
 }
 
+void RobotModelDisplay::updateMeshLodBias()
+{
+  robot_->setMeshLodBias( mesh_lod_bias_property_->getFloat() );
+  context_->queueRender();
+}
+
 void RobotModelDisplay::updateRobotDescription()
 {
   if( isEnabled() )
@@ -135,6 +164,10 @@ void RobotModelDisplay::updateCollisionVisible()
 
 void RobotModelDisplay::updateTfPrefix()
 {
+  if( joint_state_updater_ )
+  {
+    joint_state_updater_->setTfPrefix( tf_prefix_property_->getStdString() );
+  }
   clearStatuses();
   context_->queueRender();
 }
@@ -192,19 +225,83 @@ void RobotModelDisplay::load()
 
   setStatus( StatusProperty::Ok, "URDF", "URDF parsed OK" );
   robot_->load( descr );
-  robot_->update( TFLinkUpdater( context_->getFrameManager(),
-                                 boost::bind( linkUpdaterStatusFunction, _1, _2, _3, this ),
-                                 tf_prefix_property_->getStdString() ));
+
+  delete joint_state_updater_;
+  joint_state_updater_ = new JointStateLinkUpdater( descr, context_->getFrameManager(),
+                                                    boost::bind( linkUpdaterStatusFunction, _1, _2, _3, this ),
+                                                    tf_prefix_property_->getStdString() );
+  updateLinks();
+}
+
+void RobotModelDisplay::updateLinks()
+{
+  if( joint_state_updater_ && use_joint_states_property_->getBool() )
+  {
+    joint_state_updater_->update();
+    robot_->update( *joint_state_updater_ );
+  }
+  else
+  {
+    robot_->update( TFLinkUpdater( context_->getFrameManager(),
+                                   boost::bind( linkUpdaterStatusFunction, _1, _2, _3, this ),
+                                   tf_prefix_property_->getStdString() ));
+  }
+}
+
+void RobotModelDisplay::updateJointStateSource()
+{
+  unsubscribeJointStates();
+  if( isEnabled() )
+  {
+    subscribeJointStates();
+  }
+  clearStatuses();
+  has_new_transforms_ = true;
+}
+
+void RobotModelDisplay::subscribeJointStates()
+{
+  if( !use_joint_states_property_->getBool() )
+  {
+    return;
+  }
+
+  try
+  {
+    joint_state_sub_ = update_nh_.subscribe( joint_state_topic_property_->getTopicStd(), 10,
+                                             &RobotModelDisplay::incomingJointState, this );
+    setStatus( StatusProperty::Ok, "Joint States", "OK" );
+  }
+  catch( ros::Exception& e )
+  {
+    setStatus( StatusProperty::Error, "Joint States", QString( "Error subscribing: " ) + e.what() );
+  }
+}
+
+void RobotModelDisplay::unsubscribeJointStates()
+{
+  joint_state_sub_.shutdown();
+}
+
+void RobotModelDisplay::incomingJointState( const sensor_msgs::JointState::ConstPtr& msg )
+{
+  // Only stores the values; the kinematics run once per update.
+  if( joint_state_updater_ )
+  {
+    joint_state_updater_->setJointState( *msg );
+  }
 }
 
 void RobotModelDisplay::onEnable()
 {
   load();
   robot_->setVisible( true );
+  subscribeJointStates();
 }
 
 void RobotModelDisplay::onDisable()
 {
+  unsubscribeJointStates();
   robot_->setVisible( false );
   clear();
 }
@@ -217,9 +314,7 @@ void RobotModelDisplay::update( float wall_dt, float ros_dt )
 
   if( has_new_transforms_ || update )
   {
-    robot_->update( TFLinkUpdater( context_->getFrameManager(),
-                                   boost::bind( linkUpdaterStatusFunction, _1, _2, _3, this ),
-                                   tf_prefix_property_->getStdString() ));
+    updateLinks();
     context_->queueRender();
 
     has_new_transforms_ = false;
@@ -234,6 +329,8 @@ void RobotModelDisplay::fixedFrameChanged()
 
 void RobotModelDisplay::clear()
 {
+  delete joint_state_updater_;
+  joint_state_updater_ = NULL;
   robot_->clear();
   clearStatuses();
   robot_description_.clear();
@@ -36,6 +36,11 @@
 
 #include <map>
 
+#ifndef Q_MOC_RUN
+#include <ros/subscriber.h>
+#include <sensor_msgs/JointState.h>
+#endif
+
 namespace Ogre
 {
 class Entity;
@@ -50,9 +55,12 @@ class Axes;
 namespace rviz
 {
 
+class BoolProperty;
 class FloatProperty;
+class JointStateLinkUpdater;
 class Property;
 class Robot;
+class RosTopicProperty;
 class StringProperty;
 
 /**
@@ -79,7 +87,9 @@ private Q_SLOTS:
   void updateCollisionVisible();
   void updateTfPrefix();
   void updateAlpha();
+  void updateMeshLodBias();
   void updateRobotDescription();
+  void updateJointStateSource();
 
 protected:
   /** @brief Loads a URDF from the ros-param named by our
@@ -91,6 +101,13 @@ protected:
   virtual void onEnable();
   virtual void onDisable();
 
+  /** @brief Position the links, either from tf or from joint states. */
+  void updateLinks();
+
+  void subscribeJointStates();
+  void unsubscribeJointStates();
+  void incomingJointState( const sensor_msgs::JointState::ConstPtr& msg );
+
   Robot* robot_;                 ///< Handles actually drawing the robot
 
   bool has_new_transforms_;      ///< Callback sets this to tell our update function it needs to update the transforms
@@ -104,7 +121,13 @@ protected:
   FloatProperty* update_rate_property_;
   StringProperty* robot_description_property_;
   FloatProperty* alpha_property_;
+  FloatProperty* mesh_lod_bias_property_;
   StringProperty* tf_prefix_property_;
+  BoolProperty* use_joint_states_property_;
+  RosTopicProperty* joint_state_topic_property_;
+
+  JointStateLinkUpdater* joint_state_updater_; ///< Forward kinematics for the loaded URDF, used instead of tf if enabled.
+  ros::Subscriber joint_state_sub_;
 };
 
 } // namespace rviz
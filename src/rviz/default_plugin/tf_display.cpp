@@ -38,7 +38,7 @@
 #include "rviz/frame_manager.h"
 #include "rviz/ogre_helpers/arrow.h"
 #include "rviz/ogre_helpers/axes.h"
-#include "rviz/ogre_helpers/movable_text.h"
+#include "rviz/ogre_helpers/text_cloud.h"
 #include "rviz/properties/bool_property.h"
 #include "rviz/properties/float_property.h"
 #include "rviz/properties/quaternion_property.h"
@@ -160,6 +160,7 @@ typedef std::set<FrameInfo*> S_FrameInfo;
 
 TFDisplay::TFDisplay()
   : Display()
+  , names_cloud_( NULL )
   , update_timer_( 0.0f )
   , changing_single_frame_enabled_state_( false )
 {
@@ -199,6 +200,7 @@ TFDisplay::~TFDisplay()
 {
   if ( initialized() )
   {
+    delete names_cloud_;
     root_node_->removeAndDestroyAllChildren();
     scene_manager_->destroySceneNode( root_node_->getName() );
   }
@@ -209,6 +211,8 @@ void TFDisplay::onInitialize()
   root_node_ = scene_node_->createChildSceneNode();
 
   names_node_ = root_node_->createChildSceneNode();
+  names_cloud_ = new TextCloud();
+  names_node_->attachObject( names_cloud_ );
   arrows_node_ = root_node_->createChildSceneNode();
   axes_node_ = root_node_->createChildSceneNode();
 }
@@ -414,11 +418,11 @@ FrameInfo* TFDisplay::createFrame(const std::string& frame)
   info->selection_handler_.reset( new FrameSelectionHandler( info, this, context_ ));
   info->selection_handler_->addTrackedObjects( info->axes_->getSceneNode() );
 
-  info->name_text_ = new MovableText( frame, "Arial", 0.1 );
-  info->name_text_->setTextAlignment(MovableText::H_CENTER, MovableText::V_BELOW);
-  info->name_node_ = names_node_->createChildSceneNode();
-  info->name_node_->attachObject( info->name_text_ );
-  info->name_node_->setVisible( show_names_property_->getBool() );
+  info->name_label_ = names_cloud_->createLabel();
+  names_cloud_->setCaption( info->name_label_, frame );
+  names_cloud_->setAlignment( info->name_label_, TextCloud::H_CENTER, TextCloud::V_BELOW );
+  names_cloud_->setLabelVisible( info->name_label_, show_names_property_->getBool() );
+  info->has_name_label_ = true;
 
   info->parent_arrow_ = new Arrow( scene_manager_, arrows_node_, 1.0f, 0.01, 1.0f, 0.08 );
   info->parent_arrow_->getSceneNode()->setVisible( false );
@@ -483,7 +487,7 @@ void TFDisplay::updateFrame( FrameInfo* frame )
   {
     frame->parent_arrow_->getSceneNode()->setVisible(false);
     frame->axes_->getSceneNode()->setVisible(false);
-    frame->name_node_->setVisible(false);
+    names_cloud_->setLabelVisible( frame->name_label_, false );
     return;
   }
   else if (age > ros::Duration(one_third_timeout))
@@ -498,7 +502,7 @@ void TFDisplay::updateFrame( FrameInfo* frame )
       frame->axes_->setXColor(c);
       frame->axes_->setYColor(c);
       frame->axes_->setZColor(c);
-      frame->name_text_->setColor(c);
+      names_cloud_->setColor( frame->name_label_, c );
       frame->parent_arrow_->setColor(c.r, c.g, c.b, c.a);
     }
     else
@@ -507,7 +511,7 @@ void TFDisplay::updateFrame( FrameInfo* frame )
       frame->axes_->setXColor(lerpColor(frame->axes_->getDefaultXColor(), grey, t));
       frame->axes_->setYColor(lerpColor(frame->axes_->getDefaultYColor(), grey, t));
       frame->axes_->setZColor(lerpColor(frame->axes_->getDefaultZColor(), grey, t));
-      frame->name_text_->setColor(lerpColor(Ogre::ColourValue::White, grey, t));
+      names_cloud_->setColor( frame->name_label_, lerpColor(Ogre::ColourValue::White, grey, t) );
       frame->parent_arrow_->setShaftColor(lerpColor(ARROW_SHAFT_COLOR, grey, t));
       frame->parent_arrow_->setHeadColor(lerpColor(ARROW_HEAD_COLOR, grey, t));
     }
@@ -515,7 +519,7 @@ void TFDisplay::updateFrame( FrameInfo* frame )
   else
   {
     frame->axes_->setToDefaultColors();
-    frame->name_text_->setColor(Ogre::ColourValue::White);
+    names_cloud_->setColor( frame->name_label_, Ogre::ColourValue::White );
     frame->parent_arrow_->setHeadColor(ARROW_HEAD_COLOR);
     frame->parent_arrow_->setShaftColor(ARROW_SHAFT_COLOR);
   }
@@ -530,7 +534,7 @@ void TFDisplay::updateFrame( FrameInfo* frame )
     ss << "No transform from [" << frame->name_ << "] to frame [" << fixed_frame_.toStdString() << "]";
     setStatusStd(StatusProperty::Warn, frame->name_, ss.str());
     ROS_DEBUG( "Error transforming frame '%s' to frame '%s'", frame->name_.c_str(), qPrintable( fixed_frame_ ));
-    frame->name_node_->setVisible( false );
+    names_cloud_->setLabelVisible( frame->name_label_, false );
     frame->axes_->getSceneNode()->setVisible( false );
     frame->parent_arrow_->getSceneNode()->setVisible( false );
     return;
@@ -547,9 +551,9 @@ void TFDisplay::updateFrame( FrameInfo* frame )
   float scale = scale_property_->getFloat();
   frame->axes_->setScale( Ogre::Vector3( scale, scale, scale ));
 
-  frame->name_node_->setPosition( position );
-  frame->name_node_->setVisible( show_names_property_->getBool() && frame_enabled );
-  frame->name_node_->setScale( scale, scale, scale );
+  names_cloud_->setPosition( frame->name_label_, position );
+  names_cloud_->setLabelVisible( frame->name_label_, show_names_property_->getBool() && frame_enabled );
+  names_cloud_->setCharacterHeight( frame->name_label_, 0.1f * scale );
 
   frame->position_property_->setVector( position );
   frame->orientation_property_->setQuaternion( orientation );
@@ -660,8 +664,7 @@ void TFDisplay::deleteFrame( FrameInfo* frame, bool delete_properties )
   delete frame->axes_;
   context_->getSelectionManager()->removeObject( frame->axes_coll_ );
   delete frame->parent_arrow_;
-  delete frame->name_text_;
-  scene_manager_->destroySceneNode( frame->name_node_->getName() );
+  names_cloud_->destroyLabel( frame->name_label_ );
   if( delete_properties )
   {
     delete frame->enabled_property_;
@@ -689,7 +692,8 @@ FrameInfo::FrameInfo( TFDisplay* display )
   , axes_( NULL )
   , axes_coll_( 0 )
   , parent_arrow_( NULL )
-  , name_text_( NULL )
+  , name_label_( 0 )
+  , has_name_label_( false )
   , distance_to_parent_( 0.0f )
   , arrow_orientation_(Ogre::Quaternion::IDENTITY)
   , tree_property_( NULL )
@@ -711,9 +715,9 @@ void FrameInfo::updateVisibilityFromSelection()
 
 void FrameInfo::setEnabled( bool enabled )
 {
-  if( name_node_ )
+  if( has_name_label_ )
   {
-    name_node_->setVisible( display_->show_names_property_->getBool() && enabled );
+    display_->names_cloud_->setLabelVisible( name_label_, display_->show_names_property_->getBool() && enabled );
   }
 
   if( axes_ )
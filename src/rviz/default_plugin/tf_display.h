@@ -51,9 +51,9 @@ class Arrow;
 class Axes;
 class BoolProperty;
 class FloatProperty;
-class MovableText;
 class QuaternionProperty;
 class StringProperty;
+class TextCloud;
 class VectorProperty;
 
 class FrameInfo;
@@ -98,6 +98,7 @@ private:
 
   Ogre::SceneNode* root_node_;
   Ogre::SceneNode* names_node_;
+  TextCloud* names_cloud_; ///< All frame names, drawn in one batch.
   Ogre::SceneNode* arrows_node_;
   Ogre::SceneNode* axes_node_;
 
@@ -147,8 +148,8 @@ public:
   CollObjectHandle axes_coll_;
   FrameSelectionHandlerPtr selection_handler_;
   Arrow* parent_arrow_;
-  MovableText* name_text_;
-  Ogre::SceneNode* name_node_;
+  uint32_t name_label_;
+  bool has_name_label_;
 
   float distance_to_parent_;
   Ogre::Quaternion arrow_orientation_;
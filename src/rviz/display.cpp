@@ -34,6 +34,7 @@
 #include <QDockWidget>
 #include <QFont>
 #include <QMetaObject>
+#include <QTimer>
 #include <QWidget>
 
 #include <OGRE/OgreSceneManager.h>
@@ -53,15 +54,60 @@
 namespace rviz
 {
 
+/** Seconds between applications of queued status changes. */
+static const double STATUS_FLUSH_INTERVAL = 0.1;
+
+/** Copy all values in @a source into @a target, keeping the entries of @a target which @a source lacks. */
+static void mergeConfig( const Config& source, Config target )
+{
+  for( Config::MapIterator it = source.mapIterator(); it.isValid(); it.advance() )
+  {
+    QString key = it.currentKey();
+    Config child = it.currentChild();
+    if( child.getType() == Config::Map )
+    {
+      Config target_child = target.mapGetChild( key );
+      if( target_child.getType() != Config::Map )
+      {
+        target_child = target.mapMakeChild( key );
+      }
+      mergeConfig( child, target_child );
+    }
+    else if( child.getType() == Config::Value )
+    {
+      target.mapSetValue( key, child.getValue() );
+    }
+  }
+}
+
+/** Block or unblock the signals of all properties below @a property. */
+static void blockChildSignals( Property* property, bool block )
+{
+  for( int i = 0; i < property->numChildren(); i++ )
+  {
+    Property* child = property->childAt( i );
+    child->blockSignals( block );
+    blockChildSignals( child, block );
+  }
+}
+
 Display::Display()
   : context_( 0 )
   , scene_node_( NULL )
   , status_( 0 )
+  , pending_status_clear_( false )
+  , status_flush_scheduled_( false )
   , initialized_( false )
   , visibility_bits_( 0xFFFFFFFF )
   , associated_widget_( NULL )
   , associated_widget_panel_( NULL )
+  , queue_status_queued_( 0 )
+  , queue_status_dropped_( 0 )
 {
+  // Config() is an empty but valid node, which would mark every
+  // display as deferred.
+  deferred_config_.setType( Config::Invalid );
+
   // Needed for timeSignal (see header) to work across threads
   qRegisterMetaType<ros::Time>();
 
@@ -96,6 +142,69 @@ void Display::initialize( DisplayContext* context )
   initialized_ = true;
 }
 
+void Display::initializeDeferred( DisplayContext* context, const Config& config )
+{
+  bool enabled = true;
+  config.mapGetBool( "Enabled", &enabled );
+  if( enabled )
+  {
+    initialize( context );
+    load( config );
+    return;
+  }
+
+  context_ = context;
+  fixed_frame_ = context_->getFixedFrame();
+  deferred_config_.copy( config );
+
+  // Show the loaded values right away, without calling the slots of
+  // the properties, which may rely on onInitialize() having run.
+  BoolProperty::save( deferred_defaults_ );
+  blockChildSignals( this, true );
+  BoolProperty::load( config );
+  blockChildSignals( this, false );
+
+  QString name;
+  if( config.mapGetString( "Name", &name ))
+  {
+    setObjectName( name );
+  }
+}
+
+void Display::completeDeferredInitialization()
+{
+  if( initialized_ || !deferred_config_.isValid() )
+  {
+    return;
+  }
+  ros::WallTime start = ros::WallTime::now();
+
+  // Keep the current name, enabled state and edited properties, which
+  // may have changed since the config was read.
+  Config config;
+  saveDeferred( config );
+
+  // Go back to the defaults, so load() below changes the same
+  // properties with the same signals as for a display that was never
+  // deferred.
+  blockChildSignals( this, true );
+  BoolProperty::load( deferred_defaults_ );
+  blockChildSignals( this, false );
+  deferred_config_.setType( Config::Invalid );
+  deferred_defaults_ = Config();
+
+  initialize( context_ );
+  // Visibility bits changed while deferred had no scene node to go to.
+  if( visibility_bits_ != 0xFFFFFFFF )
+  {
+    applyVisibilityBits( visibility_bits_, scene_node_ );
+  }
+  load( config );
+
+  ROS_DEBUG_NAMED( "config_load", "Deferred initialization of display '%s' took %.3f s.",
+                   qPrintable( getName() ), ( ros::WallTime::now() - start ).toSec() );
+}
+
 void Display::queueRender()
 {
   if( context_ )
@@ -185,10 +294,64 @@ Qt::ItemFlags Display::getViewFlags( int column ) const
 
 void Display::setStatus( StatusProperty::Level level, const QString& name, const QString& text )
 {
-  QMetaObject::invokeMethod( this, "setStatusInternal", Qt::QueuedConnection,
-                             Q_ARG( int, level ),
-                             Q_ARG( QString, name ),
-                             Q_ARG( QString, text ));
+  boost::mutex::scoped_lock lock( status_mutex_ );
+  PendingStatus& status = pending_statuses_[ name ];
+  status.remove = false;
+  status.level = level;
+  status.text = text;
+  scheduleStatusFlush();
+}
+
+void Display::scheduleStatusFlush()
+{
+  if( !status_flush_scheduled_ )
+  {
+    status_flush_scheduled_ = true;
+    QMetaObject::invokeMethod( this, "flushStatusUpdates", Qt::QueuedConnection );
+  }
+}
+
+void Display::flushStatusUpdates()
+{
+  // Texts like message counters change with every message, so apply
+  // them at a rate the user can read.
+  double since_flush = ( ros::WallTime::now() - status_flush_time_ ).toSec();
+  if( since_flush < STATUS_FLUSH_INTERVAL )
+  {
+    QTimer::singleShot( int(( STATUS_FLUSH_INTERVAL - since_flush ) * 1000 ) + 1, this, SLOT( flushStatusUpdates() ));
+    return;
+  }
+
+  QMap<QString, PendingStatus> pending;
+  bool clear;
+  {
+    boost::mutex::scoped_lock lock( status_mutex_ );
+    pending = pending_statuses_;
+    pending_statuses_.clear();
+    clear = pending_status_clear_;
+    pending_status_clear_ = false;
+    status_flush_scheduled_ = false;
+  }
+  status_flush_time_ = ros::WallTime::now();
+
+  // A clear came before all of the pending changes, since it drops
+  // the ones queued before it.
+  if( clear )
+  {
+    clearStatusesInternal();
+  }
+  QMap<QString, PendingStatus>::const_iterator it;
+  for( it = pending.begin(); it != pending.end(); ++it )
+  {
+    if( it.value().remove )
+    {
+      deleteStatusInternal( it.key() );
+    }
+    else
+    {
+      setStatusInternal( it.value().level, it.key(), it.value().text );
+    }
+  }
 }
 
 void Display::setStatusInternal( int level, const QString& name, const QString& text )
@@ -207,20 +370,53 @@ void Display::setStatusInternal( int level, const QString& name, const QString&
   }
 }
 
+void Display::setQueueStatus( uint32_t queued, uint32_t dropped )
+{
+  if( queued == queue_status_queued_ && dropped == queue_status_dropped_ &&
+      queue_status_time_ != ros::WallTime() )
+  {
+    return;
+  }
+
+  ros::WallTime now = ros::WallTime::now();
+  if( now - queue_status_time_ < ros::WallDuration( 1.0 ))
+  {
+    return;
+  }
+
+  queue_status_queued_ = queued;
+  queue_status_dropped_ = dropped;
+  queue_status_time_ = now;
+  setStatus( StatusProperty::Ok, "Queue",
+             QString::number( queued ) + " messages queued, " + QString::number( dropped ) + " dropped" );
+}
+
+bool Display::hasUpdateTimeLeft() const
+{
+  return update_deadline_.isZero() || ros::WallTime::now() < update_deadline_;
+}
+
 void Display::deleteStatus( const QString& name )
 {
-  QMetaObject::invokeMethod( this, "deleteStatusInternal", Qt::QueuedConnection,
-                             Q_ARG( QString, name ));
+  boost::mutex::scoped_lock lock( status_mutex_ );
+  pending_statuses_[ name ].remove = true;
+  scheduleStatusFlush();
 }
 
 void Display::deleteStatusInternal( const QString& name )
 {
-  status_->deleteStatus( name );
+  if( status_ )
+  {
+    status_->deleteStatus( name );
+  }
 }
 
 void Display::clearStatuses()
 {
-  QMetaObject::invokeMethod( this, "clearStatusesInternal", Qt::QueuedConnection );
+  boost::mutex::scoped_lock lock( status_mutex_ );
+  pending_statuses_.clear();
+  pending_status_clear_ = true;
+  scheduleStatusFlush();
 }
 
 void Display::clearStatusesInternal()
@@ -256,14 +452,34 @@ void Display::load( const Config& config )
 
 void Display::save( Config config ) const
 {
-  // Base class saves sub-properties.
-  BoolProperty::save( config );
+  if( deferred_config_.isValid() )
+  {
+    saveDeferred( config );
+  }
+  else
+  {
+    // Base class saves sub-properties.
+    BoolProperty::save( config );
+  }
 
   config.mapSetValue( "Class", getClassId() );
   config.mapSetValue( "Name", getName() );
   config.mapSetValue( "Enabled", getBool() );
 }
 
+void Display::saveDeferred( Config config ) const
+{
+  // The properties hold the loaded values and any edits since.  The
+  // config given to initializeDeferred() keeps the values of
+  // properties which onInitialize() or their slots have yet to create.
+  config.copy( deferred_config_ );
+  Config current;
+  BoolProperty::save( current );
+  mergeConfig( current, config );
+  config.mapSetValue( "Name", getName() );
+  config.mapSetValue( "Enabled", getBool() );
+}
+
 void Display::setEnabled( bool enabled )
 {
   if ( enabled == isEnabled() ) return;
@@ -301,7 +517,15 @@ void Display::reset()
 
 void Display::onEnableChanged()
 {
+  // A display without initialize() has nothing to enable or disable,
+  // unless this enables a deferred one for the first time.
+  if( !initialized_ && !( deferred_config_.isValid() && isEnabled() ))
+  {
+    return;
+  }
+
   QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+  completeDeferredInitialization();
   queueRender();
   if( isEnabled() )
   {
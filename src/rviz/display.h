@@ -32,6 +32,7 @@
 #include <string>
 
 #ifndef Q_MOC_RUN  // See: https://bugreports.qt-project.org/browse/QTBUG-22829
+# include <boost/thread/mutex.hpp>
 # include <ros/ros.h>
 #endif
 
@@ -39,6 +40,7 @@
 #include "rviz/properties/bool_property.h"
 
 #include <QIcon>
+#include <QMap>
 #include <QSet>
 
 class QDockWidget;
@@ -70,6 +72,23 @@ public:
   /** @brief Main initialization, called after constructor, before load() or setEnabled(). */
   void initialize( DisplayContext* context );
 
+  /** @brief Alternative to initialize() followed by load(), used when
+   * loading a config.
+   *
+   * If the display is disabled, initialize() and load() are postponed
+   * until it is first enabled, so displays nobody looks at do not pay
+   * for onInitialize() and their subscriptions.  Until then the
+   * existing properties show the values from @a config, loaded with
+   * their signals blocked, so no property slot runs before
+   * onInitialize().  save() writes back @a config with the current
+   * property values on top; the same config is loaded with signals on
+   * when the display is initialized.  As for any display, the
+   * destructor may run without initialize() ever having been called. */
+  void initializeDeferred( DisplayContext* context, const Config& config );
+
+  /** @brief Return true if initializeDeferred() postponed initialization and it has not happened yet. */
+  bool isInitializationDeferred() const { return deferred_config_.isValid(); }
+
   /** @brief Return data appropriate for the given column (0 or 1) and
    * role for this Display.
    */
@@ -140,6 +159,10 @@ public:
    * has a level, a name, and descriptive text.  The top-level
    * StatusList has a level which is set to the worst of all the
    * children's levels.
+   *
+   * Changes are applied on the GUI thread at most ten times a second,
+   * the last one for each name winning, so calling this for every
+   * message is cheap.
    */
   virtual void setStatus( StatusProperty::Level level, const QString& name, const QString& text );
 
@@ -157,6 +180,26 @@ public:
   /** @brief Delete the status entry with the given std::string name.  This is thread-safe. */
   void deleteStatusStd( const std::string& name ) { deleteStatus( QString::fromStdString( name )); }
 
+  /** @brief Show the number of queued and dropped messages of a
+   * MessageMailbox in the "Queue" status.
+   *
+   * Meant to be called on every update(); the status is set on the
+   * first call, and afterwards whenever the queued or the dropped
+   * count differs from the one shown, at most once per second. */
+  void setQueueStatus( uint32_t queued, uint32_t dropped );
+
+  /** @brief Set the wall time by which the coming update() should be
+   * done.  Called by the VisualizationManager when its "Frame Rate
+   * Governor" hands out update time; a zero time means no limit. */
+  void setUpdateDeadline( const ros::WallTime& deadline ) { update_deadline_ = deadline; }
+
+  /** @brief Return false once the time given to the current update() is used up.
+   *
+   * Displays which process queued data should check this between
+   * items and leave the rest queued for the next update(), after
+   * processing at least one item so they always make progress. */
+  bool hasUpdateTimeLeft() const;
+
   /** Default is all bits ON. */
   void setVisibilityBits( uint32_t bits );
   void unsetVisibilityBits( uint32_t bits );
@@ -275,20 +318,53 @@ protected:
 public Q_SLOTS:
   virtual void onEnableChanged();
 
-private Q_SLOTS:
+private:
+  /** Run the initialize() and load() postponed by initializeDeferred(). */
+  void completeDeferredInitialization();
+
+  /** Write deferred_config_ into @a config, with the current property values merged in. */
+  void saveDeferred( Config config ) const;
+
+  /** Post a flushStatusUpdates() call unless one is pending.  status_mutex_ must be held. */
+  void scheduleStatusFlush();
   void setStatusInternal( int level, const QString& name, const QString& text );
   void deleteStatusInternal( const QString& name );
   void clearStatusesInternal();
+
+private Q_SLOTS:
+  /** Apply the status changes queued by setStatus(), deleteStatus() and clearStatuses(). */
+  void flushStatusUpdates();
   void associatedPanelVisibilityChange( bool visible );
   void disable();
 
 private:
   StatusList* status_;
+
+  /** A status change waiting for flushStatusUpdates(). */
+  struct PendingStatus
+  {
+    bool remove;
+    int level;
+    QString text;
+  };
+  boost::mutex status_mutex_;
+  QMap<QString, PendingStatus> pending_statuses_;
+  bool pending_status_clear_;
+  bool status_flush_scheduled_;
+  ros::WallTime status_flush_time_;
   QString class_id_;
   bool initialized_;
+  /** Config given to initializeDeferred(), invalid once initialized. */
+  Config deferred_config_;
+  /** Constructor defaults of the properties, restored before the deferred load(). */
+  Config deferred_defaults_;
   uint32_t visibility_bits_;
   QWidget* associated_widget_;
   PanelDockWidget* associated_widget_panel_;
+  uint32_t queue_status_queued_;   ///< Counts last shown in the "Queue" status.
+  uint32_t queue_status_dropped_;
+  ros::WallTime queue_status_time_;
+  ros::WallTime update_deadline_;
 };
 
 } // end namespace rviz
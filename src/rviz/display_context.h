@@ -38,6 +38,7 @@ class QKeyEvent;
 
 namespace Ogre
 {
+class AxisAlignedBox;
 class SceneManager;
 }
 
@@ -60,6 +61,8 @@ class DisplayGroup;
 class FrameManager;
 class RenderPanel;
 class SelectionManager;
+class SessionPlayer;
+class SessionRecorder;
 class ToolManager;
 class ViewController;
 class ViewportMouseEvent;
@@ -132,6 +135,20 @@ public:
   /** Set the message displayed in the status bar */
   virtual void setStatus( const QString & message ) = 0;
 
+  /** @brief Return the SessionRecorder which displays record incoming messages with, or NULL if there is none. */
+  virtual SessionRecorder* getSessionRecorder() const { return NULL; }
+
+  /** @brief Return the SessionPlayer, or NULL if there is none.  Displays ignore live messages while it is active. */
+  virtual SessionPlayer* getSessionPlayer() const { return NULL; }
+
+  /** @brief Queues a render if @a world_region is visible in the main view.
+   *
+   * Use this for changes confined to a known part of the scene, such as
+   * an object being removed, so an idle view is not redrawn for changes
+   * it can not show.  Only makes a difference when rendering on demand.
+   * @note This function can be called from any thread. */
+  virtual void queueRender( const Ogre::AxisAlignedBox& world_region ) = 0;
+
 public Q_SLOTS:
   /** @brief Queues a render.  Multiple calls before a render happens will only cause a single render.
    * @note This function can be called from any thread. */
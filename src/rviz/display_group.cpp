@@ -84,8 +84,10 @@ void DisplayGroup::load( const Config& config )
   // visibility settings?
 
   // first, create all displays and set their names
+  std::map<Display*,double> create_times;
   for( int i = 0; i < num_displays; i++ )
   {
+    ros::WallTime start = ros::WallTime::now();
     Config display_config = display_list_config.listChildAt( i );
     QString display_class = "(no class name found)";
     display_config.mapGetString( "Class", &display_class );
@@ -96,15 +98,32 @@ void DisplayGroup::load( const Config& config )
     disp->setObjectName( display_name );
 
     display_config_map[ disp ] = display_config;
+    create_times[ disp ] = ( ros::WallTime::now() - start ).toSec();
   }
 
-  // now, initialize all displays and load their properties.
+  // now, initialize all displays and load their properties.  Disabled
+  // displays show their loaded properties, but postpone initialize()
+  // until they are first enabled.  Groups are always loaded, for their
+  // children.
   for( std::map<Display*,Config>::iterator it = display_config_map.begin(); it != display_config_map.end(); ++it )
   {
     Config display_config = it->second;
     Display* disp = it->first;
-    disp->initialize( context_ );
-    disp->load( display_config );
+    ros::WallTime start = ros::WallTime::now();
+    if( qobject_cast<DisplayGroup*>( disp ))
+    {
+      disp->initialize( context_ );
+      disp->load( display_config );
+    }
+    else
+    {
+      disp->initializeDeferred( context_, display_config );
+    }
+    ROS_DEBUG_NAMED( "config_load", "Display '%s' (%s): create %.3f s, %s %.3f s.",
+                     qPrintable( disp->getName() ), qPrintable( disp->getClassId() ),
+                     create_times[ disp ],
+                     disp->isInitializationDeferred() ? "initialization deferred" : "initialize and load",
+                     ( ros::WallTime::now() - start ).toSec() );
   }
 
   if( model_ )
@@ -243,7 +262,11 @@ void DisplayGroup::reset()
   int num_children = displays_.size();
   for( int i = 0; i < num_children; i++ )
   {
-    displays_.at( i )->reset();
+    // Deferred displays have nothing to reset yet.
+    if( !displays_.at( i )->isInitializationDeferred() )
+    {
+      displays_.at( i )->reset();
+    }
   }  
 }
 
@@ -150,6 +150,8 @@ void DisplaysPanel::onSelectionChanged()
 
   remove_button_->setEnabled( num_displays_selected > 0 );
   rename_button_->setEnabled( num_displays_selected == 1 );
+
+  vis_manager_->setFocusedDisplays( displays );
 }
 
 void DisplaysPanel::onRenameDisplay()
@@ -42,6 +42,7 @@ namespace rviz
 FrameManager::FrameManager()
 {
   tf_.reset(new tf::TransformListener(ros::NodeHandle(), ros::Duration(10*60), false));
+  transformer_ = tf_.get();
   setSyncMode( SyncOff );
   setPause(false);
 }
@@ -50,6 +51,13 @@ FrameManager::~FrameManager()
 {
 }
 
+void FrameManager::setTransformer( tf::Transformer* transformer )
+{
+  boost::mutex::scoped_lock lock(cache_mutex_);
+  transformer_ = transformer ? transformer : tf_.get();
+  cache_.clear();
+}
+
 void FrameManager::update()
 {
   boost::mutex::scoped_lock lock(cache_mutex_);
@@ -164,7 +172,7 @@ bool FrameManager::adjustTime( const std::string &frame, ros::Time& time )
         ros::Time latest_time;
         std::string error_string;
         int error_code;
-        error_code = tf_->getLatestCommonTime( fixed_frame_, frame, latest_time, &error_string );
+        error_code = transformer_->getLatestCommonTime( fixed_frame_, frame, latest_time, &error_string );
 
         if ( error_code != 0 )
         {
@@ -247,7 +255,7 @@ bool FrameManager::transform(const std::string& frame, ros::Time time, const geo
   // convert pose into new frame
   try
   {
-    tf_->transformPose( fixed_frame_, pose_in, pose_out );
+    transformer_->transformPose( fixed_frame_, pose_in, pose_out );
   }
   catch(std::runtime_error& e)
   {
@@ -266,7 +274,7 @@ bool FrameManager::transform(const std::string& frame, ros::Time time, const geo
 
 bool FrameManager::frameHasProblems(const std::string& frame, ros::Time time, std::string& error)
 {
-  if (!tf_->frameExists(frame))
+  if (!transformer_->frameExists(frame))
   {
     error = "Frame [" + frame + "] does not exist";
     if (frame == fixed_frame_)
@@ -287,7 +295,7 @@ bool FrameManager::transformHasProblems(const std::string& frame, ros::Time time
   }
 
   std::string tf_error;
-  bool transform_succeeded = tf_->canTransform(fixed_frame_, frame, time, &tf_error);
+  bool transform_succeeded = transformer_->canTransform(fixed_frame_, frame, time, &tf_error);
   if (transform_succeeded)
   {
     return false;
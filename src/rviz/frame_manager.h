@@ -50,6 +50,7 @@
 namespace tf
 {
 class TransformListener;
+class Transformer;
 }
 
 namespace rviz
@@ -183,6 +184,13 @@ public:
   /** @brief Return a boost shared pointer to the tf::TransformListener used to receive transform data. */
   const boost::shared_ptr<tf::TransformListener>& getTFClientPtr() { return tf_; }
 
+  /** @brief Look transforms up in @a transformer instead of the
+   * listener, or in the listener again if @a transformer is NULL.
+   *
+   * The listener keeps receiving transforms meanwhile, so switching
+   * back does not lose any data. */
+  void setTransformer( tf::Transformer* transformer );
+
   /** @brief Create a description of a transform problem.
    * @param frame_id The name of the frame with issues.
    * @param stamp The time for which the problem was detected.
@@ -257,6 +265,7 @@ private:
   M_Cache cache_;
 
   boost::shared_ptr<tf::TransformListener> tf_;
+  tf::Transformer* transformer_; ///< Used for lookups; tf_ unless overridden by setTransformer().
   std::string fixed_frame_;
 
   bool pause_;
@@ -35,6 +35,7 @@
 
 #include <image_transport/subscriber_plugin.h>
 
+#include "rviz/topic_cache.h"
 #include "rviz/validate_floats.h"
 
 #include "rviz/image/image_display_base.h"
@@ -57,6 +58,8 @@ ImageDisplayBase::ImageDisplayBase() :
 
   connect(transport_property_, SIGNAL( requestOptions( EnumProperty* )), this,
           SLOT( fillTransportOptionList( EnumProperty* )));
+  // Transport topics may show up while the dropdown is open.
+  connect(TopicCache::get(), SIGNAL( topicsChanged() ), transport_property_, SLOT( refreshOptions() ));
 
   queue_size_property_ = new IntProperty( "Queue Size", 2,
                                           "Advanced: set the size of the incoming message queue.  Increasing this "
@@ -244,8 +247,7 @@ void ImageDisplayBase::fillTransportOptionList(EnumProperty* property)
   choices.push_back("raw");
 
   // Loop over all current ROS topic names
-  ros::master::V_TopicInfo topics;
-  ros::master::getTopics(topics);
+  ros::master::V_TopicInfo topics = TopicCache::get()->getTopics();
   ros::master::V_TopicInfo::iterator it = topics.begin();
   ros::master::V_TopicInfo::iterator end = topics.end();
   for (; it != end; ++it)
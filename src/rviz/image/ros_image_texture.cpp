@@ -45,8 +45,7 @@ namespace rviz
 {
 
 ROSImageTexture::ROSImageTexture()
-: new_image_(false)
-, width_(0)
+: width_(0)
 , height_(0)
 , median_frames_(5)
 {
@@ -67,19 +66,16 @@ ROSImageTexture::~ROSImageTexture()
 
 void ROSImageTexture::clear()
 {
-  boost::mutex::scoped_lock lock(mutex_);
-
   texture_->unload();
   texture_->loadImage(empty_image_);
 
-  new_image_ = false;
+  mailbox_.clear();
+  mailbox_.resetCounters();
   current_image_.reset();
 }
 
 const sensor_msgs::Image::ConstPtr& ROSImageTexture::getImage()
 {
-  boost::mutex::scoped_lock lock(mutex_);
-
   return current_image_;
 }
 
@@ -168,20 +164,12 @@ void ROSImageTexture::normalize( T* image_data, size_t image_data_size, std::vec
 bool ROSImageTexture::update()
 {
   sensor_msgs::Image::ConstPtr image;
-  bool new_image = false;
-  {
-    boost::mutex::scoped_lock lock(mutex_);
-
-    image = current_image_;
-    new_image = new_image_;
-  }
-
-  if (!image || !new_image)
+  if (!mailbox_.pop(&image) || !image)
   {
     return false;
   }
 
-  new_image_ = false;
+  current_image_ = image;
 
   if (image->data.empty())
   {
@@ -273,9 +261,7 @@ bool ROSImageTexture::update()
 
 void ROSImageTexture::addMessage(const sensor_msgs::Image::ConstPtr& msg)
 {
-  boost::mutex::scoped_lock lock(mutex_);
-  current_image_ = msg;
-  new_image_ = true;
+  mailbox_.push(msg);
 }
 
 } // end of namespace rviz
@@ -36,10 +36,11 @@
 #include <OGRE/OgreImage.h>
 
 #include <boost/shared_ptr.hpp>
-#include <boost/thread/mutex.hpp>
 
 #include <ros/ros.h>
 
+#include "rviz/message_mailbox.h"
+
 #include <stdexcept>
 
 namespace rviz
@@ -66,6 +67,9 @@ public:
   const Ogre::TexturePtr& getTexture() { return texture_; }
   const sensor_msgs::Image::ConstPtr& getImage();
 
+  /** @brief Hand-off of images from addMessage() to update(), only the latest is kept. */
+  const MessageMailbox<sensor_msgs::Image::ConstPtr>& getMailbox() const { return mailbox_; }
+
   uint32_t getWidth() { return width_; }
   uint32_t getHeight() { return height_; }
 
@@ -80,9 +84,8 @@ private:
   template<typename T>
   void normalize( T* image_data, size_t image_data_size, std::vector<uint8_t> &buffer  );
 
+  MessageMailbox<sensor_msgs::Image::ConstPtr> mailbox_;
   sensor_msgs::Image::ConstPtr current_image_;
-  boost::mutex mutex_;
-  bool new_image_;
 
   Ogre::TexturePtr texture_;
   Ogre::Image empty_image_;
@@ -28,6 +28,7 @@
  */
 
 #include "mesh_loader.h"
+#include "mesh_lod.h"
 #include <resource_retriever/retriever.h>
 
 #include <boost/filesystem.hpp>
@@ -629,17 +630,9 @@ float getMeshUnitRescale(const std::string& resource_path)
 
 
 
-Ogre::MeshPtr meshFromAssimpScene(const std::string& name, const aiScene* scene)
+Ogre::MeshPtr meshFromAssimpScene(const std::string& name, const aiScene* scene,
+                                  std::vector<Ogre::MaterialPtr>& material_table)
 {
-  if (!scene->HasMeshes())
-  {
-    ROS_ERROR("No meshes found in file [%s]", name.c_str());
-    return Ogre::MeshPtr();
-  }
-
-  std::vector<Ogre::MaterialPtr> material_table;
-  loadMaterials(name, scene, material_table);
-
   Ogre::MeshPtr mesh = Ogre::MeshManager::getSingleton().createManual(name, ROS_PACKAGE_NAME);
 
   Ogre::AxisAlignedBox aabb(Ogre::AxisAlignedBox::EXTENT_NULL);
@@ -649,6 +642,7 @@ Ogre::MeshPtr meshFromAssimpScene(const std::string& name, const aiScene* scene)
 
   mesh->_setBounds(aabb);
   mesh->_setBoundingSphereRadius(radius);
+  generateMeshLods(mesh);
   mesh->buildEdgeList();
 
   mesh->load();
@@ -689,11 +683,23 @@ Ogre::MeshPtr loadMeshFromResource(const std::string& resource_path)
         return Ogre::MeshPtr();
       }
 
+      std::string cache_path = getMeshCachePath(res.data.get(), res.size);
+      Ogre::MeshPtr mesh = loadCachedMesh(cache_path, resource_path, "rviz");
+      if (!mesh.isNull())
+      {
+        return mesh;
+      }
+
       Ogre::MeshSerializer ser;
       Ogre::DataStreamPtr stream(new Ogre::MemoryDataStream(res.data.get(), res.size));
-      Ogre::MeshPtr mesh = Ogre::MeshManager::getSingleton().createManual(resource_path, "rviz");
+      mesh = Ogre::MeshManager::getSingleton().createManual(resource_path, "rviz");
       ser.importMesh(stream, mesh.get());
 
+      if (generateMeshLods(mesh))
+      {
+        saveCachedMesh(cache_path, mesh);
+      }
+
       return mesh;
     }
     else if (ext == ".stl" || ext == ".STL" || ext == ".stlb" || ext == ".STLB")
@@ -715,6 +721,13 @@ Ogre::MeshPtr loadMeshFromResource(const std::string& resource_path)
         return Ogre::MeshPtr();
       }
 
+      std::string cache_path = getMeshCachePath(res.data.get(), res.size);
+      Ogre::MeshPtr mesh = loadCachedMesh(cache_path, resource_path, Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+      if (!mesh.isNull())
+      {
+        return mesh;
+      }
+
       ogre_tools::STLLoader loader;
       if (!loader.load(res.data.get()))
       {
@@ -722,20 +735,76 @@ Ogre::MeshPtr loadMeshFromResource(const std::string& resource_path)
         return Ogre::MeshPtr();
       }
 
-      return loader.toMesh(resource_path);
+      mesh = loader.toMesh(resource_path);
+      if (generateMeshLods(mesh))
+      {
+        saveCachedMesh(cache_path, mesh);
+      }
+
+      return mesh;
     }
     else
     {
+      // Find the simplified mesh in the cache by the file contents.  If
+      // the file can not be retrieved, ReadFile() below reports it.
+      std::string cache_path;
+      try
+      {
+        resource_retriever::Retriever retriever;
+        resource_retriever::MemoryResource res = retriever.get(resource_path);
+        cache_path = getMeshCachePath(res.data.get(), res.size);
+      }
+      catch (resource_retriever::Exception& e)
+      {
+      }
+
+      const unsigned int post_processing = aiProcess_SortByPType|aiProcess_GenNormals|aiProcess_Triangulate|aiProcess_GenUVCoords|aiProcess_FlipUVs|aiProcess_JoinIdenticalVertices;
+
+      // A cached mesh already has the geometry, so then the scene is
+      // only read for its materials and needs no post-processing.
+      bool cached = !cache_path.empty() && fs::exists(cache_path);
+
       Assimp::Importer importer;
       importer.SetIOHandler(new ResourceIOSystem());
-      const aiScene* scene = importer.ReadFile(resource_path, aiProcess_SortByPType|aiProcess_GenNormals|aiProcess_Triangulate|aiProcess_GenUVCoords|aiProcess_FlipUVs);
+      const aiScene* scene = importer.ReadFile(resource_path, cached ? 0 : post_processing);
       if (!scene)
       {
         ROS_ERROR("Could not load resource [%s]: %s", resource_path.c_str(), importer.GetErrorString());
         return Ogre::MeshPtr();
       }
 
-      return meshFromAssimpScene(resource_path, scene);
+      if (!scene->HasMeshes())
+      {
+        ROS_ERROR("No meshes found in file [%s]", resource_path.c_str());
+        return Ogre::MeshPtr();
+      }
+
+      std::vector<Ogre::MaterialPtr> material_table;
+      loadMaterials(resource_path, scene, material_table);
+
+      if (cached)
+      {
+        Ogre::MeshPtr mesh = loadCachedMesh(cache_path, resource_path, ROS_PACKAGE_NAME);
+        if (!mesh.isNull())
+        {
+          return mesh;
+        }
+
+        scene = importer.ApplyPostProcessing(post_processing);
+        if (!scene)
+        {
+          ROS_ERROR("Could not load resource [%s]: %s", resource_path.c_str(), importer.GetErrorString());
+          return Ogre::MeshPtr();
+        }
+      }
+
+      Ogre::MeshPtr mesh = meshFromAssimpScene(resource_path, scene, material_table);
+      if (mesh->getNumLodLevels() > 1)
+      {
+        saveCachedMesh(cache_path, mesh);
+      }
+
+      return mesh;
     }
   }
 
@@ -0,0 +1,500 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <OGRE/OgreDataStream.h>
+#include <OGRE/OgreHardwareBufferManager.h>
+#include <OGRE/OgreLodStrategy.h>
+#include <OGRE/OgreLodStrategyManager.h>
+#include <OGRE/OgreMeshManager.h>
+#include <OGRE/OgreMeshSerializer.h>
+#include <OGRE/OgreSubMesh.h>
+
+#include <ros/console.h>
+
+#include "rviz/mesh_lod.h"
+
+namespace fs = boost::filesystem;
+
+namespace rviz
+{
+
+namespace
+{
+
+/** Projected size in pixels below which a LOD level is used, and the fraction of the triangles it keeps. */
+struct LodLevel
+{
+  float pixel_area;
+  float triangle_ratio;
+};
+
+const LodLevel LOD_LEVELS[] = { { 200 * 200, 0.5 },
+                                { 100 * 100, 0.2 },
+                                { 50 * 50, 0.05 },
+                                { 20 * 20, 0.01 } };
+const size_t NUM_LOD_LEVELS = sizeof( LOD_LEVELS ) / sizeof( LOD_LEVELS[ 0 ]);
+
+/** Meshes with fewer triangles are drawn at full detail at any size. */
+const size_t MIN_LOD_TRIANGLES = 4096;
+/** No level or sub-mesh is simplified below this many triangles. */
+const size_t MIN_LEVEL_TRIANGLES = 32;
+
+/** Change when the simplification changes, so old cache entries are not used. */
+const uint32_t MESH_CACHE_VERSION = 1;
+
+/** @brief Sum of squared distances to a set of area-weighted planes. */
+struct Quadric
+{
+  double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+
+  Quadric()
+  : a2( 0 ), ab( 0 ), ac( 0 ), ad( 0 ), b2( 0 ), bc( 0 ), bd( 0 ), c2( 0 ), cd( 0 ), d2( 0 )
+  {}
+
+  void addPlane( double a, double b, double c, double d, double weight )
+  {
+    a2 += weight * a * a; ab += weight * a * b; ac += weight * a * c; ad += weight * a * d;
+    b2 += weight * b * b; bc += weight * b * c; bd += weight * b * d;
+    c2 += weight * c * c; cd += weight * c * d;
+    d2 += weight * d * d;
+  }
+
+  double error( const Ogre::Vector3& v ) const
+  {
+    double x = v.x, y = v.y, z = v.z;
+    return a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x
+      + b2 * y * y + 2 * bc * y * z + 2 * bd * y
+      + c2 * z * z + 2 * cd * z
+      + d2;
+  }
+};
+
+struct SubMeshGeometry
+{
+  std::vector<Ogre::Vector3> positions;
+  std::vector<uint32_t> indices;
+  bool use_32bit_indices;
+};
+
+/** @brief Copy the positions and triangle indices of @a sub out of its hardware buffers. */
+bool readGeometry( const Ogre::Mesh* mesh, const Ogre::SubMesh* sub, SubMeshGeometry& geometry )
+{
+  if( sub->operationType != Ogre::RenderOperation::OT_TRIANGLE_LIST )
+  {
+    return false;
+  }
+
+  const Ogre::VertexData* vertex_data = sub->useSharedVertices ? mesh->sharedVertexData : sub->vertexData;
+  const Ogre::IndexData* index_data = sub->indexData;
+  if( !vertex_data || !index_data || index_data->indexBuffer.isNull() || index_data->indexCount < 3 )
+  {
+    return false;
+  }
+
+  const Ogre::VertexElement* position = vertex_data->vertexDeclaration->findElementBySemantic( Ogre::VES_POSITION );
+  if( !position || position->getType() != Ogre::VET_FLOAT3 )
+  {
+    return false;
+  }
+
+  Ogre::HardwareVertexBufferSharedPtr vbuf = vertex_data->vertexBufferBinding->getBuffer( position->getSource() );
+  size_t vertex_size = vbuf->getVertexSize();
+  unsigned char* vertex = static_cast<unsigned char*>( vbuf->lock( Ogre::HardwareBuffer::HBL_READ_ONLY ));
+  vertex += vertex_data->vertexStart * vertex_size;
+
+  geometry.positions.resize( vertex_data->vertexCount );
+  for( size_t i = 0; i < vertex_data->vertexCount; i++, vertex += vertex_size )
+  {
+    float* p;
+    position->baseVertexPointerToElement( vertex, &p );
+    geometry.positions[ i ] = Ogre::Vector3( p[ 0 ], p[ 1 ], p[ 2 ]);
+  }
+  vbuf->unlock();
+
+  Ogre::HardwareIndexBufferSharedPtr ibuf = index_data->indexBuffer;
+  geometry.use_32bit_indices = ibuf->getType() == Ogre::HardwareIndexBuffer::IT_32BIT;
+  geometry.indices.resize( index_data->indexCount - index_data->indexCount % 3 );
+  size_t index_size = ibuf->getIndexSize();
+  void* data = ibuf->lock( index_data->indexStart * index_size, geometry.indices.size() * index_size,
+                           Ogre::HardwareBuffer::HBL_READ_ONLY );
+  if( geometry.use_32bit_indices )
+  {
+    uint32_t* indices = static_cast<uint32_t*>( data );
+    std::copy( indices, indices + geometry.indices.size(), geometry.indices.begin() );
+  }
+  else
+  {
+    uint16_t* indices = static_cast<uint16_t*>( data );
+    std::copy( indices, indices + geometry.indices.size(), geometry.indices.begin() );
+  }
+  ibuf->unlock();
+
+  for( size_t i = 0; i < geometry.indices.size(); i++ )
+  {
+    if( geometry.indices[ i ] >= geometry.positions.size() )
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Cluster the vertices of @a geometry into cubes of @a cell_size and
+ * return the triangles which still span three clusters.
+ */
+void clusterVertices( const SubMeshGeometry& geometry, const Ogre::Vector3& origin, float cell_size,
+                      std::vector<uint32_t>& indices_out )
+{
+  const size_t num_vertices = geometry.positions.size();
+  const size_t num_indices = geometry.indices.size();
+
+  // 21 bits per axis is plenty: the grid never has more than a few
+  // thousand cells along an axis.
+  typedef boost::unordered_map<uint64_t, uint32_t> M_CellToCluster;
+  M_CellToCluster cell_to_cluster;
+  std::vector<uint32_t> clusters( num_vertices );
+  for( size_t i = 0; i < num_vertices; i++ )
+  {
+    Ogre::Vector3 cell = ( geometry.positions[ i ] - origin ) / cell_size;
+    uint64_t x = uint64_t( std::max( 0.0f, cell.x )) & 0x1fffff;
+    uint64_t y = uint64_t( std::max( 0.0f, cell.y )) & 0x1fffff;
+    uint64_t z = uint64_t( std::max( 0.0f, cell.z )) & 0x1fffff;
+    uint64_t key = x | ( y << 21 ) | ( z << 42 );
+    clusters[ i ] = cell_to_cluster.insert( std::make_pair( key, uint32_t( cell_to_cluster.size() ))).first->second;
+  }
+
+  // Each cluster collects the planes of the triangles touching it.
+  std::vector<Quadric> quadrics( cell_to_cluster.size() );
+  for( size_t i = 0; i < num_indices; i += 3 )
+  {
+    const Ogre::Vector3& p0 = geometry.positions[ geometry.indices[ i ]];
+    const Ogre::Vector3& p1 = geometry.positions[ geometry.indices[ i + 1 ]];
+    const Ogre::Vector3& p2 = geometry.positions[ geometry.indices[ i + 2 ]];
+    Ogre::Vector3 normal = ( p1 - p0 ).crossProduct( p2 - p0 );
+    double length = normal.length();
+    if( length <= 0 )
+    {
+      continue;
+    }
+    double a = normal.x / length, b = normal.y / length, c = normal.z / length;
+    double d = -( a * p0.x + b * p0.y + c * p0.z );
+    for( int k = 0; k < 3; k++ )
+    {
+      quadrics[ clusters[ geometry.indices[ i + k ]]].addPlane( a, b, c, d, 0.5 * length );
+    }
+  }
+
+  // The vertex closest to those planes represents the cluster.
+  std::vector<uint32_t> representatives( quadrics.size(), 0 );
+  std::vector<double> best_error( quadrics.size(), DBL_MAX );
+  for( size_t i = 0; i < num_vertices; i++ )
+  {
+    uint32_t cluster = clusters[ i ];
+    double error = quadrics[ cluster ].error( geometry.positions[ i ]);
+    if( error < best_error[ cluster ])
+    {
+      best_error[ cluster ] = error;
+      representatives[ cluster ] = i;
+    }
+  }
+
+  indices_out.clear();
+  for( size_t i = 0; i < num_indices; i += 3 )
+  {
+    uint32_t c0 = clusters[ geometry.indices[ i ]];
+    uint32_t c1 = clusters[ geometry.indices[ i + 1 ]];
+    uint32_t c2 = clusters[ geometry.indices[ i + 2 ]];
+    if( c0 == c1 || c1 == c2 || c2 == c0 )
+    {
+      continue;
+    }
+    indices_out.push_back( representatives[ c0 ]);
+    indices_out.push_back( representatives[ c1 ]);
+    indices_out.push_back( representatives[ c2 ]);
+  }
+}
+
+/**
+ * @brief Simplify @a geometry to roughly @a target_triangles.
+ *
+ * The number of triangles left grows with the square of the grid
+ * resolution, so the resolution is corrected from the result a few
+ * times until it is close to the target.
+ */
+void simplify( const SubMeshGeometry& geometry, const Ogre::AxisAlignedBox& bounds, size_t target_triangles,
+               std::vector<uint32_t>& indices_out )
+{
+  Ogre::Vector3 size = bounds.getSize();
+  float extent = std::max( size.x, std::max( size.y, size.z ));
+  float resolution = sqrtf( target_triangles / 4.0f );
+
+  for( int iteration = 0; iteration < 5; iteration++ )
+  {
+    resolution = std::min( 1e6f, std::max( 1.0f, resolution ));
+    clusterVertices( geometry, bounds.getMinimum(), extent / resolution, indices_out );
+
+    size_t triangles = std::max( indices_out.size() / 3, size_t( 1 ));
+    float ratio = float( target_triangles ) / triangles;
+    if( ratio > 0.7f && ratio < 1.4f )
+    {
+      break;
+    }
+    resolution *= sqrtf( ratio );
+  }
+}
+
+Ogre::IndexData* createIndexData( const std::vector<uint32_t>& indices, bool use_32bit_indices )
+{
+  Ogre::IndexData* index_data = new Ogre::IndexData();
+  index_data->indexStart = 0;
+  index_data->indexCount = indices.size();
+  index_data->indexBuffer = Ogre::HardwareBufferManager::getSingleton().createIndexBuffer(
+    use_32bit_indices ? Ogre::HardwareIndexBuffer::IT_32BIT : Ogre::HardwareIndexBuffer::IT_16BIT,
+    indices.size(),
+    Ogre::HardwareBuffer::HBU_STATIC_WRITE_ONLY,
+    false );
+
+  void* data = index_data->indexBuffer->lock( Ogre::HardwareBuffer::HBL_DISCARD );
+  if( use_32bit_indices )
+  {
+    std::copy( indices.begin(), indices.end(), static_cast<uint32_t*>( data ));
+  }
+  else
+  {
+    std::copy( indices.begin(), indices.end(), static_cast<uint16_t*>( data ));
+  }
+  index_data->indexBuffer->unlock();
+
+  return index_data;
+}
+
+} // namespace
+
+bool generateMeshLods( const Ogre::MeshPtr& mesh )
+{
+  if( mesh.isNull() || mesh->getNumLodLevels() > 1 || mesh->getBounds().isNull() )
+  {
+    return false;
+  }
+
+  Ogre::LodStrategy* strategy = Ogre::LodStrategyManager::getSingleton().getStrategy( "PixelCount" );
+  if( !strategy )
+  {
+    return false;
+  }
+
+  size_t num_sub_meshes = mesh->getNumSubMeshes();
+  std::vector<SubMeshGeometry> geometry( num_sub_meshes );
+  std::vector<bool> valid( num_sub_meshes );
+  size_t triangles = 0;
+  for( size_t i = 0; i < num_sub_meshes; i++ )
+  {
+    valid[ i ] = readGeometry( mesh.get(), mesh->getSubMesh( i ), geometry[ i ]);
+    if( valid[ i ])
+    {
+      triangles += geometry[ i ].indices.size() / 3;
+    }
+  }
+
+  if( triangles < MIN_LOD_TRIANGLES )
+  {
+    return false;
+  }
+
+  size_t num_levels = 0;
+  while( num_levels < NUM_LOD_LEVELS && triangles * LOD_LEVELS[ num_levels ].triangle_ratio >= MIN_LEVEL_TRIANGLES )
+  {
+    num_levels++;
+  }
+
+  // Edge lists are per LOD level, and Ogre refuses LOD changes after they are built.
+  bool had_edge_list = mesh->isEdgeListBuilt();
+  if( had_edge_list )
+  {
+    mesh->freeEdgeList();
+  }
+
+  mesh->setLodStrategy( strategy );
+  mesh->_setLodInfo( num_levels + 1, false );
+  for( size_t level = 0; level < num_levels; level++ )
+  {
+    Ogre::MeshLodUsage usage;
+    usage.userValue = LOD_LEVELS[ level ].pixel_area;
+    usage.value = strategy->transformUserValue( usage.userValue );
+    usage.edgeData = NULL;
+    mesh->_setLodUsage( level + 1, usage );
+  }
+
+  for( size_t i = 0; i < num_sub_meshes; i++ )
+  {
+    Ogre::SubMesh* sub = mesh->getSubMesh( i );
+    std::vector<uint32_t> previous = geometry[ i ].indices;
+
+    for( size_t level = 0; level < num_levels; level++ )
+    {
+      size_t target = std::max( size_t( geometry[ i ].indices.size() / 3 * LOD_LEVELS[ level ].triangle_ratio ),
+                                MIN_LEVEL_TRIANGLES );
+
+      if( valid[ i ] && target < previous.size() / 3 )
+      {
+        std::vector<uint32_t> simplified;
+        simplify( geometry[ i ], mesh->getBounds(), target, simplified );
+        if( !simplified.empty() && simplified.size() < previous.size() )
+        {
+          previous.swap( simplified );
+        }
+      }
+
+      Ogre::IndexData* index_data;
+      if( !valid[ i ] || previous.size() == geometry[ i ].indices.size() )
+      {
+        // Not simplified; share the index buffer of the full mesh.
+        index_data = sub->indexData->clone( false );
+      }
+      else
+      {
+        index_data = createIndexData( previous, geometry[ i ].use_32bit_indices );
+      }
+      mesh->_setSubMeshLodFaceList( i, level + 1, index_data );
+    }
+  }
+
+  if( had_edge_list )
+  {
+    mesh->buildEdgeList();
+  }
+
+  ROS_DEBUG( "Generated %d LOD levels for mesh [%s] with %d triangles at full detail.",
+             (int)num_levels, mesh->getName().c_str(), (int)triangles );
+
+  return true;
+}
+
+std::string getMeshCachePath( const uint8_t* data, size_t size )
+{
+  const char* home = getenv( "HOME" );
+  if( !home )
+  {
+    return "";
+  }
+
+  fs::path cache_dir = fs::path( home ) / ".rviz" / "mesh_cache";
+  try
+  {
+    if( !fs::exists( cache_dir ))
+    {
+      fs::create_directories( cache_dir );
+    }
+  }
+  catch( fs::filesystem_error& e )
+  {
+    ROS_WARN( "Could not create mesh cache directory: %s", e.what() );
+    return "";
+  }
+
+  // 64-bit FNV-1a of the contents, so a changed file gets a new entry.
+  uint64_t hash = 14695981039346656037ULL;
+  for( size_t i = 0; i < size; i++ )
+  {
+    hash ^= data[ i ];
+    hash *= 1099511628211ULL;
+  }
+  hash ^= MESH_CACHE_VERSION;
+  hash *= 1099511628211ULL;
+
+  std::stringstream ss;
+  ss << std::hex << std::setw( 16 ) << std::setfill( '0' ) << hash << "_" << std::dec << size << ".mesh";
+  return ( cache_dir / ss.str() ).string();
+}
+
+Ogre::MeshPtr loadCachedMesh( const std::string& cache_path, const std::string& name, const std::string& group )
+{
+  if( cache_path.empty() || !fs::exists( cache_path ))
+  {
+    return Ogre::MeshPtr();
+  }
+
+  Ogre::MeshPtr mesh = Ogre::MeshManager::getSingleton().createManual( name, group );
+  try
+  {
+    std::ifstream* file = new std::ifstream( cache_path.c_str(), std::ios::in | std::ios::binary );
+    Ogre::DataStreamPtr stream( new Ogre::FileStreamDataStream( file ));
+    Ogre::MeshSerializer ser;
+    ser.importMesh( stream, mesh.get() );
+  }
+  catch( Ogre::Exception& e )
+  {
+    ROS_WARN( "Ignoring mesh cache entry [%s]: %s", cache_path.c_str(), e.what() );
+    Ogre::MeshManager::getSingleton().remove( name );
+    return Ogre::MeshPtr();
+  }
+
+  return mesh;
+}
+
+void saveCachedMesh( const std::string& cache_path, const Ogre::MeshPtr& mesh )
+{
+  if( cache_path.empty() || mesh.isNull() )
+  {
+    return;
+  }
+
+  // Write to a temporary file first, so another rviz never reads half a mesh.
+  std::string temp_path = cache_path + ".tmp";
+  try
+  {
+    Ogre::MeshSerializer ser;
+    ser.exportMesh( mesh.get(), temp_path );
+    fs::rename( temp_path, cache_path );
+  }
+  catch( Ogre::Exception& e )
+  {
+    ROS_WARN( "Could not save mesh cache entry [%s]: %s", cache_path.c_str(), e.what() );
+  }
+  catch( fs::filesystem_error& e )
+  {
+    ROS_WARN( "Could not save mesh cache entry [%s]: %s", cache_path.c_str(), e.what() );
+  }
+}
+
+} // namespace rviz
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RVIZ_MESH_LOD_H
+#define RVIZ_MESH_LOD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+#include <OGRE/OgreMesh.h>
+
+namespace rviz
+{
+
+/**
+ * @brief Add simplified LOD levels to @a mesh, switched by screen size.
+ *
+ * Each level is simplified by quadric-weighted vertex clustering: the
+ * vertices are binned into a grid over the mesh bounds, and each cell
+ * is replaced by the vertex in it with the smallest quadric error with
+ * respect to the triangles around the cell.  Since the representative
+ * is an existing vertex, every level is just a new index buffer over
+ * the original vertex data.
+ *
+ * Meshes that are small, already have LOD levels, or contain no
+ * triangle lists are left alone.
+ *
+ * @return true if LOD levels were added.
+ */
+bool generateMeshLods( const Ogre::MeshPtr& mesh );
+
+/**
+ * @brief Path in the on-disk mesh cache for a resource with contents @a data.
+ *
+ * Returns an empty string if the cache directory can not be created.
+ */
+std::string getMeshCachePath( const uint8_t* data, size_t size );
+
+/** @brief Create mesh @a name from a file saved by saveCachedMesh().  Returns a null pointer if there is none. */
+Ogre::MeshPtr loadCachedMesh( const std::string& cache_path, const std::string& name, const std::string& group );
+
+/** @brief Save @a mesh, with its LOD levels, to the mesh cache. */
+void saveCachedMesh( const std::string& cache_path, const Ogre::MeshPtr& mesh );
+
+} // namespace rviz
+
+#endif // RVIZ_MESH_LOD_H
@@ -34,12 +34,15 @@
 
 #ifndef Q_MOC_RUN
 #include <message_filters/subscriber.h>
+#include <ros/serialization.h>
+#include <std_msgs/Header.h>
 #include <tf/message_filter.h>
 #endif
 
 #include "rviz/display_context.h"
 #include "rviz/frame_manager.h"
 #include "rviz/properties/ros_topic_property.h"
+#include "rviz/session_recorder.h"
 
 #include "rviz/display.h"
 
@@ -60,6 +63,12 @@ public:
                                               this, SLOT( updateTopic() ));
     }
 
+  std::string getTopicStd() const { return topic_property_->getTopicStd(); }
+
+  /** @brief Process a serialized message recorded by SessionRecorder.
+   * @return false if @a md5sum does not match the message type of this display. */
+  virtual bool replayMessage( const std::string& md5sum, const uint8_t* data, uint32_t size ) = 0;
+
 protected Q_SLOTS:
   virtual void updateTopic() = 0;
 
@@ -119,6 +128,34 @@ public:
       topic_property_->setString( topic );
     }
 
+  /** @brief Deserialize the message, and pass it to processMessage().
+   *
+   * The header stamp is cleared so the message is transformed with the
+   * transforms SessionPlayer restored, which all share the seek time. */
+  virtual bool replayMessage( const std::string& md5sum, const uint8_t* data, uint32_t size )
+    {
+      if( md5sum != ros::message_traits::md5sum<MessageType>() )
+      {
+        return false;
+      }
+
+      boost::shared_ptr<MessageType> msg( new MessageType );
+      ros::serialization::IStream stream( const_cast<uint8_t*>( data ), size );
+      ros::serialization::deserialize( stream, *msg );
+
+      std_msgs::Header* header = ros::message_traits::Header<MessageType>::pointer( *msg );
+      if( header )
+      {
+        header->stamp = ros::Time();
+      }
+
+      ++messages_received_;
+      setStatus( StatusProperty::Ok, "Topic", QString::number( messages_received_ ) + " messages replayed" );
+
+      processMessage( msg );
+      return true;
+    }
+
 protected:
   virtual void updateTopic()
     {
@@ -169,8 +206,9 @@ protected:
     }
 
   /** @brief Incoming message callback.  Checks if the message pointer
-   * is valid, increments messages_received_, then calls
-   * processMessage(). */
+   * is valid, records it if a session is being recorded, increments
+   * messages_received_, then calls processMessage().  Messages are
+   * dropped while a recorded session is played back. */
   void incomingMessage( const typename MessageType::ConstPtr& msg )
     {
       if( !msg )
@@ -178,6 +216,19 @@ protected:
         return;
       }
 
+      SessionRecorder* recorder = context_->getSessionRecorder();
+      if( recorder && recorder->isRecording() )
+      {
+        recorder->record( topic_property_->getTopicStd(), *msg );
+      }
+
+      // Live messages would overwrite what the session player shows.
+      SessionPlayer* player = context_->getSessionPlayer();
+      if( player && player->isActive() )
+      {
+        return;
+      }
+
       ++messages_received_;
       setStatus( StatusProperty::Ok, "Topic", QString::number( messages_received_ ) + " messages received" );
 
@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RVIZ_MESSAGE_MAILBOX_H
+#define RVIZ_MESSAGE_MAILBOX_H
+
+#include <stdint.h>
+
+#include <QAtomicInt>
+#include <QAtomicPointer>
+
+namespace rviz
+{
+
+/** @brief Lock-free hand-off of messages from one producer thread to
+ * one consumer thread.
+ *
+ * Typically the producer is a ROS callback thread and the consumer is
+ * the GUI thread calling Display::update().  push() may only be called
+ * from the producer thread; everything else, except the statistics
+ * getters, only from the consumer thread.
+ *
+ * With KeepLatest, only the newest message is kept: pushing replaces
+ * a message which has not been taken yet.  With DropOldest, messages
+ * are queued, and when the consumer finds more than the capacity
+ * queued, the oldest ones are dropped.  A capacity of 0 never drops
+ * anything.  Replaced and dropped messages are counted. */
+template<class T>
+class MessageMailbox
+{
+public:
+  enum Policy
+  {
+    KeepLatest,
+    DropOldest
+  };
+
+  MessageMailbox( Policy policy = KeepLatest, uint32_t capacity = 0 )
+    : policy_( policy )
+    , capacity_( capacity )
+    , latest_( 0 )
+    , head_( new Node )
+    , tail_( head_ )
+    , queued_( 0 )
+    , received_( 0 )
+    , dropped_( 0 )
+    {}
+
+  ~MessageMailbox()
+    {
+      clear();
+      delete head_;
+    }
+
+  Policy getPolicy() const { return policy_; }
+
+  /** @brief Set how many messages DropOldest keeps, 0 for unlimited. */
+  void setCapacity( uint32_t capacity ) { capacity_ = capacity; }
+  uint32_t getCapacity() const { return capacity_; }
+
+  /** @brief Hand a message to the consumer.  Never blocks. */
+  void push( const T& value )
+    {
+      received_.ref();
+
+      if( policy_ == KeepLatest )
+      {
+        T* old = latest_.fetchAndStoreOrdered( new T( value ));
+        if( old )
+        {
+          delete old;
+          dropped_.ref();
+        }
+        return;
+      }
+
+      Node* node = new Node;
+      node->value = value;
+      // Count before publishing, so the consumer never sees fewer
+      // messages counted than it can take.
+      queued_.ref();
+      tail_->next.fetchAndStoreRelease( node );
+      tail_ = node;
+    }
+
+  /** @brief Take the oldest available message.
+   * @return false if there is none. */
+  bool pop( T* value )
+    {
+      if( policy_ == KeepLatest )
+      {
+        T* latest = latest_.fetchAndStoreOrdered( 0 );
+        if( !latest )
+        {
+          return false;
+        }
+        *value = *latest;
+        delete latest;
+        return true;
+      }
+
+      if( capacity_ > 0 )
+      {
+        T discarded;
+        while( (uint32_t)(int)queued_ > capacity_ && popNode( &discarded ))
+        {
+          dropped_.ref();
+        }
+      }
+      return popNode( value );
+    }
+
+  /** @brief Discard all messages which have not been taken yet.  They are not counted as dropped. */
+  void clear()
+    {
+      delete latest_.fetchAndStoreOrdered( 0 );
+
+      T discarded;
+      while( popNode( &discarded ))
+      {
+      }
+    }
+
+  /** @brief Reset the received and dropped counters. */
+  void resetCounters()
+    {
+      received_.fetchAndStoreOrdered( 0 );
+      dropped_.fetchAndStoreOrdered( 0 );
+    }
+
+  /** @brief Number of messages pushed since the last resetCounters(). */
+  uint32_t getReceivedCount() const { return (int)received_; }
+
+  /** @brief Number of messages replaced or dropped since the last resetCounters(). */
+  uint32_t getDroppedCount() const { return (int)dropped_; }
+
+  /** @brief Number of messages waiting to be taken. */
+  uint32_t getQueuedCount() const
+    {
+      if( policy_ == KeepLatest )
+      {
+        return (T*)latest_ ? 1 : 0;
+      }
+      return (int)queued_;
+    }
+
+private:
+  struct Node
+  {
+    Node() : next( 0 ) {}
+    QAtomicPointer<Node> next;
+    T value;
+  };
+
+  bool popNode( T* value )
+    {
+      // head_ is a dummy node whose value was taken already.
+      Node* next = head_->next.fetchAndAddAcquire( 0 );
+      if( !next )
+      {
+        return false;
+      }
+      *value = next->value;
+      next->value = T();
+      delete head_;
+      head_ = next;
+      queued_.deref();
+      return true;
+    }
+
+  // Not copyable.
+  MessageMailbox( const MessageMailbox& );
+  MessageMailbox& operator=( const MessageMailbox& );
+
+  Policy policy_;
+  uint32_t capacity_;
+
+  QAtomicPointer<T> latest_;  ///< KeepLatest slot.
+
+  Node* head_;                ///< Only accessed by the consumer.
+  Node* tail_;                ///< Only accessed by the producer.
+  QAtomicInt queued_;
+
+  QAtomicInt received_;
+  QAtomicInt dropped_;
+};
+
+} // namespace rviz
+
+#endif // RVIZ_MESSAGE_MAILBOX_H
@@ -0,0 +1,724 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+
+#include <algorithm>
+#include <sstream>
+
+#include <OGRE/OgreCamera.h>
+#include <OGRE/OgreHardwareBufferManager.h>
+#include <OGRE/OgreMaterialManager.h>
+#include <OGRE/OgreRenderQueue.h>
+#include <OGRE/OgreRoot.h>
+#include <OGRE/OgreSceneNode.h>
+#include <OGRE/OgreTechnique.h>
+
+#include <ros/assert.h>
+#include <ros/console.h>
+
+#include "rviz/ogre_helpers/custom_parameter_indices.h"
+
+#include "rviz/ogre_helpers/arrow_cloud.h"
+
+#define VERTEX_BUFFER_CAPACITY (36 * 1024 * 10)
+#define MIN_RENDERABLE_CAPACITY 64
+
+namespace rviz
+{
+
+/**
+ * Vertex of the unit arrow, used when no geometry shader is available.
+ * x/y/z are scaled by the shader according to the arrow dimensions;
+ * part selects the shaft (0) or the head (1).  The normal is only
+ * used for shading solid arrows.  This must stay in sync with
+ * ogre_media/materials/glsl150/arrow.geom.
+ */
+struct UnitArrowVertex
+{
+  float x, y, z, part;
+  float nx, ny, nz;
+};
+
+static const float g_corners[4][2] =
+{
+  {  1.0f,  1.0f },
+  { -1.0f,  1.0f },
+  { -1.0f, -1.0f },
+  {  1.0f, -1.0f },
+};
+
+static void addVertex( std::vector<UnitArrowVertex>& mesh, float x, float y, float z, float part, const Ogre::Vector3& normal )
+{
+  UnitArrowVertex v = { x, y, z, part, normal.x, normal.y, normal.z };
+  mesh.push_back( v );
+}
+
+static const std::vector<UnitArrowVertex>& getUnitArrowMesh( ArrowCloud::Shape shape )
+{
+  static std::vector<UnitArrowVertex> lines;
+  static std::vector<UnitArrowVertex> solid;
+
+  if( lines.empty() )
+  {
+    Ogre::Vector3 n = Ogre::Vector3::ZERO;
+    addVertex( lines, 0, 0, 0, 0, n );
+    addVertex( lines, 1, 0, 0, 1, n );
+    addVertex( lines, 1, 0, 0, 1, n );
+    addVertex( lines, 0, 1, 0, 1, n );
+    addVertex( lines, 1, 0, 0, 1, n );
+    addVertex( lines, 0, -1, 0, 1, n );
+  }
+
+  if( solid.empty() )
+  {
+    for( int k = 0; k < 4; k++ )
+    {
+      const float* c0 = g_corners[ k ];
+      const float* c1 = g_corners[ (k + 1) % 4 ];
+      Ogre::Vector3 side_normal( 0, c0[0] + c1[0], c0[1] + c1[1] );
+      side_normal.normalise();
+
+      // shaft side
+      addVertex( solid, 0, c0[0], c0[1], 0, side_normal );
+      addVertex( solid, 1, c0[0], c0[1], 0, side_normal );
+      addVertex( solid, 1, c1[0], c1[1], 0, side_normal );
+      addVertex( solid, 0, c0[0], c0[1], 0, side_normal );
+      addVertex( solid, 1, c1[0], c1[1], 0, side_normal );
+      addVertex( solid, 0, c1[0], c1[1], 0, side_normal );
+
+      // head side
+      Ogre::Vector3 head_normal = side_normal + Ogre::Vector3::UNIT_X;
+      head_normal.normalise();
+      addVertex( solid, 0, c0[0], c0[1], 1, head_normal );
+      addVertex( solid, 0, c1[0], c1[1], 1, head_normal );
+      addVertex( solid, 1, 0, 0, 1, head_normal );
+    }
+
+    // back caps of shaft and head
+    for( int part = 0; part < 2; part++ )
+    {
+      const int cap[6] = { 0, 1, 2, 0, 2, 3 };
+      for( int i = 0; i < 6; i++ )
+      {
+        addVertex( solid, 0, g_corners[ cap[i] ][0], g_corners[ cap[i] ][1], part, Ogre::Vector3::NEGATIVE_UNIT_X );
+      }
+    }
+  }
+
+  return shape == ArrowCloud::SHAPE_LINES ? lines : solid;
+}
+
+Ogre::String ArrowCloud::sm_Type = "ArrowCloud";
+
+ArrowCloud::ArrowCloud()
+  : shape_( SHAPE_LINES )
+  , dimensions_( 0.225f, 0.0f, 0.075f, 0.06f )
+  , alpha_( 1.0f )
+  , use_geometry_shader_( false )
+  , bounding_radius_( 0.0f )
+  , overwritten_since_bounds_( 0 )
+{
+  static int count = 0;
+  std::stringstream ss;
+  ss << "ArrowCloudMaterial" << count++;
+
+  lines_material_ = Ogre::MaterialManager::getSingleton().getByName( "rviz/ArrowCloudLines" );
+  solid_material_ = Ogre::MaterialManager::getSingleton().getByName( "rviz/ArrowCloudSolid" );
+  lines_material_ = lines_material_->clone( ss.str() + "Lines" );
+  solid_material_ = solid_material_->clone( ss.str() + "Solid" );
+  lines_material_->load();
+  solid_material_->load();
+
+  bounding_box_.setNull();
+
+  updateMaterial();
+  setAlpha( 1.0f );
+}
+
+ArrowCloud::~ArrowCloud()
+{
+  renderables_.clear();
+
+  lines_material_->unload();
+  solid_material_->unload();
+  Ogre::MaterialManager::getSingleton().remove( lines_material_->getName() );
+  Ogre::MaterialManager::getSingleton().remove( solid_material_->getName() );
+}
+
+void ArrowCloud::setShape( Shape shape )
+{
+  if( shape == shape_ )
+  {
+    return;
+  }
+  shape_ = shape;
+  updateMaterial();
+  regenerateAll();
+}
+
+void ArrowCloud::updateMaterial()
+{
+  current_material_ = ( shape_ == SHAPE_LINES ) ? lines_material_ : solid_material_;
+
+  Ogre::Technique* best = current_material_->getBestTechnique();
+  if( !best )
+  {
+    ROS_ERROR( "No techniques available for material [%s]", current_material_->getName().c_str() );
+    use_geometry_shader_ = false;
+  }
+  else
+  {
+    use_geometry_shader_ = ( best->getName() == "gp" );
+  }
+
+  // The vertex layout depends on the technique, so the buffers have to go.
+  renderables_.clear();
+  renderable_capacities_.clear();
+}
+
+void ArrowCloud::setDimensions( float shaft_length, float shaft_radius, float head_length, float head_radius )
+{
+  Ogre::Vector4 dimensions( shaft_length, shaft_radius, head_length, head_radius );
+  if( dimensions == dimensions_ )
+  {
+    return;
+  }
+  dimensions_ = dimensions;
+
+  for( size_t i = 0; i < renderables_.size(); i++ )
+  {
+    renderables_[ i ]->setCustomParameter( SIZE_PARAMETER, dimensions_ );
+  }
+  updateBounds();
+}
+
+static void setAlphaBlending( const Ogre::MaterialPtr& mat, bool blend )
+{
+  Ogre::Technique* technique = mat->getBestTechnique();
+  if( technique )
+  {
+    technique->setSceneBlending( blend ? Ogre::SBT_TRANSPARENT_ALPHA : Ogre::SBT_REPLACE );
+    technique->setDepthWriteEnabled( !blend );
+  }
+}
+
+void ArrowCloud::setAlpha( float alpha )
+{
+  alpha_ = alpha;
+
+  bool blend = alpha_ < 0.9998;
+  for( size_t i = 0; i < arrows_.size() && !blend; i++ )
+  {
+    blend = arrows_[ i ].color.a < 0.9998;
+  }
+  setAlphaBlending( lines_material_, blend );
+  setAlphaBlending( solid_material_, blend );
+
+  Ogre::Vector4 alpha4( alpha_, alpha_, alpha_, alpha_ );
+  for( size_t i = 0; i < renderables_.size(); i++ )
+  {
+    renderables_[ i ]->setCustomParameter( ALPHA_PARAMETER, alpha4 );
+  }
+}
+
+uint32_t ArrowCloud::getVerticesPerArrow() const
+{
+  if( use_geometry_shader_ )
+  {
+    return 1;
+  }
+  return getUnitArrowMesh( shape_ ).size();
+}
+
+uint32_t ArrowCloud::getArrowsPerRenderable() const
+{
+  return VERTEX_BUFFER_CAPACITY / getVerticesPerArrow();
+}
+
+ArrowCloudRenderablePtr ArrowCloud::createRenderable( uint32_t num_arrows )
+{
+  ArrowCloudRenderablePtr rend( new ArrowCloudRenderable( this, num_arrows * getVerticesPerArrow(), use_geometry_shader_ ));
+  rend->setMaterial( current_material_->getName() );
+
+  Ogre::RenderOperation* op = rend->getRenderOperation();
+  if( use_geometry_shader_ )
+  {
+    op->operationType = Ogre::RenderOperation::OT_POINT_LIST;
+  }
+  else if( shape_ == SHAPE_LINES )
+  {
+    op->operationType = Ogre::RenderOperation::OT_LINE_LIST;
+  }
+  else
+  {
+    op->operationType = Ogre::RenderOperation::OT_TRIANGLE_LIST;
+  }
+
+  rend->setCustomParameter( SIZE_PARAMETER, dimensions_ );
+  rend->setCustomParameter( ALPHA_PARAMETER, Ogre::Vector4( alpha_, alpha_, alpha_, alpha_ ));
+  rend->setCustomParameter( HIGHLIGHT_PARAMETER, Ogre::Vector4( 0.0f, 0.0f, 0.0f, 0.0f ));
+  return rend;
+}
+
+bool ArrowCloud::reserve( uint32_t num_arrows )
+{
+  uint32_t per_renderable = getArrowsPerRenderable();
+  uint32_t num_renderables = ( num_arrows + per_renderable - 1 ) / per_renderable;
+  bool reallocated = false;
+
+  for( uint32_t r = 0; r < num_renderables; r++ )
+  {
+    uint32_t needed = std::min( per_renderable, num_arrows - r * per_renderable );
+    if( r < renderables_.size() && renderable_capacities_[ r ] >= needed )
+    {
+      continue;
+    }
+
+    // Grow geometrically, up to the maximum renderable size.
+    uint32_t capacity = MIN_RENDERABLE_CAPACITY;
+    if( r < renderable_capacities_.size() )
+    {
+      capacity = std::max( capacity, renderable_capacities_[ r ] );
+    }
+    while( capacity < needed )
+    {
+      capacity *= 2;
+    }
+    capacity = std::min( capacity, per_renderable );
+
+    ArrowCloudRenderablePtr rend = createRenderable( capacity );
+    if( r < renderables_.size() )
+    {
+      renderables_[ r ] = rend;
+      renderable_capacities_[ r ] = capacity;
+    }
+    else
+    {
+      renderables_.push_back( rend );
+      renderable_capacities_.push_back( capacity );
+    }
+    reallocated = true;
+  }
+
+  return reallocated;
+}
+
+void ArrowCloud::setArrows( const Arrow* arrows, uint32_t num_arrows )
+{
+  uint32_t old_count = arrows_.size();
+  uint32_t first_changed = 0;
+  uint32_t common = std::min( old_count, num_arrows );
+  while( first_changed < common && arrows[ first_changed ] == arrows_[ first_changed ])
+  {
+    ++first_changed;
+  }
+
+  arrows_.resize( num_arrows );
+  std::copy( arrows + first_changed, arrows + num_arrows, arrows_.begin() + first_changed );
+
+  if( reserve( num_arrows ))
+  {
+    // A reallocated buffer lost its content; a full rewrite keeps
+    // this simple and only happens a logarithmic number of times.
+    first_changed = 0;
+    old_count = 0;
+  }
+
+  writeArrows( first_changed, num_arrows, first_changed >= old_count );
+  updateVertexCounts();
+  updateBounds();
+  setAlpha( alpha_ );
+
+  if( getParentSceneNode() )
+  {
+    getParentSceneNode()->needUpdate();
+  }
+}
+
+void ArrowCloud::addArrows( const Arrow* arrows, uint32_t num_arrows )
+{
+  if( num_arrows == 0 )
+  {
+    return;
+  }
+
+  uint32_t old_count = arrows_.size();
+  arrows_.insert( arrows_.end(), arrows, arrows + num_arrows );
+
+  if( reserve( arrows_.size() ))
+  {
+    // As in setArrows(), a reallocated buffer needs a full rewrite.
+    writeArrows( 0, arrows_.size(), false );
+    updateBounds();
+  }
+  else
+  {
+    writeArrows( old_count, arrows_.size(), true );
+    growBounds( old_count, arrows_.size() );
+  }
+  updateVertexCounts();
+
+  // Blending only ever has to be switched on by new arrows.
+  for( uint32_t i = old_count; i < arrows_.size(); i++ )
+  {
+    if( arrows_[ i ].color.a < 0.9998 )
+    {
+      setAlphaBlending( lines_material_, true );
+      setAlphaBlending( solid_material_, true );
+      break;
+    }
+  }
+
+  if( getParentSceneNode() )
+  {
+    getParentSceneNode()->needUpdate();
+  }
+}
+
+void ArrowCloud::setArrow( uint32_t index, const Arrow& arrow )
+{
+  ROS_ASSERT( index < arrows_.size() );
+  arrows_[ index ] = arrow;
+  writeArrows( index, index + 1, false );
+
+  // Only grow the bounds here; shrinking them needs a full scan, which
+  // is done once as many arrows were overwritten as there are, e.g.
+  // once per turn of a ring buffer.
+  if( ++overwritten_since_bounds_ >= arrows_.size() )
+  {
+    updateBounds();
+  }
+  else
+  {
+    growBounds( index, index + 1 );
+  }
+
+  if( getParentSceneNode() )
+  {
+    getParentSceneNode()->needUpdate();
+  }
+}
+
+void ArrowCloud::clear()
+{
+  arrows_.clear();
+  updateVertexCounts();
+  updateBounds();
+
+  if( getParentSceneNode() )
+  {
+    getParentSceneNode()->needUpdate();
+  }
+}
+
+void ArrowCloud::regenerateAll()
+{
+  std::vector<Arrow> arrows;
+  arrows.swap( arrows_ );
+  setArrows( arrows.empty() ? 0 : &arrows.front(), arrows.size() );
+}
+
+void ArrowCloud::writeArrows( uint32_t start, uint32_t end, bool append )
+{
+  if( start >= end )
+  {
+    return;
+  }
+
+  Ogre::Root* root = Ogre::Root::getSingletonPtr();
+  const std::vector<UnitArrowVertex>& mesh = getUnitArrowMesh( shape_ );
+  uint32_t vpp = getVerticesPerArrow();
+  uint32_t per_renderable = getArrowsPerRenderable();
+
+  uint32_t current = start;
+  while( current < end )
+  {
+    uint32_t r = current / per_renderable;
+    uint32_t local_start = current - r * per_renderable;
+    uint32_t local_end = std::min( end - r * per_renderable, renderable_capacities_[ r ] );
+
+    // If everything from the front to the last valid arrow gets
+    // rewritten, the driver may hand us fresh memory instead of
+    // waiting for pending draws.
+    Ogre::HardwareBuffer::LockOptions lock_options = Ogre::HardwareBuffer::HBL_NORMAL;
+    if( append )
+    {
+      lock_options = Ogre::HardwareBuffer::HBL_NO_OVERWRITE;
+    }
+    else if( local_start == 0 && r * per_renderable + local_end >= arrows_.size() )
+    {
+      lock_options = Ogre::HardwareBuffer::HBL_DISCARD;
+    }
+
+    Ogre::HardwareVertexBufferSharedPtr vbuf = renderables_[ r ]->getBuffer();
+    size_t vertex_size = vbuf->getVertexSize();
+    float* fptr = (float*)vbuf->lock( local_start * vpp * vertex_size,
+                                      ( local_end - local_start ) * vpp * vertex_size,
+                                      lock_options );
+
+    for( uint32_t i = local_start; i < local_end; i++ )
+    {
+      const Arrow& arrow = arrows_[ r * per_renderable + i ];
+      uint32_t color;
+      root->convertColourValue( arrow.color, &color );
+
+      for( uint32_t j = 0; j < vpp; j++ )
+      {
+        *fptr++ = arrow.position.x;
+        *fptr++ = arrow.position.y;
+        *fptr++ = arrow.position.z;
+        *fptr++ = arrow.orientation.x;
+        *fptr++ = arrow.orientation.y;
+        *fptr++ = arrow.orientation.z;
+        *fptr++ = arrow.orientation.w;
+
+        if( !use_geometry_shader_ )
+        {
+          const UnitArrowVertex& v = mesh[ j ];
+          *fptr++ = v.x;
+          *fptr++ = v.y;
+          *fptr++ = v.z;
+          *fptr++ = v.part;
+          *fptr++ = v.nx;
+          *fptr++ = v.ny;
+          *fptr++ = v.nz;
+        }
+
+        memcpy( fptr, &color, sizeof( uint32_t ));
+        ++fptr;
+      }
+    }
+
+    vbuf->unlock();
+    current = r * per_renderable + local_end;
+  }
+}
+
+void ArrowCloud::updateVertexCounts()
+{
+  uint32_t vpp = getVerticesPerArrow();
+  uint32_t per_renderable = getArrowsPerRenderable();
+  uint32_t num_arrows = arrows_.size();
+
+  for( uint32_t r = 0; r < renderables_.size(); r++ )
+  {
+    uint32_t first = r * per_renderable;
+    uint32_t count = num_arrows > first ? std::min( num_arrows - first, per_renderable ) : 0;
+    Ogre::RenderOperation* op = renderables_[ r ]->getRenderOperation();
+    op->vertexData->vertexStart = 0;
+    op->vertexData->vertexCount = count * vpp;
+  }
+}
+
+void ArrowCloud::updateBounds()
+{
+  float extent = std::max( dimensions_.x + dimensions_.z, std::max( dimensions_.y, dimensions_.w ));
+  Ogre::Vector3 extent3( extent, extent, extent );
+  uint32_t per_renderable = getArrowsPerRenderable();
+
+  overwritten_since_bounds_ = 0;
+  bounding_box_.setNull();
+  for( uint32_t r = 0; r < renderables_.size(); r++ )
+  {
+    Ogre::AxisAlignedBox box;
+    box.setNull();
+    uint32_t end = std::min<uint32_t>( arrows_.size(), ( r + 1 ) * per_renderable );
+    for( uint32_t i = r * per_renderable; i < end; i++ )
+    {
+      box.merge( arrows_[ i ].position );
+    }
+    if( !box.isNull() )
+    {
+      box.setExtents( box.getMinimum() - extent3, box.getMaximum() + extent3 );
+      bounding_box_.merge( box );
+    }
+    renderables_[ r ]->setBoundingBox( box );
+  }
+
+  bounding_radius_ = 0.0f;
+  if( !bounding_box_.isNull() )
+  {
+    bounding_radius_ = Ogre::Math::Sqrt( std::max( bounding_box_.getMaximum().squaredLength(),
+                                                   bounding_box_.getMinimum().squaredLength() ));
+  }
+}
+
+void ArrowCloud::growBounds( uint32_t start, uint32_t end )
+{
+  float extent = std::max( dimensions_.x + dimensions_.z, std::max( dimensions_.y, dimensions_.w ));
+  Ogre::Vector3 extent3( extent, extent, extent );
+  uint32_t per_renderable = getArrowsPerRenderable();
+
+  for( uint32_t i = start; i < end; i++ )
+  {
+    const Ogre::Vector3& position = arrows_[ i ].position;
+    Ogre::AxisAlignedBox box( position - extent3, position + extent3 );
+    uint32_t r = i / per_renderable;
+    Ogre::AxisAlignedBox rend_box = renderables_[ r ]->getBoundingBox();
+    rend_box.merge( box );
+    renderables_[ r ]->setBoundingBox( rend_box );
+    bounding_box_.merge( box );
+  }
+
+  bounding_radius_ = 0.0f;
+  if( !bounding_box_.isNull() )
+  {
+    bounding_radius_ = Ogre::Math::Sqrt( std::max( bounding_box_.getMaximum().squaredLength(),
+                                                   bounding_box_.getMinimum().squaredLength() ));
+  }
+}
+
+const Ogre::AxisAlignedBox& ArrowCloud::getBoundingBox() const
+{
+  return bounding_box_;
+}
+
+float ArrowCloud::getBoundingRadius() const
+{
+  return bounding_radius_;
+}
+
+void ArrowCloud::getWorldTransforms( Ogre::Matrix4* xform ) const
+{
+  *xform = _getParentNodeFullTransform();
+}
+
+void ArrowCloud::_updateRenderQueue( Ogre::RenderQueue* queue )
+{
+  for( size_t i = 0; i < renderables_.size(); i++ )
+  {
+    if( renderables_[ i ]->getRenderOperation()->vertexData->vertexCount > 0 )
+    {
+      queue->addRenderable( renderables_[ i ].get() );
+    }
+  }
+}
+
+void ArrowCloud::_notifyAttached( Ogre::Node* parent, bool isTagPoint )
+{
+  MovableObject::_notifyAttached( parent, isTagPoint );
+}
+
+#if (OGRE_VERSION_MAJOR >= 1 && OGRE_VERSION_MINOR >= 6)
+void ArrowCloud::visitRenderables( Ogre::Renderable::Visitor* visitor, bool debugRenderables )
+{
+  for( size_t i = 0; i < renderables_.size(); i++ )
+  {
+    visitor->visit( renderables_[ i ].get(), 0, debugRenderables );
+  }
+}
+#endif
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ArrowCloudRenderable::ArrowCloudRenderable( ArrowCloud* parent, uint32_t num_vertices, bool use_geometry_shader )
+  : parent_( parent )
+{
+  mRenderOp.operationType = Ogre::RenderOperation::OT_POINT_LIST;
+  mRenderOp.useIndexes = false;
+  mRenderOp.vertexData = new Ogre::VertexData;
+  mRenderOp.vertexData->vertexStart = 0;
+  mRenderOp.vertexData->vertexCount = 0;
+
+  Ogre::VertexDeclaration* decl = mRenderOp.vertexData->vertexDeclaration;
+  size_t offset = 0;
+
+  decl->addElement( 0, offset, Ogre::VET_FLOAT3, Ogre::VES_POSITION );
+  offset += Ogre::VertexElement::getTypeSize( Ogre::VET_FLOAT3 );
+
+  // orientation quaternion (x, y, z, w)
+  decl->addElement( 0, offset, Ogre::VET_FLOAT4, Ogre::VES_TEXTURE_COORDINATES, 0 );
+  offset += Ogre::VertexElement::getTypeSize( Ogre::VET_FLOAT4 );
+
+  if( !use_geometry_shader )
+  {
+    // vertex of the unit arrow, and the part it belongs to
+    decl->addElement( 0, offset, Ogre::VET_FLOAT4, Ogre::VES_TEXTURE_COORDINATES, 1 );
+    offset += Ogre::VertexElement::getTypeSize( Ogre::VET_FLOAT4 );
+
+    // face normal of the unit arrow
+    decl->addElement( 0, offset, Ogre::VET_FLOAT3, Ogre::VES_TEXTURE_COORDINATES, 2 );
+    offset += Ogre::VertexElement::getTypeSize( Ogre::VET_FLOAT3 );
+  }
+
+  decl->addElement( 0, offset, Ogre::VET_COLOUR, Ogre::VES_DIFFUSE );
+
+  Ogre::HardwareVertexBufferSharedPtr vbuf =
+    Ogre::HardwareBufferManager::getSingleton().createVertexBuffer(
+      mRenderOp.vertexData->vertexDeclaration->getVertexSize( 0 ),
+      num_vertices,
+      Ogre::HardwareBuffer::HBU_DYNAMIC );
+
+  mRenderOp.vertexData->vertexBufferBinding->setBinding( 0, vbuf );
+
+  mBox.setNull();
+}
+
+ArrowCloudRenderable::~ArrowCloudRenderable()
+{
+  delete mRenderOp.vertexData;
+  delete mRenderOp.indexData;
+}
+
+Ogre::HardwareVertexBufferSharedPtr ArrowCloudRenderable::getBuffer()
+{
+  return mRenderOp.vertexData->vertexBufferBinding->getBuffer( 0 );
+}
+
+Ogre::Real ArrowCloudRenderable::getBoundingRadius() const
+{
+  if( mBox.isNull() )
+  {
+    return 0.0f;
+  }
+  return Ogre::Math::Sqrt( std::max( mBox.getMaximum().squaredLength(), mBox.getMinimum().squaredLength() ));
+}
+
+Ogre::Real ArrowCloudRenderable::getSquaredViewDepth( const Ogre::Camera* cam ) const
+{
+  Ogre::Vector3 center = mBox.isNull() ? Ogre::Vector3::ZERO : mBox.getCenter();
+  Ogre::Matrix4 xform;
+  getWorldTransforms( &xform );
+  return ( cam->getDerivedPosition() - xform * center ).squaredLength();
+}
+
+void ArrowCloudRenderable::getWorldTransforms( Ogre::Matrix4* xform ) const
+{
+  parent_->getWorldTransforms( xform );
+}
+
+const Ogre::LightList& ArrowCloudRenderable::getLights() const
+{
+  return parent_->queryLights();
+}
+
+} // namespace rviz
@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RVIZ_ARROW_CLOUD_H
+#define RVIZ_ARROW_CLOUD_H
+
+#include <stdint.h>
+
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include <OGRE/OgreAxisAlignedBox.h>
+#include <OGRE/OgreColourValue.h>
+#include <OGRE/OgreHardwareVertexBuffer.h>
+#include <OGRE/OgreMaterial.h>
+#include <OGRE/OgreMovableObject.h>
+#include <OGRE/OgreQuaternion.h>
+#include <OGRE/OgreSimpleRenderable.h>
+#include <OGRE/OgreVector3.h>
+#include <OGRE/OgreVector4.h>
+
+namespace Ogre
+{
+class RenderQueue;
+class Camera;
+}
+
+namespace rviz
+{
+
+class ArrowCloud;
+
+class ArrowCloudRenderable : public Ogre::SimpleRenderable
+{
+public:
+  ArrowCloudRenderable( ArrowCloud* parent, uint32_t num_vertices, bool use_geometry_shader );
+  ~ArrowCloudRenderable();
+
+  Ogre::HardwareVertexBufferSharedPtr getBuffer();
+
+  virtual Ogre::Real getBoundingRadius() const;
+  virtual Ogre::Real getSquaredViewDepth( const Ogre::Camera* cam ) const;
+  virtual unsigned short getNumWorldTransforms() const { return 1; }
+  virtual void getWorldTransforms( Ogre::Matrix4* xform ) const;
+  virtual const Ogre::LightList& getLights() const;
+
+private:
+  ArrowCloud* parent_;
+};
+typedef boost::shared_ptr<ArrowCloudRenderable> ArrowCloudRenderablePtr;
+typedef std::vector<ArrowCloudRenderablePtr> V_ArrowCloudRenderable;
+
+/**
+ * \class ArrowCloud
+ * \brief Draws a large number of arrows which share one shape.
+ *
+ * Only the per-arrow data (position, orientation and color) is
+ * uploaded to the graphics card.  The arrow geometry itself is
+ * generated by a geometry shader (or, if geometry shaders are not
+ * available, by a vertex shader from replicated vertices), and the
+ * orientation of each arrow is applied on the GPU.  The CPU never
+ * rotates a single vertex.
+ *
+ * All arrows have the same dimensions, set with setDimensions().  The
+ * arrow points along the positive x axis of its orientation: a shaft
+ * from the origin of length shaft_length, followed by a head of length
+ * head_length.
+ *
+ * The vertex buffers persist between updates.  setArrows() only
+ * uploads the arrows that differ from the current content,
+ * addArrows() uploads only the new arrows and setArrow() overwrites a
+ * single arrow in place, which makes the class suitable for growing
+ * histories and fixed-size ring buffers.
+ */
+class ArrowCloud : public Ogre::MovableObject
+{
+public:
+  enum Shape
+  {
+    SHAPE_LINES,  ///< Flat line arrows: shaft plus two head lines in the local x-y plane.
+    SHAPE_SOLID,  ///< Shaded 3D arrows with square cross sections.
+  };
+
+  struct Arrow
+  {
+    Ogre::Vector3 position;
+    Ogre::Quaternion orientation;
+    Ogre::ColourValue color;
+
+    bool operator==( const Arrow& other ) const
+    {
+      return position == other.position &&
+        orientation == other.orientation &&
+        color == other.color;
+    }
+  };
+
+  ArrowCloud();
+  ~ArrowCloud();
+
+  void setShape( Shape shape );
+  Shape getShape() const { return shape_; }
+
+  /**
+   * \brief Set the dimensions shared by all arrows.
+   * @param shaft_length Length of the shaft, along x.
+   * @param shaft_radius Half the width of the (square) shaft.  Ignored for SHAPE_LINES.
+   * @param head_length Length of the head, along x.
+   * @param head_radius Half the width of the head at its base.
+   */
+  void setDimensions( float shaft_length, float shaft_radius, float head_length, float head_radius );
+
+  /** \brief Set a global alpha value, applied on top of per-arrow alpha. */
+  void setAlpha( float alpha );
+
+  /**
+   * \brief Replace all arrows.
+   *
+   * Arrows that are identical to the ones already in the vertex buffer
+   * (compared from the front) are not uploaded again.
+   */
+  void setArrows( const Arrow* arrows, uint32_t num_arrows );
+
+  /**
+   * \brief Append arrows after the existing ones.
+   *
+   * Only the new arrows are uploaded and merged into the bounds, unless
+   * a vertex buffer has to grow.
+   */
+  void addArrows( const Arrow* arrows, uint32_t num_arrows );
+
+  /**
+   * \brief Overwrite a single arrow, which must already exist.
+   *
+   * The bounds only grow, except that they are recomputed from all
+   * arrows once as many arrows were overwritten as there are.
+   */
+  void setArrow( uint32_t index, const Arrow& arrow );
+
+  /** \brief Remove all arrows.  Keeps the vertex buffers allocated. */
+  void clear();
+
+  uint32_t getNumArrows() const { return arrows_.size(); }
+
+  virtual const Ogre::String& getMovableType() const { return sm_Type; }
+  virtual const Ogre::AxisAlignedBox& getBoundingBox() const;
+  virtual float getBoundingRadius() const;
+  virtual void getWorldTransforms( Ogre::Matrix4* xform ) const;
+  virtual unsigned short getNumWorldTransforms() const { return 1; }
+  virtual void _updateRenderQueue( Ogre::RenderQueue* queue );
+  virtual void _notifyAttached( Ogre::Node* parent, bool isTagPoint = false );
+#if (OGRE_VERSION_MAJOR >= 1 && OGRE_VERSION_MINOR >= 6)
+  virtual void visitRenderables( Ogre::Renderable::Visitor* visitor, bool debugRenderables );
+#endif
+
+private:
+  uint32_t getVerticesPerArrow() const;
+  uint32_t getArrowsPerRenderable() const;
+
+  /** \brief Make sure the renderables can hold @a num_arrows.
+   * @return true if any renderable was reallocated, which invalidates its content. */
+  bool reserve( uint32_t num_arrows );
+
+  /** \brief Upload arrows [start, end) of arrows_ to the vertex buffers. */
+  void writeArrows( uint32_t start, uint32_t end, bool append );
+
+  /** \brief Set the vertex counts of all renderables to match arrows_. */
+  void updateVertexCounts();
+
+  void updateMaterial();
+  void updateBounds();
+  /** \brief Merge arrows [start, end) of arrows_ into the bounds; never shrinks them. */
+  void growBounds( uint32_t start, uint32_t end );
+  void regenerateAll();
+  ArrowCloudRenderablePtr createRenderable( uint32_t num_arrows );
+
+  std::vector<Arrow> arrows_;
+  V_ArrowCloudRenderable renderables_;
+  /// Number of arrows each renderable can hold; only the last one may be smaller than getArrowsPerRenderable().
+  std::vector<uint32_t> renderable_capacities_;
+
+  Shape shape_;
+  Ogre::Vector4 dimensions_;
+  float alpha_;
+
+  Ogre::MaterialPtr lines_material_;
+  Ogre::MaterialPtr solid_material_;
+  Ogre::MaterialPtr current_material_;
+  bool use_geometry_shader_;
+
+  Ogre::AxisAlignedBox bounding_box_;
+  float bounding_radius_;
+  /// setArrow() calls since the last updateBounds(); the bounds may be larger than needed.
+  uint32_t overwritten_since_bounds_;
+
+  static Ogre::String sm_Type;
+};
+
+} // namespace rviz
+
+#endif // RVIZ_ARROW_CLOUD_H
@@ -29,22 +29,119 @@
 
 #include "billboard_line.h"
 
+#include <string.h>
+
+#include <algorithm>
+
+#include <OGRE/OgreCamera.h>
+#include <OGRE/OgreHardwareBufferManager.h>
+#include <OGRE/OgreRenderQueue.h>
+#include <OGRE/OgreRoot.h>
 #include <OGRE/OgreSceneManager.h>
 #include <OGRE/OgreSceneNode.h>
+#include <OGRE/OgreSimpleRenderable.h>
 #include <OGRE/OgreVector3.h>
 #include <OGRE/OgreQuaternion.h>
-#include <OGRE/OgreBillboardChain.h>
 #include <OGRE/OgreMaterialManager.h>
+#include <OGRE/OgreTechnique.h>
 
 #include <sstream>
 
 #include <ros/assert.h>
 
-#define MAX_ELEMENTS (65536/4)
+#include "rviz/ogre_helpers/custom_parameter_indices.h"
+
+#define VERTICES_PER_SEGMENT 6
+#define MIN_SEGMENT_CAPACITY 64
 
 namespace rviz
 {
 
+/**
+ * Holds the segment vertices of a BillboardLine.  Each segment is six
+ * vertices (two triangles); every vertex carries its own end of the
+ * segment as position and the other end plus the side of the quad in
+ * uv0.  ogre_media/materials/glsl120/billboard_line.vert expands them.
+ */
+class BillboardLineRenderable : public Ogre::SimpleRenderable
+{
+public:
+  BillboardLineRenderable( BillboardLine* parent )
+    : parent_( parent )
+    , capacity_( 0 )
+  {
+    mRenderOp.operationType = Ogre::RenderOperation::OT_TRIANGLE_LIST;
+    mRenderOp.useIndexes = false;
+    mRenderOp.vertexData = new Ogre::VertexData;
+    mRenderOp.vertexData->vertexStart = 0;
+    mRenderOp.vertexData->vertexCount = 0;
+
+    Ogre::VertexDeclaration* decl = mRenderOp.vertexData->vertexDeclaration;
+    size_t offset = 0;
+    decl->addElement( 0, offset, Ogre::VET_FLOAT3, Ogre::VES_POSITION );
+    offset += Ogre::VertexElement::getTypeSize( Ogre::VET_FLOAT3 );
+    decl->addElement( 0, offset, Ogre::VET_FLOAT4, Ogre::VES_TEXTURE_COORDINATES, 0 );
+    offset += Ogre::VertexElement::getTypeSize( Ogre::VET_FLOAT4 );
+    decl->addElement( 0, offset, Ogre::VET_COLOUR, Ogre::VES_DIFFUSE );
+
+    mBox.setNull();
+  }
+
+  ~BillboardLineRenderable()
+  {
+    delete mRenderOp.vertexData;
+  }
+
+  /** \brief Make sure the buffer holds @a num_segments.
+   * @return true if the buffer was reallocated, which invalidates its content. */
+  bool reserve( uint32_t num_segments )
+  {
+    if( num_segments <= capacity_ && !vbuf_.isNull() )
+    {
+      return false;
+    }
+
+    capacity_ = std::max<uint32_t>( std::max( num_segments, capacity_ * 2 ), MIN_SEGMENT_CAPACITY );
+    vbuf_ = Ogre::HardwareBufferManager::getSingleton().createVertexBuffer(
+      mRenderOp.vertexData->vertexDeclaration->getVertexSize( 0 ),
+      capacity_ * VERTICES_PER_SEGMENT,
+      Ogre::HardwareBuffer::HBU_DYNAMIC );
+    mRenderOp.vertexData->vertexBufferBinding->setBinding( 0, vbuf_ );
+    return true;
+  }
+
+  const Ogre::HardwareVertexBufferSharedPtr& getBuffer() const { return vbuf_; }
+
+  virtual void _updateRenderQueue( Ogre::RenderQueue* queue )
+  {
+    parent_->writeSegments();
+    if( mRenderOp.vertexData->vertexCount > 0 )
+    {
+      SimpleRenderable::_updateRenderQueue( queue );
+    }
+  }
+
+  virtual Ogre::Real getBoundingRadius() const
+  {
+    if( mBox.isNull() )
+    {
+      return 0.0f;
+    }
+    return Ogre::Math::Sqrt( std::max( mBox.getMaximum().squaredLength(), mBox.getMinimum().squaredLength() ));
+  }
+
+  virtual Ogre::Real getSquaredViewDepth( const Ogre::Camera* cam ) const
+  {
+    Ogre::Vector3 center = mBox.isNull() ? Ogre::Vector3::ZERO : mBox.getCenter();
+    return ( cam->getDerivedPosition() - _getParentNodeFullTransform() * center ).squaredLength();
+  }
+
+private:
+  BillboardLine* parent_;
+  uint32_t capacity_;
+  Ogre::HardwareVertexBufferSharedPtr vbuf_;
+};
+
 BillboardLine::BillboardLine( Ogre::SceneManager* scene_manager, Ogre::SceneNode* parent_node )
 : Object( scene_manager )
 , width_( 0.1f )
@@ -52,9 +149,7 @@ BillboardLine::BillboardLine( Ogre::SceneManager* scene_manager, Ogre::SceneNode
 , total_elements_(0)
 , num_lines_(1)
 , max_points_per_line_(100)
-, lines_per_chain_(0)
-, current_chain_(0)
-, elements_in_current_chain_(0)
+, written_segments_(0)
 {
   if ( !parent_node )
   {
@@ -66,9 +161,16 @@ BillboardLine::BillboardLine( Ogre::SceneManager* scene_manager, Ogre::SceneNode
   static int count = 0;
   std::stringstream ss;
   ss << "BillboardLineMaterial" << count++;
-  material_ = Ogre::MaterialManager::getSingleton().create( ss.str(), Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME );
-  material_->setReceiveShadows(false);
-  material_->getTechnique(0)->setLightingEnabled(false);
+  material_ = Ogre::MaterialManager::getSingleton().getByName( "rviz/BillboardLine" );
+  material_ = material_->clone( ss.str() );
+  material_->load();
+
+  renderable_ = new BillboardLineRenderable( this );
+  renderable_->setMaterial( material_->getName() );
+  renderable_->setCustomParameter( SIZE_PARAMETER, Ogre::Vector4( width_, width_, width_, 0.0f ));
+  scene_node_->attachObject( renderable_ );
+
+  points_box_.setNull();
 
   setNumLines(num_lines_);
   setMaxPointsPerLine(max_points_per_line_);
@@ -76,100 +178,43 @@ BillboardLine::BillboardLine( Ogre::SceneManager* scene_manager, Ogre::SceneNode
 
 BillboardLine::~BillboardLine()
 {
-  V_Chain::iterator it = chains_.begin();
-  V_Chain::iterator end = chains_.end();
-  for (;it != end; ++it)
-  {
-    scene_manager_->destroyBillboardChain(*it);
-  }
+  scene_node_->detachObject( renderable_ );
+  delete renderable_;
 
   scene_manager_->destroySceneNode( scene_node_->getName() );
 
   material_->unload();
-}
-
-Ogre::BillboardChain* BillboardLine::createChain()
-{
-  std::stringstream ss;
-  static int count = 0;
-  ss << "BillboardLine chain" << count++;
-  Ogre::BillboardChain* chain = scene_manager_->createBillboardChain(ss.str());
-  chain->setMaterialName( material_->getName() );
-  scene_node_->attachObject( chain );
-
-  chains_.push_back(chain);
-
-  return chain;
+  Ogre::MaterialManager::getSingleton().remove( material_->getName() );
 }
 
 void BillboardLine::clear()
 {
-  V_Chain::iterator it = chains_.begin();
-  V_Chain::iterator end = chains_.end();
-  for (; it != end; ++it)
-  {
-    (*it)->clearAllChains();
-  }
-
   current_line_ = 0;
   total_elements_ = 0;
-  current_chain_ = 0;
-  elements_in_current_chain_ = 0;
 
   for (V_uint32::iterator it = num_elements_.begin(); it != num_elements_.end(); ++it)
   {
     *it = 0;
   }
-}
-
-void BillboardLine::setupChains()
-{
-  uint32_t total_points = max_points_per_line_ * num_lines_;
-  uint32_t num_chains = total_points / MAX_ELEMENTS;
-  if (total_points % MAX_ELEMENTS != 0)
-  {
-    ++num_chains;
-  }
-
-  for (uint32_t i = chains_.size(); i < num_chains; ++i)
-  {
-    createChain();
-  }
-
-  lines_per_chain_ = MAX_ELEMENTS / max_points_per_line_;
 
-  V_Chain::iterator it = chains_.begin();
-  V_Chain::iterator end = chains_.end();
-  for (;it != end; ++it)
-  {
-    (*it)->setMaxChainElements(max_points_per_line_);
+  points_.clear();
+  segments_.clear();
+  written_segments_ = 0;
+  renderable_->getRenderOperation()->vertexData->vertexCount = 0;
 
-    // shorten the number of chains in the last bbchain, to avoid memory wasteage
-    if (it + 1 == end)
-    {
-      uint32_t lines_left = num_lines_ % lines_per_chain_;
-      (*it)->setNumberOfChains(lines_left);
-    }
-    else
-    {
-      (*it)->setNumberOfChains(lines_per_chain_);
-    }
-  }
+  points_box_.setNull();
+  updateBounds();
 }
 
 void BillboardLine::setMaxPointsPerLine(uint32_t max)
 {
   max_points_per_line_ = max;
-
-  setupChains();
 }
 
 void BillboardLine::setNumLines(uint32_t num)
 {
   num_lines_ = num;
 
-  setupChains();
-
   num_elements_.resize(num);
 
   for (V_uint32::iterator it = num_elements_.begin(); it != num_elements_.end(); ++it)
@@ -192,42 +237,122 @@ void BillboardLine::addPoint( const Ogre::Vector3& point )
 
 void BillboardLine::addPoint( const Ogre::Vector3& point, const Ogre::ColourValue& color )
 {
-  ++num_elements_[current_line_];
-  ++total_elements_;
+  addPoints( &point, &color, 1 );
+}
 
-  ROS_ASSERT(num_elements_[current_line_] <= max_points_per_line_);
+void BillboardLine::addPoints( const Ogre::Vector3* points, const Ogre::ColourValue* colors, uint32_t num_points )
+{
+  if( num_points == 0 )
+  {
+    return;
+  }
 
-  ++elements_in_current_chain_;
-  if (elements_in_current_chain_ > MAX_ELEMENTS)
+  ROS_ASSERT(num_elements_[current_line_] + num_points <= max_points_per_line_);
+
+  points_.reserve( points_.size() + num_points );
+  for( uint32_t i = 0; i < num_points; i++ )
   {
-    ++current_chain_;
-    elements_in_current_chain_ = 1;
+    // Every point after the first of a line closes a segment.
+    if( num_elements_[current_line_] > 0 )
+    {
+      segments_.push_back( points_.size() - 1 );
+    }
+
+    Point p;
+    p.position = points[ i ];
+    p.color = colors ? colors[ i ] : color_;
+    points_.push_back( p );
+    points_box_.merge( p.position );
+
+    ++num_elements_[current_line_];
+    ++total_elements_;
   }
 
-  Ogre::BillboardChain::Element e;
-  e.position = point;
-  e.width = width_;
-  e.colour = color;
-  chains_[current_chain_]->addChainElement(current_line_ % lines_per_chain_ , e);
+  updateBounds();
 }
 
-void BillboardLine::setLineWidth( float width )
+void BillboardLine::writeSegments()
 {
-  width_ = width;
+  uint32_t num_segments = segments_.size();
+  if( written_segments_ == num_segments )
+  {
+    return;
+  }
 
-  for (uint32_t line = 0; line < num_lines_; ++line)
+  if( renderable_->reserve( num_segments ))
   {
-    uint32_t element_count = num_elements_[line];
+    written_segments_ = 0;
+  }
 
-    for ( uint32_t i = 0; i < element_count; ++i )
-    {
-      Ogre::BillboardChain* c = chains_[line / lines_per_chain_];
-      Ogre::BillboardChain::Element e = c->getChainElement(line % lines_per_chain_, i);
+  // Appended segments are not used by any pending draw; a rewrite
+  // from the front may get fresh memory from the driver.
+  Ogre::HardwareBuffer::LockOptions lock_options = written_segments_ == 0 ?
+    Ogre::HardwareBuffer::HBL_DISCARD : Ogre::HardwareBuffer::HBL_NO_OVERWRITE;
+
+  const Ogre::HardwareVertexBufferSharedPtr& vbuf = renderable_->getBuffer();
+  size_t segment_size = vbuf->getVertexSize() * VERTICES_PER_SEGMENT;
+  float* fptr = (float*)vbuf->lock( written_segments_ * segment_size,
+                                    ( num_segments - written_segments_ ) * segment_size,
+                                    lock_options );
 
-      e.width = width_;
-      c->updateChainElement(line % lines_per_chain_, i, e);
+  // Corners of the quad as (end, side): the side is given relative to
+  // the direction towards the other end, so it flips for the far end.
+  static const float corners[ VERTICES_PER_SEGMENT ][ 2 ] =
+  {
+    { 0,  1 }, { 0, -1 }, { 1,  1 },
+    { 0,  1 }, { 1,  1 }, { 1, -1 },
+  };
+
+  Ogre::Root* root = Ogre::Root::getSingletonPtr();
+  for( uint32_t s = written_segments_; s < num_segments; s++ )
+  {
+    const Point* ends[ 2 ] = { &points_[ segments_[ s ]], &points_[ segments_[ s ] + 1 ] };
+    uint32_t colors[ 2 ];
+    root->convertColourValue( ends[ 0 ]->color, &colors[ 0 ] );
+    root->convertColourValue( ends[ 1 ]->color, &colors[ 1 ] );
+
+    for( int v = 0; v < VERTICES_PER_SEGMENT; v++ )
+    {
+      int end = (int)corners[ v ][ 0 ];
+      const Ogre::Vector3& pos = ends[ end ]->position;
+      const Ogre::Vector3& other = ends[ 1 - end ]->position;
+      *fptr++ = pos.x;
+      *fptr++ = pos.y;
+      *fptr++ = pos.z;
+      *fptr++ = other.x;
+      *fptr++ = other.y;
+      *fptr++ = other.z;
+      *fptr++ = corners[ v ][ 1 ];
+      memcpy( fptr++, &colors[ end ], sizeof( uint32_t ));
     }
   }
+
+  vbuf->unlock();
+
+  written_segments_ = num_segments;
+  renderable_->getRenderOperation()->vertexData->vertexCount = num_segments * VERTICES_PER_SEGMENT;
+}
+
+void BillboardLine::updateBounds()
+{
+  Ogre::AxisAlignedBox box = points_box_;
+  if( !box.isNull() )
+  {
+    Ogre::Vector3 half_width( width_ * 0.5f, width_ * 0.5f, width_ * 0.5f );
+    box.setExtents( box.getMinimum() - half_width, box.getMaximum() + half_width );
+  }
+  renderable_->setBoundingBox( box );
+
+  // The scene node caches the bounds of its objects.
+  scene_node_->needUpdate();
+}
+
+void BillboardLine::setLineWidth( float width )
+{
+  width_ = width;
+
+  renderable_->setCustomParameter( SIZE_PARAMETER, Ogre::Vector4( width_, width_, width_, 0.0f ));
+  updateBounds();
 }
 
 void BillboardLine::setPosition( const Ogre::Vector3& position )
@@ -258,21 +383,20 @@ void BillboardLine::setColor( float r, float g, float b, float a )
     material_->getTechnique(0)->setDepthWriteEnabled( true );
   }
 
-  color_ = Ogre::ColourValue( r, g, b, a );
-
-  for (uint32_t line = 0; line < num_lines_; ++line)
+  // The alpha travels with the vertex colors; pass_color.frag has no
+  // alpha parameter.
+  Ogre::ColourValue color( r, g, b, a );
+  if( color == color_ )
   {
-    uint32_t element_count = num_elements_[line];
-
-    for ( uint32_t i = 0; i < element_count; ++i )
-    {
-      Ogre::BillboardChain* c = chains_[line / lines_per_chain_];
-      Ogre::BillboardChain::Element e = c->getChainElement(line % lines_per_chain_, i);
+    return;
+  }
+  color_ = color;
 
-      e.colour = color_;
-      c->updateChainElement(line % lines_per_chain_, i, e);
-    }
+  for (std::vector<Point>::iterator it = points_.begin(); it != points_.end(); ++it)
+  {
+    it->color = color_;
   }
+  written_segments_ = 0;
 }
 
 const Ogre::Vector3& BillboardLine::getPosition()
@@ -286,5 +410,3 @@ const Ogre::Quaternion& BillboardLine::getOrientation()
 }
 
 } // namespace rviz
-
-
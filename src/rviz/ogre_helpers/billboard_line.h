@@ -35,6 +35,7 @@
 #include <stdint.h>
 
 #include <vector>
+#include <OGRE/OgreAxisAlignedBox.h>
 #include <OGRE/OgreVector3.h>
 #include <OGRE/OgreColourValue.h>
 #include <OGRE/OgreMaterial.h>
@@ -45,15 +46,22 @@ class SceneManager;
 class SceneNode;
 class Quaternion;
 class Any;
-class BillboardChain;
 }
 
 namespace rviz
 {
 
+class BillboardLineRenderable;
+
 /**
  * \class BillboardLine
  * \brief An object that displays a multi-segment line strip rendered as billboards
+ *
+ * Only the points are stored in the vertex buffer.  Each segment is
+ * expanded into a camera-facing quad by a vertex shader, so moving the
+ * camera costs nothing on the CPU.  Points added since the last frame
+ * are appended to the buffer without touching the ones already there,
+ * and the line width is a shader parameter.
  */
 class BillboardLine : public Object
 {
@@ -71,6 +79,12 @@ public:
   void addPoint(const Ogre::Vector3& point);
   void addPoint(const Ogre::Vector3& point, const Ogre::ColourValue& color);
 
+  /**
+   * \brief Add several points to the current line in one call.
+   * @param colors One color per point, or NULL to use the color set with setColor().
+   */
+  void addPoints(const Ogre::Vector3* points, const Ogre::ColourValue* colors, uint32_t num_points);
+
   void setLineWidth( float width );
 
   void setMaxPointsPerLine(uint32_t max);
@@ -98,13 +112,21 @@ public:
   Ogre::MaterialPtr getMaterial() { return material_; }
 
 private:
-  void setupChains();
-  Ogre::BillboardChain* createChain();
+  friend class BillboardLineRenderable;
 
-  Ogre::SceneNode* scene_node_;
+  struct Point
+  {
+    Ogre::Vector3 position;
+    Ogre::ColourValue color;
+  };
+
+  /** \brief Upload the segments added since the last call.  Called at render time. */
+  void writeSegments();
+
+  void updateBounds();
 
-  typedef std::vector<Ogre::BillboardChain*> V_Chain;
-  V_Chain chains_;
+  Ogre::SceneNode* scene_node_;
+  BillboardLineRenderable* renderable_;
   Ogre::MaterialPtr material_;
 
   Ogre::ColourValue color_;
@@ -112,17 +134,20 @@ private:
 
   uint32_t current_line_;
 
-  // Ogre 1.4 doesn't have getNumChainElements()
   typedef std::vector<uint32_t> V_uint32;
   V_uint32 num_elements_;
   uint32_t total_elements_;
 
   uint32_t num_lines_;
   uint32_t max_points_per_line_;
-  uint32_t lines_per_chain_;
 
-  uint32_t current_chain_;
-  uint32_t elements_in_current_chain_;
+  std::vector<Point> points_;
+  /// Index into points_ of the first point of each segment; the second point follows it.
+  V_uint32 segments_;
+  /// Number of segments already in the vertex buffer.
+  uint32_t written_segments_;
+
+  Ogre::AxisAlignedBox points_box_;
 };
 
 } // namespace rviz
@@ -45,5 +45,8 @@
 #define UP_PARAMETER 4
 #define HIGHLIGHT_PARAMETER 5
 #define AUTO_SIZE_PARAMETER 6
+#define COLORMAP_PARAMETER 7
+#define COLORMAP_MIN_COLOR_PARAMETER 8
+#define COLORMAP_MAX_COLOR_PARAMETER 9
 
 #endif // CUSTOM_PARAMETER_INDICES_H
@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <set>
+#include <sstream>
+
+#include <OGRE/OgreMaterialManager.h>
+#include <OGRE/OgrePass.h>
+#include <OGRE/OgreTechnique.h>
+#include <OGRE/OgreTextureManager.h>
+#include <OGRE/OgreTextureUnitState.h>
+
+#include "rviz/ogre_helpers/material_cache.h"
+
+namespace rviz
+{
+
+static bool colourLess( const Ogre::ColourValue& a, const Ogre::ColourValue& b )
+{
+  if( a.r != b.r ) return a.r < b.r;
+  if( a.g != b.g ) return a.g < b.g;
+  if( a.b != b.b ) return a.b < b.b;
+  return a.a < b.a;
+}
+
+MaterialCache::Key::Key()
+: ambient( 0.5, 0.5, 0.5, 1.0 )
+, diffuse( Ogre::ColourValue::White )
+, lighting( true )
+, depth_only( false )
+{
+}
+
+bool MaterialCache::Key::operator<( const Key& other ) const
+{
+  if( base_material != other.base_material ) return base_material < other.base_material;
+  if( texture != other.texture ) return texture < other.texture;
+  if( ambient != other.ambient ) return colourLess( ambient, other.ambient );
+  if( diffuse != other.diffuse ) return colourLess( diffuse, other.diffuse );
+  if( lighting != other.lighting ) return lighting < other.lighting;
+  return depth_only < other.depth_only;
+}
+
+MaterialCache* MaterialCache::instance_ = 0;
+
+MaterialCache* MaterialCache::get()
+{
+  if( instance_ == 0 )
+  {
+    instance_ = new MaterialCache();
+  }
+  return instance_;
+}
+
+MaterialCache::MaterialCache()
+: reference_count_( 0 )
+, material_count_( 0 )
+{
+}
+
+Ogre::MaterialPtr MaterialCache::acquire( const Key& key )
+{
+  M_KeyToEntry::iterator it = entries_.find( key );
+  if( it == entries_.end() )
+  {
+    Entry entry;
+    entry.material = createMaterial( key );
+    entry.references = 0;
+    it = entries_.insert( std::make_pair( key, entry )).first;
+    names_[ entry.material->getName() ] = it;
+  }
+
+  it->second.references++;
+  reference_count_++;
+  return it->second.material;
+}
+
+void MaterialCache::release( const Ogre::MaterialPtr& material )
+{
+  if( material.isNull() )
+  {
+    return;
+  }
+
+  M_NameToEntry::iterator name_it = names_.find( material->getName() );
+  if( name_it == names_.end() )
+  {
+    return;
+  }
+
+  M_KeyToEntry::iterator it = name_it->second;
+  reference_count_--;
+  if( --it->second.references == 0 )
+  {
+    Ogre::MaterialPtr dead = it->second.material;
+    names_.erase( name_it );
+    entries_.erase( it );
+
+    dead->unload();
+    Ogre::MaterialManager::getSingleton().remove( dead->getName() );
+  }
+}
+
+size_t MaterialCache::getTextureMemory() const
+{
+  std::set<std::string> textures;
+  for( M_KeyToEntry::const_iterator it = entries_.begin(); it != entries_.end(); ++it )
+  {
+    Ogre::Technique* technique = it->second.material->getTechnique( 0 );
+    if( !technique )
+    {
+      continue;
+    }
+    for( unsigned short p = 0; p < technique->getNumPasses(); ++p )
+    {
+      Ogre::Pass* pass = technique->getPass( p );
+      for( unsigned short t = 0; t < pass->getNumTextureUnitStates(); ++t )
+      {
+        textures.insert( pass->getTextureUnitState( t )->getTextureName() );
+      }
+    }
+  }
+
+  size_t bytes = 0;
+  for( std::set<std::string>::const_iterator it = textures.begin(); it != textures.end(); ++it )
+  {
+    Ogre::TexturePtr texture = Ogre::TextureManager::getSingleton().getByName( *it );
+    if( !texture.isNull() )
+    {
+      bytes += texture->getSize();
+    }
+  }
+  return bytes;
+}
+
+Ogre::MaterialPtr MaterialCache::createMaterial( const Key& key )
+{
+  std::stringstream ss;
+  ss << "rviz/SharedMaterial" << material_count_++;
+
+  Ogre::MaterialPtr material;
+  if( !key.base_material.empty() )
+  {
+    Ogre::MaterialPtr base = Ogre::MaterialManager::getSingleton().getByName( key.base_material );
+    if( !base.isNull() )
+    {
+      material = base->clone( ss.str() );
+    }
+  }
+  if( material.isNull() )
+  {
+    material = Ogre::MaterialManager::getSingleton().create( ss.str(), ROS_PACKAGE_NAME );
+    material->setReceiveShadows( false );
+  }
+
+  if( !key.texture.empty() )
+  {
+    Ogre::Pass* pass = material->getTechnique( 0 )->getPass( 0 );
+    pass->createTextureUnitState()->setTextureName( key.texture );
+  }
+
+  material->setLightingEnabled( key.lighting );
+  material->setAmbient( key.ambient );
+  material->setDiffuse( key.diffuse );
+
+  if( key.depth_only )
+  {
+    material->setColourWriteEnabled( false );
+    material->setDepthWriteEnabled( true );
+  }
+  else if( key.diffuse.a < 0.9998 )
+  {
+    material->setSceneBlending( Ogre::SBT_TRANSPARENT_ALPHA );
+    material->setDepthWriteEnabled( false );
+  }
+  else
+  {
+    material->setSceneBlending( Ogre::SBT_REPLACE );
+    material->setDepthWriteEnabled( true );
+  }
+
+  return material;
+}
+
+} // namespace rviz
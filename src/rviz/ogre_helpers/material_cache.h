@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RVIZ_MATERIAL_CACHE_H
+#define RVIZ_MATERIAL_CACHE_H
+
+#include <stddef.h>
+
+#include <map>
+#include <string>
+
+#include <OGRE/OgreColourValue.h>
+#include <OGRE/OgreMaterial.h>
+
+namespace rviz
+{
+
+/**
+ * \brief Shares Ogre materials between objects with identical appearance.
+ *
+ * Robot links and mesh markers used to clone a material for every
+ * link and marker, so a robot with fifty identical grey links had
+ * fifty identical grey materials, and Ogre could not batch their
+ * render state.  MaterialCache instead hands out one material per
+ * distinct Key and counts references to it.  A material must be
+ * treated as read-only by its users: to change an object's color or
+ * alpha, acquire() the material for the new Key, assign it, and
+ * release() the old one.
+ */
+class MaterialCache
+{
+public:
+  /** @brief Everything that determines the appearance of a cached material. */
+  struct Key
+  {
+    Key();
+
+    /** Name of a material to clone as the starting point, or empty
+     * for a plain material. */
+    std::string base_material;
+    /** Texture to add as a texture unit to the first pass, or empty. */
+    std::string texture;
+    Ogre::ColourValue ambient;
+    /** Diffuse color.  Alpha below 1 turns on alpha blending and
+     * turns off depth writes. */
+    Ogre::ColourValue diffuse;
+    bool lighting;
+    /** Only write depth, no color.  Used for robots drawn into the
+     * depth buffer as occluders. */
+    bool depth_only;
+
+    bool operator<( const Key& other ) const;
+  };
+
+  static MaterialCache* get();
+
+  /** @brief Return the material for @a key, creating it on first use. */
+  Ogre::MaterialPtr acquire( const Key& key );
+
+  /** @brief Drop one reference to @a material, destroying it with the last one.
+   *
+   * Materials not created by this cache are ignored. */
+  void release( const Ogre::MaterialPtr& material );
+
+  /** @brief Number of distinct materials currently alive. */
+  size_t getMaterialCount() const { return entries_.size(); }
+
+  /** @brief Number of outstanding acquire() calls not yet released. */
+  size_t getReferenceCount() const { return reference_count_; }
+
+  /** @brief Bytes of texture memory used by the cached materials, each texture counted once. */
+  size_t getTextureMemory() const;
+
+private:
+  MaterialCache();
+
+  struct Entry
+  {
+    Ogre::MaterialPtr material;
+    size_t references;
+  };
+  typedef std::map<Key, Entry> M_KeyToEntry;
+  typedef std::map<std::string, M_KeyToEntry::iterator> M_NameToEntry;
+
+  Ogre::MaterialPtr createMaterial( const Key& key );
+
+  M_KeyToEntry entries_;
+  M_NameToEntry names_;
+  size_t reference_count_;
+  unsigned int material_count_;
+
+  static MaterialCache* instance_;
+};
+
+} // namespace rviz
+
+#endif // RVIZ_MATERIAL_CACHE_H
@@ -0,0 +1,334 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <set>
+#include <sstream>
+
+#include <OGRE/OgreCamera.h>
+#include <OGRE/OgreHardwareBufferManager.h>
+#include <OGRE/OgreHardwareOcclusionQuery.h>
+#include <OGRE/OgreMaterialManager.h>
+#include <OGRE/OgrePass.h>
+#include <OGRE/OgreRenderSystem.h>
+#include <OGRE/OgreRenderSystemCapabilities.h>
+#include <OGRE/OgreRenderTarget.h>
+#include <OGRE/OgreRoot.h>
+#include <OGRE/OgreSceneManager.h>
+#include <OGRE/OgreSceneNode.h>
+#include <OGRE/OgreTechnique.h>
+#include <OGRE/OgreViewport.h>
+
+#include <ros/console.h>
+
+#include "rviz/ogre_helpers/occlusion_culler.h"
+
+namespace rviz
+{
+
+OcclusionQueryBox::OcclusionQueryBox()
+: transform_( Ogre::Matrix4::IDENTITY )
+{
+  mRenderOp.operationType = Ogre::RenderOperation::OT_TRIANGLE_LIST;
+  mRenderOp.useIndexes = true;
+
+  mRenderOp.vertexData = new Ogre::VertexData;
+  mRenderOp.vertexData->vertexStart = 0;
+  mRenderOp.vertexData->vertexCount = 8;
+  Ogre::VertexDeclaration* decl = mRenderOp.vertexData->vertexDeclaration;
+  decl->addElement( 0, 0, Ogre::VET_FLOAT3, Ogre::VES_POSITION );
+
+  // Corner i is at -0.5 or 0.5 along x, y and z by bits 0, 1 and 2 of i.
+  float corners[ 8 * 3 ];
+  for( int i = 0; i < 8; i++ )
+  {
+    corners[ i * 3 + 0 ] = ( i & 1 ) ? 0.5f : -0.5f;
+    corners[ i * 3 + 1 ] = ( i & 2 ) ? 0.5f : -0.5f;
+    corners[ i * 3 + 2 ] = ( i & 4 ) ? 0.5f : -0.5f;
+  }
+  Ogre::HardwareVertexBufferSharedPtr vbuf =
+    Ogre::HardwareBufferManager::getSingleton().createVertexBuffer( decl->getVertexSize( 0 ), 8,
+                                                                    Ogre::HardwareBuffer::HBU_STATIC_WRITE_ONLY );
+  vbuf->writeData( 0, sizeof( corners ), corners, true );
+  mRenderOp.vertexData->vertexBufferBinding->setBinding( 0, vbuf );
+
+  static const uint16_t indices[ 36 ] = { 0, 4, 6,  0, 6, 2,    // -x
+                                          1, 3, 7,  1, 7, 5,    // +x
+                                          0, 1, 5,  0, 5, 4,    // -y
+                                          2, 6, 7,  2, 7, 3,    // +y
+                                          0, 2, 3,  0, 3, 1,    // -z
+                                          4, 5, 7,  4, 7, 6 };  // +z
+  mRenderOp.indexData = new Ogre::IndexData;
+  mRenderOp.indexData->indexStart = 0;
+  mRenderOp.indexData->indexCount = 36;
+  mRenderOp.indexData->indexBuffer =
+    Ogre::HardwareBufferManager::getSingleton().createIndexBuffer( Ogre::HardwareIndexBuffer::IT_16BIT, 36,
+                                                                   Ogre::HardwareBuffer::HBU_STATIC_WRITE_ONLY );
+  mRenderOp.indexData->indexBuffer->writeData( 0, sizeof( indices ), indices, true );
+
+  setBoundingBox( Ogre::AxisAlignedBox( -0.5, -0.5, -0.5, 0.5, 0.5, 0.5 ));
+}
+
+OcclusionQueryBox::~OcclusionQueryBox()
+{
+  delete mRenderOp.vertexData;
+  delete mRenderOp.indexData;
+}
+
+void OcclusionQueryBox::setBox( const Ogre::AxisAlignedBox& box )
+{
+  transform_.makeTransform( box.getCenter(), box.getSize(), Ogre::Quaternion::IDENTITY );
+}
+
+OcclusionCuller::OcclusionCuller( Ogre::SceneManager* scene_manager, Ogre::RenderTarget* target, Ogre::Viewport* viewport )
+: scene_manager_( scene_manager )
+, target_( target )
+, viewport_( viewport )
+, supported_( false )
+, enabled_( false )
+, in_viewport_( false )
+, culled_count_( 0 )
+{
+  Ogre::RenderSystem* render_system = Ogre::Root::getSingleton().getRenderSystem();
+  supported_ = render_system->getCapabilities()->hasCapability( Ogre::RSC_HWOCCLUSION );
+  if( !supported_ )
+  {
+    ROS_INFO( "Hardware occlusion queries are not supported, occlusion culling is not available." );
+  }
+
+  // Boxes only test the depth buffer; they write nothing.
+  static int count = 0;
+  std::stringstream ss;
+  ss << "OcclusionQueryMaterial" << count++;
+  material_ = Ogre::MaterialManager::getSingleton().create( ss.str(), ROS_PACKAGE_NAME );
+  material_->setReceiveShadows( false );
+  Ogre::Pass* pass = material_->getTechnique( 0 )->getPass( 0 );
+  pass->setLightingEnabled( false );
+  pass->setColourWriteEnabled( false );
+  pass->setDepthWriteEnabled( false );
+  pass->setDepthCheckEnabled( true );
+  pass->setCullingMode( Ogre::CULL_NONE );
+  pass->setManualCullingMode( Ogre::MANUAL_CULL_NONE );
+  material_->load();
+  box_.setMaterial( material_->getName() );
+
+  target_->addListener( this );
+  scene_manager_->addRenderQueueListener( this );
+}
+
+OcclusionCuller::~OcclusionCuller()
+{
+  scene_manager_->removeRenderQueueListener( this );
+  target_->removeListener( this );
+
+  reattach();
+  for( M_NodeToState::iterator it = states_.begin(); it != states_.end(); ++it )
+  {
+    destroyQuery( it->second );
+  }
+
+  Ogre::MaterialManager::getSingleton().remove( material_->getName() );
+}
+
+void OcclusionCuller::setEnabled( bool enabled )
+{
+  enabled_ = enabled && supported_;
+  if( !enabled_ )
+  {
+    for( M_NodeToState::iterator it = states_.begin(); it != states_.end(); ++it )
+    {
+      it->second.occluded = false;
+    }
+    culled_count_ = 0;
+  }
+}
+
+void OcclusionCuller::setCandidates( const std::vector<Ogre::SceneNode*>& nodes )
+{
+  std::set<Ogre::SceneNode*> node_set( nodes.begin(), nodes.end() );
+
+  M_NodeToState::iterator it = states_.begin();
+  while( it != states_.end() )
+  {
+    if( node_set.find( it->first ) == node_set.end() )
+    {
+      destroyQuery( it->second );
+      states_.erase( it++ );
+    }
+    else
+    {
+      ++it;
+    }
+  }
+
+  if( !supported_ )
+  {
+    return;
+  }
+
+  Ogre::RenderSystem* render_system = Ogre::Root::getSingleton().getRenderSystem();
+  for( size_t i = 0; i < nodes.size(); i++ )
+  {
+    if( states_.find( nodes[ i ]) == states_.end() )
+    {
+      NodeState& state = states_[ nodes[ i ]];
+      state.query = render_system->createHardwareOcclusionQuery();
+      state.query_pending = false;
+      state.occluded = false;
+    }
+  }
+}
+
+void OcclusionCuller::destroyQuery( NodeState& state )
+{
+  if( state.query )
+  {
+    Ogre::Root::getSingleton().getRenderSystem()->destroyHardwareOcclusionQuery( state.query );
+    state.query = NULL;
+  }
+}
+
+void OcclusionCuller::preViewportUpdate( const Ogre::RenderTargetViewportEvent& evt )
+{
+  if( evt.source != viewport_ )
+  {
+    return;
+  }
+  in_viewport_ = true;
+
+  if( !enabled_ )
+  {
+    return;
+  }
+
+  // Read the results of last frame's queries.  Queries still in
+  // flight keep their previous result rather than stalling the frame.
+  Ogre::SceneNode* root = scene_manager_->getRootSceneNode();
+  for( M_NodeToState::iterator it = states_.begin(); it != states_.end(); ++it )
+  {
+    NodeState& state = it->second;
+    if( state.query_pending && !state.query->isStillOutstanding() )
+    {
+      unsigned int pixels = 0;
+      state.query->pullOcclusionQuery( &pixels );
+      state.occluded = ( pixels == 0 );
+      state.query_pending = false;
+    }
+
+    if( state.occluded && it->first->getParent() == root )
+    {
+      root->removeChild( it->first );
+      detached_.push_back( it->first );
+    }
+  }
+  culled_count_ = detached_.size();
+}
+
+void OcclusionCuller::postViewportUpdate( const Ogre::RenderTargetViewportEvent& evt )
+{
+  if( evt.source != viewport_ )
+  {
+    return;
+  }
+  in_viewport_ = false;
+  reattach();
+}
+
+void OcclusionCuller::reattach()
+{
+  Ogre::SceneNode* root = scene_manager_->getRootSceneNode();
+  for( size_t i = 0; i < detached_.size(); i++ )
+  {
+    if( !detached_[ i ]->getParent() )
+    {
+      root->addChild( detached_[ i ]);
+    }
+  }
+  detached_.clear();
+}
+
+void OcclusionCuller::renderQueueEnded( Ogre::uint8 queueGroupId, const Ogre::String& invocation, bool& repeatThisInvocation )
+{
+  if( !enabled_ || !in_viewport_ || queueGroupId != Ogre::RENDER_QUEUE_MAIN ||
+      scene_manager_->getCurrentViewport() != viewport_ )
+  {
+    return;
+  }
+
+  Ogre::Camera* camera = viewport_->getCamera();
+  if( !camera )
+  {
+    return;
+  }
+  Ogre::Vector3 eye = camera->getDerivedPosition();
+  Ogre::Real near_clip = camera->getNearClipDistance();
+  Ogre::Pass* pass = material_->getBestTechnique()->getPass( 0 );
+
+  for( M_NodeToState::iterator it = states_.begin(); it != states_.end(); ++it )
+  {
+    NodeState& state = it->second;
+    if( state.query_pending )
+    {
+      continue;
+    }
+
+    // Detached nodes missed the scene graph update, so refresh their bounds here.
+    Ogre::SceneNode* node = it->first;
+    if( !node->getParent() )
+    {
+      node->_update( true, false );
+    }
+
+    Ogre::AxisAlignedBox box = node->_getWorldAABB();
+    if( box.isNull() || box.isInfinite() )
+    {
+      state.occluded = false;
+      continue;
+    }
+
+    // Grow the box so its faces are not hidden by the geometry it
+    // contains, and so it is never cut by the near clip plane.
+    Ogre::Vector3 margin = box.getSize() * 0.01 + Ogre::Vector3( 0.01 + near_clip );
+    box.setExtents( box.getMinimum() - margin, box.getMaximum() + margin );
+
+    // Nodes around the camera or outside the view are left to Ogre.
+    if( box.contains( eye ) || !camera->isVisible( box ))
+    {
+      state.occluded = false;
+      continue;
+    }
+
+    box_.setBox( box );
+    state.query->beginOcclusionQuery();
+    scene_manager_->_injectRenderWithPass( pass, &box_, false );
+    state.query->endOcclusionQuery();
+    state.query_pending = true;
+  }
+}
+
+} // namespace rviz
@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RVIZ_OCCLUSION_CULLER_H
+#define RVIZ_OCCLUSION_CULLER_H
+
+#include <map>
+#include <vector>
+
+#include <OGRE/OgreMaterial.h>
+#include <OGRE/OgreMatrix4.h>
+#include <OGRE/OgreRenderQueueListener.h>
+#include <OGRE/OgreRenderTargetListener.h>
+#include <OGRE/OgreSimpleRenderable.h>
+
+namespace Ogre
+{
+class HardwareOcclusionQuery;
+class RenderTarget;
+class SceneManager;
+class SceneNode;
+class Viewport;
+}
+
+namespace rviz
+{
+
+/** @brief Solid box drawn for occlusion queries, placed by a world transform of its own. */
+class OcclusionQueryBox : public Ogre::SimpleRenderable
+{
+public:
+  OcclusionQueryBox();
+  virtual ~OcclusionQueryBox();
+
+  void setBox( const Ogre::AxisAlignedBox& box );
+
+  virtual Ogre::Real getBoundingRadius() const { return 0; }
+  virtual Ogre::Real getSquaredViewDepth( const Ogre::Camera* cam ) const { return 0; }
+  virtual void getWorldTransforms( Ogre::Matrix4* xform ) const { *xform = transform_; }
+
+private:
+  Ogre::Matrix4 transform_;
+};
+
+/**
+ * \brief Skips scene nodes hidden behind other geometry in one viewport.
+ *
+ * After the main render queue group of the viewport is drawn, the
+ * bounding box of each candidate node is drawn against the depth
+ * buffer inside a hardware occlusion query.  When the next frame of
+ * the viewport starts, nodes whose query passed no pixels are detached
+ * from their parent for the duration of that viewport update only, so
+ * other viewports and selection still see the whole scene.
+ *
+ * Query results are used one frame late, so a node coming out from
+ * behind an occluder appears one frame after it would otherwise.
+ */
+class OcclusionCuller : public Ogre::RenderQueueListener, public Ogre::RenderTargetListener
+{
+public:
+  OcclusionCuller( Ogre::SceneManager* scene_manager, Ogre::RenderTarget* target, Ogre::Viewport* viewport );
+  virtual ~OcclusionCuller();
+
+  /** @brief False if the render system has no hardware occlusion queries. */
+  bool isSupported() const { return supported_; }
+
+  void setEnabled( bool enabled );
+  bool isEnabled() const { return enabled_; }
+
+  /**
+   * @brief Set the nodes which may be culled.
+   *
+   * Each must be a direct child of the root scene node.  Nodes missing
+   * from @a nodes lose their query, so call this whenever nodes may
+   * have been destroyed.
+   */
+  void setCandidates( const std::vector<Ogre::SceneNode*>& nodes );
+
+  /** @brief Number of candidate nodes culled in the most recent frame. */
+  int getCulledCount() const { return culled_count_; }
+
+  // Ogre::RenderTargetListener
+  virtual void preViewportUpdate( const Ogre::RenderTargetViewportEvent& evt );
+  virtual void postViewportUpdate( const Ogre::RenderTargetViewportEvent& evt );
+
+  // Ogre::RenderQueueListener
+  virtual void renderQueueStarted( Ogre::uint8 queueGroupId, const Ogre::String& invocation, bool& skipThisInvocation ) {}
+  virtual void renderQueueEnded( Ogre::uint8 queueGroupId, const Ogre::String& invocation, bool& repeatThisInvocation );
+
+private:
+  struct NodeState
+  {
+    Ogre::HardwareOcclusionQuery* query;
+    bool query_pending; ///< A query was issued and its result not read yet.
+    bool occluded;      ///< The last query result passed no pixels.
+  };
+  typedef std::map<Ogre::SceneNode*, NodeState> M_NodeToState;
+
+  void destroyQuery( NodeState& state );
+  void reattach();
+
+  Ogre::SceneManager* scene_manager_;
+  Ogre::RenderTarget* target_;
+  Ogre::Viewport* viewport_;
+
+  bool supported_;
+  bool enabled_;
+  bool in_viewport_;
+
+  M_NodeToState states_;
+  std::vector<Ogre::SceneNode*> detached_;
+  int culled_count_;
+
+  OcclusionQueryBox box_;
+  Ogre::MaterialPtr material_;
+};
+
+} // namespace rviz
+
+#endif // RVIZ_OCCLUSION_CULLER_H
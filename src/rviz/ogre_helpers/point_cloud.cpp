@@ -40,7 +40,10 @@
 #include <OGRE/OgreBillboard.h>
 #include <OGRE/OgreTexture.h>
 #include <OGRE/OgreTextureManager.h>
+#include <OGRE/OgreTechnique.h>
+#include <OGRE/OgrePass.h>
 
+#include <cmath>
 #include <sstream>
 
 #include "rviz/ogre_helpers/custom_parameter_indices.h"
@@ -132,6 +135,9 @@ PointCloud::PointCloud()
 , common_direction_( Ogre::Vector3::NEGATIVE_UNIT_Z )
 , common_up_vector_( Ogre::Vector3::UNIT_Y )
 , color_by_index_(false)
+, auto_size_(false)
+, compact_positions_(false)
+, current_compact_positions_(false)
 , current_mode_supports_geometry_shader_(false)
 {
   std::stringstream ss;
@@ -224,13 +230,12 @@ void PointCloud::regenerateAll()
     return;
   }
 
-  V_Point points;
-  points.swap(points_);
+  // clear() leaves the stored points alone, so upload them again.
   uint32_t count = point_count_;
 
   clear();
 
-  addPoints(&points.front(), count);
+  uploadPoints(count);
 }
 
 void PointCloud::setColorByIndex(bool set)
@@ -251,6 +256,94 @@ void PointCloud::setHighlightColor( float r, float g, float b )
   }
 }
 
+/** Switch the vertex programs of the normal techniques of @a mat to their "(colormap)" variants, or back. */
+static void useColorMapPrograms(const Ogre::MaterialPtr& mat, bool use)
+{
+  // Only the visible passes: depth and picking don't need colors, and
+  // the second picking pass must show the point indices of
+  // setColorByIndex() as they are.
+  static const std::string suffix = "(colormap)";
+  Ogre::Material::TechniqueIterator tech_it = mat->getTechniqueIterator();
+  while (tech_it.hasMoreElements())
+  {
+    Ogre::Technique* tech = tech_it.getNext();
+    if (tech->getSchemeName() != Ogre::MaterialManager::DEFAULT_SCHEME_NAME)
+    {
+      continue;
+    }
+
+    Ogre::Technique::PassIterator pass_it = tech->getPassIterator();
+    while (pass_it.hasMoreElements())
+    {
+      Ogre::Pass* pass = pass_it.getNext();
+      if (!pass->hasVertexProgram())
+      {
+        continue;
+      }
+
+      const std::string& name = pass->getVertexProgramName();
+      bool uses = Ogre::StringUtil::endsWith(name, suffix, false);
+      if (use && !uses)
+      {
+        pass->setVertexProgram(name + suffix);
+      }
+      else if (!use && uses)
+      {
+        pass->setVertexProgram(name.substr(0, name.size() - suffix.size()));
+      }
+    }
+  }
+}
+
+void PointCloud::setColorMap(const ColorMap& color_map)
+{
+  bool use_programs = color_map.mode != CM_NONE;
+  if (use_programs != (color_map_.mode != CM_NONE))
+  {
+    useColorMapPrograms(point_material_, use_programs);
+    useColorMapPrograms(square_material_, use_programs);
+    useColorMapPrograms(flat_square_material_, use_programs);
+    useColorMapPrograms(sphere_material_, use_programs);
+    useColorMapPrograms(tile_material_, use_programs);
+    useColorMapPrograms(box_material_, use_programs);
+  }
+  color_map_ = color_map;
+
+  Ogre::Vector4 params(color_map_.scale, color_map_.offset, color_map_.mode, 0.0f);
+  Ogre::Vector4 min_color(color_map_.min_color.r, color_map_.min_color.g, color_map_.min_color.b, color_map_.min_color.a);
+  Ogre::Vector4 max_color(color_map_.max_color.r, color_map_.max_color.g, color_map_.max_color.b, color_map_.max_color.a);
+
+  V_PointCloudRenderable::iterator it = renderables_.begin();
+  V_PointCloudRenderable::iterator end = renderables_.end();
+  for (; it != end; ++it)
+  {
+    (*it)->setCustomParameter(COLORMAP_PARAMETER, params);
+    (*it)->setCustomParameter(COLORMAP_MIN_COLOR_PARAMETER, min_color);
+    (*it)->setCustomParameter(COLORMAP_MAX_COLOR_PARAMETER, max_color);
+  }
+
+  if (getParentSceneNode())
+  {
+    getParentSceneNode()->needUpdate();
+  }
+}
+
+void PointCloud::encodeColorMapValue(float value, Ogre::ColourValue& color)
+{
+  if (!(value > 0.0f)) // also NaN
+  {
+    value = 0.0f;
+  }
+  value = std::min(value, 1.0f);
+
+  // The conversion to the vertex color truncates, so aim at the middle
+  // of each byte to get exactly the bytes back in the shader.
+  uint32_t bits = (uint32_t)(value * 16777215.0f + 0.5f);
+  color.r = ((bits >> 16) + 0.5f) / 255.0f;
+  color.g = (((bits >> 8) & 0xff) + 0.5f) / 255.0f;
+  color.b = ((bits & 0xff) + 0.5f) / 255.0f;
+}
+
 void PointCloud::setRenderMode(RenderMode mode)
 {
   render_mode_ = mode;
@@ -317,8 +410,10 @@ void PointCloud::setRenderMode(RenderMode mode)
     ROS_ERROR("No techniques available for material [%s]", current_material_->getName().c_str());
   }
 
-  if (geom_support_changed)
+  // The vertex format depends on both.
+  if (geom_support_changed || current_compact_positions_ != useCompactPositions())
   {
+    current_compact_positions_ = useCompactPositions();
     renderables_.clear();
   }
 
@@ -350,6 +445,13 @@ void PointCloud::setDimensions(float width, float height, float depth)
 
 void PointCloud::setAutoSize(bool auto_size)
 {
+  auto_size_ = auto_size;
+  if (current_compact_positions_ != useCompactPositions())
+  {
+    // changes the vertex format, see setRenderMode()
+    setRenderMode(render_mode_);
+  }
+
   V_PointCloudRenderable::iterator it = renderables_.begin();
   V_PointCloudRenderable::iterator end = renderables_.end();
   for (; it != end; ++it)
@@ -358,6 +460,34 @@ void PointCloud::setAutoSize(bool auto_size)
   }
 }
 
+void PointCloud::setCompactPositions(bool compact)
+{
+  compact_positions_ = compact;
+  setRenderMode(render_mode_);
+}
+
+bool PointCloud::useCompactPositions() const
+{
+  return compact_positions_ && render_mode_ == RM_POINTS && !auto_size_;
+}
+
+size_t PointCloud::getSystemMemoryUsage() const
+{
+  return points_.capacity() * sizeof(StoredPoint);
+}
+
+size_t PointCloud::getGpuMemoryUsage() const
+{
+  size_t bytes = 0;
+  V_PointCloudRenderable::const_iterator it = renderables_.begin();
+  V_PointCloudRenderable::const_iterator end = renderables_.end();
+  for (; it != end; ++it)
+  {
+    bytes += (*it)->getRenderOperation()->vertexData->vertexBufferBinding->getBuffer(0)->getSizeInBytes();
+  }
+  return bytes;
+}
+
 void PointCloud::setCommonDirection(const Ogre::Vector3& vec)
 {
   common_direction_ = vec;
@@ -445,8 +575,38 @@ void PointCloud::addPoints(Point* points, uint32_t num_points)
     points_.resize( point_count_ + num_points );
   }
 
-  Point* begin = &points_.front() + point_count_;
-  memcpy( begin, points, sizeof( Point ) * num_points );
+  StoredPoint* begin = &points_.front() + point_count_;
+  for (uint32_t i = 0; i < num_points; ++i)
+  {
+    begin[i].position = points[i].position;
+    root->convertColourValue( points[i].color, &begin[i].color );
+  }
+
+  uploadPoints(num_points);
+}
+
+/** Return true for the positions PointCloudCommon gives points with invalid coordinates. */
+static inline bool isInvalidPosition(const Ogre::Vector3& pos)
+{
+  return std::abs(pos.x) >= 999999.0f || std::abs(pos.y) >= 999999.0f || std::abs(pos.z) >= 999999.0f;
+}
+
+static inline int16_t quantize(float value, float origin, float inv_scale)
+{
+  float q = (value - origin) * inv_scale;
+  return (int16_t)std::max(-32767.0f, std::min(32767.0f, floorf(q + 0.5f)));
+}
+
+void PointCloud::uploadPoints(uint32_t num_points)
+{
+  if (num_points == 0)
+  {
+    return;
+  }
+  Ogre::Root* root = Ogre::Root::getSingletonPtr();
+
+  const StoredPoint* points = &points_.front() + point_count_;
+  bool compact = current_compact_positions_;
 
   uint32_t vpp = getVerticesPerPoint();
   Ogre::RenderOperation::OperationType op_type;
@@ -505,6 +665,12 @@ void PointCloud::addPoints(Point* points, uint32_t num_points)
   Ogre::RenderOperation* op = 0;
   float* fptr = 0;
 
+  // Quantization of the current renderable, with compact positions.
+  Ogre::Vector3 origin, inv_scale;
+  bool chunk_has_valid_points = false;
+  int16_t last_position[3] = { 0, 0, 0 };
+  uint32_t last_color = 0;
+
   Ogre::AxisAlignedBox aabb;
   aabb.setNull();
   uint32_t current_vertex_count = 0;
@@ -542,9 +708,49 @@ void PointCloud::addPoints(Point* points, uint32_t num_points)
       fptr = (float*)((uint8_t*)vdata);
 
       aabb.setNull();
+
+      if (compact)
+      {
+        // Fit the 16 bit range to the points going into this renderable.
+        // Invalid points are left out, unless there is nothing else.
+        uint32_t chunk_end = current_point + buffer_size / vpp;
+        uint32_t first_valid = chunk_end;
+        Ogre::AxisAlignedBox bounds;
+        for (uint32_t i = current_point; i < chunk_end; ++i)
+        {
+          if (!isInvalidPosition(points[i].position))
+          {
+            first_valid = std::min(first_valid, i);
+            bounds.merge(points[i].position);
+          }
+        }
+        chunk_has_valid_points = first_valid < chunk_end;
+        if (!chunk_has_valid_points)
+        {
+          for (uint32_t i = current_point; i < chunk_end; ++i)
+          {
+            bounds.merge(points[i].position);
+          }
+        }
+
+        origin = bounds.getCenter();
+        Ogre::Vector3 scale = bounds.getHalfSize() / 32767.0f;
+        scale.makeCeil(Ogre::Vector3(1e-6f, 1e-6f, 1e-6f));
+        inv_scale = Ogre::Vector3(1.0f / scale.x, 1.0f / scale.y, 1.0f / scale.z);
+        rend->setPositionTransform(origin, scale);
+
+        if (chunk_has_valid_points)
+        {
+          for (int j = 0; j < 3; ++j)
+          {
+            last_position[j] = quantize(points[first_valid].position[j], origin[j], inv_scale[j]);
+          }
+          last_color = points[first_valid].color;
+        }
+      }
     }
 
-    const Point& p = points[current_point];
+    const StoredPoint& p = points[current_point];
 
     uint32_t color;
 
@@ -561,7 +767,7 @@ void PointCloud::addPoints(Point* points, uint32_t num_points)
     }
     else
     {
-      Ogre::Root::getSingletonPtr()->convertColourValue( p.color, &color );
+      color = p.color;
     }
 
     aabb.merge(p.position);
@@ -572,11 +778,47 @@ void PointCloud::addPoints(Point* points, uint32_t num_points)
     float y = p.position.y;
     float z = p.position.z;
 
+    int16_t qpos[3];
+    if (compact)
+    {
+      if (chunk_has_valid_points && isInvalidPosition(p.position) && !color_by_index_)
+      {
+        // Can't be represented; draw it exactly over the last point
+        // instead, where it can't be seen.
+        qpos[0] = last_position[0];
+        qpos[1] = last_position[1];
+        qpos[2] = last_position[2];
+        color = last_color;
+      }
+      else
+      {
+        qpos[0] = quantize(x, origin.x, inv_scale.x);
+        qpos[1] = quantize(y, origin.y, inv_scale.y);
+        qpos[2] = quantize(z, origin.z, inv_scale.z);
+        last_position[0] = qpos[0];
+        last_position[1] = qpos[1];
+        last_position[2] = qpos[2];
+        last_color = color;
+      }
+    }
+
     for (uint32_t j = 0; j < vpp; ++j, ++current_vertex_count)
     {
-      *fptr++ = x;
-      *fptr++ = y;
-      *fptr++ = z;
+      if (compact)
+      {
+        int16_t* sptr = (int16_t*)fptr;
+        sptr[0] = qpos[0];
+        sptr[1] = qpos[1];
+        sptr[2] = qpos[2];
+        sptr[3] = 1;
+        fptr += 2;
+      }
+      else
+      {
+        *fptr++ = x;
+        *fptr++ = y;
+        *fptr++ = z;
+      }
 
       if (!current_mode_supports_geometry_shader_)
       {
@@ -646,7 +888,7 @@ void PointCloud::popPoints(uint32_t num_points)
   bounding_radius_ = 0.0f;
   for (uint32_t i = 0; i < point_count_; ++i)
   {
-    Point& p = points_[i];
+    StoredPoint& p = points_[i];
     bounding_box_.merge(p.position);
     bounding_radius_ = std::max(bounding_radius_, p.position.squaredLength());
   }
@@ -752,7 +994,7 @@ void PointCloud::setPickColor(const Ogre::ColourValue& color)
 
 PointCloudRenderablePtr PointCloud::createRenderable( int num_points )
 {
-  PointCloudRenderablePtr rend(new PointCloudRenderable(this, num_points, !current_mode_supports_geometry_shader_));
+  PointCloudRenderablePtr rend(new PointCloudRenderable(this, num_points, !current_mode_supports_geometry_shader_, current_compact_positions_));
   rend->setMaterial(current_material_->getName());
   Ogre::Vector4 size(width_, height_, depth_, 0.0f);
   Ogre::Vector4 alpha(alpha_, 0.0f, 0.0f, 0.0f);
@@ -764,6 +1006,10 @@ PointCloudRenderablePtr PointCloud::createRenderable( int num_points )
   rend->setCustomParameter(PICK_COLOR_PARAMETER, pick_col);
   rend->setCustomParameter(NORMAL_PARAMETER, Ogre::Vector4(common_direction_));
   rend->setCustomParameter(UP_PARAMETER, Ogre::Vector4(common_up_vector_));
+  rend->setCustomParameter(AUTO_SIZE_PARAMETER, Ogre::Vector4(auto_size_));
+  rend->setCustomParameter(COLORMAP_PARAMETER, Ogre::Vector4(color_map_.scale, color_map_.offset, color_map_.mode, 0.0f));
+  rend->setCustomParameter(COLORMAP_MIN_COLOR_PARAMETER, Ogre::Vector4(color_map_.min_color.r, color_map_.min_color.g, color_map_.min_color.b, color_map_.min_color.a));
+  rend->setCustomParameter(COLORMAP_MAX_COLOR_PARAMETER, Ogre::Vector4(color_map_.max_color.r, color_map_.max_color.g, color_map_.max_color.b, color_map_.max_color.a));
   if (getParentSceneNode())
   {
     getParentSceneNode()->attachObject(rend.get());
@@ -785,8 +1031,9 @@ void PointCloud::visitRenderables(Ogre::Renderable::Visitor* visitor, bool debug
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-PointCloudRenderable::PointCloudRenderable(PointCloud* parent, int num_points, bool use_tex_coords)
+PointCloudRenderable::PointCloudRenderable(PointCloud* parent, int num_points, bool use_tex_coords, bool compact_positions)
 : parent_(parent)
+, position_transform_(Ogre::Matrix4::IDENTITY)
 {
   // Initialize render operation
   mRenderOp.operationType = Ogre::RenderOperation::OT_POINT_LIST;
@@ -798,8 +1045,10 @@ PointCloudRenderable::PointCloudRenderable(PointCloud* parent, int num_points, b
   Ogre::VertexDeclaration *decl = mRenderOp.vertexData->vertexDeclaration;
   size_t offset = 0;
 
-  decl->addElement(0, offset, Ogre::VET_FLOAT3, Ogre::VES_POSITION);
-  offset += Ogre::VertexElement::getTypeSize(Ogre::VET_FLOAT3);
+  // SHORT4 rather than SHORT3, which Ogre does not have; w is always 1.
+  Ogre::VertexElementType position_type = compact_positions ? Ogre::VET_SHORT4 : Ogre::VET_FLOAT3;
+  decl->addElement(0, offset, position_type, Ogre::VES_POSITION);
+  offset += Ogre::VertexElement::getTypeSize(position_type);
 
   if (use_tex_coords)
   {
@@ -830,6 +1079,11 @@ Ogre::HardwareVertexBufferSharedPtr PointCloudRenderable::getBuffer()
   return mRenderOp.vertexData->vertexBufferBinding->getBuffer(0);
 }
 
+void PointCloudRenderable::setPositionTransform( const Ogre::Vector3& origin, const Ogre::Vector3& scale )
+{
+  position_transform_.makeTransform( origin, scale, Ogre::Quaternion::IDENTITY );
+}
+
 void PointCloudRenderable::_notifyCurrentCamera(Ogre::Camera* camera)
 {
   SimpleRenderable::_notifyCurrentCamera( camera );
@@ -854,6 +1108,7 @@ Ogre::Real PointCloudRenderable::getSquaredViewDepth(const Ogre::Camera* cam) co
 void PointCloudRenderable::getWorldTransforms(Ogre::Matrix4* xform) const
 {
    parent_->getWorldTransforms(xform);
+   *xform = *xform * position_transform_;
 }
 
 const Ogre::LightList& PointCloudRenderable::getLights() const
@@ -37,6 +37,7 @@
 #include <OGRE/OgreVector3.h>
 #include <OGRE/OgreMaterial.h>
 #include <OGRE/OgreColourValue.h>
+#include <OGRE/OgreMatrix4.h>
 #include <OGRE/OgreRoot.h>
 #include <OGRE/OgreHardwareBufferManager.h>
 
@@ -64,12 +65,15 @@ class PointCloud;
 class PointCloudRenderable : public Ogre::SimpleRenderable
 {
 public:
-  PointCloudRenderable(PointCloud* parent, int num_points, bool use_tex_coords);
+  PointCloudRenderable(PointCloud* parent, int num_points, bool use_tex_coords, bool compact_positions);
   ~PointCloudRenderable();
 
   Ogre::RenderOperation* getRenderOperation() { return &mRenderOp; }
   Ogre::HardwareVertexBufferSharedPtr getBuffer();
 
+  /// Set the transform from 16 bit vertex positions to the parent's coordinates.  Only used with compact positions.
+  void setPositionTransform( const Ogre::Vector3& origin, const Ogre::Vector3& scale );
+
   virtual Ogre::Real getBoundingRadius(void) const;
   virtual Ogre::Real getSquaredViewDepth(const Ogre::Camera* cam) const;
   virtual void _notifyCurrentCamera(Ogre::Camera* camera);
@@ -80,6 +84,7 @@ public:
 private:
   Ogre::MaterialPtr material_;
   PointCloud* parent_;
+  Ogre::Matrix4 position_transform_;
 };
 typedef boost::shared_ptr<PointCloudRenderable> PointCloudRenderablePtr;
 typedef std::vector<PointCloudRenderablePtr> V_PointCloudRenderable;
@@ -107,6 +112,34 @@ public:
     RM_BOXES,
   };
 
+  enum ColorMapMode
+  {
+    CM_NONE,                ///< Show the colors of the points as they are
+    CM_RAINBOW,             ///< Rainbow from red at 0 to magenta at 1
+    CM_INVERTED_RAINBOW,    ///< Rainbow from magenta at 0 to red at 1
+    CM_GRADIENT,            ///< Interpolate from ColorMap::min_color at 0 to ColorMap::max_color at 1
+  };
+
+  /**
+   * \struct ColorMap
+   * \brief How the vertex shaders turn point values into colors.
+   *
+   * With a mode other than CM_NONE the colors of the points are expected to
+   * hold values written by encodeColorMapValue().  A value v is mapped to
+   * scale * v + offset, clamped to [0, 1], and that to a color.  Changing
+   * the map only changes shader parameters, the points are not touched.
+   */
+  struct ColorMap
+  {
+    ColorMap() : mode( CM_NONE ), scale( 1.0f ), offset( 0.0f ) {}
+
+    ColorMapMode mode;
+    float scale;
+    float offset;
+    Ogre::ColourValue min_color;
+    Ogre::ColourValue max_color;
+  };
+
   PointCloud();
   ~PointCloud();
 
@@ -162,6 +195,26 @@ public:
    */
   void setAutoSize(bool auto_size);
 
+  /**
+   * \brief Store vertex positions as 16 bit integers relative to the center of each vertex buffer.
+   *
+   * Saves a quarter of the GPU memory of each vertex, with a precision of
+   * 1/65534 of the extent of the points in a buffer.  Only used with
+   * RM_POINTS and without auto size, where the shaders do not work with
+   * sizes in object space.
+   */
+  void setCompactPositions( bool compact );
+
+  /// Return the number of points in this cloud.
+  uint32_t getNumPoints() const { return point_count_; }
+  /// Return the position of point @a index, which must be less than getNumPoints().
+  const Ogre::Vector3& getPointPosition( uint32_t index ) const { return points_[ index ].position; }
+
+  /// Return the bytes of system memory used for the points of this cloud.
+  size_t getSystemMemoryUsage() const;
+  /// Return the bytes of vertex buffer memory used by this cloud.
+  size_t getGpuMemoryUsage() const;
+
   /// See Ogre::BillboardSet::setCommonDirection
   void setCommonDirection( const Ogre::Vector3& vec );
   /// See Ogre::BillboardSet::setCommonUpVector
@@ -178,6 +231,17 @@ public:
 
   void setHighlightColor( float r, float g, float b );
 
+  /// Set how the vertex shaders color the points, see ColorMap.
+  void setColorMap( const ColorMap& color_map );
+
+  /**
+   * \brief Store @a value, from [0, 1], in the r, g and b of @a color for ColorMap.
+   *
+   * Uses all 24 bits, so the value keeps a precision of about 6e-8.  Alpha
+   * is left alone and still applies.
+   */
+  static void encodeColorMapValue( float value, Ogre::ColourValue& color );
+
   virtual const Ogre::String& getMovableType() const { return sm_Type; }
   virtual const Ogre::AxisAlignedBox& getBoundingBox() const;
   virtual float getBoundingRadius() const;
@@ -194,16 +258,33 @@ public:
 
 private:
 
+  /**
+   * \brief A point as kept for regenerating the vertex buffers, with the
+   * color already in the render system's 32 bit format.  Takes 16 bytes
+   * instead of the 28 of a Point.
+   */
+  struct StoredPoint
+  {
+    Ogre::Vector3 position;
+    uint32_t color;
+  };
+
   uint32_t getVerticesPerPoint();
   PointCloudRenderablePtr createRenderable( int num_points );
   void regenerateAll();
   void shrinkRenderables();
 
+  /// Write the vertices of the next @a num_points stored points, starting at #point_count_.
+  void uploadPoints( uint32_t num_points );
+
+  /// Return true if vertex positions are currently stored as 16 bit integers.
+  bool useCompactPositions() const;
+
   Ogre::AxisAlignedBox bounding_box_;       ///< The bounding box of this point cloud
   float bounding_radius_;                   ///< The bounding radius of this point cloud
 
-  typedef std::vector<Point> V_Point;
-  V_Point points_;                          ///< The list of points we're displaying.  Allocates to a high-water-mark.
+  typedef std::vector<StoredPoint> V_StoredPoint;
+  V_StoredPoint points_;                    ///< The list of points we're displaying.  Allocates to a high-water-mark.
   uint32_t point_count_;                    ///< The number of points currently in #points_
 
   RenderMode render_mode_;
@@ -223,6 +304,10 @@ private:
   float alpha_;
 
   bool color_by_index_;
+  ColorMap color_map_;
+  bool auto_size_;
+  bool compact_positions_;
+  bool current_compact_positions_;          ///< Vertex format of the current renderables
 
   V_PointCloudRenderable renderables_;
 
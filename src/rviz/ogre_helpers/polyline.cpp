@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+
+#include <algorithm>
+
+#include <OGRE/OgreCamera.h>
+#include <OGRE/OgreHardwareBufferManager.h>
+#include <OGRE/OgreRoot.h>
+#include <OGRE/OgreSceneNode.h>
+
+#include <ros/assert.h>
+
+#include "rviz/ogre_helpers/polyline.h"
+
+#define MIN_POLYLINE_CAPACITY 64
+
+namespace rviz
+{
+
+Polyline::Polyline()
+  : color_( Ogre::ColourValue::White )
+  , capacity_( 0 )
+{
+  mRenderOp.operationType = Ogre::RenderOperation::OT_LINE_STRIP;
+  mRenderOp.useIndexes = false;
+  mRenderOp.vertexData = new Ogre::VertexData;
+  mRenderOp.vertexData->vertexStart = 0;
+  mRenderOp.vertexData->vertexCount = 0;
+
+  Ogre::VertexDeclaration* decl = mRenderOp.vertexData->vertexDeclaration;
+  size_t offset = 0;
+  decl->addElement( 0, offset, Ogre::VET_FLOAT3, Ogre::VES_POSITION );
+  offset += Ogre::VertexElement::getTypeSize( Ogre::VET_FLOAT3 );
+  decl->addElement( 0, offset, Ogre::VET_COLOUR, Ogre::VES_DIFFUSE );
+
+  mBox.setNull();
+}
+
+Polyline::~Polyline()
+{
+  delete mRenderOp.vertexData;
+}
+
+bool Polyline::reserve( uint32_t num_points )
+{
+  if( num_points <= capacity_ )
+  {
+    return false;
+  }
+
+  // Grow geometrically so a steadily growing path only reallocates
+  // a logarithmic number of times.
+  uint32_t capacity = std::max<uint32_t>( capacity_, MIN_POLYLINE_CAPACITY );
+  while( capacity < num_points )
+  {
+    capacity *= 2;
+  }
+
+  vbuf_ = Ogre::HardwareBufferManager::getSingleton().createVertexBuffer(
+    mRenderOp.vertexData->vertexDeclaration->getVertexSize( 0 ),
+    capacity,
+    Ogre::HardwareBuffer::HBU_DYNAMIC );
+  mRenderOp.vertexData->vertexBufferBinding->setBinding( 0, vbuf_ );
+  capacity_ = capacity;
+  return true;
+}
+
+void Polyline::setPoints( const std::vector<Ogre::Vector3>& points, const Ogre::ColourValue& color )
+{
+  uint32_t first_changed = 0;
+  if( color == color_ )
+  {
+    uint32_t common = std::min( points.size(), points_.size() );
+    while( first_changed < common && points[ first_changed ] == points_[ first_changed ])
+    {
+      ++first_changed;
+    }
+  }
+  color_ = color;
+
+  uint32_t old_count = points_.size();
+  bool grew = points.size() > old_count;
+  points_.resize( points.size() );
+  std::copy( points.begin() + first_changed, points.end(), points_.begin() + first_changed );
+
+  if( reserve( points_.size() ))
+  {
+    first_changed = 0;
+  }
+
+  writeVertices( first_changed, points_.size(), first_changed >= old_count );
+  mRenderOp.vertexData->vertexCount = points_.size();
+
+  if( grew && first_changed > 0 && !mBox.isNull() )
+  {
+    // Pure append: the old points are still inside the box.
+    for( uint32_t i = first_changed; i < points_.size(); i++ )
+    {
+      mBox.merge( points_[ i ]);
+    }
+  }
+  else
+  {
+    updateBounds();
+  }
+
+  if( getParentSceneNode() )
+  {
+    getParentSceneNode()->needUpdate();
+  }
+}
+
+void Polyline::clear()
+{
+  points_.clear();
+  mRenderOp.vertexData->vertexCount = 0;
+  mBox.setNull();
+
+  if( getParentSceneNode() )
+  {
+    getParentSceneNode()->needUpdate();
+  }
+}
+
+void Polyline::writeVertices( uint32_t start, uint32_t end, bool append )
+{
+  if( start >= end )
+  {
+    return;
+  }
+  ROS_ASSERT( end <= capacity_ );
+
+  size_t vertex_size = vbuf_->getVertexSize();
+
+  // When appending, the vertices we write are not used by any pending
+  // draw call, so the driver does not need to synchronize.  When
+  // rewriting everything, the old content can be discarded.
+  Ogre::HardwareBuffer::LockOptions lock_options = Ogre::HardwareBuffer::HBL_NORMAL;
+  if( append )
+  {
+    lock_options = Ogre::HardwareBuffer::HBL_NO_OVERWRITE;
+  }
+  else if( start == 0 )
+  {
+    lock_options = Ogre::HardwareBuffer::HBL_DISCARD;
+  }
+  uint8_t* data = (uint8_t*)vbuf_->lock( start * vertex_size, ( end - start ) * vertex_size, lock_options );
+
+  uint32_t color;
+  Ogre::Root::getSingletonPtr()->convertColourValue( color_, &color );
+
+  float* fptr = (float*)data;
+  for( uint32_t i = start; i < end; i++ )
+  {
+    const Ogre::Vector3& p = points_[ i ];
+    *fptr++ = p.x;
+    *fptr++ = p.y;
+    *fptr++ = p.z;
+    memcpy( fptr, &color, sizeof( uint32_t ));
+    ++fptr;
+  }
+
+  vbuf_->unlock();
+}
+
+void Polyline::updateBounds()
+{
+  mBox.setNull();
+  for( uint32_t i = 0; i < points_.size(); i++ )
+  {
+    mBox.merge( points_[ i ]);
+  }
+}
+
+Ogre::Real Polyline::getBoundingRadius() const
+{
+  if( mBox.isNull() )
+  {
+    return 0.0f;
+  }
+  return Ogre::Math::Sqrt( std::max( mBox.getMaximum().squaredLength(), mBox.getMinimum().squaredLength() ));
+}
+
+Ogre::Real Polyline::getSquaredViewDepth( const Ogre::Camera* cam ) const
+{
+  return getParentSceneNode() ? getParentSceneNode()->getSquaredViewDepth( cam ) : 0.0f;
+}
+
+} // namespace rviz
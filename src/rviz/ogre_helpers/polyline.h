@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RVIZ_POLYLINE_H
+#define RVIZ_POLYLINE_H
+
+#include <stdint.h>
+
+#include <vector>
+
+#include <OGRE/OgreSimpleRenderable.h>
+#include <OGRE/OgreColourValue.h>
+#include <OGRE/OgreHardwareVertexBuffer.h>
+#include <OGRE/OgreVector3.h>
+
+namespace rviz
+{
+
+/**
+ * \class Polyline
+ * \brief A single line strip backed by a persistent dynamic vertex buffer.
+ *
+ * Unlike Ogre::ManualObject, the vertex buffer survives between
+ * updates.  setPoints() compares the new points against the ones
+ * currently in the buffer and only uploads the tail that changed, so
+ * a path which grows by a few poses per message costs a few vertices
+ * of bandwidth instead of a full rebuild.  Points are given in the
+ * local frame of the scene node the polyline is attached to; any
+ * transform should be applied to that node, not to the points.
+ */
+class Polyline : public Ogre::SimpleRenderable
+{
+public:
+  Polyline();
+  virtual ~Polyline();
+
+  /**
+   * \brief Set the points of the line strip, drawn in a single color.
+   *
+   * Only the vertices starting at the first point that differs from
+   * the previous call are written to the vertex buffer.  If the color
+   * changes, or the buffer has to grow, all vertices are rewritten.
+   */
+  void setPoints( const std::vector<Ogre::Vector3>& points, const Ogre::ColourValue& color );
+
+  /** \brief Remove all points.  Keeps the vertex buffer allocated. */
+  void clear();
+
+  uint32_t getNumPoints() const { return points_.size(); }
+
+  /** \brief Return the number of vertices the current vertex buffer can hold. */
+  uint32_t getCapacity() const { return capacity_; }
+
+  virtual Ogre::Real getBoundingRadius() const;
+  virtual Ogre::Real getSquaredViewDepth( const Ogre::Camera* cam ) const;
+
+private:
+  /** \brief Make sure the vertex buffer holds at least @a num_points vertices.
+   * @return true if the buffer was reallocated, which invalidates its content. */
+  bool reserve( uint32_t num_points );
+
+  /** \brief Write points [start, end) of points_ into the vertex buffer.
+   * @param append true if none of these vertices was part of the last draw. */
+  void writeVertices( uint32_t start, uint32_t end, bool append );
+
+  void updateBounds();
+
+  std::vector<Ogre::Vector3> points_;
+  Ogre::ColourValue color_;
+  uint32_t capacity_;
+  Ogre::HardwareVertexBufferSharedPtr vbuf_;
+};
+
+} // namespace rviz
+
+#endif // RVIZ_POLYLINE_H
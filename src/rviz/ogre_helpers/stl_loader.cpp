@@ -30,6 +30,11 @@
 #include "stl_loader.h"
 #include <ros/console.h>
 
+#include <string.h>
+
+#include <boost/functional/hash.hpp>
+#include <boost/unordered_map.hpp>
+
 #include <OGRE/OgreManualObject.h>
 
 namespace ogre_tools
@@ -162,47 +167,86 @@ void calculateUV(const Ogre::Vector3& vec, float& u, float& v)
 }
 
 
+namespace
+{
+
+/** @brief Position and normal of an STL vertex; the texture coordinate is derived from the position. */
+struct VertexKey
+{
+  float p[6];
+
+  bool operator==( const VertexKey& other ) const
+  {
+    return memcmp( p, other.p, sizeof( p )) == 0;
+  }
+};
+
+size_t hash_value( const VertexKey& key )
+{
+  size_t seed = 0;
+  for( int i = 0; i < 6; i++ )
+  {
+    boost::hash_combine( seed, key.p[ i ]);
+  }
+  return seed;
+}
+
+}
+
 Ogre::MeshPtr STLLoader::toMesh(const std::string& name)
 {
   Ogre::ManualObject* object = new Ogre::ManualObject( "the one and only" );
   object->begin( "BaseWhiteNoLighting", Ogre::RenderOperation::OT_TRIANGLE_LIST );
 
+  // STL stores three separate vertices per triangle.  Vertices with the
+  // same position and normal are shared, so flat regions and smooth
+  // meshes need far fewer vertices.
+  typedef boost::unordered_map<VertexKey, uint32_t> M_VertexToIndex;
+  M_VertexToIndex vertex_indices;
+
   unsigned int vertexCount = 0;
   V_Triangle::const_iterator it = triangles_.begin();
   V_Triangle::const_iterator end = triangles_.end();
   for (; it != end; ++it )
   {
-    if( vertexCount >= 2004 )
+    if( vertexCount >= 65536 - 3 )
     {
-      // Subdivide large meshes into submeshes with at most 2004
-      // vertices to prevent problems on some graphics cards.
+      // Subdivide large meshes into submeshes which fit 16-bit
+      // indices.
       object->end();
       object->begin( "BaseWhiteNoLighting", Ogre::RenderOperation::OT_TRIANGLE_LIST );
       vertexCount = 0;
+      vertex_indices.clear();
     }
 
     const STLLoader::Triangle& tri = *it;
 
-    float u, v;
-    u = v = 0.0f;
-    object->position( tri.vertices_[0] );
-    object->normal( tri.normal_);
-    calculateUV( tri.vertices_[0], u, v );
-    object->textureCoord( u, v );
-
-    object->position( tri.vertices_[1] );
-    object->normal( tri.normal_);
-    calculateUV( tri.vertices_[1], u, v );
-    object->textureCoord( u, v );
-
-    object->position( tri.vertices_[2] );
-    object->normal( tri.normal_);
-    calculateUV( tri.vertices_[2], u, v );
-    object->textureCoord( u, v );
-
-    object->triangle( vertexCount + 0, vertexCount + 1, vertexCount + 2 );
+    uint32_t indices[3];
+    for( int i = 0; i < 3; i++ )
+    {
+      VertexKey key;
+      key.p[0] = tri.vertices_[i].x;
+      key.p[1] = tri.vertices_[i].y;
+      key.p[2] = tri.vertices_[i].z;
+      key.p[3] = tri.normal_.x;
+      key.p[4] = tri.normal_.y;
+      key.p[5] = tri.normal_.z;
+
+      std::pair<M_VertexToIndex::iterator, bool> inserted = vertex_indices.insert( std::make_pair( key, vertexCount ));
+      if( inserted.second )
+      {
+        float u, v;
+        u = v = 0.0f;
+        object->position( tri.vertices_[i] );
+        object->normal( tri.normal_);
+        calculateUV( tri.vertices_[i], u, v );
+        object->textureCoord( u, v );
+        vertexCount++;
+      }
+      indices[i] = inserted.first->second;
+    }
 
-    vertexCount += 3;
+    object->triangle( indices[0], indices[1], indices[2] );
   }
 
   object->end();
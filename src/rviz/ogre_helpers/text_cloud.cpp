@@ -0,0 +1,724 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+
+#include <algorithm>
+#include <sstream>
+
+#include <OGRE/OgreCamera.h>
+#include <OGRE/OgreFont.h>
+#include <OGRE/OgreFontManager.h>
+#include <OGRE/OgreHardwareBufferManager.h>
+#include <OGRE/OgreMaterialManager.h>
+#include <OGRE/OgrePass.h>
+#include <OGRE/OgreRenderQueue.h>
+#include <OGRE/OgreRoot.h>
+#include <OGRE/OgreSceneNode.h>
+#include <OGRE/OgreTechnique.h>
+#include <OGRE/OgreTextureUnitState.h>
+
+#include <ros/assert.h>
+
+#include "rviz/ogre_helpers/text_cloud.h"
+
+#define MIN_GLYPH_CAPACITY 256
+#define VERTICES_PER_GLYPH 6
+
+// Beyond this many changed labels per frame, rewriting the whole
+// buffer with one discarding lock is cheaper than many small locks.
+#define MAX_PARTIAL_WRITES 16
+
+namespace rviz
+{
+
+Ogre::String TextCloud::sm_Type = "TextCloud";
+
+TextCloud::Label::Label()
+  : position( Ogre::Vector3::ZERO )
+  , color( Ogre::ColourValue::White )
+  , pick_color( Ogre::ColourValue::Black )
+  , char_height( 0.1f )
+  , horizontal( H_LEFT )
+  , vertical( V_BELOW )
+  , visible( true )
+  , alive( true )
+  , dirty( false )
+  , first_glyph( 0 )
+  , glyph_capacity( 0 )
+{
+}
+
+TextCloud::TextCloud( const Ogre::String& font_name )
+  : renderable_( 0 )
+  , used_glyphs_( 0 )
+  , wasted_glyphs_( 0 )
+  , glyph_capacity_( 0 )
+  , needs_regenerate_( false )
+  , max_label_extent_( 0.0f )
+  , bounding_radius_( 0.0f )
+{
+  font_ = (Ogre::Font*)Ogre::FontManager::getSingleton().getByName( font_name ).getPointer();
+  if( !font_ )
+  {
+    throw Ogre::Exception( Ogre::Exception::ERR_ITEM_NOT_FOUND, "Could not find font " + font_name, "TextCloud::TextCloud" );
+  }
+  font_->load();
+  space_width_ = font_->getGlyphAspectRatio( 'A' );
+
+  static int count = 0;
+  std::stringstream ss;
+  ss << "TextCloudMaterial" << count++;
+
+  // The font texture is the glyph atlas for every label of this cloud.
+  Ogre::String atlas = font_->getMaterial()->getTechnique( 0 )->getPass( 0 )->getTextureUnitState( 0 )->getTextureName();
+
+  material_ = Ogre::MaterialManager::getSingleton().getByName( "rviz/TextCloud" );
+  material_ = material_->clone( ss.str() );
+  for( unsigned short i = 0; i < material_->getNumTechniques(); i++ )
+  {
+    material_->getTechnique( i )->getPass( 0 )->getTextureUnitState( 0 )->setTextureName( atlas );
+  }
+  material_->load();
+
+  anchor_box_.setNull();
+  bounding_box_.setNull();
+}
+
+TextCloud::~TextCloud()
+{
+  delete renderable_;
+
+  material_->unload();
+  Ogre::MaterialManager::getSingleton().remove( material_->getName() );
+}
+
+TextCloud::Label& TextCloud::getLabel( uint32_t id )
+{
+  ROS_ASSERT_MSG( id < labels_.size() && labels_[ id ].alive, "Invalid text label id %u", id );
+  return labels_[ id ];
+}
+
+uint32_t TextCloud::createLabel()
+{
+  uint32_t id;
+  if( free_ids_.empty() )
+  {
+    id = labels_.size();
+    labels_.push_back( Label() );
+  }
+  else
+  {
+    id = free_ids_.back();
+    free_ids_.pop_back();
+    labels_[ id ] = Label();
+  }
+  return id;
+}
+
+void TextCloud::destroyLabel( uint32_t id )
+{
+  Label& label = getLabel( id );
+  releaseGlyphs( label );
+  label.alive = false;
+  label.caption.clear();
+  free_ids_.push_back( id );
+}
+
+void TextCloud::setCaption( uint32_t id, const Ogre::String& caption )
+{
+  Label& label = getLabel( id );
+  if( caption == label.caption )
+  {
+    return;
+  }
+  label.caption = caption;
+  if( countGlyphs( caption ) > label.glyph_capacity )
+  {
+    allocateGlyphs( label );
+  }
+  markDirty( id );
+  growBounds( label );
+}
+
+void TextCloud::setPosition( uint32_t id, const Ogre::Vector3& position )
+{
+  Label& label = getLabel( id );
+  if( position == label.position )
+  {
+    return;
+  }
+  label.position = position;
+  markDirty( id );
+  growBounds( label );
+}
+
+void TextCloud::setColor( uint32_t id, const Ogre::ColourValue& color )
+{
+  Label& label = getLabel( id );
+  if( color == label.color )
+  {
+    return;
+  }
+  label.color = color;
+  markDirty( id );
+}
+
+void TextCloud::setCharacterHeight( uint32_t id, float height )
+{
+  Label& label = getLabel( id );
+  if( height == label.char_height )
+  {
+    return;
+  }
+  label.char_height = height;
+  markDirty( id );
+  growBounds( label );
+}
+
+void TextCloud::setAlignment( uint32_t id, HorizontalAlignment horizontal, VerticalAlignment vertical )
+{
+  Label& label = getLabel( id );
+  if( horizontal == label.horizontal && vertical == label.vertical )
+  {
+    return;
+  }
+  label.horizontal = horizontal;
+  label.vertical = vertical;
+  markDirty( id );
+}
+
+void TextCloud::setLabelVisible( uint32_t id, bool visible )
+{
+  Label& label = getLabel( id );
+  if( visible == label.visible )
+  {
+    return;
+  }
+  label.visible = visible;
+  markDirty( id );
+}
+
+void TextCloud::setPickColor( uint32_t id, const Ogre::ColourValue& color )
+{
+  Label& label = getLabel( id );
+  if( color == label.pick_color )
+  {
+    return;
+  }
+  label.pick_color = color;
+  markDirty( id );
+}
+
+void TextCloud::clear()
+{
+  labels_.clear();
+  free_ids_.clear();
+  dirty_ids_.clear();
+  released_ranges_.clear();
+  used_glyphs_ = 0;
+  wasted_glyphs_ = 0;
+  needs_regenerate_ = false;
+
+  if( renderable_ )
+  {
+    renderable_->getRenderOperation()->vertexData->vertexCount = 0;
+  }
+  updateBounds();
+}
+
+void TextCloud::markDirty( uint32_t id )
+{
+  Label& label = labels_[ id ];
+  if( !label.dirty )
+  {
+    label.dirty = true;
+    dirty_ids_.push_back( id );
+  }
+}
+
+void TextCloud::allocateGlyphs( Label& label )
+{
+  releaseGlyphs( label );
+
+  uint32_t count = countGlyphs( label.caption );
+  if( needs_regenerate_ || used_glyphs_ + count > glyph_capacity_ )
+  {
+    // regenerateAll() hands out fresh ranges to every label.
+    needs_regenerate_ = true;
+    return;
+  }
+
+  label.first_glyph = used_glyphs_;
+  label.glyph_capacity = count;
+  used_glyphs_ += count;
+}
+
+void TextCloud::releaseGlyphs( Label& label )
+{
+  if( label.glyph_capacity == 0 )
+  {
+    return;
+  }
+
+  GlyphRange range = { label.first_glyph, label.glyph_capacity };
+  released_ranges_.push_back( range );
+  wasted_glyphs_ += label.glyph_capacity;
+  label.glyph_capacity = 0;
+}
+
+uint32_t TextCloud::countGlyphs( const Ogre::String& caption ) const
+{
+  uint32_t count = 0;
+  for( Ogre::String::const_iterator it = caption.begin(); it != caption.end(); ++it )
+  {
+    if( *it != ' ' && *it != '\n' )
+    {
+      count++;
+    }
+  }
+  return count;
+}
+
+/** Per-vertex layout; must match the declaration in TextCloudRenderable. */
+static inline float* writeVertex( float* ptr, const Ogre::Vector3& anchor, float u, float v,
+                                  float offset_x, float offset_y, uint32_t color, uint32_t pick_color )
+{
+  *ptr++ = anchor.x;
+  *ptr++ = anchor.y;
+  *ptr++ = anchor.z;
+  *ptr++ = u;
+  *ptr++ = v;
+  *ptr++ = offset_x;
+  *ptr++ = offset_y;
+  memcpy( ptr++, &color, sizeof( uint32_t ));
+  memcpy( ptr++, &pick_color, sizeof( uint32_t ));
+  return ptr;
+}
+
+void TextCloud::writeLabel( const Label& label, float* vertices ) const
+{
+  size_t glyph_size = renderable_->getBuffer()->getVertexSize() * VERTICES_PER_GLYPH;
+  uint32_t written = 0;
+
+  if( label.visible && !label.caption.empty() )
+  {
+    Ogre::Root* root = Ogre::Root::getSingletonPtr();
+    uint32_t color;
+    uint32_t pick_color;
+    root->convertColourValue( label.color, &color );
+    root->convertColourValue( label.pick_color, &pick_color );
+
+    const Ogre::String& caption = label.caption;
+    float height = label.char_height;
+    float space = space_width_ * height;
+
+    // Measure the text block for alignment, the same way MovableText does.
+    float total_height = height;
+    float total_width = 0.0f;
+    float line_width = 0.0f;
+    for( Ogre::String::const_iterator it = caption.begin(); it != caption.end(); ++it )
+    {
+      if( *it == '\n' )
+      {
+        total_height += height;
+        total_width = std::max( total_width, line_width );
+        line_width = 0.0f;
+      }
+      else
+      {
+        line_width += ( *it == ' ' ) ? space : font_->getGlyphAspectRatio( *it ) * height;
+      }
+    }
+    total_width = std::max( total_width, line_width );
+
+    float top = 0.0f;
+    switch( label.vertical )
+    {
+    case V_ABOVE:  top = total_height; break;
+    case V_CENTER: top = 0.5f * total_height; break;
+    case V_BELOW:  top = 0.0f; break;
+    }
+    float start_left = ( label.horizontal == H_CENTER ) ? -0.5f * total_width : 0.0f;
+
+    float left = start_left;
+    float* ptr = vertices;
+    for( Ogre::String::const_iterator it = caption.begin(); it != caption.end(); ++it )
+    {
+      if( *it == '\n' )
+      {
+        left = start_left;
+        top -= height;
+        continue;
+      }
+      if( *it == ' ' )
+      {
+        left += space;
+        continue;
+      }
+
+      const Ogre::Font::UVRect& uv = font_->getGlyphTexCoords( *it );
+      float right = left + font_->getGlyphAspectRatio( *it ) * height;
+      float bottom = top - height;
+      const Ogre::Vector3& p = label.position;
+
+      ptr = writeVertex( ptr, p, uv.left, uv.top, left, top, color, pick_color );
+      ptr = writeVertex( ptr, p, uv.left, uv.bottom, left, bottom, color, pick_color );
+      ptr = writeVertex( ptr, p, uv.right, uv.top, right, top, color, pick_color );
+      ptr = writeVertex( ptr, p, uv.right, uv.top, right, top, color, pick_color );
+      ptr = writeVertex( ptr, p, uv.left, uv.bottom, left, bottom, color, pick_color );
+      ptr = writeVertex( ptr, p, uv.right, uv.bottom, right, bottom, color, pick_color );
+
+      left = right;
+      written++;
+    }
+  }
+
+  // Unused glyphs of the range collapse to a point and produce no fragments.
+  if( written < label.glyph_capacity )
+  {
+    memset( (char*)vertices + written * glyph_size, 0, ( label.glyph_capacity - written ) * glyph_size );
+  }
+}
+
+void TextCloud::update()
+{
+  // Compact once more than half of the buffer is released ranges.
+  if( needs_regenerate_ || !renderable_ || wasted_glyphs_ * 2 > used_glyphs_ )
+  {
+    regenerateAll();
+    return;
+  }
+
+  if( dirty_ids_.empty() && released_ranges_.empty() )
+  {
+    return;
+  }
+
+  uint32_t dirty_glyphs = 0;
+  for( size_t i = 0; i < dirty_ids_.size(); i++ )
+  {
+    dirty_glyphs += labels_[ dirty_ids_[ i ] ].glyph_capacity;
+  }
+  for( size_t i = 0; i < released_ranges_.size(); i++ )
+  {
+    dirty_glyphs += released_ranges_[ i ].count;
+  }
+
+  if( dirty_ids_.size() + released_ranges_.size() > MAX_PARTIAL_WRITES || dirty_glyphs * 4 > used_glyphs_ )
+  {
+    regenerateAll();
+    return;
+  }
+
+  Ogre::HardwareVertexBufferSharedPtr vbuf = renderable_->getBuffer();
+  Ogre::RenderOperation* op = renderable_->getRenderOperation();
+  size_t glyph_size = vbuf->getVertexSize() * VERTICES_PER_GLYPH;
+  uint32_t drawn_glyphs = op->vertexData->vertexCount / VERTICES_PER_GLYPH;
+
+  for( size_t i = 0; i < released_ranges_.size(); i++ )
+  {
+    const GlyphRange& range = released_ranges_[ i ];
+    if( range.first >= drawn_glyphs )
+    {
+      continue;
+    }
+    void* data = vbuf->lock( range.first * glyph_size, range.count * glyph_size, Ogre::HardwareBuffer::HBL_NORMAL );
+    memset( data, 0, range.count * glyph_size );
+    vbuf->unlock();
+  }
+  released_ranges_.clear();
+
+  for( size_t i = 0; i < dirty_ids_.size(); i++ )
+  {
+    Label& label = labels_[ dirty_ids_[ i ] ];
+    label.dirty = false;
+    if( !label.alive || label.glyph_capacity == 0 )
+    {
+      continue;
+    }
+
+    // Ranges past the drawn vertices are not used by any pending draw.
+    Ogre::HardwareBuffer::LockOptions lock_options = label.first_glyph >= drawn_glyphs ?
+      Ogre::HardwareBuffer::HBL_NO_OVERWRITE : Ogre::HardwareBuffer::HBL_NORMAL;
+    float* data = (float*)vbuf->lock( label.first_glyph * glyph_size, label.glyph_capacity * glyph_size, lock_options );
+    writeLabel( label, data );
+    vbuf->unlock();
+  }
+  dirty_ids_.clear();
+
+  op->vertexData->vertexCount = used_glyphs_ * VERTICES_PER_GLYPH;
+}
+
+void TextCloud::regenerateAll()
+{
+  uint32_t needed = 0;
+  for( size_t i = 0; i < labels_.size(); i++ )
+  {
+    if( labels_[ i ].alive )
+    {
+      needed += countGlyphs( labels_[ i ].caption );
+    }
+  }
+
+  if( !renderable_ || needed > glyph_capacity_ )
+  {
+    uint32_t capacity = std::max<uint32_t>( glyph_capacity_, MIN_GLYPH_CAPACITY );
+    while( capacity < needed )
+    {
+      capacity *= 2;
+    }
+
+    delete renderable_;
+    renderable_ = new TextCloudRenderable( this, capacity * VERTICES_PER_GLYPH );
+    renderable_->setMaterial( material_->getName() );
+    glyph_capacity_ = capacity;
+  }
+
+  Ogre::HardwareVertexBufferSharedPtr vbuf = renderable_->getBuffer();
+  size_t glyph_size = vbuf->getVertexSize() * VERTICES_PER_GLYPH;
+  char* data = 0;
+  if( needed > 0 )
+  {
+    data = (char*)vbuf->lock( 0, needed * glyph_size, Ogre::HardwareBuffer::HBL_DISCARD );
+  }
+
+  uint32_t first = 0;
+  for( size_t i = 0; i < labels_.size(); i++ )
+  {
+    Label& label = labels_[ i ];
+    label.dirty = false;
+    if( !label.alive )
+    {
+      continue;
+    }
+    label.first_glyph = first;
+    label.glyph_capacity = countGlyphs( label.caption );
+    if( label.glyph_capacity > 0 )
+    {
+      writeLabel( label, (float*)( data + first * glyph_size ));
+    }
+    first += label.glyph_capacity;
+  }
+
+  if( data )
+  {
+    vbuf->unlock();
+  }
+
+  used_glyphs_ = needed;
+  wasted_glyphs_ = 0;
+  needs_regenerate_ = false;
+  released_ranges_.clear();
+  dirty_ids_.clear();
+
+  renderable_->getRenderOperation()->vertexData->vertexCount = used_glyphs_ * VERTICES_PER_GLYPH;
+  updateBounds();
+}
+
+void TextCloud::growBounds( const Label& label )
+{
+  // Glyphs extend in the view plane, so the label can reach as far as
+  // the diagonal of its text block in any direction.
+  float width = 0.0f;
+  float line_width = 0.0f;
+  uint32_t lines = 1;
+  for( Ogre::String::const_iterator it = label.caption.begin(); it != label.caption.end(); ++it )
+  {
+    if( *it == '\n' )
+    {
+      lines++;
+      width = std::max( width, line_width );
+      line_width = 0.0f;
+    }
+    else
+    {
+      line_width += ( *it == ' ' ) ? space_width_ : font_->getGlyphAspectRatio( *it );
+    }
+  }
+  width = std::max( width, line_width );
+  float extent = Ogre::Math::Sqrt( width * width + lines * lines ) * label.char_height;
+
+  anchor_box_.merge( label.position );
+  max_label_extent_ = std::max( max_label_extent_, extent );
+
+  Ogre::Vector3 extent3( max_label_extent_, max_label_extent_, max_label_extent_ );
+  bounding_box_.setExtents( anchor_box_.getMinimum() - extent3, anchor_box_.getMaximum() + extent3 );
+  bounding_radius_ = Ogre::Math::Sqrt( std::max( bounding_box_.getMaximum().squaredLength(),
+                                                 bounding_box_.getMinimum().squaredLength() ));
+  if( renderable_ )
+  {
+    renderable_->setBoundingBox( bounding_box_ );
+  }
+  if( getParentSceneNode() )
+  {
+    getParentSceneNode()->needUpdate();
+  }
+}
+
+void TextCloud::updateBounds()
+{
+  anchor_box_.setNull();
+  bounding_box_.setNull();
+  max_label_extent_ = 0.0f;
+  bounding_radius_ = 0.0f;
+
+  for( size_t i = 0; i < labels_.size(); i++ )
+  {
+    if( labels_[ i ].alive && !labels_[ i ].caption.empty() )
+    {
+      growBounds( labels_[ i ] );
+    }
+  }
+
+  if( renderable_ && bounding_box_.isNull() )
+  {
+    renderable_->setBoundingBox( bounding_box_ );
+  }
+  if( getParentSceneNode() )
+  {
+    getParentSceneNode()->needUpdate();
+  }
+}
+
+const Ogre::AxisAlignedBox& TextCloud::getBoundingBox() const
+{
+  return bounding_box_;
+}
+
+float TextCloud::getBoundingRadius() const
+{
+  return bounding_radius_;
+}
+
+void TextCloud::getWorldTransforms( Ogre::Matrix4* xform ) const
+{
+  *xform = _getParentNodeFullTransform();
+}
+
+void TextCloud::_updateRenderQueue( Ogre::RenderQueue* queue )
+{
+  update();
+
+  if( renderable_ && renderable_->getRenderOperation()->vertexData->vertexCount > 0 )
+  {
+    queue->addRenderable( renderable_ );
+  }
+}
+
+#if (OGRE_VERSION_MAJOR >= 1 && OGRE_VERSION_MINOR >= 6)
+void TextCloud::visitRenderables( Ogre::Renderable::Visitor* visitor, bool debugRenderables )
+{
+  if( renderable_ )
+  {
+    visitor->visit( renderable_, 0, debugRenderables );
+  }
+}
+#endif
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TextCloudRenderable::TextCloudRenderable( TextCloud* parent, uint32_t num_vertices )
+  : parent_( parent )
+{
+  mRenderOp.operationType = Ogre::RenderOperation::OT_TRIANGLE_LIST;
+  mRenderOp.useIndexes = false;
+  mRenderOp.vertexData = new Ogre::VertexData;
+  mRenderOp.vertexData->vertexStart = 0;
+  mRenderOp.vertexData->vertexCount = 0;
+
+  Ogre::VertexDeclaration* decl = mRenderOp.vertexData->vertexDeclaration;
+  size_t offset = 0;
+
+  // label anchor, shared by all vertices of the label
+  decl->addElement( 0, offset, Ogre::VET_FLOAT3, Ogre::VES_POSITION );
+  offset += Ogre::VertexElement::getTypeSize( Ogre::VET_FLOAT3 );
+
+  // glyph atlas coordinates
+  decl->addElement( 0, offset, Ogre::VET_FLOAT2, Ogre::VES_TEXTURE_COORDINATES, 0 );
+  offset += Ogre::VertexElement::getTypeSize( Ogre::VET_FLOAT2 );
+
+  // corner offset from the anchor, in the view plane
+  decl->addElement( 0, offset, Ogre::VET_FLOAT2, Ogre::VES_TEXTURE_COORDINATES, 1 );
+  offset += Ogre::VertexElement::getTypeSize( Ogre::VET_FLOAT2 );
+
+  decl->addElement( 0, offset, Ogre::VET_COLOUR, Ogre::VES_DIFFUSE );
+  offset += Ogre::VertexElement::getTypeSize( Ogre::VET_COLOUR );
+
+  // pick color, only read by the selection technique
+  decl->addElement( 0, offset, Ogre::VET_COLOUR, Ogre::VES_SPECULAR );
+
+  Ogre::HardwareVertexBufferSharedPtr vbuf =
+    Ogre::HardwareBufferManager::getSingleton().createVertexBuffer(
+      mRenderOp.vertexData->vertexDeclaration->getVertexSize( 0 ),
+      num_vertices,
+      Ogre::HardwareBuffer::HBU_DYNAMIC );
+
+  mRenderOp.vertexData->vertexBufferBinding->setBinding( 0, vbuf );
+
+  mBox.setNull();
+}
+
+TextCloudRenderable::~TextCloudRenderable()
+{
+  delete mRenderOp.vertexData;
+  delete mRenderOp.indexData;
+}
+
+Ogre::HardwareVertexBufferSharedPtr TextCloudRenderable::getBuffer()
+{
+  return mRenderOp.vertexData->vertexBufferBinding->getBuffer( 0 );
+}
+
+Ogre::Real TextCloudRenderable::getBoundingRadius() const
+{
+  return parent_->getBoundingRadius();
+}
+
+Ogre::Real TextCloudRenderable::getSquaredViewDepth( const Ogre::Camera* cam ) const
+{
+  Ogre::Vector3 center = mBox.isNull() ? Ogre::Vector3::ZERO : mBox.getCenter();
+  Ogre::Matrix4 xform;
+  getWorldTransforms( &xform );
+  return ( cam->getDerivedPosition() - xform * center ).squaredLength();
+}
+
+void TextCloudRenderable::getWorldTransforms( Ogre::Matrix4* xform ) const
+{
+  parent_->getWorldTransforms( xform );
+}
+
+const Ogre::LightList& TextCloudRenderable::getLights() const
+{
+  return parent_->queryLights();
+}
+
+} // namespace rviz
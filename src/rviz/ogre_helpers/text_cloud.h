@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RVIZ_TEXT_CLOUD_H
+#define RVIZ_TEXT_CLOUD_H
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include <OGRE/OgreAxisAlignedBox.h>
+#include <OGRE/OgreColourValue.h>
+#include <OGRE/OgreHardwareVertexBuffer.h>
+#include <OGRE/OgreMaterial.h>
+#include <OGRE/OgreMovableObject.h>
+#include <OGRE/OgreSimpleRenderable.h>
+#include <OGRE/OgreVector3.h>
+
+namespace Ogre
+{
+class RenderQueue;
+class Camera;
+class Font;
+}
+
+namespace rviz
+{
+
+class TextCloud;
+
+class TextCloudRenderable : public Ogre::SimpleRenderable
+{
+public:
+  TextCloudRenderable( TextCloud* parent, uint32_t num_vertices );
+  ~TextCloudRenderable();
+
+  Ogre::HardwareVertexBufferSharedPtr getBuffer();
+
+  virtual Ogre::Real getBoundingRadius() const;
+  virtual Ogre::Real getSquaredViewDepth( const Ogre::Camera* cam ) const;
+  virtual unsigned short getNumWorldTransforms() const { return 1; }
+  virtual void getWorldTransforms( Ogre::Matrix4* xform ) const;
+  virtual const Ogre::LightList& getLights() const;
+
+private:
+  TextCloud* parent_;
+};
+
+/**
+ * \class TextCloud
+ * \brief Draws many camera-facing text labels in a single batch.
+ *
+ * All labels share one font, and therefore one glyph atlas: the font
+ * texture Ogre renders the glyphs into.  Every glyph is a quad in one
+ * dynamic vertex buffer, which holds the label anchor, the atlas
+ * coordinates and the corner offset in the view plane.  The vertex
+ * shader does the billboarding, so moving the camera never touches
+ * the buffer, and the whole cloud is drawn with one batch no matter
+ * how many labels it holds.
+ *
+ * Each label owns a contiguous range of glyphs in the buffer.  Changes
+ * are collected and written at render time; changing a color or a
+ * position rewrites only the glyphs of that label.  A caption that no
+ * longer fits its range moves to the end of the buffer, and the buffer
+ * is compacted once more than half of it is unused.
+ *
+ * Labels are identified by the id returned from createLabel().
+ */
+class TextCloud : public Ogre::MovableObject
+{
+public:
+  enum HorizontalAlignment
+  {
+    H_LEFT, H_CENTER
+  };
+  enum VerticalAlignment
+  {
+    V_BELOW, V_ABOVE, V_CENTER
+  };
+
+  TextCloud( const Ogre::String& font_name = "Arial" );
+  ~TextCloud();
+
+  /** @return The id of a new label with an empty caption. */
+  uint32_t createLabel();
+  void destroyLabel( uint32_t id );
+
+  void setCaption( uint32_t id, const Ogre::String& caption );
+  void setPosition( uint32_t id, const Ogre::Vector3& position );
+  void setColor( uint32_t id, const Ogre::ColourValue& color );
+  /** \brief Set the height of one line of text, in world units. */
+  void setCharacterHeight( uint32_t id, float height );
+  void setAlignment( uint32_t id, HorizontalAlignment horizontal, VerticalAlignment vertical );
+  void setLabelVisible( uint32_t id, bool visible );
+  /** \brief Set the color written during selection rendering.  Defaults to black, which picks nothing. */
+  void setPickColor( uint32_t id, const Ogre::ColourValue& color );
+
+  /** \brief Remove all labels.  Keeps the vertex buffer allocated. */
+  void clear();
+
+  uint32_t getNumLabels() const { return labels_.size() - free_ids_.size(); }
+
+  const Ogre::MaterialPtr& getMaterial() const { return material_; }
+
+  virtual const Ogre::String& getMovableType() const { return sm_Type; }
+  virtual const Ogre::AxisAlignedBox& getBoundingBox() const;
+  virtual float getBoundingRadius() const;
+  virtual void getWorldTransforms( Ogre::Matrix4* xform ) const;
+  virtual unsigned short getNumWorldTransforms() const { return 1; }
+  virtual void _updateRenderQueue( Ogre::RenderQueue* queue );
+#if (OGRE_VERSION_MAJOR >= 1 && OGRE_VERSION_MINOR >= 6)
+  virtual void visitRenderables( Ogre::Renderable::Visitor* visitor, bool debugRenderables );
+#endif
+
+private:
+  struct Label
+  {
+    Label();
+
+    Ogre::String caption;
+    Ogre::Vector3 position;
+    Ogre::ColourValue color;
+    Ogre::ColourValue pick_color;
+    float char_height;
+    HorizontalAlignment horizontal;
+    VerticalAlignment vertical;
+    bool visible;
+    bool alive;
+    bool dirty;
+
+    /// Range of glyphs this label owns in the vertex buffer.
+    uint32_t first_glyph;
+    uint32_t glyph_capacity;
+  };
+
+  Label& getLabel( uint32_t id );
+  void markDirty( uint32_t id );
+
+  /** \brief Give a label a glyph range large enough for its caption. */
+  void allocateGlyphs( Label& label );
+  /** \brief Give up the glyph range of a label; it is cleared on the next update. */
+  void releaseGlyphs( Label& label );
+
+  uint32_t countGlyphs( const Ogre::String& caption ) const;
+  /** \brief Write the glyphs of @a label to @a vertices, padding its whole range with degenerate quads. */
+  void writeLabel( const Label& label, float* vertices ) const;
+
+  /** \brief Upload all pending changes to the vertex buffer. */
+  void update();
+  /** \brief Pack all labels to the front of the buffer and rewrite it. */
+  void regenerateAll();
+
+  void growBounds( const Label& label );
+  void updateBounds();
+
+  Ogre::Font* font_;
+  float space_width_;  ///< Width of a space for a character height of 1.
+  Ogre::MaterialPtr material_;
+  TextCloudRenderable* renderable_;
+
+  std::vector<Label> labels_;
+  std::vector<uint32_t> free_ids_;
+  std::vector<uint32_t> dirty_ids_;
+
+  struct GlyphRange
+  {
+    uint32_t first;
+    uint32_t count;
+  };
+  std::vector<GlyphRange> released_ranges_;
+
+  uint32_t used_glyphs_;      ///< End of the last allocated range.
+  uint32_t wasted_glyphs_;    ///< Glyphs in released ranges.
+  uint32_t glyph_capacity_;   ///< Size of the vertex buffer, in glyphs.
+  bool needs_regenerate_;
+
+  Ogre::AxisAlignedBox anchor_box_;
+  float max_label_extent_;
+  Ogre::AxisAlignedBox bounding_box_;
+  float bounding_radius_;
+
+  static Ogre::String sm_Type;
+};
+
+} // namespace rviz
+
+#endif // RVIZ_TEXT_CLOUD_H
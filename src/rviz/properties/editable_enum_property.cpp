@@ -66,11 +66,30 @@ QWidget* EditableEnumProperty::createEditor( QWidget* parent,
   cb->addItems( strings_ );
   cb->setEditText( getValue().toString() );
   QObject::connect( cb, SIGNAL( currentIndexChanged( const QString& )), this, SLOT( setString( const QString& )));
+  editor_ = cb;
 
   // TODO: need to better handle string value which is not in list.
   return cb;
 }
 
+void EditableEnumProperty::refreshOptions()
+{
+  if( !editor_ )
+  {
+    return;
+  }
+  Q_EMIT requestOptions( this );
+
+  // Rebuilding the list must neither change the value nor lose what
+  // the user is typing.
+  QString text = editor_->currentText();
+  editor_->blockSignals( true );
+  editor_->clear();
+  editor_->addItems( strings_ );
+  editor_->setEditText( text );
+  editor_->blockSignals( false );
+}
+
 void EditableEnumProperty::setString( const QString& str )
 {
   setValue( str );
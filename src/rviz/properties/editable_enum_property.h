@@ -29,8 +29,10 @@
 #ifndef EDITABLE_ENUM_PROPERTY_H
 #define EDITABLE_ENUM_PROPERTY_H
 
+#include <QPointer>
 #include <QStringList>
 
+#include "rviz/properties/editable_combo_box.h"
 #include "rviz/properties/string_property.h"
 
 namespace rviz
@@ -65,6 +67,10 @@ public:
 public Q_SLOTS:
   virtual void setString( const QString& str );
 
+  /** @brief If an editor is open, emit requestOptions() again and
+   * show the new option list in it, keeping the text being edited. */
+  void refreshOptions();
+
 Q_SIGNALS:
   /** @brief requestOptions() is emitted each time createEditor() is
    * called.
@@ -80,6 +86,9 @@ Q_SIGNALS:
 
 protected:
   QStringList strings_;
+
+private:
+  QPointer<EditableComboBox> editor_; ///< Editor made by the last createEditor(), while it exists.
 };
 
 } // end namespace rviz
@@ -77,11 +77,28 @@ QWidget* EnumProperty::createEditor( QWidget* parent,
   cb->addItems( strings_ );
   cb->setCurrentIndex( strings_.indexOf( getValue().toString() ));
   QObject::connect( cb, SIGNAL( currentIndexChanged( const QString& )), this, SLOT( setString( const QString& )));
+  editor_ = cb;
 
   // TODO: need to better handle string value which is not in list.
   return cb;
 }
 
+void EnumProperty::refreshOptions()
+{
+  if( !editor_ )
+  {
+    return;
+  }
+  Q_EMIT requestOptions( this );
+
+  // Rebuilding the list must not change the value.
+  editor_->blockSignals( true );
+  editor_->clear();
+  editor_->addItems( strings_ );
+  editor_->setCurrentIndex( strings_.indexOf( getValue().toString() ));
+  editor_->blockSignals( false );
+}
+
 void EnumProperty::setString( const QString& str )
 {
   setValue( str );
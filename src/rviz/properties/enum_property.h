@@ -29,8 +29,10 @@
 #ifndef ENUM_PROPERTY_H
 #define ENUM_PROPERTY_H
 
+#include <QPointer>
 #include <QStringList>
 
+#include "rviz/properties/combo_box.h"
 #include "rviz/properties/string_property.h"
 
 namespace rviz
@@ -81,6 +83,11 @@ public Q_SLOTS:
   /** @brief Sort the option strings.  Does not change string/int associations. */
   void sortOptions() { strings_.sort(); }
 
+  /** @brief If an editor is open, emit requestOptions() again and
+   * show the new option list in it.  For option lists which change
+   * while the dropdown is shown. */
+  void refreshOptions();
+
 Q_SIGNALS:
   /** @brief requestOptions() is emitted each time createEditor() is
    * called.
@@ -97,6 +104,7 @@ Q_SIGNALS:
 private:
   QStringList strings_;
   QHash<QString, int> ints_;
+  QPointer<ComboBox> editor_; ///< Editor made by the last createEditor(), while it exists.
 };
 
 } // end namespace rviz
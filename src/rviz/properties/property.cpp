@@ -95,6 +95,10 @@ Property::~Property()
     child->setParent( NULL );
     delete child;
   }
+  if( model_ )
+  {
+    model_->forgetProperty( this );
+  }
 }
 
 void Property::removeChildren( int start_index, int count )
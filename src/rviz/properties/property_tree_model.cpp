@@ -31,6 +31,7 @@
 
 #include <QStringList>
 #include <QMimeData>
+#include <QTimer>
 
 #include "rviz/properties/property.h"
 
@@ -39,10 +40,22 @@
 namespace rviz
 {
 
+/** Number of children of one property given rows at a time. */
+static const int FETCH_BATCH_SIZE = 100;
+
+/** Milliseconds over which dataChanged() signals are coalesced.  The
+ * tree widget repaints at this rate anyway. */
+static const int DATA_CHANGED_INTERVAL = 100;
+
 PropertyTreeModel::PropertyTreeModel( Property* root_property, QObject* parent )
   : QAbstractItemModel( parent )
   , root_property_( root_property )
+  , data_changed_timer_( new QTimer( this ))
 {
+  data_changed_timer_->setSingleShot( true );
+  data_changed_timer_->setInterval( DATA_CHANGED_INTERVAL );
+  connect( data_changed_timer_, SIGNAL( timeout() ), this, SLOT( emitPendingDataChanged() ));
+
   root_property_->setModel( this );
 }
 
@@ -81,6 +94,10 @@ QModelIndex PropertyTreeModel::index( int row, int column, const QModelIndex& pa
     return QModelIndex();
   }
   Property* parent = getProp( parent_index );
+  if( row >= rowLimit( parent ))
+  {
+    return QModelIndex();
+  }
 
   Property* child = parent->childAt( row );
   if( child )
@@ -119,7 +136,75 @@ QModelIndex PropertyTreeModel::parentIndex( const Property* child ) const
 
 int PropertyTreeModel::rowCount( const QModelIndex& parent_index ) const
 {
-  return getProp( parent_index )->numChildren();
+  Property* parent = getProp( parent_index );
+  return qMin( parent->numChildren(), rowLimit( parent ));
+}
+
+bool PropertyTreeModel::canFetchMore( const QModelIndex& parent_index ) const
+{
+  Property* parent = getProp( parent_index );
+  return parent->numChildren() > rowLimit( parent );
+}
+
+void PropertyTreeModel::fetchMore( const QModelIndex& parent_index )
+{
+  Property* parent = getProp( parent_index );
+  int num_rows = rowCount( parent_index );
+  int count = qMin( parent->numChildren() - num_rows, FETCH_BATCH_SIZE );
+  if( count <= 0 )
+  {
+    return;
+  }
+
+  beginInsertRows( parent_index, num_rows, num_rows + count - 1 );
+  setRowLimit( parent, num_rows + count );
+  endInsertRows();
+
+  // Hidden-state changes of these properties were dropped while they
+  // had no rows, so send them again.
+  for( int i = num_rows; i < num_rows + count; i++ )
+  {
+    parent->childAtUnchecked( i )->setModel( this );
+  }
+}
+
+int PropertyTreeModel::rowLimit( const Property* parent ) const
+{
+  return row_limits_.value( parent, FETCH_BATCH_SIZE );
+}
+
+void PropertyTreeModel::setRowLimit( const Property* parent, int limit )
+{
+  int num_children = parent->numChildren();
+  if( qMin( num_children, limit ) == qMin( num_children, FETCH_BATCH_SIZE ))
+  {
+    // The default gives the same row count.
+    row_limits_.remove( parent );
+  }
+  else
+  {
+    row_limits_[ parent ] = limit;
+  }
+}
+
+void PropertyTreeModel::forgetProperty( const Property* property )
+{
+  row_limits_.remove( property );
+  pending_data_changes_.remove( const_cast<Property*>( property ));
+}
+
+bool PropertyTreeModel::isMaterialized( const Property* property ) const
+{
+  while( property && property != root_property_ )
+  {
+    Property* parent = property->getParent();
+    if( !parent || property->rowNumberInParent() >= rowLimit( parent ))
+    {
+      return false;
+    }
+    property = parent;
+  }
+  return property == root_property_;
 }
 
 QVariant PropertyTreeModel::data( const QModelIndex& index, int role ) const
@@ -297,9 +382,33 @@ void PropertyTreeModel::emitDataChanged( Property* property )
   {
     Q_EMIT configChanged();
   }
-  QModelIndex left_index = indexOf( property );
-  QModelIndex right_index = createIndex( left_index.row(), 1, left_index.internalPointer() );
-  Q_EMIT dataChanged( left_index, right_index );
+  if( pending_data_changes_.contains( property ) || !isMaterialized( property ))
+  {
+    return;
+  }
+  // A persistent index becomes invalid if the row is removed before
+  // the signal goes out.
+  pending_data_changes_.insert( property, QPersistentModelIndex( indexOf( property )));
+  if( !data_changed_timer_->isActive() )
+  {
+    data_changed_timer_->start();
+  }
+}
+
+void PropertyTreeModel::emitPendingDataChanged()
+{
+  QHash<Property*, QPersistentModelIndex> pending = pending_data_changes_;
+  pending_data_changes_.clear();
+
+  QHash<Property*, QPersistentModelIndex>::const_iterator it;
+  for( it = pending.begin(); it != pending.end(); ++it )
+  {
+    QModelIndex left_index = it.value();
+    if( left_index.isValid() )
+    {
+      Q_EMIT dataChanged( left_index, left_index.sibling( left_index.row(), 1 ));
+    }
+  }
 }
 
 void PropertyTreeModel::beginInsert( Property* parent_property, int row_within_parent, int count )
@@ -308,12 +417,40 @@ void PropertyTreeModel::beginInsert( Property* parent_property, int row_within_p
   //         qPrintable( parent_property->getName()), row_within_parent, count );
   // printPersistentIndices();
 
-  beginInsertRows( indexOf( parent_property ), row_within_parent, row_within_parent + count - 1 );
+  PendingRowChange change;
+  change.parent = parent_property;
+  change.limit = rowLimit( parent_property );
+  change.count = 0;
+  if( isMaterialized( parent_property ))
+  {
+    int num_rows = qMin( parent_property->numChildren(), change.limit );
+    if( row_within_parent < num_rows )
+    {
+      // Rows in the middle push the later ones down, keep them all.
+      change.count = count;
+      change.limit += count;
+    }
+    else if( row_within_parent == num_rows )
+    {
+      // Appended rows only get rows up to the limit.
+      change.count = qMax( 0, qMin( count, change.limit - num_rows ));
+    }
+  }
+  if( change.count > 0 )
+  {
+    beginInsertRows( indexOf( parent_property ), row_within_parent, row_within_parent + change.count - 1 );
+  }
+  pending_row_changes_.append( change );
 }
 
 void PropertyTreeModel::endInsert()
 {
-  endInsertRows();
+  PendingRowChange change = pending_row_changes_.takeLast();
+  setRowLimit( change.parent, change.limit );
+  if( change.count > 0 )
+  {
+    endInsertRows();
+  }
   // printf( "PropertyTreeModel::endInsert()\n" );
 }
 
@@ -323,23 +460,53 @@ void PropertyTreeModel::beginRemove( Property* parent_property, int row_within_p
   //         qPrintable( parent_property->getName()), row_within_parent, count );
   // printPersistentIndices();
 
-  beginRemoveRows( indexOf( parent_property ), row_within_parent, row_within_parent + count - 1 );
+  PendingRowChange change;
+  change.parent = parent_property;
+  change.limit = rowLimit( parent_property );
+  change.count = 0;
+  if( isMaterialized( parent_property ))
+  {
+    int num_rows = qMin( parent_property->numChildren(), change.limit );
+    if( row_within_parent < num_rows )
+    {
+      // Only the removed rows the view has are announced, and the
+      // limit shrinks with them so unfetched children stay unfetched.
+      change.count = qMin( row_within_parent + count, num_rows ) - row_within_parent;
+      change.limit -= change.count;
+    }
+  }
+  if( change.count > 0 )
+  {
+    beginRemoveRows( indexOf( parent_property ), row_within_parent, row_within_parent + change.count - 1 );
+  }
+  pending_row_changes_.append( change );
 }
 
 void PropertyTreeModel::endRemove()
 {
-  endRemoveRows();
+  PendingRowChange change = pending_row_changes_.takeLast();
+  setRowLimit( change.parent, change.limit );
+  if( change.count > 0 )
+  {
+    endRemoveRows();
+  }
 //  printf( "PropertyTreeModel::endRemove()\n" );
 }
 
 void PropertyTreeModel::expandProperty( Property* property )
 {
-  Q_EMIT expand( indexOf( property ));
+  if( isMaterialized( property ))
+  {
+    Q_EMIT expand( indexOf( property ));
+  }
 }
 
 void PropertyTreeModel::collapseProperty( Property* property )
 {
-  Q_EMIT collapse( indexOf( property ));
+  if( isMaterialized( property ))
+  {
+    Q_EMIT collapse( indexOf( property ));
+  }
 }
 
 void PropertyTreeModel::printPersistentIndices()
@@ -30,6 +30,11 @@
 #define PROPERTY_MODEL_H
 
 #include <QAbstractItemModel>
+#include <QHash>
+#include <QList>
+#include <QPersistentModelIndex>
+
+class QTimer;
 
 namespace rviz
 {
@@ -66,9 +71,22 @@ public:
    * an index. */
   QModelIndex parentIndex( const Property* child ) const;
 
-  /** @brief Return the number of rows under the given parent index. */ 
+  /** @brief Return the number of rows under the given parent index.
+   *
+   * Long child lists are handed to the view in batches: this is the
+   * number of children fetched so far, see fetchMore(). */ 
   virtual int rowCount( const QModelIndex &parent = QModelIndex() ) const;
 
+  /** @brief Return true if the children of @a parent have not all been given rows yet. */
+  virtual bool canFetchMore( const QModelIndex& parent ) const;
+
+  /** @brief Give the next batch of children of @a parent rows in the model.
+   *
+   * Called by PropertyTreeWidget when the last row of @a parent comes
+   * into view, so a TF display with thousands of frames only costs
+   * what is looked at. */
+  virtual void fetchMore( const QModelIndex& parent );
+
   /** @brief Return the number of columns under the given parent
    * index, which is always 2 for this model. */ 
   virtual int columnCount( const QModelIndex &parent = QModelIndex() ) const { return 2; }
@@ -108,6 +126,17 @@ public:
 
   QModelIndex indexOf( Property* property ) const;
 
+  /** @brief Return true if @a property and all its ancestors have rows
+   * in the model, false if it is below a part of a child list which has
+   * not been fetched yet. */
+  bool isMaterialized( const Property* property ) const;
+
+  /** @brief Queue a dataChanged() signal for @a property.
+   *
+   * Signals are coalesced and sent together a fraction of a second
+   * later, so a property changing every frame costs one signal per
+   * interval instead of one per change.  Properties without a row
+   * are skipped. */
   void emitDataChanged( Property* property );
 
   void beginInsert( Property* parent_property, int row_within_parent, int count = 1 );
@@ -120,6 +149,10 @@ public:
    * property if the index is invalid. */
   Property* getProp( const QModelIndex& index ) const;
 
+  /** @brief Drop what the model keeps about @a property.  Called by
+   * the Property destructor. */
+  void forgetProperty( const Property* property );
+
   /** @brief Emit the propertyHiddenChanged() signal for the given Property. */
   void emitPropertyHiddenChanged( const Property* property ) { Q_EMIT propertyHiddenChanged( property ); }
 
@@ -146,9 +179,31 @@ Q_SIGNALS:
   /** @brief Emitted when a Property wants to collapse (hide its children). */
   void collapse( const QModelIndex& index );
 
+private Q_SLOTS:
+  /** @brief Send the dataChanged() signals queued by emitDataChanged(). */
+  void emitPendingDataChanged();
+
 private:
+  /** @brief Return how many children of @a parent may have rows. */
+  int rowLimit( const Property* parent ) const;
+  void setRowLimit( const Property* parent, int limit );
+
+  /** A beginInsert() or beginRemove() waiting for its end call. */
+  struct PendingRowChange
+  {
+    Property* parent;
+    int limit; ///< Row limit of parent after the change.
+    int count; ///< Number of rows announced to the view, maybe 0.
+  };
+
   Property* root_property_;
   QString drag_drop_class_; ///< Identifier to add to mimeTypes() entry to keep drag/drops from crossing types.
+
+  /** Row limits differing from the default batch size. */
+  QHash<const Property*, int> row_limits_;
+  QList<PendingRowChange> pending_row_changes_;
+  QHash<Property*, QPersistentModelIndex> pending_data_changes_;
+  QTimer* data_changed_timer_;
 };
 
 } // end namespace rviz
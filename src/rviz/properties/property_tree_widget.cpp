@@ -29,6 +29,7 @@
 
 #include <QTimer>
 #include <QHash>
+#include <QScrollBar>
 #include <QSet>
 
 #include "rviz/properties/property.h"
@@ -45,6 +46,7 @@ PropertyTreeWidget::PropertyTreeWidget( QWidget* parent )
   : QTreeView( parent )
   , model_( NULL )
   , splitter_handle_( new SplitterHandle( this ))
+  , fetch_timer_( new QTimer( this ))
 {
   setItemDelegateForColumn( 1, new PropertyTreeDelegate( this ));
   setDropIndicatorShown( true );
@@ -60,6 +62,12 @@ PropertyTreeWidget::PropertyTreeWidget( QWidget* parent )
   QTimer* timer = new QTimer( this );
   connect( timer, SIGNAL( timeout() ), this, SLOT( update() ));
   timer->start( 100 );
+
+  fetch_timer_->setSingleShot( true );
+  fetch_timer_->setInterval( 0 );
+  connect( fetch_timer_, SIGNAL( timeout() ), this, SLOT( fetchVisibleRows() ));
+  connect( verticalScrollBar(), SIGNAL( valueChanged( int )), this, SLOT( scheduleFetch() ));
+  connect( this, SIGNAL( expanded( const QModelIndex& )), this, SLOT( scheduleFetch() ));
 }
 
 void PropertyTreeWidget::currentChanged( const QModelIndex& new_current_index, const QModelIndex& previous_current_index )
@@ -74,6 +82,20 @@ void PropertyTreeWidget::selectionChanged( const QItemSelection& selected, const
   Q_EMIT selectionHasChanged();
 }
 
+void PropertyTreeWidget::dataChanged( const QModelIndex& top_left, const QModelIndex& bottom_right )
+{
+  // A row under a collapsed parent is not drawn, and QTreeView would
+  // search all the rows it lays out only to find that out.
+  for( QModelIndex parent = top_left.parent(); parent.isValid(); parent = parent.parent() )
+  {
+    if( !isExpanded( parent ))
+    {
+      return;
+    }
+  }
+  QTreeView::dataChanged( top_left, bottom_right );
+}
+
 void PropertyTreeWidget::setModel( PropertyTreeModel* model )
 {
   if( model_ )
@@ -84,6 +106,8 @@ void PropertyTreeWidget::setModel( PropertyTreeModel* model )
                 this, SLOT( expand( const QModelIndex& )));
     disconnect( model_, SIGNAL( collapse( const QModelIndex& )),
                 this, SLOT( collapse( const QModelIndex& )));
+    disconnect( model_, SIGNAL( rowsInserted( const QModelIndex&, int, int )),
+                this, SLOT( scheduleFetch() ));
   }
   model_ = model;
   QTreeView::setModel( model_ );
@@ -95,16 +119,73 @@ void PropertyTreeWidget::setModel( PropertyTreeModel* model )
              this, SLOT( expand( const QModelIndex& )));
     connect( model_, SIGNAL( collapse( const QModelIndex& )),
              this, SLOT( collapse( const QModelIndex& )));
+    connect( model_, SIGNAL( rowsInserted( const QModelIndex&, int, int )),
+             this, SLOT( scheduleFetch() ));
 
     // this will trigger all hiddenChanged events to get re-fired
     model_->getRoot()->setModel( model_->getRoot()->getModel() );
+    scheduleFetch();
+  }
+
+}
+
+void PropertyTreeWidget::resizeEvent( QResizeEvent* event )
+{
+  QTreeView::resizeEvent( event );
+  scheduleFetch();
+}
+
+void PropertyTreeWidget::scheduleFetch()
+{
+  if( !fetch_timer_->isActive() )
+  {
+    fetch_timer_->start();
+  }
+}
+
+void PropertyTreeWidget::fetchVisibleRows()
+{
+  if( !model_ )
+  {
+    return;
+  }
+
+  int height = viewport()->height();
+  for( QModelIndex index = indexAt( QPoint( 0, 0 )); index.isValid(); index = indexBelow( index ))
+  {
+    if( visualRect( index ).top() >= height )
+    {
+      break;
+    }
+    QModelIndex parent = index.parent();
+    if( model_->canFetchMore( parent ) && isLastShownRow( index ))
+    {
+      // The new rows invalidate this walk; their rowsInserted()
+      // signal schedules the next one.
+      model_->fetchMore( parent );
+      return;
+    }
   }
+}
 
+bool PropertyTreeWidget::isLastShownRow( const QModelIndex& index ) const
+{
+  QModelIndex parent = index.parent();
+  int num_rows = model_->rowCount( parent );
+  for( int row = index.row() + 1; row < num_rows; row++ )
+  {
+    if( !isRowHidden( row, parent ))
+    {
+      return false;
+    }
+  }
+  return true;
 }
 
 void PropertyTreeWidget::propertyHiddenChanged( const Property* property )
 {
-  if( model_ )
+  // Properties without a row get their hidden state when they are fetched.
+  if( model_ && model_->isMaterialized( property ))
   {
     setRowHidden( property->rowNumberInParent(), model_->parentIndex( property ), property->getHidden() );
   }
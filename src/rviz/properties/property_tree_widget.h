@@ -34,6 +34,8 @@
 #include "rviz/config.h"
 #include "rviz/properties/property_tree_model.h"
 
+class QTimer;
+
 namespace rviz
 {
 
@@ -92,9 +94,26 @@ protected:
    * implementation then emits selectionHasChanged(). */
   virtual void selectionChanged( const QItemSelection& selected, const QItemSelection& deselected );
 
+  /** @brief Called when the model changes the data of a row.  Skips
+   * rows inside collapsed subtrees, otherwise calls the QTreeView
+   * implementation. */
+  virtual void dataChanged( const QModelIndex& top_left, const QModelIndex& bottom_right );
+
+  /** @brief Calls the QTreeView implementation, then scheduleFetch(),
+   * as a taller view may show the end of a partly fetched list. */
+  virtual void resizeEvent( QResizeEvent* event );
+
 protected Q_SLOTS:
   virtual void propertyHiddenChanged( const Property* property );
 
+  /** @brief Call fetchVisibleRows() once control returns to the event loop. */
+  void scheduleFetch();
+
+  /** @brief Fetch more children of every parent whose last shown row
+   * is in view.  Runs on scrolling, expanding, resizing, and inserted
+   * rows, so a long list grows as it is scrolled through. */
+  void fetchVisibleRows();
+
 Q_SIGNALS:
   void currentPropertyChanged( const Property* new_current_property );
   void selectionHasChanged();
@@ -108,8 +127,12 @@ private:
                       const QModelIndex& parent_index,
                       const QString& prefix );
 
+  /** @brief Return true if no row after @a index under the same parent is shown. */
+  bool isLastShownRow( const QModelIndex& index ) const;
+
   PropertyTreeModel* model_;
   SplitterHandle* splitter_handle_;
+  QTimer* fetch_timer_;
 };
 
 } // end namespace rviz
@@ -27,11 +27,8 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include "ros/master.h"
-
 #include "rviz/properties/ros_topic_property.h"
-
-#include <QApplication>
+#include "rviz/topic_cache.h"
 
 
 namespace rviz
@@ -49,6 +46,10 @@ RosTopicProperty::RosTopicProperty( const QString& name,
 {
   connect( this, SIGNAL( requestOptions( EditableEnumProperty* )),
            this, SLOT( fillTopicList()));
+  // Opening the dropdown refreshes a stale cache in the background;
+  // show the result once it is in.
+  connect( TopicCache::get(), SIGNAL( topicsChanged() ),
+           this, SLOT( refreshOptions() ));
 }
 
 void RosTopicProperty::setMessageType( const QString& message_type )
@@ -58,28 +59,15 @@ void RosTopicProperty::setMessageType( const QString& message_type )
 
 void RosTopicProperty::fillTopicList()
 {
-  QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
   clearOptions();
 
-  std::string std_message_type = message_type_.toStdString();
-
-  ros::master::V_TopicInfo topics;
-  ros::master::getTopics( topics );
-
-  // Loop through all published topics
-  ros::master::V_TopicInfo::iterator it;
-  for( it = topics.begin(); it != topics.end(); ++it )
+  // Served from the topic cache, which is sorted and indexed by type,
+  // so opening the dropdown does not wait for the master.
+  std::vector<std::string> names = TopicCache::get()->getTopicNames( message_type_.toStdString() );
+  for( size_t i = 0; i < names.size(); i++ )
   {
-    const ros::master::TopicInfo& topic = *it;
-
-    // Only add topics whose type matches.
-    if( topic.datatype == std_message_type )
-    {
-      addOptionStd( topic.name );
-    }
+    addOptionStd( names[ i ] );
   }
-  sortOptions();
-  QApplication::restoreOverrideCursor();
 }
 
 } // end namespace rviz
@@ -0,0 +1,294 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <sstream>
+
+#include <urdf_model/model.h>
+
+#include <tf/tf.h>
+
+#include "rviz/frame_manager.h"
+
+#include "rviz/robot/joint_state_link_updater.h"
+
+namespace rviz
+{
+
+JointStateLinkUpdater::JointStateLinkUpdater( const urdf::ModelInterface& urdf, FrameManager* frame_manager,
+                                              const StatusCallback& status_cb, const std::string& tf_prefix )
+  : dirty_( true )
+  , root_position_( Ogre::Vector3::ZERO )
+  , root_orientation_( Ogre::Quaternion::IDENTITY )
+  , root_valid_( false )
+  , frame_manager_( frame_manager )
+  , status_callback_( status_cb )
+  , tf_prefix_( tf_prefix )
+{
+  boost::shared_ptr<const urdf::Link> root = urdf.getRoot();
+  if( !root )
+  {
+    return;
+  }
+
+  // Walk the tree depth-first, converting the fixed part of each joint once.
+  std::vector<std::pair<boost::shared_ptr<const urdf::Link>, int> > stack;
+  stack.push_back( std::make_pair( root, -1 ));
+  while( !stack.empty() )
+  {
+    boost::shared_ptr<const urdf::Link> urdf_link = stack.back().first;
+    int parent = stack.back().second;
+    stack.pop_back();
+
+    Link link;
+    link.name = urdf_link->name;
+    link.parent = parent;
+    link.joint = -1;
+    link.position = Ogre::Vector3::ZERO;
+    link.orientation = Ogre::Quaternion::IDENTITY;
+    link.valid = true;
+
+    const boost::shared_ptr<urdf::Joint>& urdf_joint = urdf_link->parent_joint;
+    if( parent >= 0 && urdf_joint )
+    {
+      Joint joint;
+      joint.name = urdf_joint->name;
+      switch( urdf_joint->type )
+      {
+      case urdf::Joint::REVOLUTE:
+      case urdf::Joint::CONTINUOUS:
+        joint.motion = ROTATION;
+        break;
+      case urdf::Joint::PRISMATIC:
+        joint.motion = TRANSLATION;
+        break;
+      default:
+        joint.motion = FIXED;
+        break;
+      }
+
+      const urdf::Vector3& pos = urdf_joint->parent_to_joint_origin_transform.position;
+      const urdf::Rotation& rot = urdf_joint->parent_to_joint_origin_transform.rotation;
+      joint.origin_position = Ogre::Vector3( pos.x, pos.y, pos.z );
+      joint.origin_orientation = Ogre::Quaternion( rot.w, rot.x, rot.y, rot.z );
+      joint.axis = Ogre::Vector3( urdf_joint->axis.x, urdf_joint->axis.y, urdf_joint->axis.z );
+      if( joint.axis.isZeroLength() )
+      {
+        joint.motion = FIXED;
+      }
+      else
+      {
+        joint.axis.normalise();
+      }
+
+      joint.mimic = -1;
+      joint.multiplier = 1.0;
+      joint.offset = 0.0;
+      joint.value = 0.0;
+      joint.has_value = false;
+      joint.dirty = true;
+
+      link.joint = joints_.size();
+      joint_indices_[ joint.name ] = joints_.size();
+      joints_.push_back( joint );
+    }
+
+    int index = links_.size();
+    link_indices_[ link.name ] = index;
+    links_.push_back( link );
+
+    for( size_t i = 0; i < urdf_link->child_links.size(); i++ )
+    {
+      stack.push_back( std::make_pair( boost::shared_ptr<const urdf::Link>( urdf_link->child_links[ i ] ), index ));
+    }
+  }
+
+  // Resolve mimic joints once all joints are known.
+  std::map<std::string, boost::shared_ptr<urdf::Joint> >::const_iterator it = urdf.joints_.begin();
+  for( ; it != urdf.joints_.end(); ++it )
+  {
+    const boost::shared_ptr<urdf::Joint>& urdf_joint = it->second;
+    std::map<std::string, int>::iterator self = joint_indices_.find( urdf_joint->name );
+    if( !urdf_joint->mimic || self == joint_indices_.end() )
+    {
+      continue;
+    }
+    std::map<std::string, int>::iterator master = joint_indices_.find( urdf_joint->mimic->joint_name );
+    if( master != joint_indices_.end() )
+    {
+      Joint& joint = joints_[ self->second ];
+      joint.mimic = master->second;
+      joint.multiplier = urdf_joint->mimic->multiplier;
+      joint.offset = urdf_joint->mimic->offset;
+    }
+  }
+}
+
+void JointStateLinkUpdater::setJointValue( Joint& joint, double value )
+{
+  if( !joint.has_value || joint.value != value )
+  {
+    joint.value = value;
+    joint.has_value = true;
+    joint.dirty = true;
+    dirty_ = true;
+  }
+}
+
+void JointStateLinkUpdater::setJointState( const sensor_msgs::JointState& msg )
+{
+  size_t count = std::min( msg.name.size(), msg.position.size() );
+  for( size_t i = 0; i < count; i++ )
+  {
+    std::map<std::string, int>::iterator it = joint_indices_.find( msg.name[ i ] );
+    if( it != joint_indices_.end() && joints_[ it->second ].mimic < 0 )
+    {
+      setJointValue( joints_[ it->second ], msg.position[ i ] );
+    }
+  }
+}
+
+void JointStateLinkUpdater::update()
+{
+  if( links_.empty() )
+  {
+    return;
+  }
+
+  std::string root_frame = links_.front().name;
+  if( !tf_prefix_.empty() )
+  {
+    root_frame = tf::resolve( tf_prefix_, root_frame );
+  }
+  root_valid_ = frame_manager_->getTransform( root_frame, ros::Time(), root_position_, root_orientation_ );
+  if( !root_valid_ )
+  {
+    std::stringstream ss;
+    ss << "No transform from [" << root_frame << "] to [" << frame_manager_->getFixedFrame() << "]";
+    setLinkStatus( StatusProperty::Error, links_.front().name, ss.str() );
+  }
+
+  if( !dirty_ )
+  {
+    return;
+  }
+
+  for( size_t i = 0; i < joints_.size(); i++ )
+  {
+    Joint& joint = joints_[ i ];
+    if( joint.mimic >= 0 && joints_[ joint.mimic ].has_value )
+    {
+      setJointValue( joint, joint.multiplier * joints_[ joint.mimic ].value + joint.offset );
+    }
+  }
+
+  // Parents come first, so one pass recomputes every subtree below a
+  // changed joint and leaves the rest untouched.
+  std::vector<bool> moved( links_.size(), false );
+  for( size_t i = 0; i < links_.size(); i++ )
+  {
+    Link& link = links_[ i ];
+    if( link.parent < 0 || link.joint < 0 )
+    {
+      continue;
+    }
+
+    const Joint& joint = joints_[ link.joint ];
+    if( !joint.dirty && !moved[ link.parent ] )
+    {
+      continue;
+    }
+    moved[ i ] = true;
+
+    const Link& parent = links_[ link.parent ];
+    Ogre::Vector3 offset = joint.origin_position;
+    Ogre::Quaternion orientation = joint.origin_orientation;
+    if( joint.motion == ROTATION )
+    {
+      orientation = orientation * Ogre::Quaternion( Ogre::Radian( joint.value ), joint.axis );
+    }
+    else if( joint.motion == TRANSLATION )
+    {
+      offset += joint.origin_orientation * ( joint.axis * joint.value );
+    }
+
+    link.position = parent.position + parent.orientation * offset;
+    link.orientation = parent.orientation * orientation;
+    link.valid = parent.valid && ( joint.motion == FIXED || joint.has_value );
+  }
+
+  for( size_t i = 0; i < joints_.size(); i++ )
+  {
+    joints_[ i ].dirty = false;
+  }
+  dirty_ = false;
+}
+
+bool JointStateLinkUpdater::getLinkTransforms( const std::string& link_name, Ogre::Vector3& visual_position, Ogre::Quaternion& visual_orientation,
+                                               Ogre::Vector3& collision_position, Ogre::Quaternion& collision_orientation ) const
+{
+  std::map<std::string, int>::const_iterator it = link_indices_.find( link_name );
+  if( it == link_indices_.end() )
+  {
+    setLinkStatus( StatusProperty::Error, link_name, "Link is not connected to the root of the robot" );
+    return false;
+  }
+
+  if( !root_valid_ )
+  {
+    return false;
+  }
+
+  const Link& link = links_[ it->second ];
+  if( !link.valid )
+  {
+    setLinkStatus( StatusProperty::Warn, link_name, "No joint state received for a joint above this link" );
+    return false;
+  }
+
+  setLinkStatus( StatusProperty::Ok, link_name, "Transform OK" );
+
+  // Collision/visual transforms are the same in this case
+  visual_position = root_position_ + root_orientation_ * link.position;
+  visual_orientation = root_orientation_ * link.orientation;
+  collision_position = visual_position;
+  collision_orientation = visual_orientation;
+
+  return true;
+}
+
+void JointStateLinkUpdater::setLinkStatus( StatusLevel level, const std::string& link_name, const std::string& text ) const
+{
+  if( status_callback_ )
+  {
+    status_callback_( level, link_name, text );
+  }
+}
+
+} // namespace rviz
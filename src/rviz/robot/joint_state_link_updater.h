@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RVIZ_ROBOT_JOINT_STATE_LINK_UPDATER_H
+#define RVIZ_ROBOT_JOINT_STATE_LINK_UPDATER_H
+
+#include "link_updater.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/function.hpp>
+
+#include <OGRE/OgreQuaternion.h>
+#include <OGRE/OgreVector3.h>
+
+#include <sensor_msgs/JointState.h>
+
+namespace urdf
+{
+class ModelInterface;
+}
+
+namespace rviz
+{
+
+class FrameManager;
+
+/**
+ * \class JointStateLinkUpdater
+ * \brief Positions links by forward kinematics from joint values.
+ *
+ * Only the root link of the model is looked up through tf; every other
+ * link is computed from the joint values in sensor_msgs/JointState
+ * messages and the joint origins of the URDF, so the robot follows the
+ * joint states without a round trip through robot_state_publisher.
+ *
+ * The fixed part of every joint transform is converted once, when the
+ * updater is created.  update() only recomputes links below joints
+ * whose value changed since the last call, so many joint state
+ * messages per frame cost one pass over the changed subtrees.
+ *
+ * Revolute, continuous and prismatic joints move; mimic joints follow
+ * their master joint.  Floating and planar joints are not described by
+ * a single joint value and stay at their origin.
+ */
+class JointStateLinkUpdater : public LinkUpdater
+{
+public:
+  typedef boost::function<void(StatusLevel, const std::string&, const std::string&)> StatusCallback;
+
+  JointStateLinkUpdater( const urdf::ModelInterface& urdf, FrameManager* frame_manager,
+                         const StatusCallback& status_cb = StatusCallback(), const std::string& tf_prefix = std::string() );
+
+  void setTfPrefix( const std::string& tf_prefix ) { tf_prefix_ = tf_prefix; }
+
+  /** \brief Store the joint values of @a msg.  Joints not in the model are ignored. */
+  void setJointState( const sensor_msgs::JointState& msg );
+
+  /** \brief Look up the root link in tf and recompute the links below changed joints. */
+  void update();
+
+  virtual bool getLinkTransforms( const std::string& link_name, Ogre::Vector3& visual_position, Ogre::Quaternion& visual_orientation,
+                                  Ogre::Vector3& collision_position, Ogre::Quaternion& collision_orientation ) const;
+
+  virtual void setLinkStatus( StatusLevel level, const std::string& link_name, const std::string& text ) const;
+
+private:
+  enum Motion
+  {
+    FIXED,
+    ROTATION,
+    TRANSLATION
+  };
+
+  struct Joint
+  {
+    std::string name;
+    Motion motion;
+    Ogre::Vector3 origin_position;
+    Ogre::Quaternion origin_orientation;
+    Ogre::Vector3 axis;
+
+    int mimic;  ///< Index of the joint this one mimics, or -1.
+    double multiplier;
+    double offset;
+
+    double value;
+    bool has_value;
+    bool dirty;
+  };
+
+  struct Link
+  {
+    std::string name;
+    int parent;  ///< Index of the parent link, or -1 for the root.
+    int joint;   ///< Index of the parent joint, or -1 for the root.
+
+    /// Pose relative to the root link.
+    Ogre::Vector3 position;
+    Ogre::Quaternion orientation;
+    /// False while a moving joint between the root and this link has no value.
+    bool valid;
+  };
+
+  void setJointValue( Joint& joint, double value );
+
+  /// Links in depth-first order, so every parent comes before its children.
+  std::vector<Link> links_;
+  std::vector<Joint> joints_;
+  std::map<std::string, int> link_indices_;
+  std::map<std::string, int> joint_indices_;
+  bool dirty_;
+
+  Ogre::Vector3 root_position_;
+  Ogre::Quaternion root_orientation_;
+  bool root_valid_;
+
+  FrameManager* frame_manager_;
+  StatusCallback status_callback_;
+  std::string tf_prefix_;
+};
+
+} // namespace rviz
+
+#endif // RVIZ_ROBOT_JOINT_STATE_LINK_UPDATER_H
@@ -28,6 +28,7 @@
  */
 
 #include "robot.h"
+#include "robot_instances.h"
 #include "robot_link.h"
 #include "robot_joint.h"
 #include "properties/property.h"
@@ -44,6 +45,7 @@
 #include <OGRE/OgreSceneNode.h>
 #include <OGRE/OgreSceneManager.h>
 #include <OGRE/OgreEntity.h>
+#include <OGRE/OgreSubEntity.h>
 #include <OGRE/OgreMaterialManager.h>
 #include <OGRE/OgreMaterial.h>
 #include <OGRE/OgreResourceGroupManager.h>
@@ -51,6 +53,8 @@
 #include <ros/console.h>
 #include <ros/assert.h>
 
+#include <iterator>
+
 namespace rviz
 {
 
@@ -64,11 +68,16 @@ Robot::Robot( Ogre::SceneNode* root_node, DisplayContext* context, const std::st
   , doing_set_checkbox_( false )
   , robot_loaded_( false )
   , inChangedEnableAllLinks( false )
+  , mesh_lod_bias_( 1.0f )
+  , instance_meshes_added_( false )
 {
   root_visual_node_ = root_node->createChildSceneNode();
   root_collision_node_ = root_node->createChildSceneNode();
   root_other_node_ = root_node->createChildSceneNode();
 
+  instances_ = new RobotInstances();
+  root_other_node_->attachObject( instances_ );
+
   link_factory_ = new LinkFactory();
 
   setVisualVisible( visual_visible_ );
@@ -120,6 +129,9 @@ Robot::~Robot()
 {
   clear();
 
+  root_other_node_->detachObject( instances_ );
+  delete instances_;
+
   scene_manager_->destroySceneNode( root_visual_node_->getName() );
   scene_manager_->destroySceneNode( root_collision_node_->getName() );
   scene_manager_->destroySceneNode( root_other_node_->getName() );
@@ -190,6 +202,18 @@ bool Robot::isCollisionVisible()
   return collision_visible_;
 }
 
+void Robot::setMeshLodBias( float bias )
+{
+  mesh_lod_bias_ = bias;
+
+  M_NameToLink::iterator it = links_.begin();
+  M_NameToLink::iterator end = links_.end();
+  for ( ; it != end; ++it )
+  {
+    it->second->setMeshLodBias( mesh_lod_bias_ );
+  }
+}
+
 void Robot::setAlpha(float a)
 {
   alpha_ = a;
@@ -211,6 +235,10 @@ void Robot::clear()
   // style)
   unparentLinkProperties();
 
+  // The instances share the meshes of the links.
+  instances_->clearLinkMeshes();
+  instance_meshes_added_ = false;
+
   M_NameToLink::iterator link_it = links_.begin();
   M_NameToLink::iterator link_end = links_.end();
   for ( ; link_it != link_end; ++link_it )
@@ -234,6 +262,79 @@ void Robot::clear()
   root_other_node_->removeAndDestroyAllChildren();
 }
 
+int Robot::getLinkIndex( const std::string& link_name ) const
+{
+  M_NameToLink::const_iterator it = links_.find( link_name );
+  if( it == links_.end() )
+  {
+    return -1;
+  }
+  return std::distance( links_.begin(), it );
+}
+
+void Robot::setInstances( const std::vector<Ogre::Matrix4>& link_transforms, uint32_t num_instances )
+{
+  if( !instance_meshes_added_ )
+  {
+    uint32_t index = 0;
+    M_NameToLink::iterator link_it = links_.begin();
+    for( ; link_it != links_.end(); ++link_it, ++index )
+    {
+      RobotLink* link = link_it->second;
+      const std::vector<Ogre::Entity*>& entities = link->getVisualMeshes();
+      for( size_t i = 0; i < entities.size(); i++ )
+      {
+        Ogre::Entity* entity = entities[ i ];
+        Ogre::SceneNode* offset_node = entity->getParentSceneNode();
+        Ogre::Matrix4 offset;
+        offset.makeTransform( offset_node->getPosition(), offset_node->getScale(), offset_node->getOrientation() );
+        for( unsigned int j = 0; j < entity->getNumSubEntities(); j++ )
+        {
+          Ogre::SubEntity* sub = entity->getSubEntity( j );
+          instances_->addLinkMesh( index, sub->getSubMesh(), offset, link->getNormalMaterial( sub ));
+        }
+      }
+    }
+    instance_meshes_added_ = true;
+  }
+
+  uint32_t num_links = links_.size();
+  ROS_ASSERT( link_transforms.size() >= num_instances * num_links );
+  instances_->setInstances( link_transforms.empty() ? NULL : &link_transforms.front(), num_links, num_instances );
+}
+
+void Robot::clearInstances()
+{
+  instances_->setInstances( NULL, links_.size(), 0 );
+}
+
+void Robot::setInstanceAlpha( float alpha )
+{
+  instances_->setAlpha( alpha );
+}
+
+void Robot::updateInstanceMaterials( RobotLink* link )
+{
+  int index = getLinkIndex( link->getName() );
+  if( !instance_meshes_added_ || index < 0 )
+  {
+    return;
+  }
+
+  // Same order as the meshes were added in setInstances().
+  std::vector<Ogre::MaterialPtr> materials;
+  const std::vector<Ogre::Entity*>& entities = link->getVisualMeshes();
+  for( size_t i = 0; i < entities.size(); i++ )
+  {
+    Ogre::Entity* entity = entities[ i ];
+    for( unsigned int j = 0; j < entity->getNumSubEntities(); j++ )
+    {
+      materials.push_back( link->getNormalMaterial( entity->getSubEntity( j )));
+    }
+  }
+  instances_->setLinkMaterials( index, materials );
+}
+
 RobotLink* Robot::LinkFactory::createLink(
     Robot* robot,
     const boost::shared_ptr<const urdf::Link>& link,
@@ -292,6 +393,7 @@ void Robot::load( const urdf::ModelInterface &urdf, bool visual, bool collision
       links_[urdf_link->name] = link;
 
       link->setRobotAlpha( alpha_ );
+      link->setMeshLodBias( mesh_lod_bias_ );
     }
   }
 
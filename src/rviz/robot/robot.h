@@ -38,6 +38,7 @@
 #include <OGRE/OgreVector3.h>
 #include <OGRE/OgreQuaternion.h>
 #include <OGRE/OgreAny.h>
+#include <OGRE/OgreMatrix4.h>
 
 namespace Ogre
 {
@@ -78,6 +79,7 @@ class BoolProperty;
 class Robot;
 class RobotLink;
 class RobotJoint;
+class RobotInstances;
 class DisplayContext;
 
 /**
@@ -145,6 +147,12 @@ public:
   void setAlpha(float a);
   float getAlpha() { return alpha_; }
 
+  /**
+   * \brief Scale the screen size at which link meshes switch to simplified LOD levels.
+   * Values below 1 switch sooner, values above 1 keep full detail longer.
+   */
+  void setMeshLodBias( float bias );
+
   RobotLink* getRootLink() { return root_link_; }
   RobotLink* getLink( const std::string& name );
   RobotJoint* getJoint( const std::string& name );
@@ -156,6 +164,31 @@ public:
 
   const std::string& getName() { return name_; }
 
+  /**
+   * @brief Index of a link in the transform arrays of setInstances(), or -1 if there is no such link.
+   *
+   * Links are indexed in the order of getLinks().
+   */
+  int getLinkIndex( const std::string& link_name ) const;
+
+  /**
+   * @brief Draw additional poses of the robot, e.g. the waypoints of a trajectory.
+   *
+   * The instances share the meshes of the links, and each link mesh has
+   * one material for all instances; see RobotInstances.
+   *
+   * @param link_transforms num_instances * getLinks().size() link
+   *        transforms, instance after instance, in the order given by
+   *        getLinkIndex().  They are relative to the robot's root node,
+   *        like the positions a LinkUpdater returns.
+   */
+  void setInstances( const std::vector<Ogre::Matrix4>& link_transforms, uint32_t num_instances );
+  void clearInstances();
+  void setInstanceAlpha( float alpha );
+
+  /** @brief Give the instances the current materials of @a link; called when its color changes. */
+  void updateInstanceMaterials( RobotLink* link );
+
   Ogre::SceneNode* getVisualNode() { return root_visual_node_; }
   Ogre::SceneNode* getCollisionNode() { return root_collision_node_; }
   Ogre::SceneNode* getOtherNode() { return root_other_node_; }
@@ -279,6 +312,10 @@ protected:
 
   std::string name_;
   float alpha_;
+  float mesh_lod_bias_;
+
+  RobotInstances* instances_;   ///< Extra poses drawn from the link meshes, attached to root_other_node_.
+  bool instance_meshes_added_;   ///< Whether the link meshes have been registered with instances_ since the last load().
 };
 
 } // namespace rviz
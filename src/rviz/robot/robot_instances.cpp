@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <sstream>
+
+#include <OGRE/OgreCamera.h>
+#include <OGRE/OgreMaterialManager.h>
+#include <OGRE/OgreMesh.h>
+#include <OGRE/OgreRenderQueue.h>
+#include <OGRE/OgreSceneNode.h>
+#include <OGRE/OgreSubMesh.h>
+#include <OGRE/OgreTechnique.h>
+
+#include "rviz/robot/robot_instances.h"
+
+namespace rviz
+{
+
+Ogre::String RobotInstances::sm_Type = "RobotInstances";
+
+RobotInstances::RobotInstances()
+  : num_renderables_( 0 )
+  , num_instances_( 0 )
+  , alpha_( 1.0f )
+  , bounding_radius_( 0.0f )
+{
+  bounding_box_.setNull();
+}
+
+RobotInstances::~RobotInstances()
+{
+  clearLinkMeshes();
+  for( size_t i = 0; i < renderables_.size(); i++ )
+  {
+    delete renderables_[ i ];
+  }
+}
+
+void RobotInstances::addLinkMesh( uint32_t link, Ogre::SubMesh* sub_mesh, const Ogre::Matrix4& offset, const Ogre::MaterialPtr& material )
+{
+  static int count = 0;
+  std::stringstream ss;
+  ss << "RobotInstanceMaterial" << count++;
+
+  LinkMesh mesh;
+  mesh.link = link;
+  mesh.sub_mesh = sub_mesh;
+  mesh.offset = offset;
+  mesh.material = material->clone( ss.str() );
+  mesh.material->load();
+  if( alpha_ < 0.9998 )
+  {
+    applyAlpha( mesh.material, alpha_ );
+  }
+
+  // The mesh radius grows with the largest scale of the offset.
+  Ogre::Vector3 scale( offset[0][0], offset[1][0], offset[2][0] );
+  float max_scale = std::max( scale.length(), std::max( Ogre::Vector3( offset[0][1], offset[1][1], offset[2][1] ).length(),
+                                                        Ogre::Vector3( offset[0][2], offset[1][2], offset[2][2] ).length() ));
+  mesh.radius = sub_mesh->parent->getBoundingSphereRadius() * max_scale + offset.getTrans().length();
+
+  meshes_.push_back( mesh );
+}
+
+void RobotInstances::setLinkMaterials( uint32_t link, const std::vector<Ogre::MaterialPtr>& materials )
+{
+  size_t next = 0;
+  for( size_t i = 0; i < meshes_.size() && next < materials.size(); i++ )
+  {
+    LinkMesh& mesh = meshes_[ i ];
+    if( mesh.link != link )
+    {
+      continue;
+    }
+    materials[ next++ ]->copyDetailsTo( mesh.material );
+    mesh.material->load();
+    if( alpha_ < 0.9998 )
+    {
+      applyAlpha( mesh.material, alpha_ );
+    }
+  }
+}
+
+void RobotInstances::clearLinkMeshes()
+{
+  for( size_t i = 0; i < meshes_.size(); i++ )
+  {
+    Ogre::MaterialManager::getSingleton().remove( meshes_[ i ].material->getName() );
+  }
+  meshes_.clear();
+  num_renderables_ = 0;
+  num_instances_ = 0;
+  bounding_box_.setNull();
+  bounding_radius_ = 0.0f;
+}
+
+void RobotInstances::setInstances( const Ogre::Matrix4* link_transforms, uint32_t num_links, uint32_t num_instances )
+{
+  num_instances_ = num_instances;
+  num_renderables_ = num_instances * meshes_.size();
+  while( renderables_.size() < num_renderables_ )
+  {
+    renderables_.push_back( new InstanceRenderable( this ));
+  }
+
+  bounding_box_.setNull();
+  uint32_t r = 0;
+  for( uint32_t instance = 0; instance < num_instances; instance++ )
+  {
+    const Ogre::Matrix4* transforms = link_transforms + instance * num_links;
+    for( size_t m = 0; m < meshes_.size(); m++ )
+    {
+      const LinkMesh& mesh = meshes_[ m ];
+      if( mesh.link >= num_links )
+      {
+        continue;
+      }
+      Ogre::Matrix4 transform = transforms[ mesh.link ] * mesh.offset;
+      renderables_[ r++ ]->set( &mesh, transform );
+
+      Ogre::Vector3 center = transform.getTrans();
+      Ogre::Vector3 extent( mesh.radius, mesh.radius, mesh.radius );
+      bounding_box_.merge( Ogre::AxisAlignedBox( center - extent, center + extent ));
+    }
+  }
+
+  num_renderables_ = r;
+
+  bounding_radius_ = 0.0f;
+  if( !bounding_box_.isNull() )
+  {
+    bounding_radius_ = Ogre::Math::Sqrt( std::max( bounding_box_.getMaximum().squaredLength(),
+                                                   bounding_box_.getMinimum().squaredLength() ));
+  }
+
+  // The scene node caches the bounds of its objects.
+  if( getParentSceneNode() )
+  {
+    getParentSceneNode()->needUpdate();
+  }
+}
+
+void RobotInstances::applyAlpha( const Ogre::MaterialPtr& material, float alpha )
+{
+  Ogre::ColourValue color = material->getTechnique(0)->getPass(0)->getDiffuse();
+  color.a = alpha;
+  material->setDiffuse( color );
+
+  if ( alpha < 0.9998 )
+  {
+    material->setSceneBlending( Ogre::SBT_TRANSPARENT_ALPHA );
+    material->setDepthWriteEnabled( false );
+  }
+  else
+  {
+    material->setSceneBlending( Ogre::SBT_REPLACE );
+    material->setDepthWriteEnabled( true );
+  }
+}
+
+void RobotInstances::setAlpha( float alpha )
+{
+  alpha_ = alpha;
+  for( size_t i = 0; i < meshes_.size(); i++ )
+  {
+    applyAlpha( meshes_[ i ].material, alpha_ );
+  }
+}
+
+void RobotInstances::_updateRenderQueue( Ogre::RenderQueue* queue )
+{
+  for( uint32_t i = 0; i < num_renderables_; i++ )
+  {
+    queue->addRenderable( renderables_[ i ], mRenderQueueID );
+  }
+}
+
+#if (OGRE_VERSION_MAJOR >= 1 && OGRE_VERSION_MINOR >= 6)
+void RobotInstances::visitRenderables( Ogre::Renderable::Visitor* visitor, bool debugRenderables )
+{
+  for( uint32_t i = 0; i < num_renderables_; i++ )
+  {
+    visitor->visit( renderables_[ i ], 0, debugRenderables );
+  }
+}
+#endif
+
+void RobotInstances::InstanceRenderable::getRenderOperation( Ogre::RenderOperation& op )
+{
+  // Shares the vertex and index buffers of the link's own mesh.
+  mesh_->sub_mesh->_getRenderOperation( op );
+}
+
+void RobotInstances::InstanceRenderable::getWorldTransforms( Ogre::Matrix4* xform ) const
+{
+  *xform = parent_->_getParentNodeFullTransform() * transform_;
+}
+
+Ogre::Real RobotInstances::InstanceRenderable::getSquaredViewDepth( const Ogre::Camera* cam ) const
+{
+  Ogre::Vector3 position = parent_->_getParentNodeFullTransform() * transform_.getTrans();
+  return ( cam->getDerivedPosition() - position ).squaredLength();
+}
+
+const Ogre::LightList& RobotInstances::InstanceRenderable::getLights() const
+{
+  return parent_->queryLights();
+}
+
+} // namespace rviz
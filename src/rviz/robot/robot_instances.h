@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RVIZ_ROBOT_INSTANCES_H
+#define RVIZ_ROBOT_INSTANCES_H
+
+#include <stdint.h>
+
+#include <vector>
+
+#include <OGRE/OgreAxisAlignedBox.h>
+#include <OGRE/OgreMaterial.h>
+#include <OGRE/OgreMatrix4.h>
+#include <OGRE/OgreMovableObject.h>
+#include <OGRE/OgreRenderable.h>
+
+namespace Ogre
+{
+class SubMesh;
+}
+
+namespace rviz
+{
+
+class RobotInstances;
+
+/**
+ * \class RobotInstances
+ * \brief Draws extra poses of a robot from the meshes its links already have.
+ *
+ * Every mesh part of every link is registered once with addLinkMesh().
+ * An instance is then nothing but one transform per link: the mesh
+ * buffers are shared with the robot's own entities, and each mesh part
+ * has one material for all instances, so there are no entities, scene
+ * nodes or cloned materials per instance.  Drawing N instances costs N
+ * draw calls per link mesh.
+ */
+class RobotInstances : public Ogre::MovableObject
+{
+public:
+  RobotInstances();
+  ~RobotInstances();
+
+  /**
+   * \brief Register one mesh part of a link.
+   * @param link Index of the link in the transform arrays given to setInstances().
+   * @param offset Transform of the mesh relative to the link frame, including its scale.
+   * @param material Material of the mesh on the robot.  A copy is used, so alpha changes stay local.
+   */
+  void addLinkMesh( uint32_t link, Ogre::SubMesh* sub_mesh, const Ogre::Matrix4& offset, const Ogre::MaterialPtr& material );
+
+  /**
+   * \brief Refresh the materials of the mesh parts of one link.
+   * @param materials The new materials of the link's mesh parts, in the order they were added with addLinkMesh().
+   *
+   * The copies are kept and overwritten, so the renderables stay valid.
+   */
+  void setLinkMaterials( uint32_t link, const std::vector<Ogre::MaterialPtr>& materials );
+
+  /** \brief Remove all link meshes and instances. */
+  void clearLinkMeshes();
+
+  /**
+   * \brief Set the poses to draw.
+   * @param link_transforms num_instances * num_links transforms of the links, instance after instance,
+   *        relative to the scene node this object is attached to.
+   */
+  void setInstances( const Ogre::Matrix4* link_transforms, uint32_t num_links, uint32_t num_instances );
+
+  uint32_t getNumInstances() const { return num_instances_; }
+
+  void setAlpha( float alpha );
+
+  virtual const Ogre::String& getMovableType() const { return sm_Type; }
+  virtual const Ogre::AxisAlignedBox& getBoundingBox() const { return bounding_box_; }
+  virtual float getBoundingRadius() const { return bounding_radius_; }
+  virtual void _updateRenderQueue( Ogre::RenderQueue* queue );
+#if (OGRE_VERSION_MAJOR >= 1 && OGRE_VERSION_MINOR >= 6)
+  virtual void visitRenderables( Ogre::Renderable::Visitor* visitor, bool debugRenderables );
+#endif
+
+private:
+  struct LinkMesh
+  {
+    uint32_t link;
+    Ogre::SubMesh* sub_mesh;
+    Ogre::Matrix4 offset;
+    Ogre::MaterialPtr material;
+    float radius;
+  };
+
+  static void applyAlpha( const Ogre::MaterialPtr& material, float alpha );
+
+  /** One mesh part of one instance. */
+  class InstanceRenderable : public Ogre::Renderable
+  {
+  public:
+    InstanceRenderable( RobotInstances* parent ) : parent_( parent ), mesh_( 0 ) {}
+
+    void set( const LinkMesh* mesh, const Ogre::Matrix4& transform ) { mesh_ = mesh; transform_ = transform; }
+
+    virtual const Ogre::MaterialPtr& getMaterial() const { return mesh_->material; }
+    virtual void getRenderOperation( Ogre::RenderOperation& op );
+    virtual void getWorldTransforms( Ogre::Matrix4* xform ) const;
+    virtual Ogre::Real getSquaredViewDepth( const Ogre::Camera* cam ) const;
+    virtual const Ogre::LightList& getLights() const;
+
+  private:
+    RobotInstances* parent_;
+    const LinkMesh* mesh_;
+    Ogre::Matrix4 transform_;  ///< Relative to the parent node.
+  };
+
+  std::vector<LinkMesh> meshes_;
+  std::vector<InstanceRenderable*> renderables_;  ///< Only the first num_renderables_ are in use.
+  uint32_t num_renderables_;
+  uint32_t num_instances_;
+  float alpha_;
+
+  Ogre::AxisAlignedBox bounding_box_;
+  float bounding_radius_;
+
+  static Ogre::String sm_Type;
+};
+
+} // namespace rviz
+
+#endif // RVIZ_ROBOT_INSTANCES_H
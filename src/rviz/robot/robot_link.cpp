@@ -32,10 +32,12 @@
 #include <OGRE/OgreEntity.h>
 #include <OGRE/OgreMaterial.h>
 #include <OGRE/OgreMaterialManager.h>
+#include <OGRE/OgrePass.h>
 #include <OGRE/OgreRibbonTrail.h>
 #include <OGRE/OgreSceneManager.h>
 #include <OGRE/OgreSceneNode.h>
 #include <OGRE/OgreSubEntity.h>
+#include <OGRE/OgreTechnique.h>
 #include <OGRE/OgreTextureManager.h>
 
 #include <ros/console.h>
@@ -297,6 +299,12 @@ RobotLink::RobotLink( Robot* robot,
 
 RobotLink::~RobotLink()
 {
+  M_SubEntityToMaterial::iterator mat_it;
+  for( mat_it = materials_.begin(); mat_it != materials_.end(); ++mat_it )
+  {
+    MaterialCache::get()->release( mat_it->second );
+  }
+
   for( size_t i = 0; i < visual_meshes_.size(); i++ )
   {
     scene_manager_->destroyEntity( visual_meshes_[ i ]);
@@ -356,6 +364,18 @@ void RobotLink::setRenderQueueGroup( Ogre::uint8 group )
   }
 }
 
+void RobotLink::setMeshLodBias( float bias )
+{
+  for( size_t i = 0; i < visual_meshes_.size(); i++ )
+  {
+    visual_meshes_[ i ]->setMeshLodBias( bias );
+  }
+  for( size_t i = 0; i < collision_meshes_.size(); i++ )
+  {
+    collision_meshes_[ i ]->setMeshLodBias( bias );
+  }
+}
+
 void RobotLink::setOnlyRenderDepth(bool onlyRenderDepth)
 {
   setRenderQueueGroup( onlyRenderDepth ? Ogre::RENDER_QUEUE_BACKGROUND : Ogre::RENDER_QUEUE_MAIN );
@@ -366,34 +386,11 @@ void RobotLink::setOnlyRenderDepth(bool onlyRenderDepth)
 void RobotLink::updateAlpha()
 {
   float link_alpha = alpha_property_->getFloat();
-  M_SubEntityToMaterial::iterator it = materials_.begin();
-  M_SubEntityToMaterial::iterator end = materials_.end();
+  M_SubEntityToMaterialKey::iterator it = material_keys_.begin();
+  M_SubEntityToMaterialKey::iterator end = material_keys_.end();
   for (; it != end; ++it)
   {
-    const Ogre::MaterialPtr& material = it->second;
-
-    if ( only_render_depth_ )
-    {
-      material->setColourWriteEnabled( false );
-      material->setDepthWriteEnabled( true );
-    }
-    else
-    {
-      Ogre::ColourValue color = material->getTechnique(0)->getPass(0)->getDiffuse();
-      color.a = robot_alpha_ * material_alpha_ * link_alpha;
-      material->setDiffuse( color );
-
-      if ( color.a < 0.9998 )
-      {
-        material->setSceneBlending( Ogre::SBT_TRANSPARENT_ALPHA );
-        material->setDepthWriteEnabled( false );
-      }
-      else
-      {
-        material->setSceneBlending( Ogre::SBT_REPLACE );
-        material->setDepthWriteEnabled( true );
-      }
-    }
+    assignMaterial( it->first, it->second );
   }
 
   Ogre::ColourValue color = color_material_->getTechnique(0)->getPass(0)->getDiffuse();
@@ -436,24 +433,31 @@ void RobotLink::updateVisibility()
   }
 }
 
-Ogre::MaterialPtr RobotLink::getMaterialForLink( const urdf::LinkConstPtr& link)
+/** @brief Key describing @a material as it is, so the cache can clone it with a different alpha. */
+static MaterialCache::Key getMaterialKey( const Ogre::MaterialPtr& material )
+{
+  MaterialCache::Key key;
+  key.base_material = material->getName();
+  Ogre::Pass* pass = material->getTechnique(0)->getPass(0);
+  key.ambient = pass->getAmbient();
+  key.diffuse = pass->getDiffuse();
+  key.lighting = pass->getLightingEnabled();
+  return key;
+}
+
+MaterialCache::Key RobotLink::getMaterialKeyForLink( const urdf::LinkConstPtr& link)
 {
   if (!link->visual || !link->visual->material)
   {
-    return Ogre::MaterialManager::getSingleton().getByName("RVIZ/ShadedRed");
+    return getMaterialKey( Ogre::MaterialManager::getSingleton().getByName("RVIZ/ShadedRed") );
   }
 
-  static int count = 0;
-  std::stringstream ss;
-  ss << "Robot Link Material" << count;
-
-  Ogre::MaterialPtr mat = Ogre::MaterialManager::getSingleton().create(ss.str(), ROS_PACKAGE_NAME);
-  mat->getTechnique(0)->setLightingEnabled(true);
+  MaterialCache::Key key;
   if (link->visual->material->texture_filename.empty())
   {
     const urdf::Color& col = link->visual->material->color;
-    mat->getTechnique(0)->setAmbient(col.r * 0.5, col.g * 0.5, col.b * 0.5);
-    mat->getTechnique(0)->setDiffuse(col.r, col.g, col.b, col.a);
+    key.ambient = Ogre::ColourValue(col.r * 0.5, col.g * 0.5, col.b * 0.5);
+    key.diffuse = Ogre::ColourValue(col.r, col.g, col.b, col.a);
 
     material_alpha_ = col.a;
   }
@@ -496,14 +500,39 @@ Ogre::MaterialPtr RobotLink::getMaterialForLink( const urdf::LinkConstPtr& link)
       }
     }
 
-    Ogre::Pass* pass = mat->getTechnique(0)->getPass(0);
-    Ogre::TextureUnitState* tex_unit = pass->createTextureUnitState();;
-    tex_unit->setTextureName(filename);
+    key.ambient = Ogre::ColourValue::White;
+    key.texture = filename;
   }
 
-  return mat;
+  return key;
 }
 
+void RobotLink::assignMaterial( Ogre::SubEntity* sub, const MaterialCache::Key& base_key )
+{
+  MaterialCache::Key key = base_key;
+  key.diffuse.a = robot_alpha_ * material_alpha_ * alpha_property_->getFloat();
+  key.depth_only = only_render_depth_;
+
+  Ogre::MaterialPtr material = MaterialCache::get()->acquire( key );
+  Ogre::MaterialPtr& current = materials_[ sub ];
+  if( current == material )
+  {
+    MaterialCache::get()->release( material );
+    return;
+  }
+
+  // Leave the color and error materials in place; setToNormalMaterial() picks up the new one.
+  if( !using_color_ && ( current.isNull() || sub->getMaterial() == current ))
+  {
+    sub->setMaterial( material );
+  }
+
+  MaterialCache::get()->release( current );
+  current = material;
+}
+
+
+
 void RobotLink::createEntityForGeometryElement(const urdf::LinkConstPtr& link, const urdf::Geometry& geom, const urdf::Pose& origin, Ogre::SceneNode* scene_node, Ogre::Entity*& entity)
 {
   entity = NULL; // default in case nothing works.
@@ -601,42 +630,26 @@ void RobotLink::createEntityForGeometryElement(const urdf::LinkConstPtr& link, c
     offset_node->setPosition(offset_position);
     offset_node->setOrientation(offset_orientation);
 
-    if (default_material_name_.empty())
-    {
-      default_material_ = getMaterialForLink(link);
-
-      static int count = 0;
-      std::stringstream ss;
-      ss << default_material_->getName() << count++ << "Robot";
-      std::string cloned_name = ss.str();
-
-      default_material_ = default_material_->clone(cloned_name);
-      default_material_name_ = default_material_->getName();
-    }
+    MaterialCache::Key default_key = getMaterialKeyForLink(link);
 
     for (uint32_t i = 0; i < entity->getNumSubEntities(); ++i)
     {
-      // Assign materials only if the submesh does not have one already
+      // Use the link's material only if the submesh does not have one already.
+      // Selection colors are set per renderable, so links with the same
+      // appearance can share one material from the cache.
       Ogre::SubEntity* sub = entity->getSubEntity(i);
       const std::string& material_name = sub->getMaterialName();
 
       if (material_name == "BaseWhite" || material_name == "BaseWhiteNoLighting")
       {
-        sub->setMaterialName(default_material_name_);
+        material_keys_[sub] = default_key;
       }
       else
       {
-        // Need to clone here due to how selection works.  Once selection id is done per object and not per material,
-        // this can go away
-        static int count = 0;
-        std::stringstream ss;
-        ss << material_name << count++ << "Robot";
-        std::string cloned_name = ss.str();
-        sub->getMaterial()->clone(cloned_name);
-        sub->setMaterialName(cloned_name);
+        material_keys_[sub] = getMaterialKey(sub->getMaterial());
       }
 
-      materials_[sub] = sub->getMaterial();
+      assignMaterial(sub, material_keys_[sub]);
     }
   }
 }
@@ -855,6 +868,20 @@ void RobotLink::setToNormalMaterial()
   }
 }
 
+Ogre::MaterialPtr RobotLink::getNormalMaterial( Ogre::SubEntity* sub ) const
+{
+  if( using_color_ )
+  {
+    return color_material_;
+  }
+  M_SubEntityToMaterial::const_iterator it = materials_.find( sub );
+  if( it != materials_.end() )
+  {
+    return it->second;
+  }
+  return sub->getMaterial();
+}
+
 void RobotLink::setColor( float red, float green, float blue )
 {
   Ogre::ColourValue color = color_material_->getTechnique(0)->getPass(0)->getDiffuse();
@@ -866,12 +893,14 @@ void RobotLink::setColor( float red, float green, float blue )
 
   using_color_ = true;
   setToNormalMaterial();
+  robot_->updateInstanceMaterials( this );
 }
 
 void RobotLink::unsetColor()
 {
   using_color_ = false;
   setToNormalMaterial();
+  robot_->updateInstanceMaterials( this );
 }
 
 bool RobotLink::setSelectable( bool selectable )
@@ -40,6 +40,7 @@
 #include <OGRE/OgreAny.h>
 #include <OGRE/OgreMaterial.h>
 
+#include "rviz/ogre_helpers/material_cache.h"
 #include "rviz/ogre_helpers/object.h"
 #include "rviz/selection/forwards.h"
 
@@ -98,6 +99,9 @@ public:
 
   virtual void setRobotAlpha(float a);
 
+  /** @brief Scale the screen size at which the link meshes switch to simplified LOD levels. */
+  void setMeshLodBias( float bias );
+
   virtual void setTransforms(const Ogre::Vector3& visual_position, const Ogre::Quaternion& visual_orientation,
                      const Ogre::Vector3& collision_position, const Ogre::Quaternion& collision_orientation);
 
@@ -119,6 +123,12 @@ public:
   void setToErrorMaterial();
   void setToNormalMaterial();
 
+  /** @brief The entities of the visual meshes, for drawing extra poses of the link (see Robot::setInstances()). */
+  const std::vector<Ogre::Entity*>& getVisualMeshes() const { return visual_meshes_; }
+
+  /** @brief The material @a sub has when the link is drawn normally, even while it shows the error material. */
+  Ogre::MaterialPtr getNormalMaterial( Ogre::SubEntity* sub ) const;
+
   void setColor( float red, float green, float blue );
   void unsetColor();
 
@@ -164,7 +174,8 @@ private:
   void createVisual( const urdf::LinkConstPtr& link);
   void createCollision( const urdf::LinkConstPtr& link);
   void createSelection();
-  Ogre::MaterialPtr getMaterialForLink( const urdf::LinkConstPtr& link );
+  MaterialCache::Key getMaterialKeyForLink( const urdf::LinkConstPtr& link );
+  void assignMaterial( Ogre::SubEntity* sub, const MaterialCache::Key& key );
 
 
 protected:
@@ -189,9 +200,9 @@ protected:
 
 private:
   typedef std::map<Ogre::SubEntity*, Ogre::MaterialPtr> M_SubEntityToMaterial;
-  M_SubEntityToMaterial materials_;
-  Ogre::MaterialPtr default_material_;
-  std::string default_material_name_;
+  M_SubEntityToMaterial materials_; ///< Shared materials from MaterialCache, one reference held per sub-entity.
+  typedef std::map<Ogre::SubEntity*, MaterialCache::Key> M_SubEntityToMaterialKey;
+  M_SubEntityToMaterialKey material_keys_; ///< Appearance of each sub-entity before link and robot alpha are applied.
 
   std::vector<Ogre::Entity*> visual_meshes_;    ///< The entities representing the visual mesh of this link (if they exist)
   std::vector<Ogre::Entity*> collision_meshes_; ///< The entities representing the collision mesh of this link (if they exist)
@@ -0,0 +1,681 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <map>
+
+#include <boost/bind.hpp>
+
+#include <tf/transform_datatypes.h>
+#include <tf/transform_listener.h>
+
+#include "rviz/display_context.h"
+#include "rviz/display_group.h"
+#include "rviz/frame_manager.h"
+#include "rviz/message_filter_display.h"
+
+#include "rviz/session_recorder.h"
+
+#define SESSION_MAGIC "RVIZSES"
+#define SESSION_VERSION 1
+#define SESSION_CHUNK_SIZE (16 * 1024 * 1024)
+
+// How far back transforms are replayed when seeking.  Matches the
+// default cache time of tf::TransformListener.
+#define SESSION_TF_WINDOW 10.0
+
+namespace rviz
+{
+
+const char* SESSION_TF_CHANNEL = "/tf";
+
+static uint64_t align8( uint64_t value )
+{
+  return ( value + 7 ) & ~(uint64_t)7;
+}
+
+static bool writeAll( int fd, const void* data, size_t size, off_t offset )
+{
+  const uint8_t* p = (const uint8_t*)data;
+  while( size > 0 )
+  {
+    ssize_t written = pwrite( fd, p, size, offset );
+    if( written < 0 )
+    {
+      if( errno == EINTR )
+      {
+        continue;
+      }
+      return false;
+    }
+    p += written;
+    size -= written;
+    offset += written;
+  }
+  return true;
+}
+
+static bool compareEntries( const SessionIndexEntry& a, const SessionIndexEntry& b )
+{
+  return a.stamp < b.stamp;
+}
+
+SessionRecorder::SessionRecorder( const ros::NodeHandle& nh )
+  : nh_( nh )
+  , fd_( -1 )
+  , chunk_( 0 )
+  , chunk_offset_( 0 )
+  , chunk_size_( 0 )
+  , write_offset_( 0 )
+  , start_stamp_( 0 )
+  , end_stamp_( 0 )
+{
+}
+
+SessionRecorder::~SessionRecorder()
+{
+  stop();
+}
+
+bool SessionRecorder::start( const std::string& path, tf::TransformListener* tf, std::string* error )
+{
+  stop();
+
+  {
+    boost::mutex::scoped_lock lock( mutex_ );
+
+    int fd = ::open( path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644 );
+    if( fd < 0 )
+    {
+      *error = "Unable to create " + path + ": " + strerror( errno );
+      return false;
+    }
+
+    fd_ = fd;
+    path_ = path;
+    channels_.clear();
+    channel_ids_.clear();
+    start_stamp_ = ros::Time::now().toNSec();
+    end_stamp_ = start_stamp_;
+    chunk_offset_ = 0;
+    write_offset_ = sizeof( SessionFileHeader );
+
+    if( !mapChunk( 0 ))
+    {
+      *error = "Unable to map " + path + ": " + strerror( errno );
+      ::close( fd_ );
+      fd_ = -1;
+      return false;
+    }
+
+    SessionFileHeader header;
+    memset( &header, 0, sizeof( header ));
+    strncpy( header.magic, SESSION_MAGIC, sizeof( header.magic ));
+    header.version = SESSION_VERSION;
+    header.index_offset = 0;
+    memcpy( chunk_, &header, sizeof( header ));
+  }
+
+  // Snapshot of the tf buffer: the latest transform of every frame
+  // which has a parent.
+  if( tf )
+  {
+    tf::tfMessage snapshot;
+    std::vector<std::string> frames;
+    tf->getFrameStrings( frames );
+    for( size_t i = 0; i < frames.size(); i++ )
+    {
+      std::string parent;
+      tf::StampedTransform transform;
+      try
+      {
+        if( !tf->getParent( frames[ i ], ros::Time(), parent ))
+        {
+          continue;
+        }
+        tf->lookupTransform( parent, frames[ i ], ros::Time(), transform );
+      }
+      catch( tf::TransformException& e )
+      {
+        continue;
+      }
+      geometry_msgs::TransformStamped msg;
+      tf::transformStampedTFToMsg( transform, msg );
+      snapshot.transforms.push_back( msg );
+    }
+    record( SESSION_TF_CHANNEL, snapshot );
+  }
+
+  tf_sub_ = nh_.subscribe( "/tf", 100, &SessionRecorder::incomingTF, this );
+  return true;
+}
+
+void SessionRecorder::stop()
+{
+  tf_sub_.shutdown();
+
+  boost::mutex::scoped_lock lock( mutex_ );
+  if( fd_ < 0 )
+  {
+    return;
+  }
+
+  writeIndex();
+  ::close( fd_ );
+  fd_ = -1;
+}
+
+bool SessionRecorder::isRecording() const
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  return fd_ >= 0;
+}
+
+void SessionRecorder::incomingTF( const tf::tfMessage::ConstPtr& msg )
+{
+  record( SESSION_TF_CHANNEL, *msg );
+}
+
+bool SessionRecorder::mapChunk( uint64_t size )
+{
+  if( chunk_ && write_offset_ + size <= chunk_size_ )
+  {
+    return true;
+  }
+
+  // Remap so the new chunk starts at the page containing the write
+  // position; records never straddle two mappings.
+  uint64_t page_size = sysconf( _SC_PAGESIZE );
+  uint64_t position = chunk_offset_ + write_offset_;
+  uint64_t offset = position - position % page_size;
+  uint64_t chunk_size = std::max<uint64_t>( SESSION_CHUNK_SIZE, position - offset + size );
+  chunk_size = ( chunk_size + page_size - 1 ) / page_size * page_size;
+
+  unmapChunk();
+
+  if( ftruncate( fd_, offset + chunk_size ) != 0 )
+  {
+    return false;
+  }
+
+  void* chunk = mmap( 0, chunk_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, offset );
+  if( chunk == MAP_FAILED )
+  {
+    return false;
+  }
+
+  chunk_ = (uint8_t*)chunk;
+  chunk_offset_ = offset;
+  chunk_size_ = chunk_size;
+  write_offset_ = position - offset;
+  return true;
+}
+
+void SessionRecorder::unmapChunk()
+{
+  if( chunk_ )
+  {
+    munmap( chunk_, chunk_size_ );
+    chunk_ = 0;
+  }
+}
+
+void SessionRecorder::write( const std::string& channel, const std::string& datatype, const std::string& md5sum,
+                             const ros::Time& stamp, const uint8_t* data, uint32_t size )
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  if( fd_ < 0 )
+  {
+    return;
+  }
+
+  uint32_t id;
+  std::map<std::string, uint32_t>::iterator it = channel_ids_.find( channel );
+  if( it == channel_ids_.end() )
+  {
+    id = channels_.size();
+    channel_ids_[ channel ] = id;
+    Channel new_channel;
+    new_channel.name = channel;
+    new_channel.datatype = datatype;
+    new_channel.md5sum = md5sum;
+    channels_.push_back( new_channel );
+  }
+  else
+  {
+    id = it->second;
+  }
+
+  uint64_t record_size = align8( sizeof( SessionRecordHeader ) + size );
+  if( !mapChunk( record_size ))
+  {
+    ROS_ERROR( "Unable to extend session file %s: %s", path_.c_str(), strerror( errno ));
+    return;
+  }
+
+  SessionRecordHeader header;
+  header.channel = id;
+  header.size = size;
+  header.stamp = stamp.toNSec();
+
+  uint8_t* p = chunk_ + write_offset_;
+  memcpy( p, &header, sizeof( header ));
+  if( size > 0 )
+  {
+    memcpy( p + sizeof( header ), data, size );
+  }
+
+  SessionIndexEntry entry;
+  entry.stamp = header.stamp;
+  entry.record_offset = chunk_offset_ + write_offset_;
+  channels_[ id ].entries.push_back( entry );
+
+  write_offset_ += record_size;
+  end_stamp_ = std::max( end_stamp_, header.stamp );
+}
+
+void SessionRecorder::writeIndex()
+{
+  uint64_t index_offset = chunk_offset_ + write_offset_;
+  unmapChunk();
+
+  // Compute where each channel's entry array goes.
+  uint64_t offset = index_offset + sizeof( SessionIndexHeader );
+  for( size_t i = 0; i < channels_.size(); i++ )
+  {
+    offset += sizeof( SessionChannelHeader );
+    offset += align8( channels_[ i ].name.size() );
+    offset += align8( channels_[ i ].datatype.size() );
+    offset += align8( channels_[ i ].md5sum.size() );
+  }
+
+  std::vector<uint8_t> index;
+  SessionIndexHeader index_header;
+  memset( &index_header, 0, sizeof( index_header ));
+  index_header.num_channels = channels_.size();
+  index_header.start_stamp = start_stamp_;
+  index_header.end_stamp = end_stamp_;
+  index.insert( index.end(), (uint8_t*)&index_header, (uint8_t*)&index_header + sizeof( index_header ));
+
+  std::vector<uint8_t> entries;
+  for( size_t i = 0; i < channels_.size(); i++ )
+  {
+    Channel& channel = channels_[ i ];
+
+    // Records arrive in receive order, which is almost always sorted already.
+    std::stable_sort( channel.entries.begin(), channel.entries.end(), compareEntries );
+
+    SessionChannelHeader header;
+    memset( &header, 0, sizeof( header ));
+    header.name_length = channel.name.size();
+    header.datatype_length = channel.datatype.size();
+    header.md5sum_length = channel.md5sum.size();
+    header.entries_offset = offset + entries.size();
+    header.num_entries = channel.entries.size();
+    index.insert( index.end(), (uint8_t*)&header, (uint8_t*)&header + sizeof( header ));
+
+    const std::string* strings[3] = { &channel.name, &channel.datatype, &channel.md5sum };
+    for( int s = 0; s < 3; s++ )
+    {
+      index.insert( index.end(), strings[ s ]->begin(), strings[ s ]->end() );
+      index.resize( align8( index.size() ), 0 );
+    }
+
+    if( !channel.entries.empty() )
+    {
+      const uint8_t* begin = (const uint8_t*)&channel.entries.front();
+      entries.insert( entries.end(), begin, begin + channel.entries.size() * sizeof( SessionIndexEntry ));
+    }
+  }
+  index.insert( index.end(), entries.begin(), entries.end() );
+
+  bool ok = ftruncate( fd_, index_offset + index.size() ) == 0;
+  ok = ok && writeAll( fd_, &index.front(), index.size(), index_offset );
+
+  // Only mark the file complete once the index is on disk.
+  SessionFileHeader file_header;
+  ok = ok && pread( fd_, &file_header, sizeof( file_header ), 0 ) == sizeof( file_header );
+  file_header.index_offset = index_offset;
+  ok = ok && writeAll( fd_, &file_header, sizeof( file_header ), 0 );
+
+  if( !ok )
+  {
+    ROS_ERROR( "Unable to write the index of session file %s: %s", path_.c_str(), strerror( errno ));
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+SessionReader::SessionReader()
+  : fd_( -1 )
+  , data_( 0 )
+  , size_( 0 )
+{
+}
+
+SessionReader::~SessionReader()
+{
+  close();
+}
+
+bool SessionReader::open( const std::string& path, std::string* error )
+{
+  close();
+
+  fd_ = ::open( path.c_str(), O_RDONLY );
+  if( fd_ < 0 )
+  {
+    *error = "Unable to open " + path + ": " + strerror( errno );
+    return false;
+  }
+
+  struct stat st;
+  if( fstat( fd_, &st ) != 0 || (uint64_t)st.st_size < sizeof( SessionFileHeader ))
+  {
+    *error = path + " is not a session file.";
+    close();
+    return false;
+  }
+
+  void* data = mmap( 0, st.st_size, PROT_READ, MAP_SHARED, fd_, 0 );
+  if( data == MAP_FAILED )
+  {
+    *error = "Unable to map " + path + ": " + strerror( errno );
+    close();
+    return false;
+  }
+  data_ = (const uint8_t*)data;
+  size_ = st.st_size;
+
+  const SessionFileHeader* header = (const SessionFileHeader*)data_;
+  if( strncmp( header->magic, SESSION_MAGIC, sizeof( header->magic )) != 0 ||
+      header->version != SESSION_VERSION )
+  {
+    *error = path + " is not a session file of a supported version.";
+    close();
+    return false;
+  }
+  if( header->index_offset == 0 || header->index_offset + sizeof( SessionIndexHeader ) > size_ )
+  {
+    *error = path + " is incomplete; the recording was not stopped properly.";
+    close();
+    return false;
+  }
+
+  const SessionIndexHeader* index = (const SessionIndexHeader*)( data_ + header->index_offset );
+  start_time_.fromNSec( index->start_stamp );
+  end_time_.fromNSec( index->end_stamp );
+
+  uint64_t offset = header->index_offset + sizeof( SessionIndexHeader );
+  for( uint32_t i = 0; i < index->num_channels; i++ )
+  {
+    if( offset + sizeof( SessionChannelHeader ) > size_ )
+    {
+      break;
+    }
+    const SessionChannelHeader* ch = (const SessionChannelHeader*)( data_ + offset );
+    offset += sizeof( SessionChannelHeader );
+
+    uint64_t strings_size = align8( ch->name_length ) + align8( ch->datatype_length ) + align8( ch->md5sum_length );
+    if( offset + strings_size > size_ ||
+        ch->entries_offset + ch->num_entries * sizeof( SessionIndexEntry ) > size_ )
+    {
+      break;
+    }
+
+    Channel channel;
+    channel.name.assign( (const char*)data_ + offset, ch->name_length );
+    offset += align8( ch->name_length );
+    channel.datatype.assign( (const char*)data_ + offset, ch->datatype_length );
+    offset += align8( ch->datatype_length );
+    channel.md5sum.assign( (const char*)data_ + offset, ch->md5sum_length );
+    offset += align8( ch->md5sum_length );
+    channel.entries = (const SessionIndexEntry*)( data_ + ch->entries_offset );
+    channel.num_entries = ch->num_entries;
+    channels_.push_back( channel );
+  }
+
+  return true;
+}
+
+void SessionReader::close()
+{
+  if( data_ )
+  {
+    munmap( const_cast<uint8_t*>( data_ ), size_ );
+    data_ = 0;
+    size_ = 0;
+  }
+  if( fd_ >= 0 )
+  {
+    ::close( fd_ );
+    fd_ = -1;
+  }
+  channels_.clear();
+}
+
+int SessionReader::findChannel( const std::string& name ) const
+{
+  for( size_t i = 0; i < channels_.size(); i++ )
+  {
+    if( channels_[ i ].name == name )
+    {
+      return i;
+    }
+  }
+  return -1;
+}
+
+bool SessionReader::makeRecord( const SessionIndexEntry& entry, Record* record ) const
+{
+  if( entry.record_offset > size_ || size_ - entry.record_offset < sizeof( SessionRecordHeader ))
+  {
+    return false;
+  }
+  const SessionRecordHeader* header = (const SessionRecordHeader*)( data_ + entry.record_offset );
+  if( header->size > size_ - entry.record_offset - sizeof( SessionRecordHeader ))
+  {
+    return false;
+  }
+  record->stamp.fromNSec( header->stamp );
+  record->data = data_ + entry.record_offset + sizeof( SessionRecordHeader );
+  record->size = header->size;
+  return true;
+}
+
+bool SessionReader::findLatest( int channel, const ros::Time& time, Record* record ) const
+{
+  const Channel& ch = channels_[ channel ];
+  SessionIndexEntry key;
+  key.stamp = time.toNSec();
+  key.record_offset = 0;
+
+  const SessionIndexEntry* end = ch.entries + ch.num_entries;
+  const SessionIndexEntry* it = std::upper_bound( ch.entries, end, key, compareEntries );
+  if( it == ch.entries )
+  {
+    return false;
+  }
+  return makeRecord( *( it - 1 ), record );
+}
+
+void SessionReader::getRecords( int channel, const ros::Time& begin, const ros::Time& end, std::vector<Record>* records ) const
+{
+  const Channel& ch = channels_[ channel ];
+  SessionIndexEntry key;
+  key.record_offset = 0;
+
+  key.stamp = begin.toNSec();
+  const SessionIndexEntry* first = std::lower_bound( ch.entries, ch.entries + ch.num_entries, key, compareEntries );
+  key.stamp = end.toNSec();
+  const SessionIndexEntry* last = std::upper_bound( ch.entries, ch.entries + ch.num_entries, key, compareEntries );
+
+  records->clear();
+  for( const SessionIndexEntry* it = first; it < last; ++it )
+  {
+    Record record;
+    if( makeRecord( *it, &record ))
+    {
+      records->push_back( record );
+    }
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+SessionPlayer::SessionPlayer( DisplayContext* context )
+  : context_( context )
+{
+}
+
+bool SessionPlayer::open( const std::string& path, std::string* error )
+{
+  return reader_.open( path, error );
+}
+
+void SessionPlayer::close()
+{
+  if( reader_.isOpen() )
+  {
+    context_->getFrameManager()->setTransformer( 0 );
+    tf_.clear();
+  }
+  reader_.close();
+}
+
+void SessionPlayer::seek( const ros::Time& time )
+{
+  if( !reader_.isOpen() )
+  {
+    return;
+  }
+
+  replayTF( time );
+  replayDisplays( context_->getRootDisplayGroup(), time );
+  context_->queueRender();
+}
+
+void SessionPlayer::replayTF( const ros::Time& time )
+{
+  int channel = reader_.findChannel( SESSION_TF_CHANNEL );
+  if( channel < 0 )
+  {
+    return;
+  }
+
+  // Only the last few seconds of transforms are replayed, preceded by
+  // the snapshot taken when recording started, which provides frames
+  // that are never republished.
+  const SessionReader::Channel& ch = reader_.getChannel( channel );
+  std::vector<SessionReader::Record> records;
+  std::vector<SessionReader::Record> window;
+  ros::Time begin = time - ros::Duration( SESSION_TF_WINDOW );
+  if( ch.num_entries > 0 && ch.entries[ 0 ].stamp < begin.toNSec() )
+  {
+    ros::Time first;
+    first.fromNSec( ch.entries[ 0 ].stamp );
+    reader_.getRecords( channel, first, first, &records );
+  }
+  reader_.getRecords( channel, begin, time, &window );
+  records.insert( records.end(), window.begin(), window.end() );
+
+  std::map<std::string, geometry_msgs::TransformStamped> latest;
+  for( size_t i = 0; i < records.size(); i++ )
+  {
+    tf::tfMessage msg;
+    if( !reader_.decode( channel, records[ i ], msg ))
+    {
+      return;
+    }
+    for( size_t j = 0; j < msg.transforms.size(); j++ )
+    {
+      latest[ msg.transforms[ j ].child_frame_id ] = msg.transforms[ j ];
+    }
+  }
+
+  // The live listener keeps receiving transforms; lookups go to the
+  // playback buffer until close().  Only the latest transform of each
+  // frame is kept, all stamped with the seek time so that lookups of
+  // the latest transform (replayed messages have their stamps
+  // cleared) find a common time for every chain.
+  tf_.clear();
+  std::map<std::string, geometry_msgs::TransformStamped>::iterator it;
+  for( it = latest.begin(); it != latest.end(); ++it )
+  {
+    tf::StampedTransform transform;
+    tf::transformStampedMsgToTF( it->second, transform );
+    transform.stamp_ = time;
+    tf_.setTransform( transform, "rviz_session_playback" );
+  }
+  context_->getFrameManager()->setTransformer( &tf_ );
+}
+
+void SessionPlayer::replayDisplays( DisplayGroup* group, const ros::Time& time )
+{
+  for( int i = 0; i < group->numDisplays(); i++ )
+  {
+    Display* display = group->getDisplayAt( i );
+    if( !display->isEnabled() )
+    {
+      continue;
+    }
+
+    DisplayGroup* child_group = qobject_cast<DisplayGroup*>( display );
+    if( child_group )
+    {
+      replayDisplays( child_group, time );
+      continue;
+    }
+
+    _RosTopicDisplay* topic_display = dynamic_cast<_RosTopicDisplay*>( display );
+    if( !topic_display )
+    {
+      continue;
+    }
+
+    int channel = reader_.findChannel( topic_display->getTopicStd() );
+    SessionReader::Record record;
+    if( channel < 0 || !reader_.findLatest( channel, time, &record ))
+    {
+      continue;
+    }
+
+    topic_display->reset();
+    topic_display->replayMessage( reader_.getChannel( channel ).md5sum, record.data, record.size );
+  }
+}
+
+} // namespace rviz
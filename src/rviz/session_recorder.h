@@ -0,0 +1,320 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RVIZ_SESSION_RECORDER_H
+#define RVIZ_SESSION_RECORDER_H
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#ifndef Q_MOC_RUN
+#include <boost/thread/mutex.hpp>
+
+#include <ros/message_traits.h>
+#include <ros/node_handle.h>
+#include <ros/serialization.h>
+#include <ros/subscriber.h>
+#include <ros/time.h>
+
+#include <tf/tf.h>
+#include <tf/tfMessage.h>
+#endif
+
+namespace tf
+{
+class TransformListener;
+}
+
+namespace rviz
+{
+
+class DisplayContext;
+class DisplayGroup;
+
+/**
+ * On-disk layout of a session file.  All integers are in host byte
+ * order, and every structure starts at a multiple of 8 bytes, so the
+ * file can be used in place through a read-only memory mapping.
+ *
+ *  - SessionFileHeader
+ *  - records: SessionRecordHeader followed by the serialized message,
+ *    padded to 8 bytes
+ *  - index (at SessionFileHeader::index_offset):
+ *    - SessionIndexHeader
+ *    - num_channels x (SessionChannelHeader, name, datatype, md5sum),
+ *      strings padded to 8 bytes
+ *    - per channel, a SessionIndexEntry array sorted by stamp
+ */
+struct SessionFileHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t index_offset;  ///< 0 while recording, so unfinished files are detected.
+};
+
+struct SessionRecordHeader
+{
+  uint32_t channel;
+  uint32_t size;
+  uint64_t stamp;  ///< ros::Time::toNSec() of the moment the message was received.
+};
+
+struct SessionIndexHeader
+{
+  uint32_t num_channels;
+  uint32_t reserved;
+  uint64_t start_stamp;
+  uint64_t end_stamp;
+};
+
+struct SessionChannelHeader
+{
+  uint32_t name_length;
+  uint32_t datatype_length;
+  uint32_t md5sum_length;
+  uint32_t reserved;
+  uint64_t entries_offset;
+  uint64_t num_entries;
+};
+
+struct SessionIndexEntry
+{
+  uint64_t stamp;
+  uint64_t record_offset;  ///< Offset of the SessionRecordHeader.
+};
+
+/** @brief Name of the channel transforms are recorded in. */
+extern const char* SESSION_TF_CHANNEL;
+
+/**
+ * @brief Records the messages received by displays into a
+ * memory-mapped, chunked session file.
+ *
+ * Messages are stored serialized, one channel per topic, and the file
+ * is extended and mapped in chunks as it grows.  When recording
+ * starts, the current content of the tf buffer is stored as a
+ * snapshot, and every /tf message received afterwards is recorded as
+ * well.  The time index is written when recording stops.
+ *
+ * record() may be called from any thread.
+ */
+class SessionRecorder
+{
+public:
+  /** @param nh Node handle used to subscribe to /tf while recording. */
+  SessionRecorder( const ros::NodeHandle& nh );
+  ~SessionRecorder();
+
+  /** @brief Start recording to @a path.  Stores a snapshot of @a tf, if not NULL.
+   * @return false and sets @a error if the file could not be created. */
+  bool start( const std::string& path, tf::TransformListener* tf, std::string* error );
+
+  /** @brief Stop recording, and write the index. */
+  void stop();
+
+  bool isRecording() const;
+
+  const std::string& getPath() const { return path_; }
+
+  /** @brief Record @a msg in the channel named @a channel, stamped with the current time. */
+  template<class M>
+  void record( const std::string& channel, const M& msg )
+  {
+    if( !isRecording() )
+    {
+      return;
+    }
+
+    uint32_t size = ros::serialization::serializationLength( msg );
+    std::vector<uint8_t> buffer( size );
+    ros::serialization::OStream stream( buffer.empty() ? 0 : &buffer.front(), size );
+    ros::serialization::serialize( stream, msg );
+
+    write( channel, ros::message_traits::datatype<M>(), ros::message_traits::md5sum<M>(),
+           ros::Time::now(), buffer.empty() ? 0 : &buffer.front(), size );
+  }
+
+private:
+  struct Channel
+  {
+    std::string name;
+    std::string datatype;
+    std::string md5sum;
+    std::vector<SessionIndexEntry> entries;
+  };
+
+  void write( const std::string& channel, const std::string& datatype, const std::string& md5sum,
+              const ros::Time& stamp, const uint8_t* data, uint32_t size );
+
+  /** @brief Make sure @a size more bytes fit into the mapped chunk. */
+  bool mapChunk( uint64_t size );
+
+  void unmapChunk();
+
+  void incomingTF( const tf::tfMessage::ConstPtr& msg );
+
+  void writeIndex();
+
+  ros::NodeHandle nh_;
+  ros::Subscriber tf_sub_;
+
+  mutable boost::mutex mutex_;
+  std::string path_;
+  int fd_;
+
+  uint8_t* chunk_;          ///< Start of the mapped chunk.
+  uint64_t chunk_offset_;   ///< File offset of chunk_, a multiple of the page size.
+  uint64_t chunk_size_;     ///< Size of the mapped chunk.
+  uint64_t write_offset_;   ///< Offset of the next record, relative to chunk_offset_.
+
+  std::vector<Channel> channels_;
+  std::map<std::string, uint32_t> channel_ids_;
+  uint64_t start_stamp_;
+  uint64_t end_stamp_;
+};
+
+/**
+ * @brief Read-only view of a session file written by SessionRecorder.
+ *
+ * The whole file is memory mapped.  Lookups binary search the
+ * per-channel index inside the mapping, and messages are only
+ * deserialized when decode() is called.
+ */
+class SessionReader
+{
+public:
+  struct Record
+  {
+    ros::Time stamp;
+    const uint8_t* data;
+    uint32_t size;
+  };
+
+  struct Channel
+  {
+    std::string name;
+    std::string datatype;
+    std::string md5sum;
+    const SessionIndexEntry* entries;
+    uint64_t num_entries;
+  };
+
+  SessionReader();
+  ~SessionReader();
+
+  bool open( const std::string& path, std::string* error );
+  void close();
+  bool isOpen() const { return data_ != 0; }
+
+  ros::Time getStartTime() const { return start_time_; }
+  ros::Time getEndTime() const { return end_time_; }
+
+  /** @return the index of the channel, or -1 if it does not exist. */
+  int findChannel( const std::string& name ) const;
+
+  const Channel& getChannel( int index ) const { return channels_[ index ]; }
+
+  /** @brief Find the last record of a channel stamped at or before @a time.  O(log n). */
+  bool findLatest( int channel, const ros::Time& time, Record* record ) const;
+
+  /** @brief Get all records of a channel stamped in [begin, end]. */
+  void getRecords( int channel, const ros::Time& begin, const ros::Time& end, std::vector<Record>* records ) const;
+
+  /** @brief Deserialize a record into @a msg.  @return false if the message type does not match. */
+  template<class M>
+  bool decode( int channel, const Record& record, M& msg ) const
+  {
+    if( channels_[ channel ].md5sum != ros::message_traits::md5sum<M>() )
+    {
+      return false;
+    }
+    ros::serialization::IStream stream( const_cast<uint8_t*>( record.data ), record.size );
+    ros::serialization::deserialize( stream, msg );
+    return true;
+  }
+
+private:
+  /** @return false if @a entry points outside of the file. */
+  bool makeRecord( const SessionIndexEntry& entry, Record* record ) const;
+
+  int fd_;
+  const uint8_t* data_;
+  uint64_t size_;
+  std::vector<Channel> channels_;
+  ros::Time start_time_;
+  ros::Time end_time_;
+};
+
+/**
+ * @brief Feeds recorded messages back into the displays.
+ *
+ * While a session is open, displays ignore live messages.  seek()
+ * restores the recorded transforms into a buffer of the player's own,
+ * which the FrameManager uses for lookups until close(), and hands
+ * each enabled topic display the last message it received before the
+ * given time.  Only messages of enabled displays are decoded.
+ *
+ * Only displays derived from MessageFilterDisplay are recorded and
+ * replayed.  Displays with subscriptions of their own, such as
+ * MarkerDisplay and the image_transport based Image, Camera and
+ * DepthCloud displays, keep showing live data, so a replayed scene may
+ * be incomplete.  Transforms are replayed for all displays.
+ */
+class SessionPlayer
+{
+public:
+  SessionPlayer( DisplayContext* context );
+
+  bool open( const std::string& path, std::string* error );
+
+  /** @brief Stop playback and return to live data. */
+  void close();
+
+  bool isActive() const { return reader_.isOpen(); }
+
+  const SessionReader& getReader() const { return reader_; }
+
+  void seek( const ros::Time& time );
+
+private:
+  void replayTF( const ros::Time& time );
+  void replayDisplays( DisplayGroup* group, const ros::Time& time );
+
+  DisplayContext* context_;
+  SessionReader reader_;
+  tf::Transformer tf_;
+};
+
+} // namespace rviz
+
+#endif // RVIZ_SESSION_RECORDER_H
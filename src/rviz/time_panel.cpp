@@ -36,17 +36,35 @@
 #include <QCheckBox>
 #include <QSlider>
 #include <QComboBox>
+#include <QDateTime>
+#include <QDir>
 
 #include "visualization_manager.h"
 #include "frame_manager.h"
 
 #include "display_group.h"
+#include "session_recorder.h"
 
 #include "time_panel.h"
 
 namespace rviz
 {
 
+/** Number of session files kept in ~/.rviz, including the one being recorded. */
+static const int MAX_SESSION_FILES = 5;
+
+/** Delete the oldest session files in @a dir, so that a new one
+ * brings the count to MAX_SESSION_FILES. */
+static void removeOldSessions( const QDir& dir )
+{
+  // The names contain the start time, so sorting them sorts by age.
+  QStringList sessions = dir.entryList( QStringList( "session-*.rvs" ), QDir::Files, QDir::Name );
+  for( int i = 0; i + MAX_SESSION_FILES - 1 < sessions.size(); i++ )
+  {
+    dir.remove( sessions[ i ] );
+  }
+}
+
 TimePanel::TimePanel( QWidget* parent )
   : Panel( parent )
 {
@@ -74,6 +92,21 @@ TimePanel::TimePanel( QWidget* parent )
   sync_source_selector_->setSizeAdjustPolicy(QComboBox::AdjustToContents);
   sync_source_selector_->setToolTip("Time source to use for synchronization.");
 
+  record_button_ = new QPushButton( "Record" );
+  record_button_->setToolTip("Record incoming messages and transforms to a session file in ~/.rviz, and scrub through it when stopped.  "
+                             "Only topic displays based on message filters are recorded; markers and images stay live.  "
+                             "The last " + QString::number( MAX_SESSION_FILES ) + " sessions are kept.");
+  record_button_->setCheckable(true);
+
+  session_slider_ = new QSlider( Qt::Horizontal );
+  session_slider_->setToolTip("Position in the recorded session.");
+  session_slider_->setMinimumWidth( 150 );
+  session_slider_->setEnabled(false);
+
+  live_button_ = new QPushButton( "Live" );
+  live_button_->setToolTip("Close the recorded session and show live data again.");
+  live_button_->setEnabled(false);
+
   experimental_widget_ = new QWidget(this);
   QHBoxLayout* experimental_layout = new QHBoxLayout(this);
   experimental_layout->addWidget( pause_button_ );
@@ -81,6 +114,9 @@ TimePanel::TimePanel( QWidget* parent )
   experimental_layout->addWidget( sync_mode_selector_ );
   experimental_layout->addWidget( new QLabel( "Source:" ));
   experimental_layout->addWidget( sync_source_selector_ );
+  experimental_layout->addWidget( record_button_ );
+  experimental_layout->addWidget( session_slider_ );
+  experimental_layout->addWidget( live_button_ );
   experimental_layout->addSpacing(20);
   experimental_layout->setContentsMargins( 0, 0, 20, 0 );
   experimental_widget_->setLayout(experimental_layout);
@@ -112,6 +148,9 @@ TimePanel::TimePanel( QWidget* parent )
   connect( pause_button_, SIGNAL( toggled( bool )), this, SLOT( pauseToggled( bool ) ));
   connect( sync_mode_selector_, SIGNAL( activated( int )), this, SLOT( syncModeSelected( int ) ));
   connect( sync_source_selector_, SIGNAL( activated( int )), this, SLOT( syncSourceSelected( int ) ));
+  connect( record_button_, SIGNAL( toggled( bool )), this, SLOT( recordToggled( bool ) ));
+  connect( session_slider_, SIGNAL( valueChanged( int )), this, SLOT( sessionSliderMoved( int ) ));
+  connect( live_button_, SIGNAL( clicked() ), this, SLOT( liveClicked() ));
 }
 
 void TimePanel::onInitialize()
@@ -252,6 +291,77 @@ void TimePanel::experimentalToggled( bool checked )
   }
 }
 
+void TimePanel::recordToggled( bool checked )
+{
+  SessionRecorder* recorder = vis_manager_->getSessionRecorder();
+  SessionPlayer* player = vis_manager_->getSessionPlayer();
+  std::string error;
+
+  if( checked )
+  {
+    liveClicked();
+
+    QDir dir( QDir::homePath() );
+    dir.mkpath( ".rviz" );
+    dir.cd( ".rviz" );
+    removeOldSessions( dir );
+    QString path = dir.filePath( "session-" + QDateTime::currentDateTime().toString( "yyyyMMdd-hhmmss" ) + ".rvs" );
+    if( !recorder->start( path.toStdString(), vis_manager_->getTFClient(), &error ))
+    {
+      vis_manager_->setStatus( QString::fromStdString( error ));
+      record_button_->blockSignals( true );
+      record_button_->setChecked( false );
+      record_button_->blockSignals( false );
+      return;
+    }
+    vis_manager_->setStatus( "Recording session to " + path );
+    return;
+  }
+
+  recorder->stop();
+  if( !player->open( recorder->getPath(), &error ))
+  {
+    vis_manager_->setStatus( QString::fromStdString( error ));
+    return;
+  }
+
+  const SessionReader& reader = player->getReader();
+  int length = ( reader.getEndTime() - reader.getStartTime() ).toSec() * 1000;
+  session_slider_->blockSignals( true );
+  session_slider_->setRange( 0, length );
+  session_slider_->setValue( length );
+  session_slider_->blockSignals( false );
+  session_slider_->setEnabled( true );
+  live_button_->setEnabled( true );
+
+  player->seek( reader.getEndTime() );
+  vis_manager_->setStatus( "Playing back session " + QString::fromStdString( recorder->getPath() ));
+}
+
+void TimePanel::sessionSliderMoved( int msec )
+{
+  SessionPlayer* player = vis_manager_->getSessionPlayer();
+  if( player->isActive() )
+  {
+    player->seek( player->getReader().getStartTime() + ros::Duration( msec / 1000.0 ));
+  }
+}
+
+void TimePanel::liveClicked()
+{
+  SessionPlayer* player = vis_manager_->getSessionPlayer();
+  if( !player->isActive() )
+  {
+    return;
+  }
+
+  player->close();
+  session_slider_->setEnabled( false );
+  live_button_->setEnabled( false );
+  vis_manager_->resetTime();
+  vis_manager_->setStatus( "" );
+}
+
 void TimePanel::syncSourceSelected( int index )
 {
   // clear whatever was loaded from the config
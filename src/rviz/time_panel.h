@@ -38,6 +38,7 @@ class QComboBox;
 class QCheckBox;
 class QPushButton;
 class QHBoxLayout;
+class QSlider;
 class QWidget;
 
 namespace rviz
@@ -65,6 +66,15 @@ protected Q_SLOTS:
   void syncSourceSelected( int index );
   void experimentalToggled( bool checked );
 
+  /** Start recording a session, or stop and open it for playback. */
+  void recordToggled( bool checked );
+
+  /** Seek the open session to the slider position. */
+  void sessionSliderMoved( int msec );
+
+  /** Close the open session and return to live data. */
+  void liveClicked();
+
   /** Read time values from VisualizationManager and update displays. */
   void update();
 
@@ -95,6 +105,10 @@ protected:
   QComboBox* sync_source_selector_;
   QComboBox* sync_mode_selector_;
 
+  QPushButton* record_button_;
+  QSlider* session_slider_;
+  QPushButton* live_button_;
+
   QLineEdit* ros_time_label_;
   QLineEdit* ros_elapsed_label_;
   QLineEdit* wall_time_label_;
@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "rviz/topic_cache.h"
+
+namespace rviz
+{
+
+/** Seconds after which a read triggers a background refresh. */
+static const double MAX_TOPIC_AGE = 2.0;
+
+static bool topicNameLess( const ros::master::TopicInfo& a, const ros::master::TopicInfo& b )
+{
+  return a.name < b.name;
+}
+
+static bool topicEqual( const ros::master::TopicInfo& a, const ros::master::TopicInfo& b )
+{
+  return a.name == b.name && a.datatype == b.datatype;
+}
+
+TopicCache* TopicCache::instance_ = 0;
+
+TopicCache* TopicCache::get()
+{
+  if( instance_ == 0 )
+  {
+    instance_ = new TopicCache();
+  }
+  return instance_;
+}
+
+TopicCache::TopicCache()
+: fetched_( false )
+, fetching_( false )
+{
+}
+
+ros::master::V_TopicInfo TopicCache::getTopics()
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  prepareRead( lock );
+  return topics_;
+}
+
+std::vector<std::string> TopicCache::getTopicNames( const std::string& datatype )
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  prepareRead( lock );
+  M_TypeToNames::const_iterator it = names_by_type_.find( datatype );
+  if( it == names_by_type_.end() )
+  {
+    return std::vector<std::string>();
+  }
+  return it->second;
+}
+
+void TopicCache::refresh()
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  if( fetching_ )
+  {
+    return;
+  }
+  fetching_ = true;
+  // The thread object is destroyed right away, which detaches the thread.
+  boost::thread( boost::bind( &TopicCache::fetchTopics, this ));
+}
+
+void TopicCache::prepareRead( boost::mutex::scoped_lock& lock )
+{
+  if( !fetching_ && ( !fetched_ || (ros::WallTime::now() - fetch_time_).toSec() > MAX_TOPIC_AGE ))
+  {
+    fetching_ = true;
+    boost::thread( boost::bind( &TopicCache::fetchTopics, this ));
+  }
+}
+
+void TopicCache::fetchTopics()
+{
+  ros::master::V_TopicInfo topics;
+  ros::master::getTopics( topics );
+  // A failed fetch counts as well, so an unreachable master is only
+  // asked again once the empty list is stale.
+  setTopics( topics );
+
+  boost::mutex::scoped_lock lock( mutex_ );
+  fetching_ = false;
+}
+
+void TopicCache::setTopics( const ros::master::V_TopicInfo& new_topics )
+{
+  ros::master::V_TopicInfo topics = new_topics;
+  std::sort( topics.begin(), topics.end(), topicNameLess );
+
+  M_TypeToNames names_by_type;
+  ros::master::V_TopicInfo::const_iterator it;
+  for( it = topics.begin(); it != topics.end(); ++it )
+  {
+    names_by_type[ it->datatype ].push_back( it->name );
+  }
+
+  bool changed;
+  {
+    boost::mutex::scoped_lock lock( mutex_ );
+    changed = topics.size() != topics_.size() ||
+      !std::equal( topics.begin(), topics.end(), topics_.begin(), topicEqual );
+    topics_.swap( topics );
+    names_by_type_.swap( names_by_type );
+    fetch_time_ = ros::WallTime::now();
+    fetched_ = true;
+  }
+
+  if( changed )
+  {
+    Q_EMIT topicsChanged();
+  }
+}
+
+} // end namespace rviz
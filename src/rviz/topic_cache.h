@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RVIZ_TOPIC_CACHE_H
+#define RVIZ_TOPIC_CACHE_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <QObject>
+
+#ifndef Q_MOC_RUN
+#include <boost/thread/mutex.hpp>
+
+#include <ros/master.h>
+#include <ros/time.h>
+#endif
+
+namespace rviz
+{
+
+/**
+ * \brief Keeps a copy of the ROS master's topic list.
+ *
+ * Topic dropdowns, the transport lists of the image displays and the
+ * "By topic" tab of the Add Display dialog used to call
+ * ros::master::getTopics() on the GUI thread every time they opened,
+ * which blocks the whole window for the duration of an XMLRPC round
+ * trip.  TopicCache fetches the list on a background thread instead,
+ * keeps it sorted and indexed by message type, and refreshes it in the
+ * background whenever it is read after getting older than a couple of
+ * seconds.  Reads never wait for the master: before the first fetch has
+ * finished they return an empty list, and users fill themselves in when
+ * topicsChanged() arrives.
+ */
+class TopicCache: public QObject
+{
+Q_OBJECT
+public:
+  static TopicCache* get();
+
+  /** @brief Return all known topics, sorted by name. */
+  ros::master::V_TopicInfo getTopics();
+
+  /** @brief Return the sorted names of the known topics of message type @a datatype. */
+  std::vector<std::string> getTopicNames( const std::string& datatype );
+
+  /** @brief Start fetching the topic list in the background, unless a fetch is running already. */
+  void refresh();
+
+  /** @brief Replace the cached list with @a topics, as if a fetch had returned them.
+   *
+   * Sorts and indexes them, and emits topicsChanged() from the calling
+   * thread if they differ from the cached ones. */
+  void setTopics( const ros::master::V_TopicInfo& topics );
+
+Q_SIGNALS:
+  /** @brief Emitted from the fetching thread when a fetch found a
+   * different topic list.  Connections to GUI objects are queued. */
+  void topicsChanged();
+
+private:
+  TopicCache();
+
+  /** Start a fetch if there has not been one yet or the cached list is
+   * stale.  Does not wait for it.  @a lock must hold mutex_. */
+  void prepareRead( boost::mutex::scoped_lock& lock );
+
+  /** Body of the fetching thread. */
+  void fetchTopics();
+
+  typedef std::map<std::string, std::vector<std::string> > M_TypeToNames;
+
+  boost::mutex mutex_;
+  ros::master::V_TopicInfo topics_;
+  M_TypeToNames names_by_type_;
+  ros::WallTime fetch_time_;
+  bool fetched_;
+  bool fetching_;
+
+  static TopicCache* instance_;
+};
+
+} // end namespace rviz
+
+#endif // RVIZ_TOPIC_CACHE_H
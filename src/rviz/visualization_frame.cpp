@@ -29,13 +29,20 @@
 
 #include <fstream>
 
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+
 #include <QAction>
 #include <QApplication>
 #include <QCloseEvent>
+#include <QCryptographicHash>
 #include <QDesktopServices>
 #include <QDockWidget>
 #include <QDir>
+#include <QFile>
 #include <QFileDialog>
+#include <QFileInfo>
 #include <QMenu>
 #include <QMenuBar>
 #include <QMessageBox>
@@ -52,6 +59,7 @@
 #include <boost/algorithm/string/trim.hpp>
 #include <boost/bind.hpp>
 #include <boost/filesystem.hpp>
+#include <boost/thread/thread.hpp>
 
 #include <ros/console.h>
 #include <ros/package.h>
@@ -61,7 +69,11 @@
 #include <OGRE/OgreMeshManager.h>
 
 #include <ogre_helpers/initialization.h>
+#include <ogre_helpers/material_cache.h>
+#include <ogre_helpers/occlusion_culler.h>
 
+#include "rviz/binary_config_reader.h"
+#include "rviz/binary_config_writer.h"
 #include "rviz/displays_panel.h"
 #include "rviz/failed_panel.h"
 #include "rviz/help_panel.h"
@@ -92,6 +104,7 @@ namespace fs = boost::filesystem;
 #define CONFIG_EXTENSION "rviz"
 #define CONFIG_EXTENSION_WILDCARD "*."CONFIG_EXTENSION
 #define RECENT_CONFIG_COUNT 10
+#define AUTOSAVE_INTERVAL_MS 10000
 
 #if BOOST_FILESYSTEM_VERSION == 3
 #define BOOST_FILENAME_STRING filename().string
@@ -121,6 +134,8 @@ VisualizationFrame::VisualizationFrame( QWidget* parent )
   , geom_change_detector_( new WidgetGeometryChangeDetector( this ))
   , loading_( false )
   , post_load_timer_( new QTimer( this ))
+  , autosave_timer_( new QTimer( this ))
+  , autosave_thread_( NULL )
   , frame_count_(0)
 {
   panel_factory_ = new PanelFactory();
@@ -131,6 +146,10 @@ VisualizationFrame::VisualizationFrame( QWidget* parent )
   post_load_timer_->setSingleShot( true );
   connect( post_load_timer_, SIGNAL( timeout() ), this, SLOT( markLoadingDone() ));
 
+  autosave_timer_->setSingleShot( true );
+  autosave_timer_->setInterval( AUTOSAVE_INTERVAL_MS );
+  connect( autosave_timer_, SIGNAL( timeout() ), this, SLOT( autosave() ));
+
   package_path_ = ros::package::getPath("rviz");
   help_path_ = QString::fromStdString( (fs::path(package_path_) / "help/help.html").BOOST_FILE_STRING() );
   splash_path_ = QString::fromStdString( (fs::path(package_path_) / "images/splash.png").BOOST_FILE_STRING() );
@@ -150,11 +169,17 @@ VisualizationFrame::VisualizationFrame( QWidget* parent )
   fps_label_->setAlignment(Qt::AlignRight);
   statusBar()->addPermanentWidget( fps_label_, 0 );
 
+  material_label_ = new QLabel("");
+  material_label_->setAlignment(Qt::AlignRight);
+  statusBar()->addPermanentWidget( material_label_, 0 );
+
   setWindowTitle( "RViz[*]" );
 }
 
 VisualizationFrame::~VisualizationFrame()
 {
+  waitForAutosave();
+
   delete manager_;
 
   for( int i = 0; i < custom_panels_.size(); i++ )
@@ -180,7 +205,23 @@ void VisualizationFrame::updateFps()
     float fps = frame_count_ / wall_diff.toSec();
     frame_count_ = 0;
     last_fps_calc_time_ = ros::WallTime::now();
-    fps_label_->setText( QString::number(int(fps)) + QString(" fps") );
+    QString fps_text = QString::number(int(fps)) + QString(" fps");
+    OcclusionCuller* culler = manager_->getOcclusionCuller();
+    if( culler && culler->isEnabled() )
+    {
+      fps_text += QString(", %1 culled").arg( culler->getCulledCount() );
+    }
+    fps_label_->setText( fps_text );
+
+    MaterialCache* materials = MaterialCache::get();
+    material_label_->setText( QString( "%1 materials, %2 KB" )
+                              .arg( materials->getMaterialCount() )
+                              .arg( materials->getTextureMemory() / 1024 ));
+    material_label_->setToolTip( QString( "%1 mesh parts share %2 materials from the material cache, "
+                                          "using %3 KB of texture memory." )
+                                 .arg( materials->getReferenceCount() )
+                                 .arg( materials->getMaterialCount() )
+                                 .arg( materials->getTextureMemory() / 1024 ));
   }
 }
 
@@ -631,6 +672,10 @@ void VisualizationFrame::loadDisplayConfig( const QString& qpath )
     return;
   }
 
+  // Ask before the loading dialog is up.
+  Config config;
+  bool restored = loadAutosave( path, config );
+
   setWindowModified( false );
   loading_ = true;
 
@@ -642,17 +687,29 @@ void VisualizationFrame::loadDisplayConfig( const QString& qpath )
     connect( this, SIGNAL( statusUpdate( const QString& )), dialog, SLOT( showMessage( const QString& )));
   }
 
-  YamlConfigReader reader;
-  Config config;
-  reader.readFile( config, QString::fromStdString( actual_load_path ));
-  if( !reader.error() )
+  if( restored )
   {
     load( config );
   }
+  else
+  {
+    YamlConfigReader reader;
+    reader.readFile( config, QString::fromStdString( actual_load_path ));
+    if( !reader.error() )
+    {
+      load( config );
+    }
+  }
 
   markRecentConfig( path );
 
   setDisplayConfigFile( path );
+  if( restored )
+  {
+    // The restored changes are unsaved again, and only in memory now.
+    setWindowModified( true );
+    autosave_timer_->start();
+  }
 
   last_config_dir_ = fs::path( path ).parent_path().BOOST_FILE_STRING();
 
@@ -666,6 +723,115 @@ void VisualizationFrame::markLoadingDone()
   loading_ = false;
 }
 
+QString VisualizationFrame::autosavePrefix( const std::string& path ) const
+{
+  QByteArray hash = QCryptographicHash::hash( QByteArray( path.c_str() ), QCryptographicHash::Md5 );
+  return "autosave-" + QString( hash.toHex() ) + "-";
+}
+
+bool VisualizationFrame::loadAutosave( const std::string& path, Config& config )
+{
+  // Newest first.  Snapshots of other running instances are theirs;
+  // the ones of exited instances are offered once and then deleted.
+  QString prefix = autosavePrefix( path );
+  QDir dir( QString::fromStdString( config_dir_ ));
+  QStringList names = dir.entryList( QStringList( prefix + "*.snapshot" ), QDir::Files, QDir::Time );
+  bool asked = false;
+  bool restored = false;
+  for( int i = 0; i < names.size(); i++ )
+  {
+    bool ok;
+    pid_t pid = names[ i ].mid( prefix.size() ).section( '.', 0, 0 ).toInt( &ok );
+    if( !ok || pid == getpid() || kill( pid, 0 ) == 0 || errno == EPERM )
+    {
+      continue;
+    }
+    QString snapshot_file = dir.filePath( names[ i ]);
+
+    if( !asked )
+    {
+      Config snapshot;
+      BinaryConfigReader reader;
+      reader.readFile( snapshot, snapshot_file );
+      QString snapshot_path;
+      if( reader.error() )
+      {
+        ROS_WARN( "Ignoring autosave snapshot: %s", qPrintable( reader.errorMessage() ));
+      }
+      // The config file may have been saved since.
+      else if( snapshot.mapGetString( "Config File", &snapshot_path ) && snapshot_path.toStdString() == path &&
+               ( !fs::exists( path ) || fs::last_write_time( path ) <= fs::last_write_time( snapshot_file.toStdString() )))
+      {
+        asked = true;
+
+        QMessageBox box( this );
+        box.setWindowTitle( "Restore unsaved changes?" );
+        box.setText( QString::fromStdString( "RViz did not exit properly while " + path + " had unsaved changes." ));
+        box.setInformativeText( "Restore the changes from " + QFileInfo( snapshot_file ).lastModified().toString() + "?" );
+        box.setStandardButtons( QMessageBox::Yes | QMessageBox::Discard );
+        box.setDefaultButton( QMessageBox::Yes );
+        if( box.exec() == QMessageBox::Yes )
+        {
+          config = snapshot.mapGetChild( "Session" );
+          restored = config.isValid();
+          if( restored )
+          {
+            ROS_INFO( "Restoring unsaved changes to '%s' from '%s'.", path.c_str(), qPrintable( snapshot_file ));
+          }
+        }
+      }
+    }
+    QFile::remove( snapshot_file );
+  }
+  return restored;
+}
+
+/** Body of VisualizationFrame::autosave_thread_. */
+static void writeAutosave( Config snapshot, std::string path )
+{
+  BinaryConfigWriter writer;
+  writer.writeFile( snapshot, QString::fromStdString( path ));
+  if( writer.error() )
+  {
+    ROS_WARN( "Autosave failed: %s", qPrintable( writer.errorMessage() ));
+  }
+}
+
+void VisualizationFrame::autosave()
+{
+  if( !initialized_ || !isWindowModified() )
+  {
+    return;
+  }
+
+  // Building the tree reads every property, so it has to happen on
+  // this thread.  The tree is not shared with anything, so the writer
+  // thread can have it without copying.
+  Config snapshot;
+  snapshot.mapSetValue( "Config File", QString::fromStdString( display_config_file_ ));
+  save( snapshot.mapMakeChild( "Session" ));
+
+  waitForAutosave();
+  autosave_thread_ = new boost::thread( boost::bind( &writeAutosave, snapshot, autosave_file_ ));
+}
+
+void VisualizationFrame::waitForAutosave()
+{
+  if( autosave_thread_ )
+  {
+    autosave_thread_->join();
+    delete autosave_thread_;
+    autosave_thread_ = NULL;
+  }
+}
+
+void VisualizationFrame::removeAutosave()
+{
+  autosave_timer_->stop();
+  waitForAutosave();
+  QFile::remove( QString::fromStdString( autosave_file_ ));
+}
+
 void VisualizationFrame::setImageSaveDirectory( const QString& directory )
 {
   last_image_dir_ = directory.toStdString();
@@ -676,12 +842,19 @@ void VisualizationFrame::setDisplayConfigModified()
   if( !loading_ )
   {
     setWindowModified( true );
+    if( !autosave_timer_->isActive() )
+    {
+      autosave_timer_->start();
+    }
   }
 }
 
 void VisualizationFrame::setDisplayConfigFile( const std::string& path )
 {
   display_config_file_ = path;
+  // Per config and process, so instances do not overwrite each other.
+  autosave_file_ = ( QDir( QString::fromStdString( config_dir_ )).filePath( autosavePrefix( path )) +
+                     QString::number( getpid() ) + ".snapshot" ).toStdString();
 
   std::string title;
   if( path == default_display_config_file_ )
@@ -712,6 +885,7 @@ bool VisualizationFrame::saveDisplayConfig( const QString& path )
   else
   {
     setWindowModified( false );
+    removeAutosave();
     error_message_ = "";
     return true;
   }
@@ -884,6 +1058,7 @@ bool VisualizationFrame::prepareToExit()
           onSaveAs();
           return true;
         case QMessageBox::Discard:
+          removeAutosave();
           return true;
         default:
           return false;
@@ -891,6 +1066,7 @@ bool VisualizationFrame::prepareToExit()
         
       }
     case QMessageBox::Discard:
+      removeAutosave();
       return true;
     default:
       return false;
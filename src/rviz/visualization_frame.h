@@ -50,6 +50,11 @@ class QDockWidget;
 class QLabel;
 class QToolButton;
 
+namespace boost
+{
+class thread;
+}
+
 namespace rviz
 {
 
@@ -215,6 +220,11 @@ protected Q_SLOTS:
   /** @brief Set loading_ to false. */
   void markLoadingDone();
 
+  /** @brief Write a binary snapshot of the unsaved config to
+   * autosave_file_.  The Config tree is built here, the encoding and
+   * writing happen on autosave_thread_. */
+  void autosave();
+
   /** @brief Set the default directory in which to save screenshot images. */
   void setImageSaveDirectory( const QString& directory );
 
@@ -272,12 +282,30 @@ protected:
 
   void hideDockImpl( Qt::DockWidgetArea area, bool hide );
 
+  /** @brief Look for a snapshot of unsaved changes to the display
+   * config at @a path, newer than that file, left behind by an rviz
+   * which is not running anymore.  If there is one, ask whether to
+   * restore it, and read it into @a config if so.  The snapshot is
+   * deleted either way.  Return true if @a config was read. */
+  bool loadAutosave( const std::string& path, Config& config );
+
+  /** @brief Return the start of the names of the snapshots of the
+   * display config at @a path, which continue with the process id. */
+  QString autosavePrefix( const std::string& path ) const;
+
+  /** @brief Delete the autosave snapshot, once the changes in it were saved or discarded. */
+  void removeAutosave();
+
+  /** @brief Wait for autosave_thread_ to finish writing, if it is running. */
+  void waitForAutosave();
+
   RenderPanel* render_panel_;
 
   QAction* show_help_action_;
 
   std::string config_dir_;
   std::string persistent_settings_file_;
+  std::string autosave_file_;
   std::string display_config_file_;
   std::string default_display_config_file_;
   std::string last_config_dir_;
@@ -331,9 +359,12 @@ protected:
   WidgetGeometryChangeDetector* geom_change_detector_;
   bool loading_; ///< True just when loading a display config file, false all other times.
   QTimer* post_load_timer_; ///< Single-shot timer for calling postLoad() a short time after loadDisplayConfig() finishes.
+  QTimer* autosave_timer_; ///< Single-shot timer for calling autosave(), started by the first unsaved change.
+  boost::thread* autosave_thread_; ///< Thread writing the latest autosave snapshot, or NULL.
 
   QLabel* status_label_;
   QLabel* fps_label_;
+  QLabel* material_label_; ///< Shows the number of shared materials and their texture memory.
 
   int frame_count_;
   ros::WallTime last_fps_calc_time_;
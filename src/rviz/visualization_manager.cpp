@@ -28,15 +28,19 @@
  */
 
 #include <algorithm>
+#include <map>
 
 #include <QApplication>
 #include <QCursor>
 #include <QPixmap>
+#include <QSet>
 #include <QTimer>
+#include <QWidget>
 
 #include <boost/bind.hpp>
 
 #include <OGRE/OgreRoot.h>
+#include <OGRE/OgreCamera.h>
 #include <OGRE/OgreSceneManager.h>
 #include <OGRE/OgreSceneNode.h>
 #include <OGRE/OgreLight.h>
@@ -57,7 +61,9 @@
 #include "rviz/display_group.h"
 #include "rviz/displays_panel.h"
 #include "rviz/frame_manager.h"
+#include "rviz/ogre_helpers/occlusion_culler.h"
 #include "rviz/ogre_helpers/qt_ogre_render_window.h"
+#include "rviz/properties/bool_property.h"
 #include "rviz/properties/color_property.h"
 #include "rviz/properties/parse_color.h"
 #include "rviz/properties/property.h"
@@ -67,8 +73,10 @@
 #include "rviz/properties/int_property.h"
 #include "rviz/render_panel.h"
 #include "rviz/selection/selection_manager.h"
+#include "rviz/session_recorder.h"
 #include "rviz/tool.h"
 #include "rviz/tool_manager.h"
+#include "rviz/topic_cache.h"
 #include "rviz/viewport_mouse_event.h"
 #include "rviz/view_controller.h"
 #include "rviz/view_manager.h"
@@ -109,11 +117,38 @@ public:
   ros::NodeHandle update_nh_;
   ros::NodeHandle threaded_nh_;
   boost::mutex render_mutex_;
+
+  // Regions passed to queueRender() since the last rendered frame.
+  boost::mutex dirty_region_mutex_;
+  Ogre::AxisAlignedBox dirty_region_;
+
+  // Camera and viewport of the last rendered frame, for "Render On Demand".
+  Ogre::Vector3 camera_position_;
+  Ogre::Quaternion camera_orientation_;
+  Ogre::Matrix4 camera_projection_;
+  int viewport_width_;
+  int viewport_height_;
+  ros::WallTime last_frame_wall_time_;
+  bool occlusion_follow_up_frame_;
+
+  // State of the "Frame Rate Governor".
+  struct DeferredUpdate
+  {
+    float wall_dt;
+    float ros_dt;
+    ros::WallTime since;
+  };
+  std::map<Display*, DeferredUpdate> deferred_updates_;
+  QSet<Display*> focused_displays_;
+  float render_time_;
+  float detail_level_;
+  QString governor_status_;
 };
 
 VisualizationManager::VisualizationManager( RenderPanel* render_panel, WindowManagerInterface* wm )
 : ogre_root_( Ogre::Root::getSingletonPtr() )
 , update_timer_(0)
+, render_timer_(0)
 , shutting_down_(false)
 , render_panel_( render_panel )
 , time_update_timer_(0.0f)
@@ -129,6 +164,18 @@ VisualizationManager::VisualizationManager( RenderPanel* render_panel, WindowMan
   render_panel->setAutoRender(false);
 
   private_->threaded_nh_.setCallbackQueue(&private_->threaded_queue_);
+  private_->viewport_width_ = 0;
+  private_->viewport_height_ = 0;
+  private_->occlusion_follow_up_frame_ = false;
+  private_->render_time_ = 0.0f;
+  private_->detail_level_ = 1.0f;
+
+  session_recorder_ = new SessionRecorder( private_->threaded_nh_ );
+  session_player_ = new SessionPlayer( this );
+
+  // Fetch the topic list while the rest of the window comes up, so the
+  // first topic dropdown is not empty.
+  TopicCache::get()->refresh();
 
   scene_manager_ = ogre_root_->createSceneManager( Ogre::ST_GENERIC );
 
@@ -137,11 +184,14 @@ VisualizationManager::VisualizationManager( RenderPanel* render_panel, WindowMan
   directional_light_->setDirection( Ogre::Vector3( -1, 0, -1 ) );
   directional_light_->setDiffuseColour( Ogre::ColourValue( 1.0f, 1.0f, 1.0f ) );
 
+  occlusion_culler_ = new OcclusionCuller( scene_manager_, render_panel_->getRenderWindow(), render_panel_->getViewport() );
+
   root_display_group_ = new DisplayGroup();
   root_display_group_->setName( "root" );
   display_property_tree_model_ = new PropertyTreeModel( root_display_group_ );
   display_property_tree_model_->setDragDropClass( "display" );
   connect( display_property_tree_model_, SIGNAL( configChanged() ), this, SIGNAL( configChanged() ));
+  connect( display_property_tree_model_, SIGNAL( configChanged() ), this, SLOT( queueRender() ));
   
   tool_manager_ = new ToolManager( this );
   connect( tool_manager_, SIGNAL( configChanged() ), this, SIGNAL( configChanged() ));
@@ -167,6 +217,35 @@ VisualizationManager::VisualizationManager( RenderPanel* render_panel, WindowMan
   fps_property_ = new IntProperty( "Frame Rate", 30,
                                    "RViz will try to render this many frames per second.",
                                    global_options_, SLOT( updateFps() ), this );
+  fps_property_->setMin( 1 );
+
+  update_rate_property_ = new IntProperty( "Update Rate", 30,
+                                           "RViz will try to process incoming messages and update displays this many times per second.  "
+                                           "Rendering continues at the frame rate when updating takes longer.",
+                                           global_options_, SLOT( updateUpdateRate() ), this );
+  update_rate_property_->setMin( 1 );
+
+  occlusion_culling_property_ = new BoolProperty( "Occlusion Culling", false,
+                                                  "Skip displays whose bounds are completely hidden behind other geometry"
+                                                  " in the main view, using hardware occlusion queries.  A display coming"
+                                                  " into view appears one frame late.",
+                                                  global_options_, SLOT( updateOcclusionCulling() ), this );
+
+  render_on_demand_property_ = new BoolProperty( "Render On Demand", false,
+                                                 "Only render a frame when something in view changed: camera motion, or"
+                                                 " a display asking for it after new data.  Lets an idle"
+                                                 " RViz use almost no CPU or GPU.",
+                                                 global_options_, SLOT( queueRender() ), this );
+
+  governor_property_ = new BoolProperty( "Frame Rate Governor", false,
+                                         "Hold the frame rate by giving displays a share of each update interval,"
+                                         " deferring displays out of view when time runs out, and lowering mesh detail"
+                                         " when frames take too long to render.  Displays selected in the Displays"
+                                         " panel are updated first.  Displays which work through queued data"
+                                         " (markers, point clouds) stop at their share even without the governor;"
+                                         " other display updates are not interrupted, so one slow display can"
+                                         " still delay a frame.",
+                                         global_options_, SLOT( updateGovernor() ), this );
 
   root_display_group_->initialize( this ); // only initialize() a Display after its sub-properties are created.
   root_display_group_->setEnabled( true );
@@ -189,11 +268,15 @@ VisualizationManager::VisualizationManager( RenderPanel* render_panel, WindowMan
 
   update_timer_ = new QTimer;
   connect( update_timer_, SIGNAL( timeout() ), this, SLOT( onUpdate() ));
+
+  render_timer_ = new QTimer;
+  connect( render_timer_, SIGNAL( timeout() ), this, SLOT( onRender() ));
 }
 
 VisualizationManager::~VisualizationManager()
 {
   delete update_timer_;
+  delete render_timer_;
 
   shutting_down_ = true;
   private_->threaded_queue_threads_.join_all();
@@ -207,6 +290,10 @@ VisualizationManager::~VisualizationManager()
   delete tool_manager_;
   delete display_factory_;
   delete selection_manager_;
+  delete session_player_;
+  delete session_recorder_;
+
+  delete occlusion_culler_;
 
   if(ogre_root_)
   {
@@ -253,13 +340,14 @@ ros::CallbackQueueInterface* VisualizationManager::getUpdateQueue()
 
 void VisualizationManager::startUpdate()
 {
-  float interval = 1000.0 / float(fps_property_->getInt());
-  update_timer_->start( interval );
+  update_timer_->start( 1000.0 / float(update_rate_property_->getInt()) );
+  render_timer_->start( 1000.0 / float(fps_property_->getInt()) );
 }
 
 void VisualizationManager::stopUpdate()
 {
   update_timer_->stop();
+  render_timer_->stop();
 }
 
 void createColorMaterial(const std::string& name, const Ogre::ColourValue& color, bool use_self_illumination)
@@ -292,6 +380,12 @@ void VisualizationManager::queueRender()
   render_requested_ = 1;
 }
 
+void VisualizationManager::queueRender( const Ogre::AxisAlignedBox& world_region )
+{
+  boost::mutex::scoped_lock lock( private_->dirty_region_mutex_ );
+  private_->dirty_region_.merge( world_region );
+}
+
 void VisualizationManager::onUpdate()
 {
   ros::WallDuration wall_diff = ros::WallTime::now() - last_update_wall_time_;
@@ -306,15 +400,22 @@ void VisualizationManager::onUpdate()
     resetTime();
   }
 
-  ros::spinOnce();
+  // Call waiting callbacks for at most half an update interval, the
+  // rest waits for the next update.
+  ros::CallbackQueue* queue = ros::getGlobalCallbackQueue();
+  ros::WallTime deadline = last_update_wall_time_ + ros::WallDuration( 0.5 / update_rate_property_->getInt() );
+  while( !queue->isEmpty() && ros::WallTime::now() < deadline )
+  {
+    queue->callOne( ros::WallDuration() );
+  }
+  double callback_time = ( ros::WallTime::now() - last_update_wall_time_ ).toSec();
+  double budget = std::max( 0.0, 1.0 / update_rate_property_->getInt() - callback_time );
 
   Q_EMIT preUpdate();
 
   frame_manager_->update();
 
-  root_display_group_->update( wall_dt, ros_dt );
-
-  view_manager_->update(wall_dt, ros_dt);
+  updateDisplays( wall_dt, ros_dt, ros::WallDuration( budget ));
 
   time_update_timer_ += wall_dt;
 
@@ -340,6 +441,41 @@ void VisualizationManager::onUpdate()
   {
     tool_manager_->getCurrentTool()->update(wall_dt, ros_dt);
   }
+}
+
+/** @brief Collect the scene nodes of the enabled displays in @a group and its sub-groups which hang directly off @a root. */
+static void collectDisplaySceneNodes( DisplayGroup* group, Ogre::SceneNode* root, std::vector<Ogre::SceneNode*>& nodes )
+{
+  for( int i = 0; i < group->numDisplays(); i++ )
+  {
+    Display* display = group->getDisplayAt( i );
+    if( !display->isEnabled() )
+    {
+      continue;
+    }
+
+    DisplayGroup* sub_group = qobject_cast<DisplayGroup*>( display );
+    if( sub_group )
+    {
+      collectDisplaySceneNodes( sub_group, root, nodes );
+    }
+    else if( display->getSceneNode() && display->getSceneNode()->getParent() == root )
+    {
+      nodes.push_back( display->getSceneNode() );
+    }
+  }
+}
+
+void VisualizationManager::onRender()
+{
+  ros::WallDuration wall_diff = ros::WallTime::now() - last_render_wall_time_;
+  ros::Duration ros_diff = ros::Time::now() - last_render_ros_time_;
+  float wall_dt = wall_diff.toSec();
+  float ros_dt = ros_diff.toSec();
+  last_render_ros_time_ = ros::Time::now();
+  last_render_wall_time_ = ros::WallTime::now();
+
+  view_manager_->update(wall_dt, ros_dt);
 
   if ( view_manager_ &&
         view_manager_->getCurrent() &&
@@ -350,11 +486,317 @@ void VisualizationManager::onUpdate()
 
   frame_count_++;
 
-  if ( render_requested_ || wall_dt > 0.01 )
+  bool render = render_requested_ || wall_dt > 0.01;
+  if( render_on_demand_property_->getBool() )
+  {
+    render = isRenderNeeded();
+  }
+
+  if ( render )
+  {
+    rememberRenderedView();
+
+    if ( occlusion_culler_->isEnabled() )
+    {
+      std::vector<Ogre::SceneNode*> nodes;
+      collectDisplaySceneNodes( root_display_group_, scene_manager_->getRootSceneNode(), nodes );
+      occlusion_culler_->setCandidates( nodes );
+    }
+
+    ros::WallTime render_start = ros::WallTime::now();
+    {
+      boost::mutex::scoped_lock lock(private_->render_mutex_);
+      ogre_root_->renderOneFrame();
+    }
+    adjustDetailLevel( ( ros::WallTime::now() - render_start ).toSec() );
+
+    // Occlusion query results only take effect in the next frame, so
+    // when rendering on demand make sure there is one.
+    private_->occlusion_follow_up_frame_ = occlusion_culler_->isEnabled() && !private_->occlusion_follow_up_frame_;
+    if( private_->occlusion_follow_up_frame_ )
+    {
+      render_requested_ = 1;
+    }
+  }
+}
+
+/** @brief Collect the enabled displays in @a group and its sub-groups, without the groups themselves. */
+static void collectEnabledDisplays( DisplayGroup* group, std::vector<Display*>& displays )
+{
+  for( int i = 0; i < group->numDisplays(); i++ )
+  {
+    Display* display = group->getDisplayAt( i );
+    if( !display->isEnabled() )
+    {
+      continue;
+    }
+
+    DisplayGroup* sub_group = qobject_cast<DisplayGroup*>( display );
+    if( sub_group )
+    {
+      collectEnabledDisplays( sub_group, displays );
+    }
+    else
+    {
+      displays.push_back( display );
+    }
+  }
+}
+
+/** @brief Return true if @a display shows something in @a camera's view or in a widget of its own. */
+/** Update @a display with an even share of the time left until
+ * @a deadline among it and the @a remaining - 1 displays after it, so
+ * what one display does not use goes to the ones after it. */
+static void updateDisplayShare( Display* display, float wall_dt, float ros_dt,
+                                const ros::WallTime& deadline, size_t remaining )
+{
+  ros::WallTime now = ros::WallTime::now();
+  double time_left = std::max( 0.0, ( deadline - now ).toSec() );
+  display->setUpdateDeadline( now + ros::WallDuration( time_left / remaining ));
+  display->update( wall_dt, ros_dt );
+  display->setUpdateDeadline( ros::WallTime() );
+}
+
+static bool isDisplayInView( Display* display, Ogre::Camera* camera )
+{
+  if( display->getAssociatedWidget() && display->getAssociatedWidget()->isVisible() )
+  {
+    return true;
+  }
+  if( !camera || !display->getSceneNode() )
   {
-    render_requested_ = 0;
-    boost::mutex::scoped_lock lock(private_->render_mutex_);
-    ogre_root_->renderOneFrame();
+    return false;
+  }
+
+  // Null bounds do not mean there is nothing to show: many objects do
+  // not report bounds, and overlays or panels draw outside the scene.
+  const Ogre::AxisAlignedBox& bounds = display->getSceneNode()->_getWorldAABB();
+  return bounds.isNull() || camera->isVisible( bounds );
+}
+
+void VisualizationManager::updateDisplays( float wall_dt, float ros_dt, const ros::WallDuration& budget )
+{
+  ros::WallTime deadline = ros::WallTime::now() + budget;
+
+  std::vector<Display*> displays;
+  collectEnabledDisplays( root_display_group_, displays );
+
+  if( !governor_property_->getBool() )
+  {
+    // Every display is updated, but those checking hasUpdateTimeLeft()
+    // still stop at their share of the budget.
+    for( size_t i = 0; i < displays.size(); i++ )
+    {
+      updateDisplayShare( displays[ i ], wall_dt, ros_dt, deadline, displays.size() - i );
+    }
+    return;
+  }
+
+  // Sort by priority, keeping the display list order within one.
+  enum { FOCUSED, IN_VIEW, OUT_OF_VIEW };
+  Ogre::Camera* camera = render_panel_->getViewport()->getCamera();
+  std::vector<std::pair<int, size_t> > order;
+  order.reserve( displays.size() );
+  for( size_t i = 0; i < displays.size(); i++ )
+  {
+    int priority = OUT_OF_VIEW;
+    if( private_->focused_displays_.contains( displays[ i ] ))
+    {
+      priority = FOCUSED;
+    }
+    else if( isDisplayInView( displays[ i ], camera ))
+    {
+      priority = IN_VIEW;
+    }
+    order.push_back( std::make_pair( priority, i ));
+  }
+  std::sort( order.begin(), order.end() );
+
+  std::map<Display*, VisualizationManagerPrivate::DeferredUpdate> deferred_updates;
+  for( size_t i = 0; i < order.size(); i++ )
+  {
+    Display* display = displays[ order[ i ].second ];
+    ros::WallTime now = ros::WallTime::now();
+
+    VisualizationManagerPrivate::DeferredUpdate update;
+    update.wall_dt = wall_dt;
+    update.ros_dt = ros_dt;
+    update.since = now;
+    std::map<Display*, VisualizationManagerPrivate::DeferredUpdate>::iterator it = private_->deferred_updates_.find( display );
+    if( it != private_->deferred_updates_.end() )
+    {
+      update.wall_dt += it->second.wall_dt;
+      update.ros_dt += it->second.ros_dt;
+      update.since = it->second.since;
+    }
+
+    if( order[ i ].first == OUT_OF_VIEW && now >= deadline && now - update.since < ros::WallDuration( 1.0 ))
+    {
+      deferred_updates[ display ] = update;
+      continue;
+    }
+
+    updateDisplayShare( display, update.wall_dt, update.ros_dt, deadline, order.size() - i );
+  }
+  private_->deferred_updates_.swap( deferred_updates );
+
+  updateGovernorStatus();
+}
+
+void VisualizationManager::adjustDetailLevel( float render_time )
+{
+  if( !governor_property_->getBool() )
+  {
+    return;
+  }
+
+  // Smooth over a few frames, so a single slow frame does not change
+  // the detail level.
+  private_->render_time_ = 0.9f * private_->render_time_ + 0.1f * render_time;
+
+  float frame_time = 1.0f / fps_property_->getInt();
+  if( private_->render_time_ > 0.8f * frame_time )
+  {
+    private_->detail_level_ = std::max( 0.1f, private_->detail_level_ * 0.9f );
+  }
+  else if( private_->render_time_ < 0.4f * frame_time )
+  {
+    private_->detail_level_ = std::min( 1.0f, private_->detail_level_ * 1.1f );
+  }
+
+  // Set it every frame, the current view may have a different camera.
+  Ogre::Camera* camera = render_panel_->getViewport()->getCamera();
+  if( camera )
+  {
+    camera->setLodBias( private_->detail_level_ );
+  }
+}
+
+void VisualizationManager::updateGovernorStatus()
+{
+  QString status;
+  if( governor_property_->getBool() )
+  {
+    if( private_->detail_level_ < 1.0f )
+    {
+      status = "Mesh detail at " + QString::number( int( private_->detail_level_ * 100 )) + "%";
+    }
+    if( !private_->deferred_updates_.empty() )
+    {
+      if( !status.isEmpty() )
+      {
+        status += ", ";
+      }
+      status += QString::number( private_->deferred_updates_.size() ) + " displays deferred";
+    }
+  }
+
+  if( status == private_->governor_status_ )
+  {
+    return;
+  }
+  private_->governor_status_ = status;
+
+  if( status.isEmpty() )
+  {
+    global_status_->deleteStatus( "Frame Rate Governor" );
+  }
+  else
+  {
+    global_status_->setStatus( StatusProperty::Ok, "Frame Rate Governor", status );
+  }
+}
+
+void VisualizationManager::setFocusedDisplays( const QList<Display*>& displays )
+{
+  private_->focused_displays_ = QSet<Display*>::fromList( displays );
+  for( int i = 0; i < displays.size(); i++ )
+  {
+    connect( displays[ i ], SIGNAL( destroyed( QObject* )), this, SLOT( onDisplayDestroyed( QObject* )), Qt::UniqueConnection );
+  }
+}
+
+void VisualizationManager::onDisplayDestroyed( QObject* display )
+{
+  // Only the address is used; the Display part of the object is gone.
+  Display* destroyed = static_cast<Display*>( display );
+  private_->focused_displays_.remove( destroyed );
+  private_->deferred_updates_.erase( destroyed );
+}
+
+void VisualizationManager::updateGovernor()
+{
+  if( !governor_property_->getBool() )
+  {
+    private_->deferred_updates_.clear();
+    private_->render_time_ = 0.0f;
+    private_->detail_level_ = 1.0f;
+
+    Ogre::Camera* camera = render_panel_->getViewport()->getCamera();
+    if( camera )
+    {
+      camera->setLodBias( 1.0f );
+    }
+  }
+  updateGovernorStatus();
+  queueRender();
+}
+
+bool VisualizationManager::isRenderNeeded()
+{
+  if( render_requested_ )
+  {
+    return true;
+  }
+
+  // Catch changes nobody reported, e.g. from plugins which never
+  // call queueRender().
+  if( ros::WallTime::now() - private_->last_frame_wall_time_ > ros::WallDuration( 1.0 ))
+  {
+    return true;
+  }
+
+  Ogre::Viewport* viewport = render_panel_->getViewport();
+  Ogre::Camera* camera = viewport->getCamera();
+  if( !camera )
+  {
+    return true;
+  }
+
+  if( viewport->getActualWidth() != private_->viewport_width_ ||
+      viewport->getActualHeight() != private_->viewport_height_ ||
+      camera->getDerivedPosition() != private_->camera_position_ ||
+      camera->getDerivedOrientation() != private_->camera_orientation_ ||
+      camera->getProjectionMatrix() != private_->camera_projection_ )
+  {
+    return true;
+  }
+
+  boost::mutex::scoped_lock lock( private_->dirty_region_mutex_ );
+  return !private_->dirty_region_.isNull() && camera->isVisible( private_->dirty_region_ );
+}
+
+void VisualizationManager::rememberRenderedView()
+{
+  render_requested_ = 0;
+
+  {
+    boost::mutex::scoped_lock lock( private_->dirty_region_mutex_ );
+    private_->dirty_region_.setNull();
+  }
+
+  private_->last_frame_wall_time_ = ros::WallTime::now();
+
+  Ogre::Viewport* viewport = render_panel_->getViewport();
+  private_->viewport_width_ = viewport->getActualWidth();
+  private_->viewport_height_ = viewport->getActualHeight();
+
+  Ogre::Camera* camera = viewport->getCamera();
+  if( camera )
+  {
+    private_->camera_position_ = camera->getDerivedPosition();
+    private_->camera_orientation_ = camera->getDerivedOrientation();
+    private_->camera_projection_ = camera->getProjectionMatrix();
   }
 }
 
@@ -441,9 +883,11 @@ void VisualizationManager::emitStatusUpdate( const QString& message )
 void VisualizationManager::load( const Config& config )
 {
   stopUpdate();
+  ros::WallTime start = ros::WallTime::now();
 
   emitStatusUpdate( "Creating displays" );
   root_display_group_->load( config );
+  ROS_DEBUG_NAMED( "config_load", "Creating displays took %.3f s.", ( ros::WallTime::now() - start ).toSec() );
 
   emitStatusUpdate( "Creating tools" );
   tool_manager_->load( config.mapGetChild( "Tools" ));
@@ -451,6 +895,7 @@ void VisualizationManager::load( const Config& config )
   emitStatusUpdate( "Creating views" );
   view_manager_->load( config.mapGetChild( "Views" ));
 
+  ROS_DEBUG_NAMED( "config_load", "Loading the config took %.3f s.", ( ros::WallTime::now() - start ).toSec() );
   startUpdate();
 }
 
@@ -501,6 +946,14 @@ void VisualizationManager::updateBackgroundColor()
 }
 
 void VisualizationManager::updateFps()
+{
+  if ( render_timer_->isActive() )
+  {
+    startUpdate();
+  }
+}
+
+void VisualizationManager::updateUpdateRate()
 {
   if ( update_timer_->isActive() )
   {
@@ -508,6 +961,24 @@ void VisualizationManager::updateFps()
   }
 }
 
+void VisualizationManager::updateOcclusionCulling()
+{
+  occlusion_culler_->setEnabled( occlusion_culling_property_->getBool() );
+  if ( !occlusion_culler_->isEnabled() )
+  {
+    occlusion_culler_->setCandidates( std::vector<Ogre::SceneNode*>() );
+  }
+  if ( occlusion_culling_property_->getBool() && !occlusion_culler_->isSupported() )
+  {
+    global_status_->setStatus( StatusProperty::Warn, "Occlusion Culling", "Hardware occlusion queries are not supported by this render system." );
+  }
+  else
+  {
+    global_status_->deleteStatus( "Occlusion Culling" );
+  }
+  queueRender();
+}
+
 void VisualizationManager::handleMouseEvent( const ViewportMouseEvent& vme )
 {
   //process pending mouse events
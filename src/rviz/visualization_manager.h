@@ -33,6 +33,8 @@
 
 #include <deque>
 
+#include <QList>
+
 #include <ros/time.h>
 
 #include "rviz/bit_allocator.h"
@@ -44,6 +46,7 @@ class QTimer;
 
 namespace Ogre
 {
+class AxisAlignedBox;
 class Root;
 class SceneManager;
 class SceneNode;
@@ -63,6 +66,7 @@ class TransformListener;
 namespace rviz
 {
 
+class BoolProperty;
 class ColorProperty;
 class Display;
 class DisplayFactory;
@@ -73,12 +77,15 @@ class IntProperty;
 class PropertyTreeModel;
 class RenderPanel;
 class SelectionManager;
+class SessionPlayer;
+class SessionRecorder;
 class StatusList;
 class TfFrameProperty;
 class ViewportMouseEvent;
 class WindowManagerInterface;
 class Tool;
 class OgreRenderQueueClearer;
+class OcclusionCuller;
 
 class VisualizationManagerPrivate;
 
@@ -123,7 +130,8 @@ public:
 
   /**
    * \brief Start timers.
-   * Creates and starts the update and idle timers, both set to 30Hz (33ms).
+   * Starts the update timer at the "Update Rate" and the render timer
+   * at the "Frame Rate", both 30Hz (33ms) by default.
    */
   void startUpdate();
 
@@ -229,9 +237,8 @@ public:
   /**
    * @brief Handle a mouse event.
    *
-   * This just copies the given event into an event queue.  The events
-   * in the queue are processed by onUpdate() which is called from the
-   * main thread by a timer every 33ms.
+   * The event is passed to the current tool right away; the resulting
+   * camera motion shows up with the next onRender().
    */
   void handleMouseEvent( const ViewportMouseEvent& event );
 
@@ -267,6 +274,15 @@ public:
    */
   void queueRender();
 
+  /**
+   * \brief Queues a render if @a world_region is visible from the current camera.
+   *
+   * Regions queued before a render are merged.  Without "Render On
+   * Demand" every frame is rendered anyway, so this has no effect.
+   * \note This function can be called from any thread.
+   */
+  void queueRender( const Ogre::AxisAlignedBox& world_region );
+
   /**
    * @brief Return the window manager, if any.
    */
@@ -292,6 +308,14 @@ public:
    * been rendered since the last time they did something. */
   uint64_t getFrameCount() const { return frame_count_; }
 
+  /** @brief Return the occlusion culler of the main view, controlled by the "Occlusion Culling" option. */
+  OcclusionCuller* getOcclusionCuller() const { return occlusion_culler_; }
+
+  /** @brief Tell the "Frame Rate Governor" which displays the user is
+   * working with, so their updates go first.  The DisplaysPanel sets
+   * its selected displays here. */
+  void setFocusedDisplays( const QList<Display*>& displays );
+
   /** @brief Notify this VisualizationManager that something about its
    * display configuration has changed. */
   void notifyConfigChanged();
@@ -312,6 +336,9 @@ public:
 
   virtual void setStatus( const QString & message );
 
+  virtual SessionRecorder* getSessionRecorder() const { return session_recorder_; }
+  virtual SessionPlayer* getSessionPlayer() const { return session_player_; }
+
   virtual void setHelpPath( const QString& help_path ) { help_path_ = help_path; }
   virtual QString getHelpPath() const { return help_path_; }
 
@@ -330,14 +357,24 @@ protected Q_SLOTS:
   /** @brief Call update() on all managed objects.
    *
    * This is the central place where update() is called on most rviz
-   * objects.  Display objects, the FrameManager, the current
-   * ViewController, the SelectionManager, PropertyManager.  Also
-   * calls ros::spinOnce(), so any callbacks on the global
-   * CallbackQueue get called from here as well.
+   * objects.  Display objects, the FrameManager, the SelectionManager,
+   * PropertyManager.  Also calls the callbacks waiting on the global
+   * CallbackQueue, for at most half an update interval, so a flood of
+   * messages can not hold off the displays.
    *
-   * It is called at 30Hz from the update timer. */
+   * It is called from the update timer, at the "Update Rate".  It
+   * does not render; the scene it leaves behind is what the next
+   * onRender() shows. */
   void onUpdate();
 
+  /** @brief Update the current ViewController and render a frame.
+   *
+   * Called from the render timer, at the "Frame Rate".  Both timers
+   * run in the GUI thread, so a frame still waits for a running
+   * onUpdate(); keeping onUpdate() within its update interval is what
+   * keeps camera motion smooth while displays are busy. */
+  void onRender();
+
   void onToolChanged( Tool* );
 
 protected:
@@ -348,12 +385,42 @@ protected:
 
   void threadedQueueThreadFunc();
 
+  /** @brief With "Render On Demand" set, check if anything visible changed since the last rendered frame. */
+  bool isRenderNeeded();
+
+  /** @brief Remember the camera and viewport of the frame just rendered and clear the queued renders. */
+  void rememberRenderedView();
+
+  /** @brief Call update() on all enabled displays.
+   *
+   * With the "Frame Rate Governor" set, the displays share @a budget,
+   * the time the callbacks left of this update interval: focused
+   * displays first, then the ones in view, then the rest, each with an
+   * even share of what is left.  Displays out of view are deferred
+   * while there is no time left, for at most a second, and get the
+   * deferred time added to their next update().  Without it, all
+   * enabled displays are updated in list order, each still with an
+   * even share of @a budget for hasUpdateTimeLeft().  A display which
+   * does not check it is never interrupted. */
+  void updateDisplays( float wall_dt, float ros_dt, const ros::WallDuration& budget );
+
+  /** @brief Lower or raise the mesh detail of the main camera so
+   * rendering a frame fits into the "Frame Rate" interval.
+   * @param render_time Seconds the last frame took to render. */
+  void adjustDetailLevel( float render_time );
+
+  /** @brief Show what the "Frame Rate Governor" is doing in the global status. */
+  void updateGovernorStatus();
+
   Ogre::Root* ogre_root_;                                 ///< Ogre Root
   Ogre::SceneManager* scene_manager_;                     ///< Ogre scene manager associated with this panel
 
   QTimer* update_timer_;                                 ///< Update timer.  Display::update is called on each display whenever this timer fires
+  QTimer* render_timer_;                                 ///< Render timer.  The view is updated and a frame rendered whenever this timer fires
   ros::Time last_update_ros_time_;                        ///< Update stopwatch.  Stores how long it's been since the last update
   ros::WallTime last_update_wall_time_;
+  ros::Time last_render_ros_time_;
+  ros::WallTime last_render_wall_time_;
 
   volatile bool shutting_down_;
 
@@ -367,6 +434,7 @@ protected:
   TfFrameProperty* fixed_frame_property_;          ///< Frame to transform fixed data to
   StatusList* global_status_;
   IntProperty* fps_property_;
+  IntProperty* update_rate_property_;
 
   RenderPanel* render_panel_;
 
@@ -391,10 +459,23 @@ protected:
 
   OgreRenderQueueClearer* ogre_render_queue_clearer_;
 
+  OcclusionCuller* occlusion_culler_;
+  BoolProperty* occlusion_culling_property_;
+  BoolProperty* render_on_demand_property_;
+  BoolProperty* governor_property_;
+
+  SessionRecorder* session_recorder_;
+  SessionPlayer* session_player_;
+
 private Q_SLOTS:
+  /** @brief Forget a destroyed display in the "Frame Rate Governor" state. */
+  void onDisplayDestroyed( QObject* display );
   void updateFixedFrame();
   void updateBackgroundColor();
   void updateFps();
+  void updateUpdateRate();
+  void updateOcclusionCulling();
+  void updateGovernor();
 
 private:
   DisplayFactory* display_factory_;
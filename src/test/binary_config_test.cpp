@@ -0,0 +1,259 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <unistd.h>
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+
+#include <gtest/gtest.h>
+#include <rviz/binary_config_reader.h>
+#include <rviz/binary_config_writer.h>
+
+using namespace rviz;
+
+/** Gives each test a snapshot path in the temp directory and removes it again. */
+class BinaryConfigTest : public testing::Test
+{
+protected:
+  BinaryConfigTest()
+    : filename_( QDir::tempPath() + "/rviz_binary_config_test_" + QString::number( getpid() ) + ".snapshot" )
+    {}
+
+  ~BinaryConfigTest()
+    {
+      QFile::remove( filename_ );
+      QFile::remove( filename_ + ".tmp" );
+    }
+
+  /** Write a file that starts like a snapshot with the given header. */
+  void writeHeader( quint32 magic, quint32 version )
+    {
+      QFile file( filename_ );
+      ASSERT_TRUE( file.open( QIODevice::WriteOnly | QIODevice::Truncate ));
+      QDataStream out( &file );
+      out.setVersion( QDataStream::Qt_4_6 );
+      out << magic << version;
+      out << quint8( Config::Empty );
+    }
+
+  QString filename_;
+};
+
+TEST_F( BinaryConfigTest, round_trip )
+{
+  Config config;
+  config.mapSetValue( "Name", "Grid" );
+  config.mapSetValue( "Enabled", true );
+  config.mapSetValue( "Cell Count", 10 );
+  config.mapSetValue( "Line Width", 0.03 );
+  Config displays = config.mapMakeChild( "Displays" );
+  displays.listAppendNew().mapSetValue( "Class", "rviz/Axes" );
+  displays.listAppendNew().setValue( "plain" );
+  displays.listAppendNew();
+  config.mapMakeChild( "Empty Map" ).setType( Config::Map );
+
+  BinaryConfigWriter writer;
+  writer.writeFile( config, filename_ );
+  ASSERT_FALSE( writer.error() ) << qPrintable( writer.errorMessage() );
+  EXPECT_FALSE( QFile::exists( filename_ + ".tmp" ));
+
+  Config read;
+  BinaryConfigReader reader;
+  reader.readFile( read, filename_ );
+  ASSERT_FALSE( reader.error() ) << qPrintable( reader.errorMessage() );
+
+  ASSERT_EQ( Config::Map, read.getType() );
+  QString name;
+  EXPECT_TRUE( read.mapGetString( "Name", &name ));
+  EXPECT_EQ( "Grid", name.toStdString() );
+  bool enabled = false;
+  EXPECT_TRUE( read.mapGetBool( "Enabled", &enabled ));
+  EXPECT_TRUE( enabled );
+  int cells = 0;
+  EXPECT_TRUE( read.mapGetInt( "Cell Count", &cells ));
+  EXPECT_EQ( 10, cells );
+  float width = 0;
+  EXPECT_TRUE( read.mapGetFloat( "Line Width", &width ));
+  EXPECT_FLOAT_EQ( 0.03f, width );
+
+  Config read_displays = read.mapGetChild( "Displays" );
+  ASSERT_EQ( Config::List, read_displays.getType() );
+  ASSERT_EQ( 3, read_displays.listLength() );
+  QString class_name;
+  EXPECT_TRUE( read_displays.listChildAt( 0 ).mapGetString( "Class", &class_name ));
+  EXPECT_EQ( "rviz/Axes", class_name.toStdString() );
+  EXPECT_EQ( Config::Value, read_displays.listChildAt( 1 ).getType() );
+  EXPECT_EQ( "plain", read_displays.listChildAt( 1 ).getValue().toString().toStdString() );
+  EXPECT_EQ( Config::Empty, read_displays.listChildAt( 2 ).getType() );
+  EXPECT_EQ( Config::Map, read.mapGetChild( "Empty Map" ).getType() );
+}
+
+TEST_F( BinaryConfigTest, overwrites_previous_file )
+{
+  Config first;
+  first.mapSetValue( "Value", 1 );
+  Config second;
+  second.mapSetValue( "Value", 2 );
+
+  BinaryConfigWriter writer;
+  writer.writeFile( first, filename_ );
+  writer.writeFile( second, filename_ );
+  ASSERT_FALSE( writer.error() );
+
+  Config read;
+  BinaryConfigReader reader;
+  reader.readFile( read, filename_ );
+  int value = 0;
+  EXPECT_TRUE( read.mapGetInt( "Value", &value ));
+  EXPECT_EQ( 2, value );
+}
+
+TEST_F( BinaryConfigTest, rejects_truncated_file )
+{
+  Config config;
+  Config list = config.mapMakeChild( "List" );
+  for( int i = 0; i < 100; i++ )
+  {
+    list.listAppendNew().setValue( QString( "value %1" ).arg( i ));
+  }
+
+  BinaryConfigWriter writer;
+  writer.writeFile( config, filename_ );
+  ASSERT_FALSE( writer.error() );
+
+  QFile file( filename_ );
+  ASSERT_TRUE( file.resize( file.size() / 2 ));
+
+  Config read;
+  BinaryConfigReader reader;
+  reader.readFile( read, filename_ );
+  EXPECT_TRUE( reader.error() );
+  EXPECT_FALSE( reader.errorMessage().isEmpty() );
+}
+
+TEST_F( BinaryConfigTest, rejects_oversized_strings )
+{
+  {
+    QFile file( filename_ );
+    ASSERT_TRUE( file.open( QIODevice::WriteOnly | QIODevice::Truncate ));
+    QDataStream out( &file );
+    out.setVersion( QDataStream::Qt_4_6 );
+    out << BinaryConfigWriter::MAGIC << BinaryConfigWriter::VERSION;
+    // A map whose only key claims to be 2GB long.
+    out << quint8( Config::Map ) << quint32( 1 ) << quint32( 0x80000000 );
+  }
+
+  Config read;
+  BinaryConfigReader reader;
+  reader.readFile( read, filename_ );
+  EXPECT_TRUE( reader.error() );
+
+  {
+    QFile file( filename_ );
+    ASSERT_TRUE( file.open( QIODevice::WriteOnly | QIODevice::Truncate ));
+    QDataStream out( &file );
+    out.setVersion( QDataStream::Qt_4_6 );
+    out << BinaryConfigWriter::MAGIC << BinaryConfigWriter::VERSION;
+    // A string value claiming the same.
+    out << quint8( Config::Value ) << quint32( QVariant::String ) << quint8( 0 ) << quint32( 0x80000000 );
+  }
+
+  reader.readFile( read, filename_ );
+  EXPECT_TRUE( reader.error() );
+}
+
+TEST_F( BinaryConfigTest, rejects_deep_nesting )
+{
+  {
+    QFile file( filename_ );
+    ASSERT_TRUE( file.open( QIODevice::WriteOnly | QIODevice::Truncate ));
+    QDataStream out( &file );
+    out.setVersion( QDataStream::Qt_4_6 );
+    out << BinaryConfigWriter::MAGIC << BinaryConfigWriter::VERSION;
+    for( int i = 0; i < BinaryConfigReader::MAX_DEPTH + 2; i++ )
+    {
+      out << quint8( Config::List ) << quint32( 1 );
+    }
+    out << quint8( Config::Empty );
+  }
+
+  Config read;
+  BinaryConfigReader reader;
+  reader.readFile( read, filename_ );
+  EXPECT_TRUE( reader.error() );
+}
+
+TEST_F( BinaryConfigTest, rejects_other_versions )
+{
+  writeHeader( BinaryConfigWriter::MAGIC, BinaryConfigWriter::VERSION + 1 );
+
+  Config read;
+  BinaryConfigReader reader;
+  reader.readFile( read, filename_ );
+  EXPECT_TRUE( reader.error() );
+  EXPECT_TRUE( reader.errorMessage().contains( "version" ));
+
+  // The current version with the same content reads fine.
+  writeHeader( BinaryConfigWriter::MAGIC, BinaryConfigWriter::VERSION );
+  reader.readFile( read, filename_ );
+  EXPECT_FALSE( reader.error() ) << qPrintable( reader.errorMessage() );
+}
+
+TEST_F( BinaryConfigTest, rejects_other_files )
+{
+  writeHeader( 0x12345678, BinaryConfigWriter::VERSION );
+
+  Config read;
+  BinaryConfigReader reader;
+  reader.readFile( read, filename_ );
+  EXPECT_TRUE( reader.error() );
+
+  QFile::remove( filename_ );
+  reader.readFile( read, filename_ );
+  EXPECT_TRUE( reader.error() );
+}
+
+TEST_F( BinaryConfigTest, reports_write_errors )
+{
+  Config config;
+  config.mapSetValue( "Value", 1 );
+
+  BinaryConfigWriter writer;
+  writer.writeFile( config, QDir::tempPath() + "/rviz_binary_config_test_missing_dir/config.snapshot" );
+  EXPECT_TRUE( writer.error() );
+  EXPECT_FALSE( writer.errorMessage().isEmpty() );
+}
+
+int main( int argc, char **argv )
+{
+  testing::InitGoogleTest( &argc, argv );
+  return RUN_ALL_TESTS();
+}
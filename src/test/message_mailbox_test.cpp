@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <gtest/gtest.h>
+#include <rviz/message_mailbox.h>
+
+using namespace rviz;
+
+TEST( MessageMailbox, keep_latest_replaces )
+{
+  MessageMailbox<int> mailbox;
+  int value = 0;
+  EXPECT_FALSE( mailbox.pop( &value ));
+
+  mailbox.push( 1 );
+  mailbox.push( 2 );
+  mailbox.push( 3 );
+  EXPECT_EQ( 1u, mailbox.getQueuedCount() );
+  EXPECT_TRUE( mailbox.pop( &value ));
+  EXPECT_EQ( 3, value );
+  EXPECT_FALSE( mailbox.pop( &value ));
+
+  EXPECT_EQ( 3u, mailbox.getReceivedCount() );
+  EXPECT_EQ( 2u, mailbox.getDroppedCount() );
+}
+
+TEST( MessageMailbox, drop_oldest_keeps_order )
+{
+  MessageMailbox<int> mailbox( MessageMailbox<int>::DropOldest );
+  for( int i = 0; i < 5; i++ )
+  {
+    mailbox.push( i );
+  }
+  EXPECT_EQ( 5u, mailbox.getQueuedCount() );
+
+  int value = -1;
+  for( int i = 0; i < 5; i++ )
+  {
+    EXPECT_TRUE( mailbox.pop( &value ));
+    EXPECT_EQ( i, value );
+  }
+  EXPECT_FALSE( mailbox.pop( &value ));
+  EXPECT_EQ( 0u, mailbox.getDroppedCount() );
+}
+
+TEST( MessageMailbox, drop_oldest_capacity )
+{
+  MessageMailbox<int> mailbox( MessageMailbox<int>::DropOldest, 2 );
+  for( int i = 0; i < 5; i++ )
+  {
+    mailbox.push( i );
+  }
+
+  int value = -1;
+  EXPECT_TRUE( mailbox.pop( &value ));
+  EXPECT_EQ( 3, value );
+  EXPECT_TRUE( mailbox.pop( &value ));
+  EXPECT_EQ( 4, value );
+  EXPECT_FALSE( mailbox.pop( &value ));
+
+  EXPECT_EQ( 5u, mailbox.getReceivedCount() );
+  EXPECT_EQ( 3u, mailbox.getDroppedCount() );
+}
+
+TEST( MessageMailbox, clear_and_reset )
+{
+  MessageMailbox<int> mailbox( MessageMailbox<int>::DropOldest );
+  mailbox.push( 1 );
+  mailbox.push( 2 );
+  mailbox.clear();
+
+  int value = 0;
+  EXPECT_FALSE( mailbox.pop( &value ));
+  EXPECT_EQ( 0u, mailbox.getQueuedCount() );
+  EXPECT_EQ( 0u, mailbox.getDroppedCount() );
+  EXPECT_EQ( 2u, mailbox.getReceivedCount() );
+
+  mailbox.resetCounters();
+  EXPECT_EQ( 0u, mailbox.getReceivedCount() );
+
+  // The mailbox stays usable after clear().
+  mailbox.push( 3 );
+  EXPECT_TRUE( mailbox.pop( &value ));
+  EXPECT_EQ( 3, value );
+}
+
+static void produce( MessageMailbox<int>* mailbox, int count )
+{
+  for( int i = 0; i < count; i++ )
+  {
+    mailbox->push( i );
+  }
+}
+
+TEST( MessageMailbox, producer_thread )
+{
+  const int count = 100000;
+  MessageMailbox<int> mailbox( MessageMailbox<int>::DropOldest );
+  boost::thread producer( boost::bind( &produce, &mailbox, count ));
+
+  std::vector<int> received;
+  int value;
+  while( (int)received.size() < count )
+  {
+    if( mailbox.pop( &value ))
+    {
+      received.push_back( value );
+    }
+  }
+  producer.join();
+
+  for( int i = 0; i < count; i++ )
+  {
+    ASSERT_EQ( i, received[ i ] );
+  }
+  EXPECT_FALSE( mailbox.pop( &value ));
+  EXPECT_EQ( 0u, mailbox.getDroppedCount() );
+}
+
+int main( int argc, char **argv )
+{
+  testing::InitGoogleTest( &argc, argv );
+  return RUN_ALL_TESTS();
+}
@@ -45,6 +45,7 @@ public:
   virtual FrameManager* getFrameManager() const { return 0; }
   virtual tf::TransformListener* getTFClient() const { return 0; }
   virtual void queueRender() {}
+  virtual void queueRender( const Ogre::AxisAlignedBox& world_region ) {}
   virtual QString getFixedFrame() const { return ""; }
   virtual uint64_t getFrameCount() const { return 0; }
   virtual DisplayFactory* getDisplayFactory() const { return display_factory_; }
@@ -58,6 +59,8 @@ public:
   virtual DisplayGroup* getRootDisplayGroup() const { return 0; }
   virtual uint32_t getDefaultVisibilityBit() const { return 0; }
   virtual BitAllocator* visibilityBits() { return 0; }
+  virtual SessionRecorder* getSessionRecorder() const { return 0; }
+  virtual SessionPlayer* getSessionPlayer() const { return 0; }
 private:
   DisplayFactory* display_factory_;
 };
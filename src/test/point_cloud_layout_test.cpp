@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include <sensor_msgs/PointCloud2.h>
+
+#include <gtest/gtest.h>
+#include <rviz/default_plugin/point_cloud_layout.h>
+
+using namespace rviz;
+
+static void addField( sensor_msgs::PointCloud2& cloud, const std::string& name, uint32_t offset, uint8_t datatype )
+{
+  sensor_msgs::PointField field;
+  field.name = name;
+  field.offset = offset;
+  field.datatype = datatype;
+  field.count = 1;
+  cloud.fields.push_back( field );
+}
+
+/** Make a cloud with float32 x, y and z at offsets 0, 4 and 8, where
+ * point i is at ( i, 2i, 3i ). */
+static sensor_msgs::PointCloud2 makeCloud( uint32_t point_step, uint32_t num_points )
+{
+  sensor_msgs::PointCloud2 cloud;
+  cloud.height = 1;
+  cloud.width = num_points;
+  cloud.point_step = point_step;
+  cloud.row_step = point_step * num_points;
+  cloud.is_bigendian = false;
+  addField( cloud, "x", 0, sensor_msgs::PointField::FLOAT32 );
+  addField( cloud, "y", 4, sensor_msgs::PointField::FLOAT32 );
+  addField( cloud, "z", 8, sensor_msgs::PointField::FLOAT32 );
+
+  cloud.data.resize( point_step * num_points, 0 );
+  for( uint32_t i = 0; i < num_points; i++ )
+  {
+    float xyz[3] = { float( i ), 2.0f * i, 3.0f * i };
+    memcpy( &cloud.data[ i * point_step ], xyz, sizeof( xyz ));
+  }
+  return cloud;
+}
+
+template<typename T>
+static void setValue( sensor_msgs::PointCloud2& cloud, uint32_t index, uint32_t offset, T value )
+{
+  memcpy( &cloud.data[ index * cloud.point_step + offset ], &value, sizeof( T ));
+}
+
+TEST( PointCloudLayout, specialized_layouts )
+{
+  EXPECT_TRUE( PointCloudLayout::get( makeCloud( 12, 1 )).specialized );
+  EXPECT_TRUE( PointCloudLayout::get( makeCloud( 16, 1 )).specialized );
+  EXPECT_TRUE( PointCloudLayout::get( makeCloud( 32, 1 )).specialized );
+  EXPECT_TRUE( PointCloudLayout::get( makeCloud( 48, 1 )).specialized );
+  EXPECT_FALSE( PointCloudLayout::get( makeCloud( 20, 1 )).specialized );
+
+  sensor_msgs::PointCloud2 big_endian = makeCloud( 16, 1 );
+  big_endian.is_bigendian = true;
+  EXPECT_FALSE( PointCloudLayout::get( big_endian ).specialized );
+
+  sensor_msgs::PointCloud2 doubles = makeCloud( 32, 1 );
+  doubles.fields[ 0 ].datatype = sensor_msgs::PointField::FLOAT64;
+  EXPECT_FALSE( PointCloudLayout::get( doubles ).specialized );
+}
+
+TEST( PointCloudLayout, field_offsets )
+{
+  sensor_msgs::PointCloud2 cloud = makeCloud( 32, 1 );
+  PointCloudLayout layout = PointCloudLayout::get( cloud );
+  EXPECT_EQ( -1, layout.intensity_offset );
+  EXPECT_EQ( -1, layout.rgb_offset );
+
+  addField( cloud, "intensity", 16, sensor_msgs::PointField::FLOAT32 );
+  addField( cloud, "rgb", 20, sensor_msgs::PointField::UINT32 );
+  layout = PointCloudLayout::get( cloud );
+  EXPECT_EQ( 16, layout.intensity_offset );
+  EXPECT_EQ( 20, layout.rgb_offset );
+  EXPECT_EQ( 32u, layout.point_step );
+}
+
+TEST( PointCloudLayout, decode_xyz )
+{
+  const uint32_t steps[] = { 12, 16, 32, 48 };
+  for( size_t s = 0; s < sizeof( steps ) / sizeof( steps[0] ); s++ )
+  {
+    sensor_msgs::PointCloud2 cloud = makeCloud( steps[ s ], 5 );
+    V_PointCloudPoint points( 5 );
+    ASSERT_TRUE( decodeXYZ( cloud, PointCloudLayout::get( cloud ), points ));
+    for( uint32_t i = 0; i < 5; i++ )
+    {
+      EXPECT_EQ( float( i ), points[ i ].position.x );
+      EXPECT_EQ( 2.0f * i, points[ i ].position.y );
+      EXPECT_EQ( 3.0f * i, points[ i ].position.z );
+    }
+  }
+}
+
+TEST( PointCloudLayout, decode_rejects_short_data )
+{
+  sensor_msgs::PointCloud2 cloud = makeCloud( 16, 5 );
+  cloud.data.resize( 16 * 4 );
+  V_PointCloudPoint points( 5 );
+  EXPECT_FALSE( decodeXYZ( cloud, PointCloudLayout::get( cloud ), points ));
+
+  std::vector<float> values;
+  decodeChannel( cloud, 0, sensor_msgs::PointField::FLOAT32, values );
+  EXPECT_TRUE( values.empty() );
+}
+
+TEST( PointCloudLayout, decode_xyz_intensity )
+{
+  sensor_msgs::PointCloud2 cloud = makeCloud( 32, 3 );
+  addField( cloud, "intensity", 16, sensor_msgs::PointField::FLOAT32 );
+  setValue( cloud, 0, 16, 5.0f );
+  setValue( cloud, 1, 16, -1.0f );
+  setValue( cloud, 2, 16, 2.0f );
+
+  V_PointCloudPoint points( 3 );
+  std::vector<float> intensities;
+  float min_value = 0, max_value = 0;
+  ASSERT_TRUE( decodeXYZIntensity( cloud, PointCloudLayout::get( cloud ), points, intensities, min_value, max_value ));
+  ASSERT_EQ( 3u, intensities.size() );
+  EXPECT_EQ( 5.0f, intensities[ 0 ] );
+  EXPECT_EQ( -1.0f, intensities[ 1 ] );
+  EXPECT_EQ( 2.0f, intensities[ 2 ] );
+  EXPECT_EQ( -1.0f, min_value );
+  EXPECT_EQ( 5.0f, max_value );
+  EXPECT_EQ( 4.0f, points[ 2 ].position.y );
+
+  // Intensity somewhere no specialized loop expects it.
+  sensor_msgs::PointCloud2 other = makeCloud( 32, 3 );
+  addField( other, "intensity", 20, sensor_msgs::PointField::FLOAT32 );
+  EXPECT_FALSE( decodeXYZIntensity( other, PointCloudLayout::get( other ), points, intensities, min_value, max_value ));
+}
+
+TEST( PointCloudLayout, decode_xyz_rgb )
+{
+  sensor_msgs::PointCloud2 cloud = makeCloud( 16, 2 );
+  addField( cloud, "rgb", 12, sensor_msgs::PointField::FLOAT32 );
+  setValue<uint32_t>( cloud, 0, 12, 0xff0000 );
+  setValue<uint32_t>( cloud, 1, 12, 0x00ff33 );
+
+  V_PointCloudPoint points( 2 );
+  ASSERT_TRUE( decodeXYZRGB( cloud, PointCloudLayout::get( cloud ), points ));
+  EXPECT_EQ( 1.0f, points[ 0 ].color.r );
+  EXPECT_EQ( 0.0f, points[ 0 ].color.g );
+  EXPECT_EQ( 0.0f, points[ 0 ].color.b );
+  EXPECT_EQ( 0.0f, points[ 1 ].color.r );
+  EXPECT_EQ( 1.0f, points[ 1 ].color.g );
+  EXPECT_FLOAT_EQ( 0x33 / 255.0f, points[ 1 ].color.b );
+  EXPECT_EQ( 1.0f, points[ 1 ].color.a );
+  EXPECT_EQ( 1.0f, points[ 1 ].position.x );
+}
+
+TEST( PointCloudLayout, decode_channel )
+{
+  sensor_msgs::PointCloud2 cloud = makeCloud( 24, 2 );
+  addField( cloud, "ring", 12, sensor_msgs::PointField::UINT16 );
+  addField( cloud, "time", 16, sensor_msgs::PointField::FLOAT64 );
+  setValue<uint16_t>( cloud, 0, 12, 7 );
+  setValue<uint16_t>( cloud, 1, 12, 65535 );
+  setValue<double>( cloud, 0, 16, 0.25 );
+  setValue<double>( cloud, 1, 16, -8.5 );
+
+  std::vector<float> values;
+  decodeChannel( cloud, 12, sensor_msgs::PointField::UINT16, values );
+  ASSERT_EQ( 2u, values.size() );
+  EXPECT_EQ( 7.0f, values[ 0 ] );
+  EXPECT_EQ( 65535.0f, values[ 1 ] );
+
+  decodeChannel( cloud, 16, sensor_msgs::PointField::FLOAT64, values );
+  ASSERT_EQ( 2u, values.size() );
+  EXPECT_EQ( 0.25f, values[ 0 ] );
+  EXPECT_EQ( -8.5f, values[ 1 ] );
+
+  decodeChannel( cloud, 4, sensor_msgs::PointField::FLOAT32, values );
+  EXPECT_EQ( 2.0f, values[ 1 ] );
+}
+
+TEST( PointCloudLayout, signature_ignores_content )
+{
+  sensor_msgs::PointCloud2 small = makeCloud( 16, 1 );
+  sensor_msgs::PointCloud2 large = makeCloud( 16, 100 );
+  large.header.frame_id = "other";
+  large.height = 10;
+  large.width = 10;
+  EXPECT_EQ( PointCloudLayout::getSignature( small ), PointCloudLayout::getSignature( large ));
+}
+
+TEST( PointCloudLayout, signature_tracks_fields )
+{
+  sensor_msgs::PointCloud2 cloud = makeCloud( 32, 1 );
+  std::string signature = PointCloudLayout::getSignature( cloud );
+
+  sensor_msgs::PointCloud2 changed = cloud;
+  changed.point_step = 48;
+  EXPECT_NE( signature, PointCloudLayout::getSignature( changed ));
+
+  changed = cloud;
+  changed.is_bigendian = true;
+  EXPECT_NE( signature, PointCloudLayout::getSignature( changed ));
+
+  changed = cloud;
+  changed.fields[ 2 ].offset = 12;
+  EXPECT_NE( signature, PointCloudLayout::getSignature( changed ));
+
+  changed = cloud;
+  changed.fields[ 2 ].datatype = sensor_msgs::PointField::FLOAT64;
+  EXPECT_NE( signature, PointCloudLayout::getSignature( changed ));
+
+  changed = cloud;
+  changed.fields[ 2 ].count = 2;
+  EXPECT_NE( signature, PointCloudLayout::getSignature( changed ));
+
+  changed = cloud;
+  changed.fields[ 2 ].name = "w";
+  EXPECT_NE( signature, PointCloudLayout::getSignature( changed ));
+
+  changed = cloud;
+  addField( changed, "intensity", 16, sensor_msgs::PointField::FLOAT32 );
+  EXPECT_NE( signature, PointCloudLayout::getSignature( changed ));
+}
+
+TEST( PointCloudLayout, cached_layouts_follow_signature )
+{
+  // Two clouds which only differ in a field offset must not share a
+  // cached layout.
+  sensor_msgs::PointCloud2 first = makeCloud( 32, 1 );
+  addField( first, "intensity", 16, sensor_msgs::PointField::FLOAT32 );
+  sensor_msgs::PointCloud2 second = makeCloud( 32, 1 );
+  addField( second, "intensity", 20, sensor_msgs::PointField::FLOAT32 );
+
+  EXPECT_EQ( 16, PointCloudLayout::get( first ).intensity_offset );
+  EXPECT_EQ( 20, PointCloudLayout::get( second ).intensity_offset );
+  EXPECT_EQ( 16, PointCloudLayout::get( first ).intensity_offset );
+
+  // More layouts than the cache holds still come out right.
+  for( uint32_t i = 0; i < 100; i++ )
+  {
+    sensor_msgs::PointCloud2 cloud = makeCloud( 32, 1 );
+    addField( cloud, "intensity", 12 + i, sensor_msgs::PointField::FLOAT32 );
+    ASSERT_EQ( int32_t( 12 + i ), PointCloudLayout::get( cloud ).intensity_offset );
+  }
+  EXPECT_EQ( 16, PointCloudLayout::get( first ).intensity_offset );
+}
+
+int main( int argc, char **argv )
+{
+  testing::InitGoogleTest( &argc, argv );
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,361 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include <std_msgs/String.h>
+
+#include <gtest/gtest.h>
+#include <rviz/session_recorder.h>
+
+using namespace rviz;
+
+/**
+ * Writes session files the way SessionRecorder lays them out, without
+ * needing a ROS master or clock.
+ */
+class SessionFileBuilder
+{
+public:
+  SessionFileBuilder()
+    : data_( sizeof( SessionFileHeader ), 0 )
+    {
+      SessionFileHeader* header = getHeader();
+      strncpy( header->magic, "RVIZSES", sizeof( header->magic ));
+      header->version = 1;
+    }
+
+  /** @return the index of the new channel. */
+  uint32_t addChannel( const std::string& name, const std::string& datatype, const std::string& md5sum )
+    {
+      Channel channel;
+      channel.name = name;
+      channel.datatype = datatype;
+      channel.md5sum = md5sum;
+      channels_.push_back( channel );
+      return channels_.size() - 1;
+    }
+
+  void addRecord( uint32_t channel, uint64_t stamp, const std::vector<uint8_t>& payload )
+    {
+      SessionIndexEntry entry;
+      entry.stamp = stamp;
+      entry.record_offset = data_.size();
+      channels_[ channel ].entries.push_back( entry );
+
+      SessionRecordHeader header;
+      memset( &header, 0, sizeof( header ));
+      header.channel = channel;
+      header.size = payload.size();
+      header.stamp = stamp;
+      append( &header, sizeof( header ));
+      append( payload.empty() ? 0 : &payload.front(), payload.size() );
+      pad();
+    }
+
+  void addMessage( uint32_t channel, uint64_t stamp, const std_msgs::String& msg )
+    {
+      std::vector<uint8_t> buffer( ros::serialization::serializationLength( msg ));
+      ros::serialization::OStream stream( &buffer.front(), buffer.size() );
+      ros::serialization::serialize( stream, msg );
+      addRecord( channel, stamp, buffer );
+    }
+
+  /** @brief Append the index and return the whole file.  Entries must be added in stamp order. */
+  std::vector<uint8_t> finish( uint64_t start_stamp, uint64_t end_stamp )
+    {
+      uint64_t index_offset = data_.size();
+
+      uint64_t entries_offset = index_offset + sizeof( SessionIndexHeader );
+      for( size_t i = 0; i < channels_.size(); i++ )
+      {
+        entries_offset += sizeof( SessionChannelHeader );
+        entries_offset += align8( channels_[ i ].name.size() );
+        entries_offset += align8( channels_[ i ].datatype.size() );
+        entries_offset += align8( channels_[ i ].md5sum.size() );
+      }
+
+      SessionIndexHeader index_header;
+      memset( &index_header, 0, sizeof( index_header ));
+      index_header.num_channels = channels_.size();
+      index_header.start_stamp = start_stamp;
+      index_header.end_stamp = end_stamp;
+      append( &index_header, sizeof( index_header ));
+
+      for( size_t i = 0; i < channels_.size(); i++ )
+      {
+        const Channel& channel = channels_[ i ];
+        SessionChannelHeader header;
+        memset( &header, 0, sizeof( header ));
+        header.name_length = channel.name.size();
+        header.datatype_length = channel.datatype.size();
+        header.md5sum_length = channel.md5sum.size();
+        header.entries_offset = entries_offset;
+        header.num_entries = channel.entries.size();
+        append( &header, sizeof( header ));
+        append( channel.name.data(), channel.name.size() );
+        pad();
+        append( channel.datatype.data(), channel.datatype.size() );
+        pad();
+        append( channel.md5sum.data(), channel.md5sum.size() );
+        pad();
+        entries_offset += channel.entries.size() * sizeof( SessionIndexEntry );
+      }
+
+      for( size_t i = 0; i < channels_.size(); i++ )
+      {
+        const std::vector<SessionIndexEntry>& entries = channels_[ i ].entries;
+        append( entries.empty() ? 0 : &entries.front(), entries.size() * sizeof( SessionIndexEntry ));
+      }
+
+      getHeader()->index_offset = index_offset;
+      return data_;
+    }
+
+  /** @brief The file as it is while still recording, without an index. */
+  std::vector<uint8_t> unfinished() const { return data_; }
+
+private:
+  struct Channel
+  {
+    std::string name;
+    std::string datatype;
+    std::string md5sum;
+    std::vector<SessionIndexEntry> entries;
+  };
+
+  static uint64_t align8( uint64_t value ) { return ( value + 7 ) & ~(uint64_t)7; }
+
+  SessionFileHeader* getHeader() { return (SessionFileHeader*)&data_.front(); }
+
+  void append( const void* data, size_t size )
+    {
+      data_.insert( data_.end(), (const uint8_t*)data, (const uint8_t*)data + size );
+    }
+
+  void pad() { data_.resize( align8( data_.size() ), 0 ); }
+
+  std::vector<uint8_t> data_;
+  std::vector<Channel> channels_;
+};
+
+/** Writes a session file to a temporary path and removes it again. */
+class SessionReaderTest : public testing::Test
+{
+protected:
+  SessionReaderTest()
+    {
+      char path[] = "/tmp/rviz_session_test_XXXXXX";
+      int fd = mkstemp( path );
+      if( fd >= 0 )
+      {
+        close( fd );
+      }
+      path_ = path;
+    }
+
+  ~SessionReaderTest()
+    {
+      unlink( path_.c_str() );
+    }
+
+  bool write( const std::vector<uint8_t>& data )
+    {
+      FILE* file = fopen( path_.c_str(), "wb" );
+      if( !file )
+      {
+        return false;
+      }
+      bool ok = fwrite( &data.front(), 1, data.size(), file ) == data.size();
+      return fclose( file ) == 0 && ok;
+    }
+
+  static std_msgs::String makeString( const std::string& text )
+    {
+      std_msgs::String msg;
+      msg.data = text;
+      return msg;
+    }
+
+  static const uint64_t SECOND = 1000000000ull;
+
+  std::string path_;
+  SessionReader reader_;
+};
+
+TEST_F( SessionReaderTest, channels_and_times )
+{
+  SessionFileBuilder builder;
+  uint32_t chatter = builder.addChannel( "/chatter", "std_msgs/String", ros::message_traits::md5sum<std_msgs::String>() );
+  builder.addChannel( SESSION_TF_CHANNEL, "tf/tfMessage", "0" );
+  builder.addMessage( chatter, 10 * SECOND, makeString( "a" ));
+  ASSERT_TRUE( write( builder.finish( 10 * SECOND, 12 * SECOND )));
+
+  std::string error;
+  ASSERT_TRUE( reader_.open( path_, &error )) << error;
+  EXPECT_EQ( 10.0, reader_.getStartTime().toSec() );
+  EXPECT_EQ( 12.0, reader_.getEndTime().toSec() );
+  EXPECT_EQ( 0, reader_.findChannel( "/chatter" ));
+  EXPECT_EQ( 1, reader_.findChannel( SESSION_TF_CHANNEL ));
+  EXPECT_EQ( -1, reader_.findChannel( "/missing" ));
+  EXPECT_EQ( "std_msgs/String", reader_.getChannel( 0 ).datatype );
+  EXPECT_EQ( 1u, reader_.getChannel( 0 ).num_entries );
+  EXPECT_EQ( 0u, reader_.getChannel( 1 ).num_entries );
+}
+
+TEST_F( SessionReaderTest, find_latest_and_decode )
+{
+  SessionFileBuilder builder;
+  uint32_t chatter = builder.addChannel( "/chatter", "std_msgs/String", ros::message_traits::md5sum<std_msgs::String>() );
+  builder.addMessage( chatter, 1 * SECOND, makeString( "one" ));
+  builder.addMessage( chatter, 2 * SECOND, makeString( "two" ));
+  builder.addMessage( chatter, 3 * SECOND, makeString( "three" ));
+  ASSERT_TRUE( write( builder.finish( 1 * SECOND, 3 * SECOND )));
+
+  std::string error;
+  ASSERT_TRUE( reader_.open( path_, &error )) << error;
+
+  SessionReader::Record record;
+  EXPECT_FALSE( reader_.findLatest( 0, ros::Time( 0.5 ), &record ));
+
+  ASSERT_TRUE( reader_.findLatest( 0, ros::Time( 2.5 ), &record ));
+  EXPECT_EQ( 2.0, record.stamp.toSec() );
+  std_msgs::String msg;
+  ASSERT_TRUE( reader_.decode( 0, record, msg ));
+  EXPECT_EQ( "two", msg.data );
+
+  // A record stamped exactly at the time counts.
+  ASSERT_TRUE( reader_.findLatest( 0, ros::Time( 3.0 ), &record ));
+  ASSERT_TRUE( reader_.decode( 0, record, msg ));
+  EXPECT_EQ( "three", msg.data );
+}
+
+TEST_F( SessionReaderTest, get_records )
+{
+  SessionFileBuilder builder;
+  uint32_t chatter = builder.addChannel( "/chatter", "std_msgs/String", ros::message_traits::md5sum<std_msgs::String>() );
+  for( int i = 1; i <= 5; i++ )
+  {
+    builder.addMessage( chatter, i * SECOND, makeString( "x" ));
+  }
+  ASSERT_TRUE( write( builder.finish( 1 * SECOND, 5 * SECOND )));
+
+  std::string error;
+  ASSERT_TRUE( reader_.open( path_, &error )) << error;
+
+  std::vector<SessionReader::Record> records;
+  reader_.getRecords( 0, ros::Time( 2.0 ), ros::Time( 4.0 ), &records );
+  ASSERT_EQ( 3u, records.size() );
+  EXPECT_EQ( 2.0, records[ 0 ].stamp.toSec() );
+  EXPECT_EQ( 4.0, records[ 2 ].stamp.toSec() );
+
+  reader_.getRecords( 0, ros::Time( 6.0 ), ros::Time( 7.0 ), &records );
+  EXPECT_TRUE( records.empty() );
+}
+
+TEST_F( SessionReaderTest, decode_rejects_other_types )
+{
+  SessionFileBuilder builder;
+  uint32_t channel = builder.addChannel( "/other", "other/Type", "0123456789abcdef" );
+  builder.addMessage( channel, 1 * SECOND, makeString( "a" ));
+  ASSERT_TRUE( write( builder.finish( 1 * SECOND, 1 * SECOND )));
+
+  std::string error;
+  ASSERT_TRUE( reader_.open( path_, &error )) << error;
+
+  SessionReader::Record record;
+  ASSERT_TRUE( reader_.findLatest( 0, ros::Time( 1.0 ), &record ));
+  std_msgs::String msg;
+  EXPECT_FALSE( reader_.decode( 0, record, msg ));
+}
+
+TEST_F( SessionReaderTest, rejects_unfinished_file )
+{
+  SessionFileBuilder builder;
+  uint32_t chatter = builder.addChannel( "/chatter", "std_msgs/String", ros::message_traits::md5sum<std_msgs::String>() );
+  builder.addMessage( chatter, 1 * SECOND, makeString( "a" ));
+  ASSERT_TRUE( write( builder.unfinished() ));
+
+  std::string error;
+  EXPECT_FALSE( reader_.open( path_, &error ));
+  EXPECT_FALSE( error.empty() );
+  EXPECT_FALSE( reader_.isOpen() );
+}
+
+TEST_F( SessionReaderTest, rejects_other_files )
+{
+  std::vector<uint8_t> data( 64, 'x' );
+  ASSERT_TRUE( write( data ));
+
+  std::string error;
+  EXPECT_FALSE( reader_.open( path_, &error ));
+  EXPECT_FALSE( reader_.isOpen() );
+
+  EXPECT_FALSE( reader_.open( path_ + ".missing", &error ));
+}
+
+TEST_F( SessionReaderTest, skips_records_outside_the_file )
+{
+  SessionFileBuilder builder;
+  uint32_t chatter = builder.addChannel( "/chatter", "std_msgs/String", ros::message_traits::md5sum<std_msgs::String>() );
+  builder.addMessage( chatter, 1 * SECOND, makeString( "good" ));
+  builder.addMessage( chatter, 2 * SECOND, makeString( "bad" ));
+  std::vector<uint8_t> data = builder.finish( 1 * SECOND, 2 * SECOND );
+
+  // Claim a payload larger than the whole file for the second record.
+  SessionFileHeader* header = (SessionFileHeader*)&data.front();
+  const SessionChannelHeader* channel = (const SessionChannelHeader*)( &data.front() + header->index_offset + sizeof( SessionIndexHeader ));
+  const SessionIndexEntry* entries = (const SessionIndexEntry*)( &data.front() + channel->entries_offset );
+  SessionRecordHeader* record_header = (SessionRecordHeader*)( &data.front() + entries[ 1 ].record_offset );
+  record_header->size = 0xffffffff;
+  ASSERT_TRUE( write( data ));
+
+  std::string error;
+  ASSERT_TRUE( reader_.open( path_, &error )) << error;
+
+  SessionReader::Record record;
+  EXPECT_FALSE( reader_.findLatest( 0, ros::Time( 2.0 ), &record ));
+  ASSERT_TRUE( reader_.findLatest( 0, ros::Time( 1.0 ), &record ));
+
+  std::vector<SessionReader::Record> records;
+  reader_.getRecords( 0, ros::Time( 0.0 ), ros::Time( 3.0 ), &records );
+  EXPECT_EQ( 1u, records.size() );
+}
+
+int main( int argc, char **argv )
+{
+  testing::InitGoogleTest( &argc, argv );
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <rviz/topic_cache.h>
+
+using namespace rviz;
+
+// setTopics() marks the cache as fetched, so none of these reads
+// contact a master, as long as each test stays well below the two
+// seconds after which a read starts a background refresh.
+
+TEST( TopicCache, sorts_topics )
+{
+  ros::master::V_TopicInfo topics;
+  topics.push_back( ros::master::TopicInfo( "/scan", "sensor_msgs/LaserScan" ));
+  topics.push_back( ros::master::TopicInfo( "/camera/image", "sensor_msgs/Image" ));
+  topics.push_back( ros::master::TopicInfo( "/map", "nav_msgs/OccupancyGrid" ));
+  TopicCache::get()->setTopics( topics );
+
+  ros::master::V_TopicInfo cached = TopicCache::get()->getTopics();
+  ASSERT_EQ( 3u, cached.size() );
+  EXPECT_EQ( "/camera/image", cached[ 0 ].name );
+  EXPECT_EQ( "sensor_msgs/Image", cached[ 0 ].datatype );
+  EXPECT_EQ( "/map", cached[ 1 ].name );
+  EXPECT_EQ( "/scan", cached[ 2 ].name );
+}
+
+TEST( TopicCache, indexes_by_type )
+{
+  ros::master::V_TopicInfo topics;
+  topics.push_back( ros::master::TopicInfo( "/right/image", "sensor_msgs/Image" ));
+  topics.push_back( ros::master::TopicInfo( "/scan", "sensor_msgs/LaserScan" ));
+  topics.push_back( ros::master::TopicInfo( "/left/image", "sensor_msgs/Image" ));
+  TopicCache::get()->setTopics( topics );
+
+  std::vector<std::string> images = TopicCache::get()->getTopicNames( "sensor_msgs/Image" );
+  ASSERT_EQ( 2u, images.size() );
+  EXPECT_EQ( "/left/image", images[ 0 ] );
+  EXPECT_EQ( "/right/image", images[ 1 ] );
+
+  std::vector<std::string> scans = TopicCache::get()->getTopicNames( "sensor_msgs/LaserScan" );
+  ASSERT_EQ( 1u, scans.size() );
+  EXPECT_EQ( "/scan", scans[ 0 ] );
+
+  EXPECT_TRUE( TopicCache::get()->getTopicNames( "nav_msgs/Odometry" ).empty() );
+}
+
+TEST( TopicCache, replaces_index )
+{
+  ros::master::V_TopicInfo topics;
+  topics.push_back( ros::master::TopicInfo( "/image", "sensor_msgs/Image" ));
+  TopicCache::get()->setTopics( topics );
+  EXPECT_EQ( 1u, TopicCache::get()->getTopicNames( "sensor_msgs/Image" ).size() );
+
+  // The same topic with another type moves to the other index entry.
+  topics[ 0 ].datatype = "sensor_msgs/CompressedImage";
+  TopicCache::get()->setTopics( topics );
+  EXPECT_TRUE( TopicCache::get()->getTopicNames( "sensor_msgs/Image" ).empty() );
+  EXPECT_EQ( 1u, TopicCache::get()->getTopicNames( "sensor_msgs/CompressedImage" ).size() );
+
+  TopicCache::get()->setTopics( ros::master::V_TopicInfo() );
+  EXPECT_TRUE( TopicCache::get()->getTopics().empty() );
+  EXPECT_TRUE( TopicCache::get()->getTopicNames( "sensor_msgs/CompressedImage" ).empty() );
+}
+
+int main( int argc, char **argv )
+{
+  testing::InitGoogleTest( &argc, argv );
+  return RUN_ALL_TESTS();
+}